@@ -2,7 +2,7 @@
 
 const fs = require('fs');
 const path = require('path');
-const { Transform, pipeline } = require('stream');
+const { pipeline } = require('stream');
 const OpenCC = require('./opencc');
 
 const BUILT_IN_CONFIGS = [
@@ -155,38 +155,6 @@ function resolveConfigPath(config) {
   return path.resolve(process.cwd(), config);
 }
 
-function createConverterStream(converter) {
-  const nativeStream = converter._createConverterStream();
-  let pendingChunk = null;
-
-  return new Transform({
-    transform(chunk, encoding, callback) {
-      try {
-        const input = Buffer.isBuffer(chunk) ? chunk : Buffer.from(chunk, encoding);
-        if (pendingChunk === null) {
-          pendingChunk = Buffer.from(input);
-          callback();
-          return;
-        }
-        const output = nativeStream.convertChunk(pendingChunk);
-        pendingChunk = Buffer.from(input);
-        callback(null, output);
-      } catch (error) {
-        callback(error);
-      }
-    },
-    flush(callback) {
-      try {
-        callback(null, pendingChunk === null
-          ? nativeStream.finish()
-          : nativeStream.finish(pendingChunk));
-      } catch (error) {
-        callback(error);
-      }
-    },
-  });
-}
-
 function isSameFile(inputFileName, outputFileName) {
   if (!inputFileName || !outputFileName) {
     return false;
@@ -209,7 +177,7 @@ function convertStream(converter, options, callback) {
 
   const input = options.input ? fs.createReadStream(options.input) : process.stdin;
   const output = options.output ? fs.createWriteStream(options.output) : process.stdout;
-  pipeline(input, createConverterStream(converter), output, callback);
+  pipeline(input, converter.createStream(), output, callback);
 }
 
 function main() {
@@ -1,7 +1,10 @@
 #include <napi.h>
+#include <algorithm>
+#include <exception>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "src/Config.hpp"
 #include "src/Converter.hpp"
@@ -15,17 +18,79 @@ std::string ToUtf8String(const Napi::Value& val) {
   return val.As<Napi::String>().Utf8Value();
 }
 
+std::string_view BufferView(const Napi::Value& val) {
+  const Napi::Buffer<char> buffer = val.As<Napi::Buffer<char>>();
+  return std::string_view(buffer.Data(), buffer.Length());
+}
+
+// Returns converted text as a Buffer if buffer is set, which skips the
+// UTF-8 to UTF-16 transcode of a JavaScript string, and as a string
+// otherwise.
+Napi::Value NewOutput(Napi::Env env, const char* data, size_t length,
+                      bool buffer) {
+  if (buffer) {
+    return Napi::Buffer<char>::Copy(env, data, length);
+  }
+  return Napi::String::New(env, data, length);
+}
+
+// Default number of libuv threadpool jobs a convertBatch() call is split
+// into, which is libuv's default threadpool size.
+constexpr size_t kDefaultBatchJobs = 4;
+
+// Batches are not split into jobs smaller than this.
+constexpr size_t kMinBatchJobBytes = 64 * 1024;
+
+// UTF-8 views of the items of a batch. Strings are copied to UTF-8 once;
+// Buffers are read in place and must outlive the views.
+struct BatchInputs {
+  std::vector<std::string> strings;
+  std::vector<std::string_view> views;
+
+  // Returns false if an item is neither a string nor a Buffer.
+  bool Read(const Napi::Array& array) {
+    const uint32_t length = array.Length();
+    // Reserved up front so that views into strings stay valid.
+    strings.reserve(length);
+    views.reserve(length);
+    for (uint32_t i = 0; i < length; i++) {
+      const Napi::Value item = array[i];
+      if (item.IsBuffer()) {
+        views.push_back(BufferView(item));
+      } else if (item.IsString()) {
+        strings.push_back(ToUtf8String(item));
+        views.push_back(strings.back());
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
 class OpenccBinding : public Napi::ObjectWrap<OpenccBinding> {
   class ConvertWorker : public Napi::AsyncWorker {
     OpenccBinding* instance_;
-    std::string input_;
+    // Strings are copied to UTF-8; a Buffer is read in place and kept alive
+    // by bufferRef_ until the worker is destroyed on the main thread.
+    std::string storage_;
+    Napi::ObjectReference bufferRef_;
+    std::string_view input_;
     std::string output_;
+    bool bufferOutput_;
 
   public:
-    ConvertWorker(OpenccBinding* instance, const std::string& input,
-                  const Napi::Function& callback)
+    ConvertWorker(OpenccBinding* instance, const Napi::Value& input,
+                  const Napi::Function& callback, bool bufferOutput)
         : Napi::AsyncWorker(callback, "opencc:convert-async-cb"),
-          instance_(instance), input_(input) {
+          instance_(instance), bufferOutput_(bufferOutput) {
+      if (input.IsBuffer()) {
+        bufferRef_ = Napi::Persistent(input.As<Napi::Object>());
+        input_ = BufferView(input);
+      } else {
+        storage_ = ToUtf8String(input);
+        input_ = storage_;
+      }
       instance_->Ref();
     }
 
@@ -38,11 +103,15 @@ class OpenccBinding : public Napi::ObjectWrap<OpenccBinding> {
         output_ = instance_->Convert(input_);
       } catch (opencc::Exception& e) {
         SetError(e.what());
+      } catch (std::exception& e) {
+        SetError(e.what());
       }
     }
 
     void OnOK() override {
-      Callback().Call({Env().Undefined(), Napi::String::New(Env(), output_)});
+      Callback().Call({Env().Undefined(),
+                       NewOutput(Env(), output_.data(), output_.size(),
+                                 bufferOutput_)});
     }
 
     void OnError(const Napi::Error& e) override {
@@ -51,6 +120,79 @@ class OpenccBinding : public Napi::ObjectWrap<OpenccBinding> {
     }
   };
 
+  // State shared by the jobs of one convertBatch() call. The batch is cut
+  // into runs of consecutive items, each converted by its own AsyncWorker so
+  // that the runs spread over the libuv threadpool; the callback is called
+  // once, after the last run completes.
+  struct BatchJob {
+    ConverterPtr converter;
+    BatchInputs inputs;
+    // Holds the input array's items, keeping Buffer inputs alive.
+    Napi::ObjectReference inputsRef;
+    Napi::FunctionReference callback;
+    std::vector<size_t> runStarts;
+    std::vector<std::string> outputs;
+    std::vector<std::vector<size_t>> offsets;
+    size_t pendingRuns = 0;
+    std::string error;
+
+    // Called on the main thread as each run completes.
+    void RunDone(Napi::Env env) {
+      if (--pendingRuns > 0) {
+        return;
+      }
+      if (!error.empty()) {
+        callback.Call({Napi::String::New(env, error), env.Undefined()});
+        return;
+      }
+      Napi::Array converted = Napi::Array::New(env, inputs.views.size());
+      for (size_t run = 0; run + 1 < runStarts.size(); run++) {
+        const std::string& output = outputs[run];
+        const std::vector<size_t>& runOffsets = offsets[run];
+        for (size_t i = runStarts[run]; i < runStarts[run + 1]; i++) {
+          const size_t k = i - runStarts[run];
+          converted[static_cast<uint32_t>(i)] =
+              Napi::String::New(env, output.data() + runOffsets[k],
+                                runOffsets[k + 1] - runOffsets[k]);
+        }
+      }
+      callback.Call({env.Undefined(), converted});
+    }
+  };
+
+  class BatchRunWorker : public Napi::AsyncWorker {
+    std::shared_ptr<BatchJob> job_;
+    size_t run_;
+
+  public:
+    BatchRunWorker(Napi::Env env, std::shared_ptr<BatchJob> job, size_t run)
+        : Napi::AsyncWorker(env, "opencc:convert-batch"), job_(job),
+          run_(run) {}
+
+    void Execute() override {
+      const auto begin = job_->inputs.views.begin();
+      const std::vector<std::string_view> items(
+          begin + job_->runStarts[run_], begin + job_->runStarts[run_ + 1]);
+      try {
+        job_->converter->ConvertBatch(items, &job_->outputs[run_],
+                                      &job_->offsets[run_], 1);
+      } catch (opencc::Exception& e) {
+        SetError(e.what());
+      } catch (std::exception& e) {
+        SetError(e.what());
+      }
+    }
+
+    void OnOK() override { job_->RunDone(Env()); }
+
+    void OnError(const Napi::Error& e) override {
+      if (job_->error.empty()) {
+        job_->error = e.Message();
+      }
+      job_->RunDone(Env());
+    }
+  };
+
   Config config_;
   ConverterPtr converter_;
 
@@ -121,37 +263,139 @@ public:
     return Napi::String::New(info.Env(), OPENCC_VERSION);
   }
 
+  // convert(input, callback, bufferOutput?): input is a string or a Buffer of
+  // UTF-8 text; the converted text is passed as a Buffer if bufferOutput is
+  // true and as a string otherwise.
   Napi::Value Convert(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+    if (info.Length() < 2 || (!info[0].IsString() && !info[0].IsBuffer()) ||
+        !info[1].IsFunction() ||
+        (info.Length() >= 3 && !info[2].IsBoolean())) {
       Napi::TypeError::New(env, "Wrong arguments").ThrowAsJavaScriptException();
       return env.Undefined();
     }
 
-    ConvertWorker* worker =
-        new ConvertWorker(this, ToUtf8String(info[0]),
-                          info[1].As<Napi::Function>());
+    const bool bufferOutput =
+        info.Length() >= 3 && info[2].As<Napi::Boolean>().Value();
+    ConvertWorker* worker = new ConvertWorker(
+        this, info[0], info[1].As<Napi::Function>(), bufferOutput);
     worker->Queue();
     return env.Undefined();
   }
 
+  // convertSync(input, bufferOutput?): like convert(), but returns the
+  // converted text.
   Napi::Value ConvertSync(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() < 1 || !info[0].IsString()) {
+    if (info.Length() < 1 || (!info[0].IsString() && !info[0].IsBuffer()) ||
+        (info.Length() >= 2 && !info[1].IsBoolean())) {
       Napi::TypeError::New(env, "Wrong arguments").ThrowAsJavaScriptException();
       return env.Undefined();
     }
 
-    const std::string input = ToUtf8String(info[0]);
+    const bool buffer = info[0].IsBuffer();
+    const std::string storage = buffer ? std::string() : ToUtf8String(info[0]);
     std::string output;
     try {
-      output = Convert(std::string_view(input));
+      output = Convert(buffer ? BufferView(info[0]) : std::string_view(storage));
     } catch (opencc::Exception& e) {
       Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
       return env.Undefined();
+    } catch (std::exception& e) {
+      Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+
+    const bool bufferOutput =
+        info.Length() >= 2 && info[1].As<Napi::Boolean>().Value();
+    return NewOutput(env, output.data(), output.size(), bufferOutput);
+  }
+
+  Napi::Value ConvertBatchSync(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    BatchInputs inputs;
+    if (info.Length() < 1 || !info[0].IsArray() ||
+        (info.Length() >= 2 && !info[1].IsNumber()) ||
+        !inputs.Read(info[0].As<Napi::Array>())) {
+      Napi::TypeError::New(env, "Wrong arguments").ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+
+    const size_t threads =
+        info.Length() >= 2 ? info[1].As<Napi::Number>().Uint32Value() : 1;
+    std::string output;
+    std::vector<size_t> offsets;
+    try {
+      converter_->ConvertBatch(inputs.views, &output, &offsets, threads);
+    } catch (opencc::Exception& e) {
+      Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+      return env.Undefined();
+    } catch (std::exception& e) {
+      Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+      return env.Undefined();
     }
 
-    return Napi::String::New(env, output);
+    Napi::Array converted = Napi::Array::New(env, inputs.views.size());
+    for (uint32_t i = 0; i < inputs.views.size(); i++) {
+      converted[i] = Napi::String::New(env, output.data() + offsets[i],
+                                       offsets[i + 1] - offsets[i]);
+    }
+    return converted;
+  }
+
+  // convertBatch(inputs, jobs, callback): converts inputs as up to jobs
+  // libuv threadpool jobs and calls callback(err, converted) once.
+  Napi::Value ConvertBatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::shared_ptr<BatchJob> job(new BatchJob());
+    if (info.Length() < 3 || !info[0].IsArray() || !info[1].IsNumber() ||
+        !info[2].IsFunction() ||
+        !job->inputs.Read(info[0].As<Napi::Array>())) {
+      Napi::TypeError::New(env, "Wrong arguments").ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+
+    const Napi::Array array = info[0].As<Napi::Array>();
+    Napi::Array held = Napi::Array::New(env, array.Length());
+    for (uint32_t i = 0; i < array.Length(); i++) {
+      held[i] = static_cast<Napi::Value>(array[i]);
+    }
+    job->inputsRef = Napi::Persistent(held.As<Napi::Object>());
+    job->callback = Napi::Persistent(info[2].As<Napi::Function>());
+    job->converter = converter_;
+
+    const std::vector<std::string_view>& views = job->inputs.views;
+    size_t totalBytes = 0;
+    for (std::string_view view : views) {
+      totalBytes += view.size();
+    }
+    size_t jobs = info[1].As<Napi::Number>().Uint32Value();
+    if (jobs == 0) {
+      jobs = kDefaultBatchJobs;
+    }
+    const size_t runs = std::max<size_t>(
+        1, std::min({jobs, views.size(), totalBytes / kMinBatchJobBytes}));
+
+    // Cut the batch into runs of consecutive items of roughly equal size.
+    job->runStarts.push_back(0);
+    const size_t runBytes = totalBytes / runs;
+    size_t bytes = 0;
+    for (size_t i = 0; i + 1 < views.size() && job->runStarts.size() < runs;
+         i++) {
+      bytes += views[i].size();
+      if (bytes >= runBytes) {
+        job->runStarts.push_back(i + 1);
+        bytes = 0;
+      }
+    }
+    job->runStarts.push_back(views.size());
+    job->outputs.resize(job->runStarts.size() - 1);
+    job->offsets.resize(job->runStarts.size() - 1);
+    job->pendingRuns = job->outputs.size();
+    for (size_t run = 0; run < job->outputs.size(); run++) {
+      (new BatchRunWorker(env, job, run))->Queue();
+    }
+    return env.Undefined();
   }
 
   static Napi::Value GenerateDict(const Napi::CallbackInfo& info) {
@@ -182,6 +426,9 @@ public:
             StaticMethod("generateDict", &OpenccBinding::GenerateDict),
             InstanceMethod("convert", &OpenccBinding::Convert),
             InstanceMethod("convertSync", &OpenccBinding::ConvertSync),
+            InstanceMethod("convertBatchSync",
+                           &OpenccBinding::ConvertBatchSync),
+            InstanceMethod("convertBatch", &OpenccBinding::ConvertBatch),
         });
     exports.Set("Opencc", cons);
     return exports;
@@ -213,18 +460,18 @@ public:
     }
 
     try {
-      std::string output;
       if (info[0].IsBuffer()) {
-        Napi::Buffer<char> input = info[0].As<Napi::Buffer<char>>();
-        output = stream_->ConvertChunk({input.Data(), input.Length()});
-      } else {
-        const std::string input = ToUtf8String(info[0]);
-        output = stream_->ConvertChunk(input);
+        const std::string output = stream_->ConvertChunk(BufferView(info[0]));
+        return NewOutput(env, output.data(), output.size(), true);
       }
-      return Napi::String::New(env, output);
+      const std::string input = ToUtf8String(info[0]);
+      return Napi::String::New(env, stream_->ConvertChunk(input));
     } catch (opencc::Exception& e) {
       Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
       return env.Undefined();
+    } catch (std::exception& e) {
+      Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+      return env.Undefined();
     }
   }
 
@@ -237,9 +484,8 @@ public:
 
     try {
       if (info.Length() >= 1 && info[0].IsBuffer()) {
-        Napi::Buffer<char> input = info[0].As<Napi::Buffer<char>>();
-        return Napi::String::New(
-            env, stream_->Finish({input.Data(), input.Length()}));
+        const std::string output = stream_->Finish(BufferView(info[0]));
+        return NewOutput(env, output.data(), output.size(), true);
       }
       if (info.Length() >= 1) {
         const std::string input = ToUtf8String(info[0]);
@@ -249,6 +495,9 @@ public:
     } catch (opencc::Exception& e) {
       Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
       return env.Undefined();
+    } catch (std::exception& e) {
+      Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+      return env.Undefined();
     }
   }
 
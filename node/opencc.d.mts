@@ -16,7 +16,7 @@ interface OpenCCConversion {
   dict: OpenCCDict;
 }
 interface OpenCCFileDict {
-  type: "text" | "ocd" | "ocd2";
+  type: "text" | "ocd" | "ocd2" | "ocd3";
   file: string;
   may_output_tofu?: boolean;
 }
@@ -43,14 +43,21 @@ interface OpenCCOptions {
   resourceZip?: string;
 }
 
+import type { Transform } from "stream";
+
 declare class OpenCC {
   constructor(config?: string | OpenCCConfig, options?: OpenCCOptions);
   static readonly version: string;
   static fromConfig(config: OpenCCConfig, options?: OpenCCOptions): OpenCC;
   static generateDict(inputFileName: string, outputFileName: string, formatFrom: string, formatTo: string): void;
-  convert(input: string, callback: (err: string | undefined, convertedText: string) => void): void;
-  convertSync(input: string): string;
-  convertPromise(input: string): Promise<string>;
+  convert(input: string | Buffer, callback: (err: string | undefined, convertedText: string) => void): void;
+  convertBuffer(input: string | Buffer, callback: (err: string | undefined, convertedBuffer: Buffer) => void): void;
+  convertSync(input: string | Buffer): string;
+  convertBufferSync(input: string | Buffer): Buffer;
+  convertBatchSync(inputs: (string | Buffer)[], threads?: number): string[];
+  convertBatch(inputs: (string | Buffer)[], jobs?: number): Promise<string[]>;
+  convertPromise(input: string | Buffer): Promise<string>;
+  createStream(): Transform;
 }
 export { OpenCC, OpenCCConfig, OpenCCOptions };
 export default OpenCC;
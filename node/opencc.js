@@ -28,6 +28,7 @@
 
 const path = require('path');
 const fs = require('fs');
+const { Transform } = require('stream');
 const packageRoot = path.join(__dirname, '..');
 
 function requireOptionalPackage(packageName) {
@@ -375,17 +376,37 @@ OpenCC.generateDict = function (inputFileName, outputFileName,
     formatFrom, formatTo);
 }
 
+// Buffers are passed to the addon as UTF-8 and read in place, without
+// transcoding through JavaScript strings; anything else is converted as its
+// string form.
+function toInput(input) {
+  return Buffer.isBuffer(input) ? input : input.toString();
+}
+
 /**
  * Converts input text.
  *
  * @fn void convert(string input, function callback)
  * @memberof OpenCC
- * @param input Input text.
+ * @param input Input text, or a Buffer of UTF-8 text.
  * @param callback Callback function(err, convertedText).
  * @ingroup node_api
  */
 OpenCC.prototype.convert = function (input, callback) {
-  return this.handler.convert(input.toString(), callback);
+  return this.handler.convert(toInput(input), callback);
+};
+
+/**
+ * Converts input text to a Buffer of UTF-8 text.
+ *
+ * @fn void convertBuffer(Buffer input, function callback)
+ * @memberof OpenCC
+ * @param input Input text, or a Buffer of UTF-8 text.
+ * @param callback Callback function(err, convertedBuffer).
+ * @ingroup node_api
+ */
+OpenCC.prototype.convertBuffer = function (input, callback) {
+  return this.handler.convert(toInput(input), callback, true);
 };
 
 /**
@@ -393,12 +414,71 @@ OpenCC.prototype.convert = function (input, callback) {
  *
  * @fn string convertSync(string input)
  * @memberof OpenCC
- * @param input Input text.
+ * @param input Input text, or a Buffer of UTF-8 text.
  * @return Converted text.
  * @ingroup node_api
  */
 OpenCC.prototype.convertSync = function (input) {
-  return this.handler.convertSync(input.toString());
+  return this.handler.convertSync(toInput(input));
+};
+
+/**
+ * Converts input text to a Buffer of UTF-8 text.
+ *
+ * @fn Buffer convertBufferSync(Buffer input)
+ * @memberof OpenCC
+ * @param input Input text, or a Buffer of UTF-8 text.
+ * @return Converted text as a Buffer.
+ * @ingroup node_api
+ */
+OpenCC.prototype.convertBufferSync = function (input) {
+  return this.handler.convertSync(toInput(input), true);
+};
+
+/**
+ * Converts an array of input texts in one call.
+ *
+ * @fn string[] convertBatchSync(string[] inputs, number threads)
+ * @memberof OpenCC
+ * @param inputs Input texts or Buffers of UTF-8 text.
+ * @param threads Maximum number of threads for large batches, 1 by default.
+ *        0 uses one per CPU.
+ * @return Converted texts, in the order of inputs.
+ * @ingroup node_api
+ */
+OpenCC.prototype.convertBatchSync = function (inputs, threads) {
+  const texts = Array.from(inputs, toInput);
+  if (threads === undefined) {
+    return this.handler.convertBatchSync(texts);
+  }
+  return this.handler.convertBatchSync(texts, threads);
+};
+
+/**
+ * Converts an array of input texts asynchronously as one job.
+ *
+ * The batch is split into runs of consecutive texts converted on the libuv
+ * threadpool, so many short texts cost one round trip instead of one
+ * asynchronous call each.
+ *
+ * @fn Promise convertBatch(string[] inputs, number jobs)
+ * @memberof OpenCC
+ * @param inputs Input texts or Buffers of UTF-8 text.
+ * @param jobs Maximum number of threadpool jobs for large batches. 0 or
+ *        undefined uses 4, libuv's default threadpool size.
+ * @return The Promise that will yield the converted texts, in the order of
+ *         inputs.
+ * @ingroup node_api
+ */
+OpenCC.prototype.convertBatch = function (inputs, jobs) {
+  const self = this;
+  const texts = Array.from(inputs, toInput);
+  return new Promise(function (resolve, reject) {
+    self.handler.convertBatch(texts, jobs || 0, function (err, converted) {
+      if (err) reject(new Error(err));
+      else resolve(converted);
+    });
+  });
 };
 
 /**
@@ -406,14 +486,14 @@ OpenCC.prototype.convertSync = function (input) {
  *
  * @fn Promise convertPromise(string input)
  * @memberof OpenCC
- * @param input Input text.
+ * @param input Input text, or a Buffer of UTF-8 text.
  * @return The Promise that will yield the converted text.
  * @ingroup node_api
  */
 OpenCC.prototype.convertPromise = function (input) {
   const self = this;
   return new Promise(function (resolve, reject) {
-    self.handler.convert(input.toString(), function (err, text) {
+    self.handler.convert(toInput(input), function (err, text) {
       if (err) reject(err);
       else resolve(text);
     });
@@ -423,3 +503,51 @@ OpenCC.prototype.convertPromise = function (input) {
 OpenCC.prototype._createConverterStream = function () {
   return new binding.OpenccStream(this.handler);
 };
+
+/**
+ * Creates a Transform stream converting UTF-8 text piped through it, e.g.
+ * from fs.createReadStream() to fs.createWriteStream().
+ *
+ * Chunks may split characters. Each conversion stops 16 characters short of
+ * the input received so far and the rest waits for the next chunk, so a
+ * phrase crossing that point converts as if the text were cut there. Output
+ * chunks are Buffers of UTF-8 text.
+ *
+ * @fn stream.Transform createStream()
+ * @memberof OpenCC
+ * @return The Transform stream.
+ * @ingroup node_api
+ */
+OpenCC.prototype.createStream = function () {
+  const nativeStream = this._createConverterStream();
+  // The last chunk must go to finish() rather than convertChunk(), so each
+  // chunk is held back until the next one arrives.
+  let pendingChunk = null;
+
+  return new Transform({
+    transform(chunk, encoding, callback) {
+      try {
+        const input = Buffer.isBuffer(chunk) ? chunk : Buffer.from(chunk, encoding);
+        if (pendingChunk === null) {
+          pendingChunk = Buffer.from(input);
+          callback();
+          return;
+        }
+        const output = nativeStream.convertChunk(pendingChunk);
+        pendingChunk = Buffer.from(input);
+        callback(null, output);
+      } catch (error) {
+        callback(error);
+      }
+    },
+    flush(callback) {
+      try {
+        callback(null, pendingChunk === null
+          ? nativeStream.finish()
+          : nativeStream.finish(pendingChunk));
+      } catch (error) {
+        callback(error);
+      }
+    },
+  });
+};
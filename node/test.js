@@ -73,6 +73,122 @@ describe('Sync API', function () {
   });
 });
 
+describe('Batch API', function () {
+  const batches = {};
+  cases.forEach(function (tc) {
+    Object.entries(tc.expected || {}).forEach(function ([cfg, expected]) {
+      batches[cfg] = batches[cfg] || { inputs: [], expected: [] };
+      batches[cfg].inputs.push(tc.input);
+      batches[cfg].expected.push(expected);
+    });
+  });
+  Object.entries(batches).forEach(function ([cfg, batch]) {
+    it('[' + cfg + '] converts all cases in one call', function () {
+      const opencc = new OpenCC(cfg + '.json');
+      assert.deepEqual(opencc.convertBatchSync(batch.inputs), batch.expected);
+      assert.deepEqual(opencc.convertBatchSync(batch.inputs, 4), batch.expected);
+    });
+  });
+
+  it('returns an empty array for an empty batch', function () {
+    const opencc = new OpenCC('s2t.json');
+    assert.deepEqual(opencc.convertBatchSync([]), []);
+  });
+
+  it('converts a batch asynchronously across threadpool jobs', async function () {
+    const opencc = new OpenCC('s2t.json');
+    // Large enough to be split into several jobs.
+    const inputs = [];
+    for (let i = 0; i < 2000; i++) {
+      inputs.push(i % 3 === 0 ? '' : '鼠标和打印机，汉字。'.repeat(i % 17 + 1));
+    }
+    const expected = inputs.map((input) => opencc.convertSync(input));
+    assert.deepEqual(await opencc.convertBatch(inputs), expected);
+    assert.deepEqual(await opencc.convertBatch(inputs, 2), expected);
+    assert.deepEqual(await opencc.convertBatch([]), []);
+  });
+
+  it('returns strings for Buffer inputs', async function () {
+    const opencc = new OpenCC('s2t.json');
+    const inputs = [Buffer.from('汉字'), '鼠标', Buffer.alloc(0)];
+    const expected = ['漢字', '鼠標', ''];
+    assert.deepEqual(opencc.convertBatchSync(inputs), expected);
+    assert.deepEqual(await opencc.convertBatch(inputs), expected);
+  });
+});
+
+describe('Buffer API', function () {
+  it('converts Buffers to strings', async function () {
+    const opencc = new OpenCC('s2t.json');
+    const input = Buffer.from('鼠标和打印机');
+    const expected = opencc.convertSync('鼠标和打印机');
+    assert.equal(opencc.convertSync(input), expected);
+    assert.equal(await opencc.convertPromise(input), expected);
+    const converted = await new Promise(function (resolve, reject) {
+      opencc.convert(input, function (err, text) {
+        if (err) reject(err);
+        else resolve(text);
+      });
+    });
+    assert.equal(converted, expected);
+  });
+
+  it('converts to Buffers with convertBuffer and convertBufferSync',
+    async function () {
+      const opencc = new OpenCC('s2t.json');
+      const expected = Buffer.from(opencc.convertSync('鼠标和打印机'));
+      for (const input of [Buffer.from('鼠标和打印机'), '鼠标和打印机']) {
+        assert.deepEqual(opencc.convertBufferSync(input), expected);
+        const converted = await new Promise(function (resolve, reject) {
+          opencc.convertBuffer(input, function (err, buffer) {
+            if (err) reject(err);
+            else resolve(buffer);
+          });
+        });
+        assert.ok(Buffer.isBuffer(converted));
+        assert.deepEqual(converted, expected);
+      }
+    });
+});
+
+describe('Stream API', function () {
+  it('converts text piped through createStream()', async function () {
+    const { Readable } = require('stream');
+    const { pipeline } = require('stream/promises');
+    const opencc = new OpenCC('s2t.json');
+    // Every character converts the same way wherever the text is cut, so
+    // the windowed stream must match converting the whole input at once.
+    const text = '鼠标和打印机。\n'.repeat(300);
+    const encoded = Buffer.from(text);
+    const chunks = [];
+    for (let i = 0; i < encoded.length; i += 1000) {
+      // Chunk boundaries fall inside characters.
+      chunks.push(encoded.subarray(i, i + 1000));
+    }
+    const output = [];
+    await pipeline(Readable.from(chunks), opencc.createStream(),
+      async function (source) {
+        for await (const chunk of source) {
+          assert.ok(Buffer.isBuffer(chunk));
+          output.push(chunk);
+        }
+      });
+    assert.equal(Buffer.concat(output).toString(), opencc.convertSync(text));
+  });
+
+  it('returns Buffers for Buffer chunks and strings for string chunks',
+    function () {
+      const opencc = new OpenCC('s2t.json');
+      const stream = opencc._createConverterStream();
+      const chunk = stream.convertChunk(Buffer.from('鼠标和打印机。'.repeat(4)));
+      assert.ok(Buffer.isBuffer(chunk));
+      const rest = stream.finish('鼠标');
+      assert.equal(typeof rest, 'string');
+      assert.equal(chunk.toString() + rest,
+        opencc.convertSync('鼠标和打印机。'.repeat(4) + '鼠标'));
+    });
+});
+
 describe('API compatibility', function () {
   it('includes tofu-risk dictionaries by default', function () {
     const opencc = new OpenCC('t2s.json');
@@ -1,7 +1,7 @@
 import importlib.util
 import ntpath
 import os
-from typing import Optional
+from typing import Iterable, List, Optional, Union
 
 __all__ = ['CONFIGS', 'OpenCC', '__version__']
 
@@ -98,6 +98,23 @@ class OpenCC(opencc_clib._OpenCC):
         super().__init__(config, include_tofu_risk_dictionaries, resource_zip)
         self.config = config
 
-    def convert(self, text: str):
-        byte_text = text.encode('utf-8')
-        return super().convert(byte_text, len(byte_text))
+    def convert(self, text: Union[str, bytes, bytearray, memoryview]):
+        """Convert text, returning str for str and bytes for UTF-8 bytes-like
+        input. Bytes-like input is read in place without copying, and the GIL
+        is released during the conversion."""
+        return super().convert(text)
+
+    def convert_batch(self, texts: Iterable[Union[str, bytes]],
+                      threads: int = 1) -> List[Union[str, bytes]]:
+        return super().convert_batch(list(texts), threads)
+
+    def stream(self, max_keep_chars: int = 16):
+        """Return a stream converting text fed in pieces.
+
+        stream.convert(piece) returns the converted text that can already be
+        emitted; the last max_keep_chars characters are kept back so that
+        phrases spanning two pieces convert as a whole. stream.finish()
+        returns the rest. Pieces may be str or UTF-8 bytes, which may be split
+        inside a character.
+        """
+        return super().stream(max_keep_chars)
@@ -2,6 +2,8 @@ import json
 import os
 import zipfile
 
+import pytest
+
 _this_dir = os.path.dirname(os.path.abspath(__file__))
 _opencc_rootdir = os.path.abspath(os.path.join(_this_dir, '..', '..'))
 _testcases_path = os.path.join(_opencc_rootdir, 'test', 'testcases', 'testcases.json')
@@ -103,6 +105,70 @@ def test_include_tofu_risk_dictionaries_option():
     ).convert('㑮') == '㑮'
 
 
+def test_convert_batch():
+    import opencc
+
+    converter = opencc.OpenCC('s2t')
+    texts = ['汉字', '', 'abc', '鼠标和打印机'] * 50
+    expected = [converter.convert(text) for text in texts]
+    assert converter.convert_batch(texts) == expected
+    assert converter.convert_batch(iter(texts), threads=4) == expected
+    assert converter.convert_batch([]) == []
+    assert converter.convert_batch(['汉字', '汉字'.encode('utf-8')]) == [
+        '漢字', '漢字'.encode('utf-8')]
+
+
+def test_convert_bytes_like():
+    import opencc
+
+    converter = opencc.OpenCC('s2t')
+    encoded = '鼠标和打印机'.encode('utf-8')
+    expected = converter.convert('鼠标和打印机').encode('utf-8')
+    assert converter.convert(encoded) == expected
+    assert converter.convert(bytearray(encoded)) == expected
+    assert converter.convert(memoryview(encoded)) == expected
+    with pytest.raises(TypeError):
+        converter.convert(42)
+
+
+def test_stream():
+    import opencc
+
+    converter = opencc.OpenCC('s2t')
+    text = '鼠标和打印机，汉字。\n' * 20
+    stream = converter.stream()
+    pieces = [stream.convert(text[i:i + 7]) for i in range(0, len(text), 7)]
+    assert ''.join(pieces) + stream.finish() == converter.convert(text)
+
+    # Byte pieces may split characters.
+    encoded = text.encode('utf-8')
+    stream = converter.stream()
+    pieces = [stream.convert(encoded[i:i + 10])
+              for i in range(0, len(encoded), 10)]
+    assert b''.join(pieces) + stream.finish() == converter.convert(encoded)
+
+
+def test_convert_from_threads():
+    import threading
+
+    import opencc
+
+    converter = opencc.OpenCC('s2t')
+    text = '鼠标和打印机，汉字。' * 1000
+    expected = converter.convert(text)
+    results = [None] * 4
+
+    def work(index):
+        results[index] = converter.convert(text)
+
+    threads = [threading.Thread(target=work, args=(i,)) for i in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert results == [expected] * 4
+
+
 def test_resource_zip_text_dictionary_support(tmp_path):
     import opencc
 
@@ -108,7 +108,7 @@ def main():
                         "-f",
                         "text",
                         "-t",
-                        "ocd2",
+                        "ocd3",
                     ],
                     check=True,
                 )
@@ -20,6 +20,7 @@
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <string_view>
 
 #include "BinaryDict.hpp"
 #include "Lexicon.hpp"
@@ -135,8 +136,15 @@ BinaryDictPtr BinaryDict::NewFromFile(FILE* fp) {
   return NewFromBuffer(buffer.data(), buffer.size());
 }
 
-BinaryDictPtr BinaryDict::NewFromBuffer(const char* data, size_t size) {
-  BinaryDictPtr dict(new BinaryDict(LexiconPtr(new Lexicon)));
+namespace {
+
+// Parses a serialized BinaryDict in place and calls
+// visit(key, values, numValues) for every entry, in order. The key and the
+// values are views into data; values is reused between entries, so parsing
+// allocates nothing once it has grown to the largest number of values.
+// Returns the number of entries.
+template <typename Visitor>
+size_t ParseEntries(const char* data, size_t size, Visitor visit) {
   size_t offset = 0;
   const size_t fieldWidth = DetectFieldWidth(data, size);
 
@@ -157,7 +165,7 @@ BinaryDictPtr BinaryDict::NewFromBuffer(const char* data, size_t size) {
     throw InvalidFormat(
         "Invalid OpenCC binary dictionary (keyTotalLength exceeds data size)");
   }
-  dict->keyBuffer.assign(data + offset, keyTotalLength);
+  const char* keyBuffer = data + offset;
   offset += keyTotalLength;
 
   size_t valueTotalLength = readField();
@@ -165,40 +173,71 @@ BinaryDictPtr BinaryDict::NewFromBuffer(const char* data, size_t size) {
     throw InvalidFormat(
         "Invalid OpenCC binary dictionary (valueTotalLength exceeds data size)");
   }
-  dict->valueBuffer.assign(data + offset, valueTotalLength);
+  const char* valueBuffer = data + offset;
   offset += valueTotalLength;
 
+  // Bytes after keyStart / valueStart up to the first NUL, which must lie
+  // within its buffer.
+  const auto terminatedView = [](const char* start, size_t available,
+                                 const char* what) {
+    const void* end = memchr(start, '\0', available);
+    if (end == nullptr) {
+      throw InvalidFormat(std::string("Invalid OpenCC binary dictionary (") +
+                          what + " not null-terminated)");
+    }
+    return std::string_view(start,
+                            static_cast<const char*>(end) - start);
+  };
+
+  std::vector<std::string_view> values;
   for (size_t i = 0; i < numItems; i++) {
     size_t numValues = readField();
     size_t keyOffset = readField();
     if (keyOffset >= keyTotalLength) {
       throw InvalidFormat("Invalid OpenCC binary dictionary (keyOffset)");
     }
-    const char* keyStart = dict->keyBuffer.c_str() + keyOffset;
-    if (memchr(keyStart, '\0', keyTotalLength - keyOffset) == nullptr) {
-      throw InvalidFormat(
-          "Invalid OpenCC binary dictionary (key not null-terminated)");
-    }
-    std::string key = keyStart;
-    std::vector<std::string> values;
+    const std::string_view key = terminatedView(
+        keyBuffer + keyOffset, keyTotalLength - keyOffset, "key");
+    values.clear();
     for (size_t j = 0; j < numValues; j++) {
       size_t valueOffset = readField();
       if (valueOffset >= valueTotalLength) {
         throw InvalidFormat("Invalid OpenCC binary dictionary (valueOffset)");
       }
-      const char* valueStart = dict->valueBuffer.c_str() + valueOffset;
-      if (memchr(valueStart, '\0', valueTotalLength - valueOffset) == nullptr) {
-        throw InvalidFormat(
-            "Invalid OpenCC binary dictionary (value not null-terminated)");
-      }
-      values.push_back(valueStart);
+      values.push_back(terminatedView(valueBuffer + valueOffset,
+                                      valueTotalLength - valueOffset,
+                                      "value"));
     }
-    DictEntry* entry = DictEntryFactory::New(key, values);
-    dict->lexicon->Add(entry);
+    visit(key, values);
   }
+  return numItems;
+}
+
+} // namespace
+
+BinaryDictPtr BinaryDict::NewFromBuffer(const char* data, size_t size) {
+  BinaryDictPtr dict(new BinaryDict(LexiconPtr(new Lexicon)));
+  ParseEntries(data, size,
+               [&dict](std::string_view key,
+                       const std::vector<std::string_view>& values) {
+                 dict->lexicon->Add(DictEntryFactory::New(
+                     std::string(key),
+                     std::vector<std::string>(values.begin(), values.end())));
+               });
   return dict;
 }
 
+size_t BinaryDict::VisitEntries(
+    const char* data, size_t size,
+    const std::function<void(std::string_view key,
+                             std::string_view defaultValue)>& visit) {
+  return ParseEntries(data, size,
+                      [&visit](std::string_view key,
+                               const std::vector<std::string_view>& values) {
+                        visit(key, values.empty() ? key : values.front());
+                      });
+}
+
 void BinaryDict::ConstructBuffer(std::string& keyBuf,
                                  std::vector<size_t>& keyOffset,
                                  size_t& keyTotalLength, std::string& valueBuf,
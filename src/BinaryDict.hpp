@@ -20,6 +20,8 @@
 
 #include <cstdint>
 #include <cstring>
+#include <functional>
+#include <string_view>
 
 #include "Common.hpp"
 #include "SerializableDict.hpp"
@@ -55,14 +57,24 @@ public:
   static BinaryDictPtr NewFromFile(FILE* fp);
   static BinaryDictPtr NewFromBuffer(const char* data, size_t size);
 
+  /**
+   * Calls @p visit for every entry of the serialized dictionary in
+   * [data, data + size), in order, with its key and default value (the key
+   * for an entry without values). Both are views into @p data; no entry is
+   * constructed. Applies the checks of NewFromBuffer() and throws
+   * InvalidFormat on malformed data. Returns the number of entries.
+   */
+  static size_t VisitEntries(
+      const char* data, size_t size,
+      const std::function<void(std::string_view key,
+                               std::string_view defaultValue)>& visit);
+
   const LexiconPtr& GetLexicon() const { return lexicon; }
 
   size_t KeyMaxLength() const;
 
 private:
   LexiconPtr lexicon;
-  std::string keyBuffer;
-  std::string valueBuffer;
 
   void ConstructBuffer(std::string& keyBuffer, std::vector<size_t>& keyOffset,
                        size_t& keyTotalLength, std::string& valueBuffer,
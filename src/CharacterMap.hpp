@@ -0,0 +1,197 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Dict.hpp"
+
+namespace opencc {
+namespace internal {
+
+constexpr uint32_t kInvalidCodePoint = UINT32_MAX;
+
+/**
+ * Decodes the UTF-8 character at the start of [str, str + len) and stores
+ * its length in @p charLength. Returns kInvalidCodePoint for truncated,
+ * overlong or otherwise malformed sequences, surrogates and code points
+ * above U+10FFFF. Decoding is strict so that every accepted code point has
+ * exactly one byte sequence: a table keyed by code point then matches the
+ * same bytes as a table keyed by the raw UTF-8.
+ */
+inline uint32_t DecodeUtf8(const char* str, size_t len, size_t* charLength) {
+  if (len == 0) {
+    return kInvalidCodePoint;
+  }
+  const unsigned char lead = static_cast<unsigned char>(str[0]);
+  if (lead < 0x80) {
+    *charLength = 1;
+    return lead;
+  }
+  uint32_t codePoint;
+  size_t length;
+  uint32_t minimum;
+  if ((lead & 0xE0) == 0xC0) {
+    codePoint = lead & 0x1FU;
+    length = 2;
+    minimum = 0x80;
+  } else if ((lead & 0xF0) == 0xE0) {
+    codePoint = lead & 0x0FU;
+    length = 3;
+    minimum = 0x800;
+  } else if ((lead & 0xF8) == 0xF0) {
+    codePoint = lead & 0x07U;
+    length = 4;
+    minimum = 0x10000;
+  } else {
+    return kInvalidCodePoint;
+  }
+  if (length > len) {
+    return kInvalidCodePoint;
+  }
+  for (size_t i = 1; i < length; i++) {
+    const unsigned char ch = static_cast<unsigned char>(str[i]);
+    if ((ch & 0xC0) != 0x80) {
+      return kInvalidCodePoint;
+    }
+    codePoint = (codePoint << 6) | (ch & 0x3FU);
+  }
+  if (codePoint < minimum || codePoint > 0x10FFFF ||
+      (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+    return kInvalidCodePoint;
+  }
+  *charLength = length;
+  return codePoint;
+}
+
+/**
+ * Two-level array from a code point to a 32-bit value: a block index per 256
+ * code points, then one shared array of 256-value blocks. Blocks without any
+ * value all map to block 0, which holds only kNone, so a lookup is two loads
+ * and no branch. Storage grows by 1 KiB per block in use; a CJK character
+ * dictionary uses about a hundred blocks.
+ */
+class CodePointTable {
+public:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  CodePointTable() : blocks(kNumBlocks, 0), values(kBlockSize, kNone) {}
+
+  void Set(uint32_t codePoint, uint32_t value) {
+    uint16_t& block = blocks[codePoint >> kBlockBits];
+    if (block == 0) {
+      block = static_cast<uint16_t>(values.size() >> kBlockBits);
+      values.resize(values.size() + kBlockSize, kNone);
+    }
+    values[(size_t(block) << kBlockBits) | (codePoint & (kBlockSize - 1))] =
+        value;
+  }
+
+  /** @p codePoint must be at most U+10FFFF. */
+  uint32_t Get(uint32_t codePoint) const {
+    return values[(size_t(blocks[codePoint >> kBlockBits]) << kBlockBits) |
+                  (codePoint & (kBlockSize - 1))];
+  }
+
+private:
+  static constexpr uint32_t kBlockBits = 8;
+  static constexpr uint32_t kBlockSize = 1U << kBlockBits;
+  static constexpr size_t kNumBlocks = 0x110000 >> kBlockBits;
+
+  std::vector<uint16_t> blocks;
+  std::vector<uint32_t> values;
+};
+
+/**
+ * Compiled form of a dictionary whose keys are all single characters: a
+ * CodePointTable from each key to its default value in a string arena.
+ * PrefixMatch builds one for such dictionaries instead of a trie, and the
+ * conversion loop calls MatchPrefixView() inline on it.
+ */
+class CharacterMap {
+public:
+  struct Value {
+    uint32_t codePoint;
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  /**
+   * Adds @p key unless it is already present. Returns false, adding
+   * nothing, if @p key is not exactly one valid UTF-8 character.
+   */
+  bool Add(std::string_view key, std::string_view value) {
+    size_t charLength = 0;
+    const uint32_t codePoint = DecodeUtf8(key.data(), key.size(), &charLength);
+    if (codePoint == kInvalidCodePoint || charLength != key.size()) {
+      return false;
+    }
+    if (table.Get(codePoint) == CodePointTable::kNone) {
+      Value stored{codePoint, static_cast<uint32_t>(arena.size()),
+                   static_cast<uint32_t>(value.size())};
+      arena.append(value.data(), value.size());
+      AddValue(stored);
+    }
+    return true;
+  }
+
+  /**
+   * Restores an entry written out from GetValues(); the caller has checked
+   * the value range against @p arena and the code point.
+   */
+  void AddValue(const Value& value) {
+    table.Set(value.codePoint, static_cast<uint32_t>(values.size()));
+    values.push_back(value);
+  }
+
+  /** Matches the character at the start of [word, word + len). */
+  PrefixMatchView MatchPrefixView(const char* word, size_t len) const {
+    size_t charLength = 0;
+    const uint32_t codePoint = DecodeUtf8(word, len, &charLength);
+    if (codePoint == kInvalidCodePoint) {
+      return PrefixMatchView{};
+    }
+    const uint32_t index = table.Get(codePoint);
+    if (index == CodePointTable::kNone) {
+      return PrefixMatchView{};
+    }
+    const Value& value = values[index];
+    return PrefixMatchView{
+        true, charLength, std::string_view(word, charLength),
+        std::string_view(arena.data() + value.offset, value.length)};
+  }
+
+  const std::vector<Value>& GetValues() const { return values; }
+
+  const std::string& GetArena() const { return arena; }
+
+  std::string& MutableArena() { return arena; }
+
+private:
+  CodePointTable table;
+  std::vector<Value> values;
+  std::string arena;
+};
+
+} // namespace internal
+} // namespace opencc
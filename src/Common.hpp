@@ -40,12 +40,14 @@ class Converter;
 class Dict;
 class DictEntry;
 class DictGroup;
+class FlatLexicon;
 class Lexicon;
 class MarisaDict;
 class MultiValueDictEntry;
 class NoValueDictEntry;
 class Segmentation;
 class Segments;
+struct SegmentSpan;
 class SerializableDict;
 class SingleValueDictEntry;
 class TextDict;
@@ -54,6 +56,7 @@ typedef std::shared_ptr<ConversionChain> ConversionChainPtr;
 typedef std::shared_ptr<Converter> ConverterPtr;
 typedef std::shared_ptr<Dict> DictPtr;
 typedef std::shared_ptr<DictGroup> DictGroupPtr;
+typedef std::shared_ptr<FlatLexicon> FlatLexiconPtr;
 typedef std::shared_ptr<Lexicon> LexiconPtr;
 typedef std::shared_ptr<MarisaDict> MarisaDictPtr;
 typedef std::shared_ptr<Segmentation> SegmentationPtr;
@@ -34,6 +34,7 @@
 #include "ConversionChain.hpp"
 #include "ConfigBasedConverter.hpp"
 #include "Converter.hpp"
+#include "ConverterSnapshot.hpp"
 #include "SingleStageConverter.hpp"
 #include "DictGroup.hpp"
 #include "Exception.hpp"
@@ -81,7 +82,8 @@ void PruneExpiredDictCache() {
   }
 }
 
-bool GetFileCacheKey(const std::string& path, std::string* cacheKey) {
+bool GetFileCacheKey(const std::string& path, std::string* cacheKey,
+                     size_t* fileSize) {
 #if defined(_WIN32) || defined(_WIN64)
   WIN32_FILE_ATTRIBUTE_DATA fileInfo;
   const std::wstring widePath = internal::WideFromUtf8(path);
@@ -112,6 +114,9 @@ bool GetFileCacheKey(const std::string& path, std::string* cacheKey) {
   cacheKey->push_back('.');
   cacheKey->append(
       std::to_string(static_cast<unsigned long long>(fileInfo.nFileSizeLow)));
+  *fileSize = static_cast<size_t>(
+      (static_cast<unsigned long long>(fileInfo.nFileSizeHigh) << 32) |
+      fileInfo.nFileSizeLow);
 #else
   cacheKey->append(std::to_string(static_cast<long long>(statBuf.st_mtime)));
   cacheKey->push_back('.');
@@ -127,6 +132,7 @@ bool GetFileCacheKey(const std::string& path, std::string* cacheKey) {
 #endif
   cacheKey->push_back('\n');
   cacheKey->append(std::to_string(static_cast<long long>(statBuf.st_size)));
+  *fileSize = static_cast<size_t>(statBuf.st_size);
 #endif
   return true;
 }
@@ -149,18 +155,24 @@ bool CanOpenFileUtf8(const std::string& path) {
   return true;
 }
 
-std::string ReadFileUtf8(const std::string& path) {
+// Reads the config file at path into content. Returns false, having read no
+// further than its first block, if the file is a converter snapshot, which is
+// loaded by mapping it instead.
+bool ReadConfigFileUtf8(const std::string& path, std::string* content) {
   FILE* fp = OpenFileUtf8(path, "rb");
   if (fp == nullptr) {
     throw FileNotFound(path);
   }
 
-  std::string content;
   char buffer[4096];
   for (;;) {
     const size_t read = fread(buffer, 1, sizeof(buffer), fp);
+    if (content->empty() && ConverterSnapshot::IsSnapshot(buffer, read)) {
+      fclose(fp);
+      return false;
+    }
     if (read > 0) {
-      content.append(buffer, read);
+      content->append(buffer, read);
     }
     if (read < sizeof(buffer)) {
       if (ferror(fp)) {
@@ -171,7 +183,7 @@ std::string ReadFileUtf8(const std::string& path) {
     }
   }
   fclose(fp);
-  return content;
+  return true;
 }
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -273,6 +285,13 @@ public:
   std::string configDirectory;
   std::shared_ptr<ResourceProvider> resourceProvider;
   ConfigLoadOptions options;
+  // Sizes of the dictionary files used by converters built so far, keyed by
+  // dictionary cache key so that a file used twice is counted once.
+  std::unordered_map<std::string, size_t> dictionaryBytes;
+
+  void RecordDictionary(const std::string& cacheKey, size_t size) {
+    dictionaryBytes[cacheKey] = size;
+  }
 
   const JSONValue& GetProperty(const JSONValue& doc, const char* name) {
     if (!doc.HasMember(name)) {
@@ -345,9 +364,11 @@ public:
     const std::string path = resourceProvider->Resolve(fileName);
     std::string cacheKey = cachePrefix;
     cacheKey.push_back('\n');
-    if (!GetFileCacheKey(path, &cacheKey)) {
+    size_t fileSize = 0;
+    if (!GetFileCacheKey(path, &cacheKey, &fileSize)) {
       throw FileNotFound(path);
     }
+    RecordDictionary(cacheKey, fileSize);
     {
       std::lock_guard<std::mutex> lock(DictCacheMutex());
       PruneExpiredDictCache();
@@ -383,6 +404,7 @@ public:
     const std::shared_ptr<const ResourceProvider::Resource> resource =
         resourceProvider->GetResource(fileName);
     std::string cacheKey = "text-darts\n" + resource->CacheKey();
+    RecordDictionary(cacheKey, resource->Size());
     {
       std::lock_guard<std::mutex> lock(DictCacheMutex());
       PruneExpiredDictCache();
@@ -418,6 +440,7 @@ public:
     const std::shared_ptr<const ResourceProvider::Resource> resource =
         resourceProvider->GetResource(fileName);
     std::string cacheKey = "ocd\n" + resource->CacheKey();
+    RecordDictionary(cacheKey, resource->Size());
     {
       std::lock_guard<std::mutex> lock(DictCacheMutex());
       PruneExpiredDictCache();
@@ -429,8 +452,10 @@ public:
         }
       }
     }
-    DictPtr dict =
-        DartsDict::NewFromBuffer(resource->Data(), resource->Size());
+    // As for OCD2, the resource keeps its bytes alive and the dictionary
+    // reads the double array and values from them in place.
+    DictPtr dict = DartsDict::NewFromSharedBuffer(
+        resource->Data(), resource->Size(), resource);
     {
       std::lock_guard<std::mutex> lock(DictCacheMutex());
       PruneExpiredDictCache();
@@ -452,6 +477,7 @@ public:
     const std::shared_ptr<const ResourceProvider::Resource> resource =
         resourceProvider->GetResource(fileName);
     std::string cacheKey = "ocd2-marisa\n" + resource->CacheKey();
+    RecordDictionary(cacheKey, resource->Size());
     {
       std::lock_guard<std::mutex> lock(DictCacheMutex());
       PruneExpiredDictCache();
@@ -464,7 +490,10 @@ public:
       }
     }
 
-    DictPtr dict = MarisaDict::NewFromBuffer(resource->Data(), resource->Size());
+    // The resource keeps its bytes (a file mapping or the zip archive) alive,
+    // so the dictionary can reference them instead of copying.
+    DictPtr dict = MarisaDict::NewFromSharedBuffer(
+        resource->Data(), resource->Size(), resource);
     {
       std::lock_guard<std::mutex> lock(DictCacheMutex());
       PruneExpiredDictCache();
@@ -478,6 +507,16 @@ public:
     }
   }
 
+  ConverterPtr LoadSnapshotFile(const std::string& path) {
+    ConverterPtr converter = ConverterSnapshot::NewFromFile(path, options);
+    std::string cacheKey = "snapshot\n";
+    size_t fileSize = 0;
+    if (GetFileCacheKey(path, &cacheKey, &fileSize)) {
+      RecordDictionary(cacheKey, fileSize);
+    }
+    return converter;
+  }
+
   DictPtr LoadDictFromFile(const std::string& type,
                            const std::string& fileName) {
     if (type == "text") {
@@ -493,7 +532,9 @@ public:
       }
       return LoadDictWithResourceProvider<DartsDict>("ocd", fileName);
     }
-    if (type == "ocd2") {
+    // OCD3 shares the Marisa trie container with OCD2; MarisaDict detects
+    // the layout from the file header, so both types load the same way.
+    if (type == "ocd2" || type == "ocd3") {
       if (resourceProvider != nullptr) {
         try {
           return LoadOcd2DictWithResourceProvider(fileName);
@@ -501,7 +542,7 @@ public:
           // Fallback to loading from resolved file path
         }
       }
-      return LoadDictWithResourceProvider<MarisaDict>("ocd2", fileName);
+      return LoadDictWithResourceProvider<MarisaDict>(type, fileName);
     }
     throw InvalidFormat("Unknown dictionary type: " + type);
     return nullptr;
@@ -647,7 +688,8 @@ public:
       } else {
       }
     }
-    ConversionChainPtr chain(new ConversionChain(conversions));
+    ConversionChainPtr chain(
+        new ConversionChain(conversions, options.compileConversionChains));
     return chain;
   }
 
@@ -735,6 +777,15 @@ Config::Config() : internal(new ConfigInternal()) {}
 
 Config::~Config() { delete reinterpret_cast<ConfigInternal*>(internal); }
 
+size_t Config::GetLoadedDictionaryBytes() const {
+  const ConfigInternal* impl = reinterpret_cast<const ConfigInternal*>(internal);
+  size_t total = 0;
+  for (const auto& dictionary : impl->dictionaryBytes) {
+    total += dictionary.second;
+  }
+  return total;
+}
+
 ConverterPtr Config::NewFromFile(const std::string& fileName) {
   return NewFromFile(fileName, std::vector<std::string>{}, nullptr);
 }
@@ -758,6 +809,13 @@ Config::NewFromFile(const std::string& fileName,
     try {
       const std::shared_ptr<const ResourceProvider::Resource> resource =
           provider->GetResource(fileName);
+      if (ConverterSnapshot::IsSnapshot(resource->Data(), resource->Size())) {
+        ConverterPtr converter = ConverterSnapshot::NewFromSharedBuffer(
+            resource->Data(), resource->Size(), resource, options);
+        impl->RecordDictionary("snapshot\n" + resource->CacheKey(),
+                               resource->Size());
+        return converter;
+      }
       impl->configDirectory = GetParentDirectory(resource->Name());
       return NewFromString(std::string(resource->Data(), resource->Size()),
                            provider, options);
@@ -772,7 +830,10 @@ Config::NewFromFile(const std::string& fileName,
   if (!isRegularFile(prefixedFileName)) {
     throw FileNotFound(prefixedFileName);
   }
-  std::string content = ReadFileUtf8(prefixedFileName);
+  std::string content;
+  if (!ReadConfigFileUtf8(prefixedFileName, &content)) {
+    return impl->LoadSnapshotFile(prefixedFileName);
+  }
 
 #if defined(_WIN32) || defined(_WIN64)
   UTF8Util::ReplaceAll(prefixedFileName, "\\", "/");
@@ -823,7 +884,10 @@ ConverterPtr Config::NewFromFile(const std::string& fileName,
   if (!isRegularFile(prefixedFileName)) {
     throw FileNotFound(prefixedFileName);
   }
-  std::string content = ReadFileUtf8(prefixedFileName);
+  std::string content;
+  if (!ReadConfigFileUtf8(prefixedFileName, &content)) {
+    return impl->LoadSnapshotFile(prefixedFileName);
+  }
 
 #if defined(_WIN32) || defined(_WIN64)
   UTF8Util::ReplaceAll(prefixedFileName, "\\", "/");
@@ -19,16 +19,11 @@
 #pragma once
 
 #include "Common.hpp"
+#include "ConfigLoadOptions.hpp"
 #include "ResourceProvider.hpp"
 
 namespace opencc {
 
-struct OPENCC_EXPORT ConfigLoadOptions {
-  ConfigLoadOptions() : includeTofuRiskDictionaries(true) {}
-
-  bool includeTofuRiskDictionaries;
-};
-
 /**
  * Configuration loader
  * @ingroup opencc_cpp_api
@@ -74,6 +69,15 @@ public:
                            const char* argv0,
                            const ConfigLoadOptions& options);
 
+  /**
+   * Returns the total size in bytes of the distinct dictionary files (and
+   * converter snapshots) used by the converters this Config has created,
+   * whether they were read from disk or shared with converters that were
+   * already loaded. Inline dictionaries are not counted. This approximates
+   * the memory the converters keep alive; see ConverterRegistry.
+   */
+  size_t GetLoadedDictionaryBytes() const;
+
 private:
   void* internal;
 };
@@ -18,9 +18,12 @@
 
 #pragma once
 
+#include <chrono>
 #include <utility>
 
 #include "Converter.hpp"
+#include "ConverterStats.hpp"
+#include "ScratchString.hpp"
 
 namespace opencc {
 /**
@@ -41,9 +44,32 @@ public:
         mainConverter(std::move(mainConverter)) {}
 
   std::string Convert(std::string_view text) const override {
+    std::string converted;
+    if (AppendConvertedIfRecording(text, &converted)) {
+      return converted;
+    }
     return mainConverter->Convert(normConverter->Convert(text));
   }
 
+  void AppendConverted(std::string_view text,
+                       std::string* output) const override {
+    if (AppendConvertedIfRecording(text, output)) {
+      return;
+    }
+    internal::ScratchString normalized;
+    normConverter->AppendConverted(text, &normalized.value);
+    mainConverter->AppendConverted(normalized.value, output);
+  }
+
+  void AppendConvertedProfiled(std::string_view text, std::string* output,
+                               ConversionProfile* profile) const override {
+    internal::ScratchString normalized;
+    const auto start = std::chrono::steady_clock::now();
+    normConverter->AppendConverted(text, &normalized.value);
+    profile->normalizationNanos += internal::NanosSince(start);
+    mainConverter->AppendConvertedProfiled(normalized.value, output, profile);
+  }
+
   ConversionInspectionResult Inspect(std::string_view text) const override {
     ConversionInspectionResult result;
     result.input = text;
@@ -71,6 +97,9 @@ public:
     return normConverter;
   }
 
+  /** Returns the converter run after the normalization pre-pass. */
+  const ConverterPtr& GetMainConverter() const { return mainConverter; }
+
 private:
   const ConverterPtr normConverter;
   const ConverterPtr mainConverter;
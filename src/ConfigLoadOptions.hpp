@@ -0,0 +1,43 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Export.hpp"
+
+namespace opencc {
+
+/**
+ * Options for loading a converter from a config. Converter snapshots record
+ * the options they were written with; see ConverterSnapshot.
+ * @ingroup opencc_cpp_api
+ */
+struct OPENCC_EXPORT ConfigLoadOptions {
+  ConfigLoadOptions()
+      : includeTofuRiskDictionaries(true), compileConversionChains(false) {}
+
+  bool includeTofuRiskDictionaries;
+  /**
+   * Compose adjacent conversion chain stages into single-pass stages where
+   * this is provably equivalent. Output is unchanged; loading takes longer
+   * and uses more memory. See ConversionChain.
+   */
+  bool compileConversionChains;
+};
+
+} // namespace opencc
@@ -16,7 +16,12 @@
  * limitations under the License.
  */
 
+#include <mutex>
+
+#include "CharacterMap.hpp"
 #include "Conversion.hpp"
+#include "ConverterStats.hpp"
+#include "KeyHitProfile.hpp"
 #include "PrefixMatch.hpp"
 #include "Segments.hpp"
 #include "UTF8Util.hpp"
@@ -26,8 +31,62 @@ using namespace opencc;
 Conversion::Conversion(DictPtr _dict)
     : dict(_dict), prefixMatch(new PrefixMatch(_dict)) {}
 
-void Conversion::AppendConverted(std::string_view phrase,
-                                  std::string* output) const {
+Conversion::Conversion(DictPtr _dict, std::shared_ptr<PrefixMatch> _prefixMatch)
+    : dict(_dict), prefixMatch(_prefixMatch) {}
+
+namespace {
+
+// Recording policies for AppendConvertedWith(). The plain conversion path
+// instantiates the no-op one, so it pays nothing for the counters.
+struct NoMatchRecords {
+  void Matched(const char*, size_t) {}
+  void Unmatched(size_t, size_t) {}
+};
+
+struct RecordMatches {
+  void Matched(const char* key, size_t length) {
+    if (counts != nullptr) {
+      counts->matches++;
+      counts->matchedBytes += length;
+    }
+    if (hits != nullptr) {
+      hits->Record(std::string_view(key, length));
+    }
+  }
+  void Unmatched(size_t length, size_t skipped) {
+    if (counts != nullptr) {
+      counts->unmatchedBytes += length;
+      counts->skipScanBytes += skipped;
+    }
+  }
+
+  MatchCounts* counts;
+  KeyHitProfile* hits;
+};
+
+// Key lookups for AppendConvertedWith(). A character map is looked up
+// inline, so a stage of single characters runs in one tight loop with no
+// virtual call per character.
+struct PrefixMatchLookup {
+  PrefixMatchView MatchPrefixView(const char* word, size_t len) const {
+    return prefixMatch.MatchPrefixView(word, len);
+  }
+
+  const PrefixMatch& prefixMatch;
+};
+
+struct CharacterMapLookup {
+  PrefixMatchView MatchPrefixView(const char* word, size_t len) const {
+    return characters.MatchPrefixView(word, len);
+  }
+
+  const internal::CharacterMap& characters;
+};
+
+template <typename Lookup, typename Records>
+void AppendConvertedWith(const PrefixMatch& prefixMatch, Lookup lookup,
+                         std::string_view phrase, std::string* output,
+                         Records records) {
   if (phrase.empty()) {
     return;
   }
@@ -39,7 +98,7 @@ void Conversion::AppendConverted(std::string_view phrase,
   for (const char* pstr = phraseData; pstr < phraseEnd;) {
     size_t remainingLength = phraseEnd - pstr;
     const PrefixMatchView matched =
-        prefixMatch->MatchPrefixView(pstr, remainingLength);
+        lookup.MatchPrefixView(pstr, remainingLength);
     size_t matchedLength;
     if (!matched.matched) {
       matchedLength =
@@ -54,20 +113,78 @@ void Conversion::AppendConverted(std::string_view phrase,
       // Extend the unmatched run over characters that cannot begin any
       // dictionary key; each of them would fail the prefix lookup, so they
       // are consumed with a single bulk scan and one append.
-      matchedLength += prefixMatch->SkipUnmatchable(
+      const size_t skipped = prefixMatch.SkipUnmatchable(
           pstr + matchedLength, remainingLength - matchedLength);
+      matchedLength += skipped;
+      records.Unmatched(matchedLength, skipped);
       output->append(pstr, matchedLength);
     } else {
       matchedLength = matched.keyLength;
       if (matchedLength > remainingLength) {
         matchedLength = remainingLength;
       }
+      records.Matched(pstr, matchedLength);
       output->append(matched.value.data(), matched.value.size());
     }
     pstr += matchedLength;
   }
 }
 
+// Guards enabling the key hit profile of any conversion.
+std::mutex& KeyHitProfileMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+} // namespace
+
+void Conversion::AppendConverted(std::string_view phrase,
+                                  std::string* output) const {
+  AppendConverted(phrase, output, nullptr);
+}
+
+void Conversion::AppendConverted(std::string_view phrase, std::string* output,
+                                 MatchCounts* counts) const {
+  KeyHitProfile* hits = keyHitProfile.load(std::memory_order_acquire);
+  const internal::CharacterMap* characters = prefixMatch->GetCharacterMap();
+  if (counts == nullptr && hits == nullptr) {
+    if (characters != nullptr) {
+      AppendConvertedWith(*prefixMatch, CharacterMapLookup{*characters},
+                          phrase, output, NoMatchRecords());
+    } else {
+      AppendConvertedWith(*prefixMatch, PrefixMatchLookup{*prefixMatch},
+                          phrase, output, NoMatchRecords());
+    }
+  } else {
+    AppendConvertedWith(*prefixMatch, PrefixMatchLookup{*prefixMatch}, phrase,
+                        output, RecordMatches{counts, hits});
+  }
+}
+
+std::shared_ptr<KeyHitProfile> Conversion::EnableKeyHitProfile() {
+  std::lock_guard<std::mutex> lock(KeyHitProfileMutex());
+  if (keyHitProfileOwner == nullptr) {
+    keyHitProfileOwner.reset(new KeyHitProfile);
+  }
+  keyHitProfileUsers++;
+  keyHitProfile.store(keyHitProfileOwner.get(), std::memory_order_release);
+  return keyHitProfileOwner;
+}
+
+void Conversion::DisableKeyHitProfile() {
+  std::lock_guard<std::mutex> lock(KeyHitProfileMutex());
+  if (keyHitProfileUsers > 0 && --keyHitProfileUsers == 0) {
+    // The profile stays alive: conversions that loaded the pointer before
+    // this call may still be counting into it.
+    keyHitProfile.store(nullptr, std::memory_order_release);
+  }
+}
+
+std::shared_ptr<KeyHitProfile> Conversion::GetKeyHitProfile() const {
+  std::lock_guard<std::mutex> lock(KeyHitProfileMutex());
+  return keyHitProfileUsers > 0 ? keyHitProfileOwner : nullptr;
+}
+
 std::string Conversion::Convert(std::string_view phrase) const {
   if (phrase.empty()) {
     return std::string();
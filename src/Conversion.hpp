@@ -18,12 +18,15 @@
 
 #pragma once
 
+#include <atomic>
 #include <string_view>
 
 #include "Common.hpp"
 #include "Segmentation.hpp"
 
 namespace opencc {
+class KeyHitProfile;
+struct MatchCounts;
 class PrefixMatch;
 
 /**
@@ -45,6 +48,13 @@ public:
   /** Constructs a Conversion backed by @p dict. */
   Conversion(DictPtr _dict);
 
+  /**
+   * Constructs a Conversion backed by @p dict that looks keys up through
+   * @p prefixMatch, which must have been built for @p dict (e.g. restored
+   * from a converter snapshot).
+   */
+  Conversion(DictPtr _dict, std::shared_ptr<PrefixMatch> _prefixMatch);
+
   /**
    * Converts @p phrase using prefix-match replacement and returns the result.
    * @param phrase UTF-8 text; need not be null-terminated.
@@ -65,6 +75,13 @@ public:
    */
   void AppendConverted(std::string_view phrase, std::string* output) const;
 
+  /**
+   * Like AppendConverted(std::string_view, std::string*), and adds the
+   * matches made to @p counts unless it is @c nullptr.
+   */
+  void AppendConverted(std::string_view phrase, std::string* output,
+                       MatchCounts* counts) const;
+
   /**
    * Converts @p phrase and appends the result to @p output.
    * @param phrase Null-terminated UTF-8 text.
@@ -81,8 +98,34 @@ public:
   /** Returns the backing dictionary. */
   const DictPtr GetDict() const { return dict; }
 
+  /** Returns the prefix matcher that keys are looked up through. */
+  const std::shared_ptr<PrefixMatch>& GetPrefixMatch() const {
+    return prefixMatch;
+  }
+
+  /**
+   * Starts counting the keys this conversion matches and returns the
+   * profile; see KeyHitProfiler for attributing them to dictionaries. The
+   * profile is created on the first call and kept for the lifetime of the
+   * conversion. Calls nest: counting stops when each of them has been
+   * balanced by DisableKeyHitProfile().
+   */
+  std::shared_ptr<KeyHitProfile> EnableKeyHitProfile();
+
+  /** Balances one EnableKeyHitProfile() call. */
+  void DisableKeyHitProfile();
+
+  /**
+   * Returns the profile while counting is enabled, or @c nullptr otherwise.
+   */
+  std::shared_ptr<KeyHitProfile> GetKeyHitProfile() const;
+
 private:
   const DictPtr dict;
   const std::shared_ptr<PrefixMatch> prefixMatch;
+  // Points to keyHitProfileOwner's profile while counting is enabled.
+  std::atomic<KeyHitProfile*> keyHitProfile{nullptr};
+  std::shared_ptr<KeyHitProfile> keyHitProfileOwner;
+  size_t keyHitProfileUsers = 0;
 };
 } // namespace opencc
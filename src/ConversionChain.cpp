@@ -15,18 +15,376 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-
+#include <chrono>
 #include <list>
 #include <string_view>
+#include <unordered_set>
+#include <utility>
 
 #include "ConversionChain.hpp"
+#include "ConverterStats.hpp"
+#include "DictEntries.hpp"
+#include "DictGroup.hpp"
+#include "Lexicon.hpp"
 #include "Segments.hpp"
+#include "TextDict.hpp"
+#include "UTF8Util.hpp"
+#include "Utf8SkipScan.hpp"
 
 using namespace opencc;
 
+class ConversionChain::CompiledStage {
+public:
+  CompiledStage() { guard.EnableCharLevel(); }
+
+  bool IsFused() const { return staged.size() > 1; }
+
+  // True when the single-pass conversion may be used for segment, i.e. the
+  // guard lets the whole segment through.
+  bool CanRunFused(std::string_view segment) const {
+    return internal::SkipNonCandidateBytes(guard, segment.data(),
+                                           segment.size()) == segment.size();
+  }
+
+  // Produces the same output as running staged in order on every segment
+  // accepted by CanRunFused().
+  ConversionPtr conversion;
+  // The original conversions, in order. Holds just conversion itself when
+  // nothing was composed into this stage.
+  std::vector<ConversionPtr> staged;
+  // Characters that may make the composition diverge from staged execution.
+  // Ideographic description operators are always included by Finalize().
+  internal::Utf8SkipTable guard;
+};
+
+namespace {
+
+struct StageBuffers {
+  std::string first;
+  std::string second;
+};
+
+// Intermediate stage output is written to per-thread buffers that keep their
+// capacity across segments, so a multi-stage chain does not allocate per
+// segment. Fallback buffers are separate because a compiled stage falls back
+// to staged execution while the outer buffers hold its input.
+struct ChainScratch {
+  StageBuffers stages;
+  StageBuffers fallback;
+};
+
+ChainScratch& ThreadChainScratch() {
+  static thread_local ChainScratch scratch;
+  return scratch;
+}
+
+// Do not keep the buffers of an occasional huge unsegmented input alive for
+// the lifetime of the thread.
+const size_t kMaxRetainedScratchCapacity = 1 << 20;
+
+void ReleaseOversizedScratch(std::string* buffer) {
+  if (buffer->capacity() > kMaxRetainedScratchCapacity) {
+    std::string().swap(*buffer);
+  }
+}
+
+void ReleaseOversizedScratch(ChainScratch* scratch) {
+  ReleaseOversizedScratch(&scratch->stages.first);
+  ReleaseOversizedScratch(&scratch->stages.second);
+  ReleaseOversizedScratch(&scratch->fallback.first);
+  ReleaseOversizedScratch(&scratch->fallback.second);
+}
+
+// Runs the passes [first, last) over segment, feeding each pass's output to
+// the next through buffers, and appends the last pass's output to output.
+// first must not equal last.
+template <typename Iterator, typename Apply>
+void RunPasses(Iterator first, Iterator last, std::string_view segment,
+               std::string* output, StageBuffers* buffers, Apply apply) {
+  Iterator lastPass = last;
+  --lastPass;
+  std::string_view input = segment;
+  std::string* current = &buffers->first;
+  std::string* spare = &buffers->second;
+  for (Iterator pass = first; pass != lastPass; ++pass) {
+    current->clear();
+    apply(*pass, input, current);
+    input = *current;
+    std::swap(current, spare);
+  }
+  apply(*lastPass, input, output);
+}
+
+struct SpanBuffers {
+  std::vector<SegmentSpan> first;
+  std::vector<SegmentSpan> second;
+};
+
+SpanBuffers& ThreadProfileSpans() {
+  static thread_local SpanBuffers spans;
+  return spans;
+}
+
+// Runs the passes [first, last) over every segment of text described by
+// spans, completing each pass over all segments before starting the next so
+// that it is timed once. Appends the last pass's output to output and adds
+// the pass times to profile from stage profile->stageCount on.
+template <typename Iterator, typename Apply>
+void RunPassesProfiled(Iterator first, Iterator last, std::string_view text,
+                       const std::vector<SegmentSpan>& spans,
+                       std::string* output, StageBuffers* buffers,
+                       ConversionProfile* profile, Apply apply) {
+  SpanBuffers& spanBuffers = ThreadProfileSpans();
+  std::string_view input = text;
+  const std::vector<SegmentSpan>* inputSpans = &spans;
+  std::string* current = &buffers->first;
+  std::string* spare = &buffers->second;
+  std::vector<SegmentSpan>* currentSpans = &spanBuffers.first;
+  std::vector<SegmentSpan>* spareSpans = &spanBuffers.second;
+  size_t stage = profile->stageCount;
+  for (Iterator pass = first; pass != last; ++pass, ++stage) {
+    Iterator next = pass;
+    const bool lastPass = ++next == last;
+    std::string* out = lastPass ? output : current;
+    current->clear();
+    currentSpans->clear();
+    const auto start = std::chrono::steady_clock::now();
+    for (const SegmentSpan& span : *inputSpans) {
+      if (span.length == 0) {
+        continue;
+      }
+      const size_t offset = out->size();
+      apply(*pass, input.substr(span.offset, span.length), out);
+      if (!lastPass) {
+        currentSpans->push_back(SegmentSpan{offset, out->size() - offset});
+      }
+    }
+    profile->AddStageNanos(stage, internal::NanosSince(start));
+    input = *current;
+    inputSpans = currentSpans;
+    std::swap(current, spare);
+    std::swap(currentSpans, spareSpans);
+  }
+  profile->stageCount = stage;
+}
+
+void AppendConvertedStaged(const std::vector<ConversionPtr>& conversions,
+                           std::string_view segment, std::string* output,
+                           StageBuffers* buffers) {
+  RunPasses(conversions.begin(), conversions.end(), segment, output, buffers,
+            [](const ConversionPtr& conversion, std::string_view input,
+               std::string* out) { conversion->AppendConverted(input, out); });
+}
+
+// What composing a conversion into the stage before it needs to know about
+// that conversion's keys.
+struct ComposedKeys {
+  ComposedKeys() { continuationChars.EnableCharLevel(); }
+
+  std::unordered_set<std::string> singleCharKeys;
+  // Every character that occurs after the first character of a key. A match
+  // can only run across the boundary in front of such a character.
+  internal::Utf8SkipTable continuationChars;
+};
+
+// Records a key of the conversion being composed. Returns false for empty
+// keys and keys that are not valid UTF-8 character sequences, whose matching
+// cannot be reasoned about character by character.
+bool AddComposedKey(const char* key, size_t len, ComposedKeys* keys) {
+  if (len == 0) {
+    return false;
+  }
+  for (size_t pos = 0; pos < len;) {
+    const size_t charLength = UTF8Util::NextCharLengthNoException(key + pos);
+    if (charLength == 0 || charLength > len - pos) {
+      return false;
+    }
+    if (pos > 0) {
+      internal::MarkKeyFirstChar(&keys->continuationChars, key + pos,
+                                 charLength);
+    }
+    pos += charLength;
+  }
+  if (UTF8Util::NextCharLengthNoException(key) == len) {
+    keys->singleCharKeys.insert(std::string(key, len));
+  }
+  return true;
+}
+
+bool CollectComposedKeys(const DictPtr& dict, ComposedKeys* keys) {
+  const std::list<DictPtr>* items = dict->GetDictGroupItems();
+  if (items != nullptr) {
+    for (const DictPtr& child : *items) {
+      if (!CollectComposedKeys(child, keys)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool valid = true;
+  const bool enumerated = internal::EnumerateDictEntries(
+      *dict, [&valid, keys](std::string_view key, std::string_view) {
+        valid = AddComposedKey(key.data(), key.size(), keys);
+        return valid;
+      });
+  return enumerated && valid;
+}
+
+// Returns true if a conversion with the given keys converts value the same
+// way on its own as inside a longer text in which no match can run across
+// the end of value: no match may run into value from the left (its first
+// character continues no key), and value must contain no ideographic
+// description operator, invalid or truncated sequence (all of which idsTable
+// stops at), since those are grouped without regard to piece boundaries.
+bool ConvertsInIsolation(std::string_view value, const ComposedKeys& keys,
+                         const internal::Utf8SkipTable& idsTable) {
+  if (internal::SkipNonCandidateBytes(idsTable, value.data(), value.size()) !=
+      value.size()) {
+    return false;
+  }
+  if (value.empty()) {
+    return true;
+  }
+  const size_t firstCharLength =
+      UTF8Util::NextCharLengthNoException(value.data());
+  return internal::SkipNonCandidateBytes(keys.continuationChars, value.data(),
+                                         firstCharLength) == firstCharLength;
+}
+
+// Returns a dictionary with the same keys and group structure as dict whose
+// values have been run through next. A value next would not necessarily
+// convert the same way in isolation is kept as is, and its key's first
+// character is marked in guard so that no segment that could match it takes
+// the composed path. Returns nullptr when a leaf's entries are unavailable.
+DictPtr ComposeDict(const DictPtr& dict, const Conversion& next,
+                    const ComposedKeys& nextKeys,
+                    const internal::Utf8SkipTable& idsTable,
+                    internal::Utf8SkipTable* guard) {
+  const std::list<DictPtr>* items = dict->GetDictGroupItems();
+  if (items != nullptr) {
+    std::list<DictPtr> children;
+    for (const DictPtr& child : *items) {
+      DictPtr composed = ComposeDict(child, next, nextKeys, idsTable, guard);
+      if (composed == nullptr) {
+        return nullptr;
+      }
+      children.push_back(composed);
+    }
+    if (dict->GetMatchPolicy() == DictGroupMatchPolicy::Union) {
+      return DictPtr(new UnionDictGroup(children));
+    }
+    return DictPtr(new DictGroup(children, dict->GetMatchPolicy()));
+  }
+  LexiconPtr composed(new Lexicon);
+  auto compose = [&](std::string_view key, std::string_view value) {
+    if (ConvertsInIsolation(value, nextKeys, idsTable)) {
+      composed->Add(DictEntryFactory::New(std::string(key),
+                                          next.Convert(value)));
+    } else {
+      internal::MarkKeyFirstChar(guard, key.data(), key.size());
+      composed->Add(
+          DictEntryFactory::New(std::string(key), std::string(value)));
+    }
+    return true;
+  };
+  // Entries are read from the leaf's storage where possible, so that
+  // composing does not construct its lexicon.
+  if (!internal::EnumerateDictEntries(*dict, compose)) {
+    return nullptr;
+  }
+  composed->Sort();
+  return DictPtr(new TextDict(composed));
+}
+
+// Composes next into stage. Running the result is equivalent to running
+// next after stage on a segment as long as no match of next runs across the
+// boundary between two pieces of stage's output (a value stage emitted for a
+// match, or a character stage passed through):
+//  - at a position where stage matches, the composed dict emits the value
+//    with next already applied, which is what next produces for it in
+//    context when ConvertsInIsolation() holds;
+//  - at a position where stage does not match, the character passes through
+//    stage, and a fallback dict of next's single-character keys converts it
+//    the way next would.
+// A match can only run across a boundary in front of a piece that starts
+// with a continuation character of next's keys. The guard therefore
+// collects next's continuation characters (for pieces passed through) and
+// the first characters of stage's keys whose values start with one or do
+// not convert in isolation otherwise; segments it stops in run the original
+// conversions instead. Returns nullptr when next cannot be composed at all.
+std::shared_ptr<ConversionChain::CompiledStage>
+ComposeStage(const ConversionChain::CompiledStage& stage,
+             const ConversionPtr& next) {
+  ComposedKeys nextKeys;
+  if (!CollectComposedKeys(next->GetDict(), &nextKeys)) {
+    return nullptr;
+  }
+  nextKeys.continuationChars.Finalize();
+  internal::Utf8SkipTable idsTable;
+  idsTable.EnableCharLevel();
+  idsTable.Finalize();
+
+  std::shared_ptr<ConversionChain::CompiledStage> composed(
+      new ConversionChain::CompiledStage);
+  composed->guard = stage.guard;
+  composed->guard.MergeCandidates(nextKeys.continuationChars);
+  DictPtr composedDict = ComposeDict(stage.conversion->GetDict(), *next,
+                                     nextKeys, idsTable, &composed->guard);
+  if (composedDict == nullptr) {
+    return nullptr;
+  }
+  if (!nextKeys.singleCharKeys.empty()) {
+    LexiconPtr charLexicon(new Lexicon);
+    for (const std::string& key : nextKeys.singleCharKeys) {
+      charLexicon->Add(DictEntryFactory::New(key, next->Convert(key)));
+    }
+    charLexicon->Sort();
+    composedDict.reset(new DictGroup(
+        std::list<DictPtr>{composedDict, DictPtr(new TextDict(charLexicon))},
+        DictGroupMatchPolicy::ShortCircuit));
+  }
+  composed->guard.Finalize();
+  composed->conversion.reset(new Conversion(composedDict));
+  composed->staged = stage.staged;
+  composed->staged.push_back(next);
+  return composed;
+}
+
+} // namespace
+
 ConversionChain::ConversionChain(const std::list<ConversionPtr> _conversions)
     : conversions(_conversions) {}
 
+ConversionChain::ConversionChain(const std::list<ConversionPtr> _conversions,
+                                 bool compile)
+    : conversions(_conversions) {
+  if (compile) {
+    Compile();
+  }
+}
+
+void ConversionChain::Compile() {
+  for (const ConversionPtr& conversion : conversions) {
+    if (!compiledStages.empty()) {
+      std::shared_ptr<const CompiledStage> composed =
+          ComposeStage(*compiledStages.back(), conversion);
+      if (composed != nullptr) {
+        compiledStages.back() = composed;
+        continue;
+      }
+    }
+    std::shared_ptr<CompiledStage> stage(new CompiledStage);
+    stage->guard.Finalize();
+    stage->conversion = conversion;
+    stage->staged.push_back(conversion);
+    compiledStages.push_back(stage);
+  }
+}
+
+size_t ConversionChain::GetPassCount() const {
+  return compiledStages.empty() ? conversions.size() : compiledStages.size();
+}
+
 SegmentsPtr ConversionChain::Convert(const SegmentsPtr& input) const {
   SegmentsPtr output = input;
   for (auto conversion : conversions) {
@@ -37,28 +395,7 @@ SegmentsPtr ConversionChain::Convert(const SegmentsPtr& input) const {
 
 void ConversionChain::AppendConvertedSegment(const char* segment,
                                              std::string* output) const {
-  if (conversions.empty()) {
-    output->append(segment);
-    return;
-  }
-
-  auto conversion = conversions.begin();
-  auto lastConversion = conversions.end();
-  --lastConversion;
-  if (conversion == lastConversion) {
-    (*conversion)->AppendConverted(segment, output);
-    return;
-  }
-
-  std::string converted;
-  (*conversion)->AppendConverted(segment, &converted);
-  ++conversion;
-  for (; conversion != lastConversion; ++conversion) {
-    std::string next;
-    (*conversion)->AppendConverted(converted, &next);
-    converted.swap(next);
-  }
-  (*lastConversion)->AppendConverted(converted, output);
+  AppendConvertedSegment(std::string_view(segment), output);
 }
 
 void ConversionChain::AppendConvertedSegment(std::string_view segment,
@@ -70,24 +407,97 @@ void ConversionChain::AppendConvertedSegment(std::string_view segment,
     output->append(segment.data(), segment.size());
     return;
   }
+  if (conversions.size() == 1) {
+    conversions.front()->AppendConverted(segment, output);
+    return;
+  }
+
+  AppendConvertedMultiStage(segment, output);
+  ReleaseOversizedScratch(&ThreadChainScratch());
+}
 
-  auto conversion = conversions.begin();
-  auto lastConversion = conversions.end();
-  --lastConversion;
-  if (conversion == lastConversion) {
-    (*conversion)->AppendConverted(segment, output);
+void ConversionChain::AppendConvertedSegments(
+    std::string_view text, const std::vector<SegmentSpan>& spans,
+    std::string* output) const {
+  if (conversions.size() <= 1) {
+    for (const SegmentSpan& span : spans) {
+      AppendConvertedSegment(text.substr(span.offset, span.length), output);
+    }
     return;
   }
+  for (const SegmentSpan& span : spans) {
+    if (span.length > 0) {
+      AppendConvertedMultiStage(text.substr(span.offset, span.length), output);
+    }
+  }
+  ReleaseOversizedScratch(&ThreadChainScratch());
+}
+
+void ConversionChain::AppendConvertedMultiStage(std::string_view segment,
+                                                std::string* output) const {
+  ChainScratch& scratch = ThreadChainScratch();
+  if (compiledStages.empty()) {
+    RunPasses(conversions.begin(), conversions.end(), segment, output,
+              &scratch.stages,
+              [](const ConversionPtr& conversion, std::string_view input,
+                 std::string* out) {
+                conversion->AppendConverted(input, out);
+              });
+  } else {
+    RunPasses(compiledStages.begin(), compiledStages.end(), segment, output,
+              &scratch.stages,
+              [&scratch](const std::shared_ptr<const CompiledStage>& stage,
+                         std::string_view input, std::string* out) {
+                if (!stage->IsFused() || stage->CanRunFused(input)) {
+                  stage->conversion->AppendConverted(input, out);
+                } else {
+                  AppendConvertedStaged(stage->staged, input, out,
+                                        &scratch.fallback);
+                }
+              });
+  }
+}
 
-  std::string converted;
-  (*conversion)->AppendConverted(segment, &converted);
-  ++conversion;
-  for (; conversion != lastConversion; ++conversion) {
-    std::string next;
-    (*conversion)->AppendConverted(std::string_view(converted), &next);
-    converted.swap(next);
+void ConversionChain::AppendConvertedSegmentsProfiled(
+    std::string_view text, const std::vector<SegmentSpan>& spans,
+    std::string* output, ConversionProfile* profile) const {
+  if (conversions.empty()) {
+    for (const SegmentSpan& span : spans) {
+      output->append(text.substr(span.offset, span.length));
+    }
+    return;
+  }
+  MatchCounts* counts = &profile->matches;
+  ChainScratch& scratch = ThreadChainScratch();
+  auto applyConversion = [counts](const ConversionPtr& conversion,
+                                  std::string_view input, std::string* out) {
+    conversion->AppendConverted(input, out, counts);
+  };
+  if (compiledStages.empty()) {
+    RunPassesProfiled(conversions.begin(), conversions.end(), text, spans,
+                      output, &scratch.stages, profile, applyConversion);
+  } else {
+    RunPassesProfiled(
+        compiledStages.begin(), compiledStages.end(), text, spans, output,
+        &scratch.stages, profile,
+        [&](const std::shared_ptr<const CompiledStage>& stage,
+            std::string_view input, std::string* out) {
+          if (!stage->IsFused() || stage->CanRunFused(input)) {
+            stage->conversion->AppendConverted(input, out, counts);
+          } else {
+            RunPasses(stage->staged.begin(), stage->staged.end(), input, out,
+                      &scratch.fallback, applyConversion);
+          }
+        });
+  }
+  ReleaseOversizedScratch(&scratch);
+  for (std::vector<SegmentSpan>* spanBuffer :
+       {&ThreadProfileSpans().first, &ThreadProfileSpans().second}) {
+    if (spanBuffer->capacity() * sizeof(SegmentSpan) >
+        kMaxRetainedScratchCapacity) {
+      std::vector<SegmentSpan>().swap(*spanBuffer);
+    }
   }
-  (*lastConversion)->AppendConverted(std::string_view(converted), output);
 }
 
 std::vector<SegmentsPtr>
@@ -19,11 +19,15 @@
 #pragma once
 
 #include <list>
+#include <string_view>
+#include <vector>
 
 #include "Common.hpp"
 #include "Conversion.hpp"
 
 namespace opencc {
+struct ConversionProfile;
+
 /**
  * An ordered sequence of @c Conversion objects applied to pre-segmented text.
  *
@@ -40,9 +44,32 @@ namespace opencc {
  */
 class OPENCC_EXPORT ConversionChain {
 public:
+  class CompiledStage;
+
   /** Constructs a chain from an ordered list of conversions. */
   ConversionChain(const std::list<ConversionPtr> _conversions);
 
+  /**
+   * Constructs a chain from an ordered list of conversions and, when
+   * @p compile is true, composes adjacent conversions ahead of time into
+   * single-pass stages.
+   *
+   * The composed stage matches the earlier conversion's keys, emits their
+   * values already run through the later conversion, and converts
+   * characters the earlier conversion passes through the way the later one
+   * would. This is equivalent to staged execution as long as no match of the
+   * later conversion spans two pieces of the earlier one's output. Each
+   * compiled stage records the characters that could make that happen (and
+   * ideographic description operators); segments containing any of them fall
+   * back to running the original conversions one after another, so the
+   * output of AppendConvertedSegment() is identical in both modes. Compiling
+   * costs a copy of the composed dictionaries' lexicons.
+   *
+   * Convert() and ConvertWithTrace() always run the original conversions
+   * stage by stage.
+   */
+  ConversionChain(const std::list<ConversionPtr> _conversions, bool compile);
+
   /**
    * Passes @p input through every conversion in the chain sequentially and
    * returns the final @c Segments.
@@ -65,6 +92,30 @@ public:
   void AppendConvertedSegment(std::string_view segment,
                               std::string* output) const;
 
+  /**
+   * Converts every segment of @p text described by @p spans (byte ranges of
+   * @p text, e.g. from Segmentation::SegmentSpans()) and appends the results
+   * to @p output in order. Equivalent to calling AppendConvertedSegment() on
+   * each span.
+   */
+  void AppendConvertedSegments(std::string_view text,
+                               const std::vector<SegmentSpan>& spans,
+                               std::string* output) const;
+
+  /**
+   * Like AppendConvertedSegments(), and adds the time spent in each pass and
+   * the dictionary matches made to @p profile. Pass i is recorded as stage
+   * profile->stageCount + i, and stageCount is advanced by GetPassCount().
+   *
+   * To time each pass once rather than once per segment, every pass runs
+   * over all segments before the next one starts, with the intermediate
+   * results kept in per-thread buffers. The output is the same.
+   */
+  void AppendConvertedSegmentsProfiled(std::string_view text,
+                                       const std::vector<SegmentSpan>& spans,
+                                       std::string* output,
+                                       ConversionProfile* profile) const;
+
   /**
    * Converts @p input through the chain and records every intermediate
    * @c Segments after each conversion stage.
@@ -75,7 +126,23 @@ public:
   /** Returns the list of conversions in application order. */
   const std::list<ConversionPtr> GetConversions() const { return conversions; }
 
+  /**
+   * Returns the number of passes AppendConvertedSegment() makes over a
+   * segment that does not need the staged fallback. This is the number of
+   * conversions, or fewer when the chain was compiled and some of them were
+   * composed.
+   */
+  size_t GetPassCount() const;
+
 private:
+  void Compile();
+
+  // Runs a non-empty segment through a chain of at least two conversions.
+  void AppendConvertedMultiStage(std::string_view segment,
+                                 std::string* output) const;
+
   const std::list<ConversionPtr> conversions;
+  // Empty unless the chain was compiled.
+  std::vector<std::shared_ptr<const CompiledStage>> compiledStages;
 };
 } // namespace opencc
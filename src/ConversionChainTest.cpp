@@ -16,8 +16,11 @@
  * limitations under the License.
  */
 
+#include <filesystem>
+
 #include "ConversionChain.hpp"
 #include "Converter.hpp"
+#include "DartsDict.hpp"
 #include "DictGroupTestBase.hpp"
 #include "MaxMatchSegmentation.hpp"
 #include "PipelineConverter.hpp"
@@ -61,6 +64,117 @@ TEST_F(ConversionChainTest, Convert) {
   SegmentsAssertEquals(SegmentsPtr(new Segments{utf8("裡面")}), converted);
 }
 
+TEST_F(ConversionChainTest, CompiledChainComposesCharacterStage) {
+  // 头发 → 頭髮 (phrase), 里 → 裏 (character), then 裏 → 裡 and 髮 → 发.
+  LexiconPtr variantsLexicon(new Lexicon);
+  variantsLexicon->Add(DictEntryFactory::New(utf8("裏"), utf8("裡")));
+  variantsLexicon->Add(DictEntryFactory::New(utf8("髮"), utf8("发")));
+  variantsLexicon->Sort();
+  const ConversionPtr conversionVariants(
+      new Conversion(DictPtr(new TextDict(variantsLexicon))));
+  const std::list<ConversionPtr> conversions{conversion, conversionVariants};
+  const ConversionChain staged(conversions);
+  const ConversionChain compiled(conversions, true);
+  EXPECT_EQ(2u, staged.GetPassCount());
+  EXPECT_EQ(1u, compiled.GetPassCount());
+
+  const std::vector<std::string> inputs = {
+      utf8("里面"),        utf8("头发里"),    utf8("裏髮"),
+      utf8("太后的头发干燥"), "ASCII only", utf8("⿰里里头发"),
+      utf8("里⿰"),        utf8("abc里\xe9"), ""};
+  for (const std::string& input : inputs) {
+    std::string expected;
+    std::string actual;
+    staged.AppendConvertedSegment(input, &expected);
+    compiled.AppendConvertedSegment(input, &actual);
+    EXPECT_EQ(expected, actual) << input;
+  }
+  std::string converted;
+  compiled.AppendConvertedSegment(utf8("头发里"), &converted);
+  EXPECT_EQ(utf8("頭发裡"), converted);
+}
+
+TEST_F(ConversionChainTest, CompiledChainFallsBackForMultiCharacterKeys) {
+  // The second stage matches 頭髮 and 乾燥, which only appear after the
+  // first stage, and 後 + 裏 across two first-stage matches.
+  LexiconPtr secondLexicon(new Lexicon);
+  secondLexicon->Add(DictEntryFactory::New(utf8("頭髮"), "HAIR"));
+  secondLexicon->Add(DictEntryFactory::New(utf8("乾燥"), "DRY"));
+  secondLexicon->Add(DictEntryFactory::New(utf8("後裏"), "BEHIND"));
+  secondLexicon->Add(DictEntryFactory::New(utf8("裏"), utf8("裡")));
+  secondLexicon->Sort();
+  const ConversionPtr secondConversion(
+      new Conversion(DictPtr(new TextDict(secondLexicon))));
+  const std::list<ConversionPtr> conversions{conversion, secondConversion};
+  const ConversionChain staged(conversions);
+  const ConversionChain compiled(conversions, true);
+  EXPECT_EQ(1u, compiled.GetPassCount());
+
+  const std::vector<std::string> inputs = {
+      utf8("太后的头发干燥"), utf8("后里"), utf8("里面"), utf8("头发"),
+      utf8("干"), utf8("里后里")};
+  for (const std::string& input : inputs) {
+    std::string expected;
+    std::string actual;
+    staged.AppendConvertedSegment(input, &expected);
+    compiled.AppendConvertedSegment(input, &actual);
+    EXPECT_EQ(expected, actual) << input;
+  }
+}
+
+TEST_F(ConversionChainTest, CompiledChainReadsStoredEntries) {
+  // Composing walks the entries of a loaded DartsDict and of a TextDict
+  // parsed from text without constructing a lexicon for either.
+  LexiconPtr charactersLexicon(new Lexicon);
+  charactersLexicon->Add(DictEntryFactory::New(utf8("发"), utf8("髮")));
+  charactersLexicon->Add(DictEntryFactory::New(utf8("里"), utf8("裏")));
+  charactersLexicon->Sort();
+  const std::string fileName =
+      (std::filesystem::temp_directory_path() /
+       "opencc_conversion_chain_test_characters.ocd")
+          .string();
+  DartsDict::NewFromDict(TextDict(charactersLexicon))
+      ->opencc::SerializableDict::SerializeToFile(fileName);
+  const DartsDictPtr dartsDict =
+      SerializableDict::NewFromFile<DartsDict>(fileName);
+  std::remove(fileName.c_str());
+  const std::string variantsText = utf8("裏\t裡\n髮\t发\n");
+  const TextDictPtr variantsDict =
+      TextDict::NewFromBuffer(variantsText.data(), variantsText.size());
+  const ConversionPtr variantsConversion(new Conversion(variantsDict));
+
+  const std::list<ConversionPtr> conversions{
+      ConversionPtr(new Conversion(dartsDict)), variantsConversion};
+  const ConversionChain staged(conversions);
+  const ConversionChain compiled(conversions, true);
+  EXPECT_EQ(1u, compiled.GetPassCount());
+  for (const std::string& input : {utf8("头发里"), utf8("里面")}) {
+    std::string expected;
+    std::string actual;
+    staged.AppendConvertedSegment(input, &expected);
+    compiled.AppendConvertedSegment(input, &actual);
+    EXPECT_EQ(expected, actual) << input;
+  }
+  EXPECT_FALSE(dartsDict->IsLexiconConstructed());
+  EXPECT_FALSE(variantsDict->IsLexiconConstructed());
+}
+
+TEST_F(ConversionChainTest, CompiledChainKeepsUncomposableStages) {
+  // A truncated key cannot be reasoned about character by character.
+  LexiconPtr truncatedLexicon(new Lexicon);
+  truncatedLexicon->Add(DictEntryFactory::New("\xe9", "X"));
+  truncatedLexicon->Sort();
+  const ConversionPtr truncatedConversion(
+      new Conversion(DictPtr(new TextDict(truncatedLexicon))));
+  const ConversionChain compiled(
+      std::list<ConversionPtr>{conversion, truncatedConversion, conversion},
+      true);
+  EXPECT_EQ(2u, compiled.GetPassCount());
+  std::string converted;
+  compiled.AppendConvertedSegment(utf8("头发"), &converted);
+  EXPECT_EQ(utf8("頭髮"), converted);
+}
+
 TEST_F(ConversionChainTest, StreamKeepsIncompleteIdeographicDescriptionSequence) {
   LexiconPtr lexicon(new Lexicon);
   lexicon->Add(DictEntryFactory::New(utf8("钅"), utf8("釒")));
@@ -157,6 +271,28 @@ TEST_F(PipelineConverterTest, ConvertEmptyPipelineIsIdentity) {
   EXPECT_EQ(utf8("钅"), pipeline.Convert(utf8("钅")));
 }
 
+TEST_F(PipelineConverterTest, ConvertBatchMatchesConvert) {
+  // Three stages, one of them a nested pipeline, so intermediate buffers are
+  // borrowed while others are still in use.
+  const ConverterPtr identity(new PipelineConverter({}));
+  const PipelineConverter nested({ConverterPtr(new PipelineConverter(
+                                      {stage1, identity})),
+                                  identity, stage2});
+  const std::vector<std::string> texts = {"", utf8("钅"), utf8("钅钅 釒"),
+                                         "abc", utf8("钅")};
+  const std::vector<std::string_view> inputs(texts.begin(), texts.end());
+  std::string output = "stale";
+  std::vector<size_t> offsets;
+  nested.ConvertBatch(inputs, &output, &offsets);
+  ASSERT_EQ(inputs.size() + 1, offsets.size());
+  EXPECT_EQ(output.size(), offsets.back());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    EXPECT_EQ(nested.Convert(inputs[i]),
+              output.substr(offsets[i], offsets[i + 1] - offsets[i]));
+  }
+  EXPECT_EQ(utf8("金金金 金abc金"), output);
+}
+
 TEST_F(PipelineConverterTest, GetSegmentationReturnsLastStage) {
   PipelineConverter pipeline({stage1, stage2});
   EXPECT_EQ(seg2, pipeline.GetSegmentation());
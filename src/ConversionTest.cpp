@@ -190,11 +190,20 @@ TEST_F(ConversionTest, DifferentialFuzzAgainstReferenceLoop) {
   // produces — same output or the same exception — on BOTH PrefixMatch
   // constructions: the table path (dict group) and the single-dictionary
   // fast path (MarisaDict answering prefix queries directly, whose skip
-  // table is built from a trie walk instead of materialized lexicons).
+  // table is built from a trie walk instead of materialized lexicons) -- and
+  // on a character dictionary, converted through its CharacterMap and
+  // compared with a trie over the same characters (the unmatchable extra
+  // key keeps the reference off the character map).
   const MarisaDictPtr marisaDict = MarisaDict::NewFromDict(*dict);
   const Conversion marisaConversion(marisaDict);
   const PrefixMatch marisaReference(marisaDict);
   PrefixMatch groupReference(dict);
+  const DictPtr characters = CreateDictForCharacters();
+  const Conversion characterConversion(characters);
+  LexiconPtr unmatchable(new Lexicon);
+  unmatchable->Add(DictEntryFactory::New("zzzzzzzz", "z"));
+  const PrefixMatch characterReference(DictPtr(new DictGroup(
+      std::list<DictPtr>{characters, DictPtr(new TextDict(unmatchable))})));
 
   struct FuzzTarget {
     const char* name;
@@ -204,6 +213,7 @@ TEST_F(ConversionTest, DifferentialFuzzAgainstReferenceLoop) {
   const std::vector<FuzzTarget> targets = {
       {"table-path", conversion.get(), &groupReference},
       {"fast-path", &marisaConversion, &marisaReference},
+      {"character-map", &characterConversion, &characterReference},
   };
 
   const std::vector<std::string> fragments = {
@@ -16,11 +16,185 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
 #include "Converter.hpp"
+#include "ConverterStats.hpp"
+#include "ParallelPieces.hpp"
 #include "StreamWindow.hpp"
 
 using namespace opencc;
 
+namespace {
+
+// Pieces smaller than this are not worth a thread hand-off.
+constexpr size_t kMinParallelPieceBytes = 64 * 1024;
+
+// Splitting into a few pieces per thread lets threads that finish early pick
+// up the remaining work when line lengths or conversion costs are uneven.
+constexpr size_t kPiecesPerThread = 4;
+
+// Guards creating the stats collector of any converter; taken only by
+// EnableStats() and GetStats().
+std::mutex& StatsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+} // namespace
+
+std::string Converter::ConvertParallel(std::string_view text,
+                                       size_t threads) const {
+  threads = internal::ResolveThreadCount(threads);
+  const size_t maxPieces =
+      std::min(threads * kPiecesPerThread, text.size() / kMinParallelPieceBytes);
+  if (threads == 1 || maxPieces <= 1) {
+    return Convert(text);
+  }
+
+  std::vector<std::string_view> pieces;
+  pieces.reserve(maxPieces);
+  const size_t pieceBytes = text.size() / maxPieces;
+  size_t begin = 0;
+  while (begin < text.size()) {
+    const size_t end = internal::ParallelCutOffset(text, begin + pieceBytes);
+    pieces.push_back(text.substr(begin, end - begin));
+    begin = end;
+  }
+  if (pieces.size() == 1) {
+    return Convert(text);
+  }
+
+  std::vector<std::string> outputs(pieces.size());
+  internal::RunPieces(pieces.size(), threads, [&](size_t i) {
+    outputs[i] = Convert(pieces[i]);
+  });
+
+  size_t totalLength = 0;
+  for (const std::string& output : outputs) {
+    totalLength += output.size();
+  }
+  std::string converted;
+  converted.reserve(totalLength);
+  for (const std::string& output : outputs) {
+    converted.append(output);
+  }
+  return converted;
+}
+
+void Converter::ConvertBatch(const std::vector<std::string_view>& inputs,
+                             std::string* output, std::vector<size_t>* offsets,
+                             size_t threads) const {
+  threads = internal::ResolveThreadCount(threads);
+  size_t totalBytes = 0;
+  for (std::string_view input : inputs) {
+    totalBytes += input.size();
+  }
+  output->clear();
+  offsets->assign(inputs.size() + 1, 0);
+  const size_t maxRuns =
+      std::min({threads * kPiecesPerThread,
+                totalBytes / kMinParallelPieceBytes, inputs.size()});
+  if (threads == 1 || maxRuns <= 1) {
+    output->reserve(totalBytes + totalBytes / 5);
+    for (size_t i = 0; i < inputs.size(); i++) {
+      (*offsets)[i] = output->size();
+      AppendConverted(inputs[i], output);
+    }
+    offsets->back() = output->size();
+    return;
+  }
+
+  // Cut the batch into runs of consecutive items of roughly equal size. Each
+  // run is converted into its own buffer, with offsets relative to it, and
+  // the buffers are joined once all runs are done.
+  std::vector<size_t> runStarts(1, 0);
+  const size_t runBytes = totalBytes / maxRuns;
+  size_t bytes = 0;
+  for (size_t i = 0; i + 1 < inputs.size(); i++) {
+    bytes += inputs[i].size();
+    if (bytes >= runBytes) {
+      runStarts.push_back(i + 1);
+      bytes = 0;
+    }
+  }
+  runStarts.push_back(inputs.size());
+
+  std::vector<std::string> outputs(runStarts.size() - 1);
+  internal::RunPieces(outputs.size(), threads, [&](size_t run) {
+    std::string& converted = outputs[run];
+    converted.reserve(runBytes + runBytes / 5);
+    for (size_t i = runStarts[run]; i < runStarts[run + 1]; i++) {
+      (*offsets)[i] = converted.size();
+      AppendConverted(inputs[i], &converted);
+    }
+  });
+
+  size_t totalLength = 0;
+  for (const std::string& converted : outputs) {
+    totalLength += converted.size();
+  }
+  output->reserve(totalLength);
+  for (size_t run = 0; run < outputs.size(); run++) {
+    const size_t base = output->size();
+    for (size_t i = runStarts[run]; i < runStarts[run + 1]; i++) {
+      (*offsets)[i] += base;
+    }
+    output->append(outputs[run]);
+  }
+  offsets->back() = output->size();
+}
+
+void Converter::AppendConverted(std::string_view text,
+                                std::string* output) const {
+  if (AppendConvertedIfRecording(text, output)) {
+    return;
+  }
+  output->append(Convert(text));
+}
+
+void Converter::AppendConvertedProfiled(std::string_view text,
+                                        std::string* output,
+                                        ConversionProfile*) const {
+  output->append(Convert(text));
+}
+
+std::shared_ptr<ConverterStats> Converter::EnableStats() {
+  std::lock_guard<std::mutex> lock(StatsMutex());
+  if (statsOwner == nullptr) {
+    statsOwner.reset(new ConverterStats);
+  }
+  stats.store(statsOwner.get(), std::memory_order_release);
+  return statsOwner;
+}
+
+void Converter::DisableStats() {
+  // The collector stays alive: conversions that loaded the pointer before
+  // this call may still be recording into it.
+  stats.store(nullptr, std::memory_order_release);
+}
+
+std::shared_ptr<ConverterStats> Converter::GetStats() const {
+  std::lock_guard<std::mutex> lock(StatsMutex());
+  return stats.load(std::memory_order_acquire) == nullptr ? nullptr
+                                                          : statsOwner;
+}
+
+void Converter::AppendConvertedRecorded(ConverterStats* current,
+                                        std::string_view text,
+                                        std::string* output) const {
+  ConversionProfile profile;
+  const size_t begin = output->size();
+  const auto start = std::chrono::steady_clock::now();
+  AppendConvertedProfiled(text, output, &profile);
+  const uint64_t nanos = internal::NanosSince(start);
+  current->Record(text, std::string_view(*output).substr(begin), nanos,
+                  profile);
+}
+
 std::string ConverterStream::ConvertChunk(std::string_view input) {
   if (!input.empty()) {
     pending.append(input);
@@ -18,15 +18,21 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "Common.hpp"
 #include "ConversionInspection.hpp"
 #include "Segmentation.hpp"
 
 namespace opencc {
+class ConverterStats;
+struct ConversionProfile;
+
 /**
  * Abstract base for full-text converters.
  *
@@ -43,6 +49,9 @@ namespace opencc {
  * via @c GetConversionChain() even when an internal normalization pre-pass is
  * present.
  *
+ * Conversions can be counted and timed with EnableStats(); see
+ * ConverterStats.
+ *
  * @ingroup opencc_cpp_api
  */
 class OPENCC_EXPORT Converter {
@@ -55,6 +64,100 @@ public:
    */
   virtual std::string Convert(std::string_view text) const = 0;
 
+  /**
+   * Converts @p text using up to @p threads threads and returns the result.
+   *
+   * The input is split after line feeds, where no dictionary match can
+   * straddle the cut, and the pieces are converted concurrently with
+   * Convert(); the concatenated output is byte-identical to Convert(@p text).
+   * Inputs that are small or contain no line feed are converted on the
+   * calling thread.
+   *
+   * Requires Convert() to be safe to call concurrently, which holds for all
+   * built-in segmentations and dictionaries.  Exceptions thrown by any piece
+   * are rethrown on the calling thread.
+   *
+   * @param text    UTF-8 input; need not be null-terminated.
+   * @param threads Maximum number of threads, including the calling thread.
+   *                0 selects std::thread::hardware_concurrency().
+   */
+  std::string ConvertParallel(std::string_view text, size_t threads = 0) const;
+
+  /**
+   * Converts each of @p inputs and stores the results back to back in
+   * @p output, replacing its contents.
+   *
+   * @p offsets receives inputs.size() + 1 entries: result @c i occupies
+   * [offsets[i], offsets[i + 1]) of @p output and equals Convert(inputs[i]).
+   * Results are appended to one buffer with AppendConverted() rather than
+   * returned as separate strings, so converting many short strings costs
+   * neither one allocation per item nor repeated virtual dispatch through
+   * Convert().
+   *
+   * Batches large enough to be worth a thread hand-off are split into runs of
+   * consecutive items converted concurrently, with the same requirements and
+   * exception handling as ConvertParallel().
+   *
+   * @param inputs  UTF-8 inputs; need not be null-terminated.
+   * @param output  Receives the concatenated results.
+   * @param offsets Receives the start of each result and the total length.
+   * @param threads Maximum number of threads, including the calling thread.
+   *                0 selects std::thread::hardware_concurrency().
+   */
+  void ConvertBatch(const std::vector<std::string_view>& inputs,
+                    std::string* output, std::vector<size_t>* offsets,
+                    size_t threads = 1) const;
+
+  /**
+   * Appends the conversion of @p text to @p output.
+   *
+   * The result is identical to appending Convert(@p text), which is what the
+   * default implementation does. Built-in converters override it to write
+   * into @p output directly and to reuse per-thread scratch buffers for
+   * intermediate stages.
+   */
+  virtual void AppendConverted(std::string_view text,
+                               std::string* output) const;
+
+  /**
+   * Like AppendConverted(), and adds the time spent in each step and the
+   * dictionary matches made to @p profile.
+   *
+   * The default implementation appends Convert(@p text) and records nothing.
+   * Built-in converters override it to fill in every field they can.
+   */
+  virtual void AppendConvertedProfiled(std::string_view text,
+                                       std::string* output,
+                                       ConversionProfile* profile) const;
+
+  /**
+   * Starts recording every conversion through this converter and returns
+   * the collector. The collector is created on the first call and kept for
+   * the lifetime of the converter, so calling again, including after
+   * DisableStats(), resumes counting into it.
+   *
+   * Recorded conversions run through AppendConvertedProfiled(), which costs
+   * a few clock reads per conversion stage. While stats are disabled a
+   * conversion pays one atomic load.
+   *
+   * Convert() and AppendConverted() of the built-in converters are recorded,
+   * and so are ConvertBatch() and ConvertParallel(), which count each item
+   * or piece as one conversion. A converter shared between callers, e.g.
+   * through ConverterRegistry, shares its stats as well.
+   */
+  std::shared_ptr<ConverterStats> EnableStats();
+
+  /**
+   * Stops recording. The collector returned by EnableStats() keeps its
+   * counts.
+   */
+  void DisableStats();
+
+  /**
+   * Returns the collector while stats are enabled, or @c nullptr otherwise.
+   */
+  std::shared_ptr<ConverterStats> GetStats() const;
+
   /**
    * Converts @p text and returns a detailed inspection result that includes
    * the initial segmentation, per-stage intermediate segments, and final
@@ -74,6 +177,30 @@ public:
    * converter has no single chain (e.g. @c PipelineConverter).
    */
   virtual ConversionChainPtr GetConversionChain() const = 0;
+
+protected:
+  /**
+   * Converts @p text through AppendConvertedProfiled() and records the
+   * conversion if stats are enabled. Returns false without doing anything
+   * otherwise. Overrides of Convert() and AppendConverted() call this first.
+   */
+  bool AppendConvertedIfRecording(std::string_view text,
+                                  std::string* output) const {
+    ConverterStats* current = stats.load(std::memory_order_acquire);
+    if (current == nullptr) {
+      return false;
+    }
+    AppendConvertedRecorded(current, text, output);
+    return true;
+  }
+
+private:
+  void AppendConvertedRecorded(ConverterStats* current, std::string_view text,
+                               std::string* output) const;
+
+  // Points to statsOwner's collector while stats are enabled.
+  std::atomic<ConverterStats*> stats{nullptr};
+  std::shared_ptr<ConverterStats> statsOwner;
 };
 
 class OPENCC_EXPORT ConverterStream {
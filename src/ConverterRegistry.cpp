@@ -0,0 +1,233 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <future>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "ConverterRegistry.hpp"
+
+namespace opencc {
+
+namespace {
+
+// Every ConfigLoadOptions field must be part of the key, or converters loaded
+// with different options would be handed out for each other.
+std::string MakeKey(const std::string& configFileName,
+                    const ConfigLoadOptions& options) {
+  std::string key = configFileName;
+  key.push_back('\n');
+  key.push_back(options.includeTofuRiskDictionaries ? '1' : '0');
+  key.push_back(options.compileConversionChains ? '1' : '0');
+  return key;
+}
+
+} // namespace
+
+class ConverterRegistry::RegistryInternal {
+public:
+  struct Entry {
+    std::shared_future<ConverterPtr> converter;
+    bool loaded = false;
+    size_t bytes = 0;
+    size_t pins = 0;
+    std::list<std::string>::iterator recency;
+  };
+
+  RegistryInternal(const std::vector<std::string>& paths_,
+                   size_t memoryBudget_)
+      : paths(paths_), memoryBudget(memoryBudget_), memoryUsage(0) {}
+
+  // Returns the converter for key, loading it on this thread if no other
+  // thread has started to. pinDelta is applied while the entry is known to
+  // exist, so a pinned converter can never be dropped before it is pinned.
+  ConverterPtr Acquire(const std::string& configFileName,
+                       const ConfigLoadOptions& options, size_t pinDelta) {
+    const std::string key = MakeKey(configFileName, options);
+    std::promise<ConverterPtr> promise;
+    std::shared_future<ConverterPtr> converter;
+    bool loadHere = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(key);
+      if (it == entries.end()) {
+        it = entries.emplace(key, Entry()).first;
+        it->second.converter = promise.get_future().share();
+        recency.push_front(key);
+        it->second.recency = recency.begin();
+        loadHere = true;
+      } else {
+        recency.splice(recency.begin(), recency, it->second.recency);
+      }
+      it->second.pins += pinDelta;
+      converter = it->second.converter;
+    }
+    if (loadHere) {
+      Load(key, configFileName, options, &promise);
+    }
+    return converter.get();
+  }
+
+  void Release(const std::string& configFileName,
+               const ConfigLoadOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = entries.find(MakeKey(configFileName, options));
+    if (it != entries.end() && it->second.pins > 0) {
+      it->second.pins--;
+      EvictOverBudget(nullptr);
+    }
+  }
+
+  // Drops least recently used entries until memoryUsage fits memoryBudget.
+  // Pinned entries, entries still loading and keep are never dropped.
+  // Requires mutex to be held.
+  void EvictOverBudget(const std::string* keep) {
+    if (memoryBudget == 0) {
+      return;
+    }
+    auto position = recency.end();
+    while (memoryUsage > memoryBudget && position != recency.begin()) {
+      --position;
+      const auto it = entries.find(*position);
+      if (it->second.pins > 0 || !it->second.loaded ||
+          (keep != nullptr && *keep == it->first)) {
+        continue;
+      }
+      memoryUsage -= it->second.bytes;
+      entries.erase(it);
+      position = recency.erase(position);
+    }
+  }
+
+  // Drops every loaded entry that is not pinned. Requires mutex to be held.
+  void EvictUnpinned() {
+    for (auto position = recency.begin(); position != recency.end();) {
+      const auto it = entries.find(*position);
+      if (it->second.pins > 0 || !it->second.loaded) {
+        ++position;
+        continue;
+      }
+      memoryUsage -= it->second.bytes;
+      entries.erase(it);
+      position = recency.erase(position);
+    }
+  }
+
+  const std::vector<std::string> paths;
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, Entry> entries;
+  // Keys from most to least recently used.
+  std::list<std::string> recency;
+  size_t memoryBudget;
+  size_t memoryUsage;
+
+private:
+  void Load(const std::string& key, const std::string& configFileName,
+            const ConfigLoadOptions& options,
+            std::promise<ConverterPtr>* promise) {
+    ConverterPtr converter;
+    size_t bytes = 0;
+    try {
+      Config config;
+      converter = config.NewFromFile(configFileName, paths, nullptr, options);
+      bytes = config.GetLoadedDictionaryBytes();
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = entries.find(key);
+        recency.erase(it->second.recency);
+        entries.erase(it);
+      }
+      promise->set_exception(std::current_exception());
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      Entry& entry = entries.find(key)->second;
+      entry.loaded = true;
+      entry.bytes = bytes;
+      memoryUsage += bytes;
+      EvictOverBudget(&key);
+    }
+    promise->set_value(converter);
+  }
+};
+
+ConverterRegistry::ConverterRegistry()
+    : internal(new RegistryInternal(std::vector<std::string>(), 0)) {}
+
+ConverterRegistry::ConverterRegistry(const std::vector<std::string>& paths,
+                                     size_t memoryBudget)
+    : internal(new RegistryInternal(paths, memoryBudget)) {}
+
+ConverterRegistry::~ConverterRegistry() {}
+
+ConverterPtr ConverterRegistry::Get(const std::string& configFileName) {
+  return Get(configFileName, ConfigLoadOptions());
+}
+
+ConverterPtr ConverterRegistry::Get(const std::string& configFileName,
+                                    const ConfigLoadOptions& options) {
+  return internal->Acquire(configFileName, options, 0);
+}
+
+void ConverterRegistry::Pin(const std::string& configFileName,
+                            const ConfigLoadOptions& options) {
+  internal->Acquire(configFileName, options, 1);
+}
+
+void ConverterRegistry::Unpin(const std::string& configFileName,
+                              const ConfigLoadOptions& options) {
+  internal->Release(configFileName, options);
+}
+
+void ConverterRegistry::WarmUp(const std::vector<std::string>& configFileNames,
+                               const ConfigLoadOptions& options) {
+  for (const std::string& configFileName : configFileNames) {
+    Get(configFileName, options);
+  }
+}
+
+void ConverterRegistry::Clear() {
+  std::lock_guard<std::mutex> lock(internal->mutex);
+  internal->EvictUnpinned();
+}
+
+void ConverterRegistry::SetMemoryBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(internal->mutex);
+  internal->memoryBudget = bytes;
+  internal->EvictOverBudget(nullptr);
+}
+
+size_t ConverterRegistry::GetMemoryBudget() const {
+  std::lock_guard<std::mutex> lock(internal->mutex);
+  return internal->memoryBudget;
+}
+
+size_t ConverterRegistry::GetMemoryUsage() const {
+  std::lock_guard<std::mutex> lock(internal->mutex);
+  return internal->memoryUsage;
+}
+
+size_t ConverterRegistry::Size() const {
+  std::lock_guard<std::mutex> lock(internal->mutex);
+  return internal->entries.size();
+}
+
+} // namespace opencc
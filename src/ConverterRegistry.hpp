@@ -0,0 +1,135 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Common.hpp"
+#include "Config.hpp"
+
+namespace opencc {
+/**
+ * Shared cache of loaded converters.
+ *
+ * Config shares dictionary files between the converters it creates, but only
+ * while some converter still uses them, and every load rebuilds the
+ * segmentation and prefix-match tables. A registry keeps converters alive
+ * between requests and hands out one shared instance per config file and
+ * ConfigLoadOptions, so a service creating converters per request loads each
+ * config once, and configs sharing dictionary files (s2t, s2tw and s2twp all
+ * use STPhrases and STCharacters) read those files once. A service usually
+ * keeps a single registry for the lifetime of the process.
+ *
+ * Converters are immutable once loaded and may be used from several threads
+ * at once. All registry methods are thread-safe; concurrent requests for a
+ * config that is not loaded yet share a single load.
+ *
+ * A memory budget bounds the converters the registry keeps, each charged the
+ * size of its dictionary files (Config::GetLoadedDictionaryBytes()). Files
+ * shared by several converters are charged to each, so the estimate errs on
+ * the high side. When the budget is exceeded the least recently used
+ * converters that are not pinned are dropped; the converter just requested
+ * is always kept. Dropping a converter only releases the registry's
+ * reference, so converters still held by callers stay valid.
+ *
+ * @ingroup opencc_cpp_api
+ */
+class OPENCC_EXPORT ConverterRegistry {
+public:
+  /**
+   * Creates a registry without a memory budget that looks configs up like
+   * Config::NewFromFile(const std::string&).
+   */
+  ConverterRegistry();
+
+  /**
+   * Creates a registry that also looks for configs and dictionaries in
+   * @p paths. A @p memoryBudget of 0 bytes means no budget.
+   */
+  ConverterRegistry(const std::vector<std::string>& paths,
+                    size_t memoryBudget);
+
+  ~ConverterRegistry();
+
+  ConverterRegistry(const ConverterRegistry&) = delete;
+  ConverterRegistry& operator=(const ConverterRegistry&) = delete;
+
+  /**
+   * Returns the converter for @p configFileName with default
+   * ConfigLoadOptions, loading it on first use.
+   * @throws FileNotFound, InvalidFormat as Config::NewFromFile() does. A
+   *   failed load is not cached.
+   */
+  ConverterPtr Get(const std::string& configFileName);
+
+  /**
+   * Returns the converter for @p configFileName loaded with @p options,
+   * loading it on first use.
+   */
+  ConverterPtr Get(const std::string& configFileName,
+                   const ConfigLoadOptions& options);
+
+  /**
+   * Loads the converter if needed and keeps it from being dropped until a
+   * matching Unpin(). Pins nest.
+   */
+  void Pin(const std::string& configFileName,
+           const ConfigLoadOptions& options);
+
+  /**
+   * Releases one Pin(). Does nothing if the converter is not pinned.
+   */
+  void Unpin(const std::string& configFileName,
+             const ConfigLoadOptions& options);
+
+  /**
+   * Loads every config in @p configFileNames, e.g. at service startup, so
+   * that first requests do not pay for loading. Stops at the first config
+   * that fails to load and rethrows its exception.
+   */
+  void WarmUp(const std::vector<std::string>& configFileNames,
+              const ConfigLoadOptions& options);
+
+  /**
+   * Drops every converter that is not pinned.
+   */
+  void Clear();
+
+  /**
+   * Changes the memory budget, dropping converters if it is now exceeded.
+   * 0 means no budget.
+   */
+  void SetMemoryBudget(size_t bytes);
+
+  size_t GetMemoryBudget() const;
+
+  /**
+   * Returns the bytes charged to the converters currently held.
+   */
+  size_t GetMemoryUsage() const;
+
+  /**
+   * Returns the number of converters currently held, including ones still
+   * loading.
+   */
+  size_t Size() const;
+
+private:
+  class RegistryInternal;
+  std::unique_ptr<RegistryInternal> internal;
+};
+} // namespace opencc
@@ -0,0 +1,145 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <thread>
+
+#include "Config.hpp"
+#include "ConfigTestBase.hpp"
+#include "Converter.hpp"
+#include "ConverterRegistry.hpp"
+#include "Exception.hpp"
+#include "TestUtilsUTF8.hpp"
+
+namespace opencc {
+
+class ConverterRegistryTest : public ConfigTestBase {
+protected:
+  ConverterRegistryTest()
+      : simpleConfig("config_test.json"),
+        nestedConfig("config_test_nested_group.json") {}
+
+  size_t FileSize(const std::string& fileName) const {
+    std::ifstream ifs(CONFIG_TEST_DIR_PATH + "/" + fileName,
+                      std::ios::binary | std::ios::ate);
+    return static_cast<size_t>(ifs.tellg());
+  }
+
+  // Both test configs use the same two text dictionaries.
+  size_t ConfigBytes() const {
+    return FileSize("config_test_phrases.txt") +
+           FileSize("config_test_characters.txt");
+  }
+
+  const std::string simpleConfig;
+  const std::string nestedConfig;
+};
+
+TEST_F(ConverterRegistryTest, CountsEachDictionaryFileOnce) {
+  Config config;
+  config.NewFromFile(CONFIG_TEST_JSON_PATH);
+  EXPECT_EQ(ConfigBytes(), config.GetLoadedDictionaryBytes());
+
+  Config inlineConfig;
+  inlineConfig.NewFromString(
+      R"({"name": "Inline", "conversion_chain": [{"dict": {
+            "type": "inline", "entries": {"a": "b"}}}]})",
+      CONFIG_TEST_DIR_PATH);
+  EXPECT_EQ(0, inlineConfig.GetLoadedDictionaryBytes());
+}
+
+TEST_F(ConverterRegistryTest, SharesOneConverterPerConfigAndOptions) {
+  ConverterRegistry registry({CONFIG_TEST_DIR_PATH}, 0);
+  const ConverterPtr converter = registry.Get(simpleConfig);
+  EXPECT_EQ(converter, registry.Get(simpleConfig));
+  EXPECT_EQ(utf8("燕燕于飛差池其羽之子于歸遠送於野"),
+            converter->Convert(utf8("燕燕于飞差池其羽之子于归远送于野")));
+
+  ConfigLoadOptions compiled;
+  compiled.compileConversionChains = true;
+  const ConverterPtr compiledConverter = registry.Get(simpleConfig, compiled);
+  EXPECT_NE(converter, compiledConverter);
+  EXPECT_EQ(compiledConverter, registry.Get(simpleConfig, compiled));
+  EXPECT_EQ(2, registry.Size());
+  EXPECT_EQ(2 * ConfigBytes(), registry.GetMemoryUsage());
+
+  registry.Clear();
+  EXPECT_EQ(0, registry.Size());
+  EXPECT_EQ(0, registry.GetMemoryUsage());
+  EXPECT_NE(converter, registry.Get(simpleConfig));
+}
+
+TEST_F(ConverterRegistryTest, ConcurrentRequestsShareOneLoad) {
+  ConverterRegistry registry({CONFIG_TEST_DIR_PATH}, 0);
+  std::vector<ConverterPtr> converters(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < converters.size(); i++) {
+    threads.emplace_back(
+        [&registry, &converters, i, this]() {
+          converters[i] = registry.Get(i % 2 == 0 ? simpleConfig
+                                                  : nestedConfig);
+        });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 2; i < converters.size(); i++) {
+    EXPECT_EQ(converters[i % 2], converters[i]);
+  }
+  EXPECT_NE(converters[0], converters[1]);
+  EXPECT_EQ(2, registry.Size());
+}
+
+TEST_F(ConverterRegistryTest, EvictsLeastRecentlyUsedOverBudget) {
+  ConverterRegistry registry({CONFIG_TEST_DIR_PATH}, ConfigBytes());
+  const ConverterPtr simple = registry.Get(simpleConfig);
+  const ConverterPtr nested = registry.Get(nestedConfig);
+  // Only the converter just requested fits; the other one is dropped but
+  // stays usable for callers holding it.
+  EXPECT_EQ(1, registry.Size());
+  EXPECT_EQ(ConfigBytes(), registry.GetMemoryUsage());
+  EXPECT_EQ(nested, registry.Get(nestedConfig));
+  EXPECT_EQ(utf8("遠"), simple->Convert(utf8("远")));
+
+  // A pinned converter survives budget pressure until unpinned.
+  const ConfigLoadOptions options;
+  registry.Pin(simpleConfig, options);
+  registry.Get(nestedConfig);
+  EXPECT_EQ(2, registry.Size());
+  registry.Unpin(simpleConfig, options);
+  EXPECT_EQ(1, registry.Size());
+  registry.Get(nestedConfig);
+  EXPECT_EQ(1, registry.Size());
+
+  registry.SetMemoryBudget(0);
+  registry.WarmUp({simpleConfig, nestedConfig}, options);
+  EXPECT_EQ(2, registry.Size());
+  registry.SetMemoryBudget(ConfigBytes());
+  EXPECT_EQ(1, registry.Size());
+}
+
+TEST_F(ConverterRegistryTest, FailedLoadsAreNotCached) {
+  ConverterRegistry registry({CONFIG_TEST_DIR_PATH}, 0);
+  EXPECT_THROW(registry.Get("no_such_config.json"), FileNotFound);
+  EXPECT_THROW(registry.Pin("no_such_config.json", ConfigLoadOptions()),
+               FileNotFound);
+  EXPECT_EQ(0, registry.Size());
+  EXPECT_EQ(0, registry.GetMemoryUsage());
+}
+
+} // namespace opencc
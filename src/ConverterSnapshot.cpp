@@ -0,0 +1,514 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "ConfigBasedConverter.hpp"
+#include "Conversion.hpp"
+#include "ConversionChain.hpp"
+#include "ConverterSnapshot.hpp"
+#include "DictGroup.hpp"
+#include "Exception.hpp"
+#include "MappedFile.hpp"
+#include "MarisaDict.hpp"
+#include "MaxMatchSegmentation.hpp"
+#include "PipelineConverter.hpp"
+#include "PrefixMatch.hpp"
+#include "SerializableDict.hpp"
+#include "SingleStageConverter.hpp"
+
+using namespace opencc;
+
+namespace {
+
+// Snapshot layout (native byte order). Sections are 8-byte aligned relative
+// to the start of the snapshot so that dictionaries and tables can be used in
+// place from a mapping:
+//   char     header[24]            "OPENCC_SNAPSHOT_1.0", NUL-padded
+//   uint32_t numDicts, loadOptions (kIncludeTofuRiskDictionaries |
+//                                   kCompileConversionChains)
+//   section  dicts[numDicts]       MarisaDict in the OCD3 layout
+//   converter
+// section:   zero padding to 8, uint64_t length, payload[length]
+// converter: uint32_t kind, then
+//   kSingleStageConverter: uint32_t hasSegmentation,
+//                          [stage] (the mmseg segmentation),
+//                          uint32_t numConversions, stage[numConversions]
+//   kConfigBasedConverter: converter normalization, converter main
+//   kPipelineConverter:    uint32_t numStages, converter[numStages]
+// stage:     dict, section (PrefixMatch::SerializeTables() output)
+// dict:      uint32_t kind, then
+//   kLeafDict:  uint32_t index into dicts
+//   kDictGroup: uint32_t matchPolicy, numChildren, dict[numChildren]
+const char* kSnapshotHeader = "OPENCC_SNAPSHOT_1.0";
+constexpr size_t kSnapshotHeaderSize = 24;
+constexpr size_t kSectionAlignment = 8;
+// Bounds recursion on corrupt input; real converters nest a few levels.
+constexpr int kMaxNestingDepth = 32;
+
+const uint32_t kSingleStageConverter = 0;
+const uint32_t kConfigBasedConverter = 1;
+const uint32_t kPipelineConverter = 2;
+const uint32_t kLeafDict = 0;
+const uint32_t kDictGroup = 1;
+const uint32_t kIncludeTofuRiskDictionaries = 1;
+const uint32_t kCompileConversionChains = 2;
+
+uint32_t EncodeLoadOptions(const ConfigLoadOptions& options) {
+  return (options.includeTofuRiskDictionaries ? kIncludeTofuRiskDictionaries
+                                              : 0) |
+         (options.compileConversionChains ? kCompileConversionChains : 0);
+}
+
+std::string DescribeLoadOptions(uint32_t loadOptions) {
+  std::string description = "includeTofuRiskDictionaries=";
+  description +=
+      (loadOptions & kIncludeTofuRiskDictionaries) != 0 ? "true" : "false";
+  description += ", compileConversionChains=";
+  description +=
+      (loadOptions & kCompileConversionChains) != 0 ? "true" : "false";
+  return description;
+}
+
+DictPtr NewDictGroup(const std::list<DictPtr>& children,
+                     DictGroupMatchPolicy matchPolicy) {
+  if (matchPolicy == DictGroupMatchPolicy::Union) {
+    return DictPtr(new UnionDictGroup(children));
+  }
+  return DictPtr(new DictGroup(children, matchPolicy));
+}
+
+class SnapshotWriter {
+public:
+  SnapshotWriter(FILE* _fp, const ConfigLoadOptions& _options)
+      : fp(_fp), base(ftell(_fp)), options(_options) {
+    if (base < 0) {
+      throw InvalidFormat("Converter snapshot output must be seekable.");
+    }
+  }
+
+  void Write(const ConverterPtr& converter) {
+    CollectConverter(converter);
+    char header[kSnapshotHeaderSize] = {};
+    memcpy(header, kSnapshotHeader, strlen(kSnapshotHeader));
+    WriteBytes(header, sizeof(header));
+    WriteInteger(static_cast<uint32_t>(leaves.size()));
+    WriteInteger(EncodeLoadOptions(options));
+    for (const MarisaDictPtr& leaf : leaves) {
+      WriteSection([&leaf](FILE* out) { leaf->SerializeToFile(out); });
+    }
+    WriteConverter(converter);
+  }
+
+private:
+  void CollectConverter(const ConverterPtr& converter) {
+    if (const ConfigBasedConverter* configBased =
+            dynamic_cast<const ConfigBasedConverter*>(converter.get())) {
+      CollectConverter(configBased->GetNormalizationConverter());
+      CollectConverter(configBased->GetMainConverter());
+    } else if (const PipelineConverter* pipeline =
+                   dynamic_cast<const PipelineConverter*>(converter.get())) {
+      for (const ConverterPtr& stage : pipeline->GetStages()) {
+        CollectConverter(stage);
+      }
+    } else if (dynamic_cast<const SingleStageConverter*>(converter.get()) !=
+               nullptr) {
+      const SegmentationPtr segmentation = converter->GetSegmentation();
+      if (segmentation != nullptr) {
+        CollectDict(SegmentationDict(segmentation));
+      }
+      for (const ConversionPtr& conversion : Conversions(converter)) {
+        CollectDict(conversion->GetDict());
+      }
+    } else {
+      throw InvalidFormat("Converter type cannot be stored in a snapshot.");
+    }
+  }
+
+  void CollectDict(const DictPtr& dict) {
+    const std::list<DictPtr>* items = dict->GetDictGroupItems();
+    if (items != nullptr) {
+      for (const DictPtr& child : *items) {
+        CollectDict(child);
+      }
+      return;
+    }
+    if (leafIndices.count(dict.get()) == 0) {
+      leafIndices[dict.get()] = static_cast<uint32_t>(leaves.size());
+      leaves.push_back(
+          MarisaDict::NewFromDict(*dict, MarisaDict::Format::Ocd3));
+    }
+  }
+
+  static DictPtr SegmentationDict(const SegmentationPtr& segmentation) {
+    const MaxMatchSegmentation* maxMatch =
+        dynamic_cast<const MaxMatchSegmentation*>(segmentation.get());
+    if (maxMatch == nullptr) {
+      throw InvalidFormat(
+          "Only mmseg segmentation can be stored in a converter snapshot.");
+    }
+    return maxMatch->GetDict();
+  }
+
+  static std::list<ConversionPtr> Conversions(const ConverterPtr& converter) {
+    const ConversionChainPtr chain = converter->GetConversionChain();
+    if (chain == nullptr) {
+      throw InvalidFormat("Converter without a conversion chain cannot be "
+                          "stored in a snapshot.");
+    }
+    return chain->GetConversions();
+  }
+
+  void WriteConverter(const ConverterPtr& converter) {
+    if (const ConfigBasedConverter* configBased =
+            dynamic_cast<const ConfigBasedConverter*>(converter.get())) {
+      WriteInteger(kConfigBasedConverter);
+      WriteConverter(configBased->GetNormalizationConverter());
+      WriteConverter(configBased->GetMainConverter());
+      return;
+    }
+    if (const PipelineConverter* pipeline =
+            dynamic_cast<const PipelineConverter*>(converter.get())) {
+      WriteInteger(kPipelineConverter);
+      WriteInteger(static_cast<uint32_t>(pipeline->GetStages().size()));
+      for (const ConverterPtr& stage : pipeline->GetStages()) {
+        WriteConverter(stage);
+      }
+      return;
+    }
+    WriteInteger(kSingleStageConverter);
+    const SegmentationPtr segmentation = converter->GetSegmentation();
+    WriteInteger(static_cast<uint32_t>(segmentation != nullptr ? 1 : 0));
+    if (segmentation != nullptr) {
+      WriteStage(SegmentationDict(segmentation));
+    }
+    const std::list<ConversionPtr> conversions = Conversions(converter);
+    WriteInteger(static_cast<uint32_t>(conversions.size()));
+    for (const ConversionPtr& conversion : conversions) {
+      WriteStage(conversion->GetDict());
+    }
+  }
+
+  // Writes the structure of dict followed by the prefix-match tables built
+  // over the same structure with the re-encoded leaves, i.e. exactly what
+  // the reader will reconstruct.
+  void WriteStage(const DictPtr& dict) {
+    WriteDict(dict);
+    const PrefixMatch prefixMatch(MirrorDict(dict));
+    WriteSection(
+        [&prefixMatch](FILE* out) { prefixMatch.SerializeTables(out); });
+  }
+
+  void WriteDict(const DictPtr& dict) {
+    const std::list<DictPtr>* items = dict->GetDictGroupItems();
+    if (items == nullptr) {
+      WriteInteger(kLeafDict);
+      WriteInteger(leafIndices.at(dict.get()));
+      return;
+    }
+    WriteInteger(kDictGroup);
+    WriteInteger(static_cast<uint32_t>(dict->GetMatchPolicy()));
+    WriteInteger(static_cast<uint32_t>(items->size()));
+    for (const DictPtr& child : *items) {
+      WriteDict(child);
+    }
+  }
+
+  DictPtr MirrorDict(const DictPtr& dict) const {
+    const std::list<DictPtr>* items = dict->GetDictGroupItems();
+    if (items == nullptr) {
+      return leaves[leafIndices.at(dict.get())];
+    }
+    std::list<DictPtr> children;
+    for (const DictPtr& child : *items) {
+      children.push_back(MirrorDict(child));
+    }
+    return NewDictGroup(children, dict->GetMatchPolicy());
+  }
+
+  void WriteSection(const std::function<void(FILE*)>& writePayload) {
+    Pad();
+    const long lengthPos = ftell(fp);
+    WriteInteger(static_cast<uint64_t>(0));
+    writePayload(fp);
+    const long end = ftell(fp);
+    if (lengthPos < 0 || end < lengthPos ||
+        fseek(fp, lengthPos, SEEK_SET) != 0) {
+      throw InvalidFormat("Cannot write converter snapshot.");
+    }
+    WriteInteger(static_cast<uint64_t>(end - lengthPos) - sizeof(uint64_t));
+    if (fseek(fp, end, SEEK_SET) != 0) {
+      throw InvalidFormat("Cannot write converter snapshot.");
+    }
+  }
+
+  void Pad() {
+    const long pos = ftell(fp);
+    if (pos < 0) {
+      throw InvalidFormat("Cannot write converter snapshot.");
+    }
+    const char zeros[kSectionAlignment] = {};
+    WriteBytes(zeros, (kSectionAlignment -
+                       static_cast<size_t>(pos - base) % kSectionAlignment) %
+                          kSectionAlignment);
+  }
+
+  template <typename INT_TYPE> void WriteInteger(INT_TYPE num) {
+    WriteBytes(&num, sizeof(num));
+  }
+
+  void WriteBytes(const void* data, size_t size) {
+    if (size > 0 && fwrite(data, 1, size, fp) != size) {
+      throw InvalidFormat("Cannot write converter snapshot.");
+    }
+  }
+
+  FILE* fp;
+  const long base;
+  const ConfigLoadOptions options;
+  std::vector<MarisaDictPtr> leaves;
+  std::unordered_map<const Dict*, uint32_t> leafIndices;
+};
+
+class SnapshotReader {
+public:
+  SnapshotReader(const char* _data, size_t _size,
+                 std::shared_ptr<const void> _owner)
+      : data(_data), size(_size), offset(0), owner(std::move(_owner)),
+        compileConversionChains(false) {}
+
+  // Reads the converter. If expected is set, the snapshot must have been
+  // written with the same options.
+  ConverterPtr Read(const ConfigLoadOptions* expected) {
+    if (!ConverterSnapshot::IsSnapshot(data, size)) {
+      throw InvalidFormat("Invalid OpenCC converter snapshot header");
+    }
+    offset = kSnapshotHeaderSize;
+    const uint32_t numDicts = ReadInteger<uint32_t>();
+    const uint32_t loadOptions = ReadInteger<uint32_t>();
+    if (expected != nullptr && loadOptions != EncodeLoadOptions(*expected)) {
+      throw InvalidFormat(
+          "OpenCC converter snapshot was written with " +
+          DescribeLoadOptions(loadOptions) + " but is loaded with " +
+          DescribeLoadOptions(EncodeLoadOptions(*expected)));
+    }
+    compileConversionChains = (loadOptions & kCompileConversionChains) != 0;
+    for (uint32_t i = 0; i < numDicts; i++) {
+      size_t length = 0;
+      const char* section = ReadSection(&length);
+      dicts.push_back(MarisaDict::NewFromSharedBuffer(section, length, owner));
+    }
+    ConverterPtr converter = ReadConverter(0);
+    if (offset != size) {
+      throw InvalidFormat("Invalid OpenCC converter snapshot (trailing data)");
+    }
+    return converter;
+  }
+
+private:
+  ConverterPtr ReadConverter(int depth) {
+    CheckDepth(depth);
+    const uint32_t kind = ReadInteger<uint32_t>();
+    if (kind == kConfigBasedConverter) {
+      ConverterPtr normConverter = ReadConverter(depth + 1);
+      ConverterPtr mainConverter = ReadConverter(depth + 1);
+      return ConverterPtr(new ConfigBasedConverter(std::move(normConverter),
+                                                   std::move(mainConverter)));
+    }
+    if (kind == kPipelineConverter) {
+      const uint32_t numStages = ReadInteger<uint32_t>();
+      std::vector<ConverterPtr> stages;
+      for (uint32_t i = 0; i < numStages; i++) {
+        stages.push_back(ReadConverter(depth + 1));
+      }
+      return ConverterPtr(new PipelineConverter(std::move(stages)));
+    }
+    if (kind != kSingleStageConverter) {
+      throw InvalidFormat("Invalid OpenCC converter snapshot (converter)");
+    }
+    SegmentationPtr segmentation;
+    if (ReadInteger<uint32_t>() != 0) {
+      const DictPtr dict = ReadDict(0);
+      segmentation.reset(new MaxMatchSegmentation(dict, ReadPrefixMatch(dict)));
+    }
+    const uint32_t numConversions = ReadInteger<uint32_t>();
+    std::list<ConversionPtr> conversions;
+    for (uint32_t i = 0; i < numConversions; i++) {
+      const DictPtr dict = ReadDict(0);
+      conversions.push_back(
+          ConversionPtr(new Conversion(dict, ReadPrefixMatch(dict))));
+    }
+    return ConverterPtr(new SingleStageConverter(
+        segmentation, ConversionChainPtr(new ConversionChain(
+                          conversions, compileConversionChains))));
+  }
+
+  DictPtr ReadDict(int depth) {
+    CheckDepth(depth);
+    const uint32_t kind = ReadInteger<uint32_t>();
+    if (kind == kLeafDict) {
+      const uint32_t index = ReadInteger<uint32_t>();
+      if (index >= dicts.size()) {
+        throw InvalidFormat(
+            "Invalid OpenCC converter snapshot (dictionary index)");
+      }
+      return dicts[index];
+    }
+    const uint32_t matchPolicy = ReadInteger<uint32_t>();
+    if (kind != kDictGroup ||
+        (matchPolicy !=
+             static_cast<uint32_t>(DictGroupMatchPolicy::ShortCircuit) &&
+         matchPolicy != static_cast<uint32_t>(DictGroupMatchPolicy::Union))) {
+      throw InvalidFormat("Invalid OpenCC converter snapshot (dictionary)");
+    }
+    const uint32_t numChildren = ReadInteger<uint32_t>();
+    std::list<DictPtr> children;
+    for (uint32_t i = 0; i < numChildren; i++) {
+      children.push_back(ReadDict(depth + 1));
+    }
+    return NewDictGroup(children,
+                        static_cast<DictGroupMatchPolicy>(matchPolicy));
+  }
+
+  std::shared_ptr<PrefixMatch> ReadPrefixMatch(const DictPtr& dict) {
+    size_t length = 0;
+    const char* section = ReadSection(&length);
+    size_t bytesRead = 0;
+    std::shared_ptr<PrefixMatch> prefixMatch =
+        PrefixMatch::NewFromSerializedTables(dict, section, length, &bytesRead,
+                                             owner);
+    if (bytesRead != length) {
+      throw InvalidFormat(
+          "Invalid OpenCC converter snapshot (prefix match tables)");
+    }
+    return prefixMatch;
+  }
+
+  const char* ReadSection(size_t* length) {
+    const size_t padding =
+        (kSectionAlignment - offset % kSectionAlignment) % kSectionAlignment;
+    Consume(padding);
+    const uint64_t sectionLength = ReadInteger<uint64_t>();
+    if (sectionLength > size - offset) {
+      throw InvalidFormat("Invalid OpenCC converter snapshot (truncated)");
+    }
+    *length = static_cast<size_t>(sectionLength);
+    return Consume(*length);
+  }
+
+  template <typename INT_TYPE> INT_TYPE ReadInteger() {
+    INT_TYPE num;
+    memcpy(&num, Consume(sizeof(num)), sizeof(num));
+    return num;
+  }
+
+  const char* Consume(size_t length) {
+    if (length > size - offset) {
+      throw InvalidFormat("Invalid OpenCC converter snapshot (truncated)");
+    }
+    const char* bytes = data + offset;
+    offset += length;
+    return bytes;
+  }
+
+  static void CheckDepth(int depth) {
+    if (depth >= kMaxNestingDepth) {
+      throw InvalidFormat("Invalid OpenCC converter snapshot (nesting)");
+    }
+  }
+
+  const char* data;
+  const size_t size;
+  size_t offset;
+  const std::shared_ptr<const void> owner;
+  bool compileConversionChains;
+  std::vector<DictPtr> dicts;
+};
+
+} // namespace
+
+void ConverterSnapshot::SerializeToFile(const ConverterPtr& converter,
+                                        const std::string& fileName) {
+  SerializeToFile(converter, fileName, ConfigLoadOptions());
+}
+
+void ConverterSnapshot::SerializeToFile(const ConverterPtr& converter,
+                                        const std::string& fileName,
+                                        const ConfigLoadOptions& options) {
+  FILE* fp = OpenSerializableFileUtf8(fileName, "wb");
+  if (fp == NULL) {
+    throw FileNotWritable(fileName);
+  }
+  try {
+    SerializeToFile(converter, fp, options);
+  } catch (...) {
+    fclose(fp);
+    throw;
+  }
+  fclose(fp);
+}
+
+void ConverterSnapshot::SerializeToFile(const ConverterPtr& converter,
+                                        FILE* fp) {
+  SerializeToFile(converter, fp, ConfigLoadOptions());
+}
+
+void ConverterSnapshot::SerializeToFile(const ConverterPtr& converter,
+                                        FILE* fp,
+                                        const ConfigLoadOptions& options) {
+  SnapshotWriter(fp, options).Write(converter);
+}
+
+ConverterPtr ConverterSnapshot::NewFromFile(const std::string& fileName) {
+  std::shared_ptr<const internal::MappedFile> file =
+      internal::MappedFile::Open(fileName);
+  const char* data = file->Data();
+  const size_t size = file->Size();
+  return SnapshotReader(data, size, std::move(file)).Read(nullptr);
+}
+
+ConverterPtr ConverterSnapshot::NewFromFile(const std::string& fileName,
+                                            const ConfigLoadOptions& options) {
+  std::shared_ptr<const internal::MappedFile> file =
+      internal::MappedFile::Open(fileName);
+  const char* data = file->Data();
+  const size_t size = file->Size();
+  return SnapshotReader(data, size, std::move(file)).Read(&options);
+}
+
+ConverterPtr
+ConverterSnapshot::NewFromSharedBuffer(const char* data, size_t size,
+                                       std::shared_ptr<const void> owner) {
+  return SnapshotReader(data, size, std::move(owner)).Read(nullptr);
+}
+
+ConverterPtr
+ConverterSnapshot::NewFromSharedBuffer(const char* data, size_t size,
+                                       std::shared_ptr<const void> owner,
+                                       const ConfigLoadOptions& options) {
+  return SnapshotReader(data, size, std::move(owner)).Read(&options);
+}
+
+bool ConverterSnapshot::IsSnapshot(const char* data, size_t size) {
+  return size >= kSnapshotHeaderSize &&
+         memcmp(data, kSnapshotHeader, strlen(kSnapshotHeader) + 1) == 0;
+}
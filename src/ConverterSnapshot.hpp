@@ -0,0 +1,111 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+#include "Common.hpp"
+#include "ConfigLoadOptions.hpp"
+
+namespace opencc {
+/**
+ * Precompiled converter snapshots.
+ *
+ * A snapshot is a single file holding a fully resolved converter: its
+ * structure (normalization pre-pass, segmentation, conversion chains and
+ * dictionary groups), every dictionary it uses in the OCD3 layout, and the
+ * compiled prefix-match tables (matchers and skip tables) of every
+ * segmentation and conversion. Loading one maps the file and wires the
+ * converter up around it without parsing JSON, reconstructing lexicons or
+ * rebuilding any lookup table, so startup cost no longer grows with
+ * dictionary size.
+ *
+ * Config::NewFromFile() recognizes snapshot files, so a snapshot can be used
+ * anywhere a config file name is accepted. A snapshot records the
+ * ConfigLoadOptions its converter was loaded with, and loading it with other
+ * options throws InvalidFormat rather than silently producing a converter
+ * that ignores them; `opencc_dict -f config -t snapshot` takes the same
+ * option flags as `opencc`. A snapshot is tied to the library's native byte
+ * order and is rebuilt from its config rather than migrated.
+ *
+ * @ingroup opencc_cpp_api
+ */
+class OPENCC_EXPORT ConverterSnapshot {
+public:
+  /**
+   * Writes a snapshot of @p converter to @p fileName.
+   *
+   * Supports converters built from configs: SingleStageConverter with an
+   * optional mmseg segmentation, and pipelines or normalization pre-passes
+   * of those. Compiled conversion chains are stored stage by stage.
+   * @throws InvalidFormat if the converter uses a segmentation or converter
+   *   type that cannot be stored.
+   */
+  static void SerializeToFile(const ConverterPtr& converter,
+                              const std::string& fileName);
+
+  /**
+   * Writes a snapshot of @p converter, which was loaded with @p options, to
+   * @p fileName.
+   */
+  static void SerializeToFile(const ConverterPtr& converter,
+                              const std::string& fileName,
+                              const ConfigLoadOptions& options);
+
+  /**
+   * Writes a snapshot of @p converter to @p fp, which must be seekable.
+   */
+  static void SerializeToFile(const ConverterPtr& converter, FILE* fp);
+
+  static void SerializeToFile(const ConverterPtr& converter, FILE* fp,
+                              const ConfigLoadOptions& options);
+
+  /**
+   * Loads a snapshot from @p fileName with the options it was written with.
+   * The file is memory-mapped where the platform allows.
+   */
+  static ConverterPtr NewFromFile(const std::string& fileName);
+
+  /**
+   * Loads a snapshot from @p fileName.
+   * @throws InvalidFormat if the snapshot was written with options other
+   *   than @p options.
+   */
+  static ConverterPtr NewFromFile(const std::string& fileName,
+                                  const ConfigLoadOptions& options);
+
+  /**
+   * Loads a snapshot from @p data without copying it. @p owner keeps the
+   * buffer alive for the lifetime of the converter.
+   */
+  static ConverterPtr NewFromSharedBuffer(const char* data, size_t size,
+                                          std::shared_ptr<const void> owner);
+
+  /**
+   * Like NewFromSharedBuffer(), but throws InvalidFormat if the snapshot was
+   * written with options other than @p options.
+   */
+  static ConverterPtr NewFromSharedBuffer(const char* data, size_t size,
+                                          std::shared_ptr<const void> owner,
+                                          const ConfigLoadOptions& options);
+
+  /** Returns true if @p data starts with a snapshot header. */
+  static bool IsSnapshot(const char* data, size_t size);
+};
+} // namespace opencc
@@ -0,0 +1,162 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "Config.hpp"
+#include "ConfigTestBase.hpp"
+#include "ConversionChain.hpp"
+#include "Converter.hpp"
+#include "ConverterSnapshot.hpp"
+#include "Exception.hpp"
+#include "PipelineConverter.hpp"
+#include "TestUtilsUTF8.hpp"
+
+namespace opencc {
+
+class ConverterSnapshotTest : public ConfigTestBase {
+protected:
+  ConverterSnapshotTest()
+      : snapshotFileName("converter_snapshot_test.ocs"),
+        inputs({utf8("燕燕于飞差池其羽之子于归远送于野"),
+                utf8("燕燕于飞，下上其音。之子于归，远送于南。"), "",
+                utf8("abc 于飞 xyz")}) {}
+
+  virtual void TearDown() { std::remove(snapshotFileName.c_str()); }
+
+  std::string ReadSnapshot() const {
+    std::ifstream ifs(snapshotFileName, std::ios::binary);
+    std::stringstream buffer;
+    buffer << ifs.rdbuf();
+    return buffer.str();
+  }
+
+  void ExpectSameOutput(const ConverterPtr& expected,
+                        const ConverterPtr& actual) const {
+    for (const std::string& input : inputs) {
+      EXPECT_EQ(expected->Convert(input), actual->Convert(input));
+    }
+  }
+
+  const std::string snapshotFileName;
+  const std::vector<std::string> inputs;
+};
+
+TEST_F(ConverterSnapshotTest, RoundTripMatchesConfig) {
+  Config config;
+  const ConverterPtr converter = config.NewFromFile(CONFIG_TEST_JSON_PATH);
+  ConverterSnapshot::SerializeToFile(converter, snapshotFileName);
+
+  const ConverterPtr restored =
+      ConverterSnapshot::NewFromFile(snapshotFileName);
+  ExpectSameOutput(converter, restored);
+  EXPECT_NE(nullptr, restored->GetSegmentation());
+  ASSERT_NE(nullptr, restored->GetConversionChain());
+  EXPECT_EQ(1, restored->GetConversionChain()->GetConversions().size());
+  EXPECT_EQ(utf8("燕燕于飛差池其羽之子于歸遠送於野"),
+            restored->Convert(inputs[0]));
+}
+
+TEST_F(ConverterSnapshotTest, ConfigLoadsSnapshotFiles) {
+  Config config;
+  const ConverterPtr converter = config.NewFromFile(CONFIG_TEST_JSON_PATH);
+  ConverterSnapshot::SerializeToFile(converter, snapshotFileName);
+
+  Config snapshotConfig;
+  ExpectSameOutput(converter, snapshotConfig.NewFromFile(snapshotFileName));
+}
+
+TEST_F(ConverterSnapshotTest, RejectsMismatchedLoadOptions) {
+  ConfigLoadOptions options;
+  options.includeTofuRiskDictionaries = false;
+  options.compileConversionChains = true;
+  Config config;
+  const ConverterPtr converter = config.NewFromFile(
+      CONFIG_TEST_JSON_PATH, std::vector<std::string>{}, nullptr, options);
+  ConverterSnapshot::SerializeToFile(converter, snapshotFileName, options);
+
+  Config snapshotConfig;
+  ExpectSameOutput(converter,
+                   snapshotConfig.NewFromFile(snapshotFileName,
+                                              std::vector<std::string>{},
+                                              nullptr, options));
+  ExpectSameOutput(converter, ConverterSnapshot::NewFromFile(snapshotFileName));
+  EXPECT_THROW(snapshotConfig.NewFromFile(snapshotFileName), InvalidFormat);
+  ConfigLoadOptions uncompiled = options;
+  uncompiled.compileConversionChains = false;
+  EXPECT_THROW(
+      ConverterSnapshot::NewFromFile(snapshotFileName, uncompiled),
+      InvalidFormat);
+}
+
+TEST_F(ConverterSnapshotTest, NestedGroupsAndNormalization) {
+  Config config;
+  const ConverterPtr nested = config.NewFromFile(
+      CONFIG_TEST_DIR_PATH + "/config_test_nested_group.json");
+  const ConverterPtr normalized = config.NewFromString(
+      R"({
+        "name": "Snapshot normalization test",
+        "normalization": [{"dict": {"type": "inline",
+                                    "entries": {"归": "歸"}}}],
+        "conversion_chain": [{"dict": {"type": "inline",
+                                       "entries": {"之子于歸": "之子于归"}}}]
+      })",
+      CONFIG_TEST_DIR_PATH);
+  const ConverterPtr pipeline(new PipelineConverter({nested, normalized}));
+
+  for (const ConverterPtr& converter : {nested, normalized, pipeline}) {
+    ConverterSnapshot::SerializeToFile(converter, snapshotFileName);
+    ExpectSameOutput(converter,
+                     ConverterSnapshot::NewFromFile(snapshotFileName));
+  }
+}
+
+TEST_F(ConverterSnapshotTest, LoadsFromUnalignedBuffer) {
+  Config config;
+  const ConverterPtr converter = config.NewFromFile(CONFIG_TEST_JSON_PATH);
+  ConverterSnapshot::SerializeToFile(converter, snapshotFileName);
+  const std::string snapshot = ReadSnapshot();
+
+  // Shifted by one byte, every table is copied instead of used in place.
+  std::shared_ptr<std::string> buffer(new std::string(" " + snapshot));
+  const ConverterPtr restored = ConverterSnapshot::NewFromSharedBuffer(
+      buffer->data() + 1, snapshot.size(), buffer);
+  ExpectSameOutput(converter, restored);
+}
+
+TEST_F(ConverterSnapshotTest, RejectsTruncatedSnapshot) {
+  Config config;
+  ConverterSnapshot::SerializeToFile(config.NewFromFile(CONFIG_TEST_JSON_PATH),
+                                     snapshotFileName);
+  const std::string snapshot = ReadSnapshot();
+  ASSERT_TRUE(ConverterSnapshot::IsSnapshot(snapshot.data(), snapshot.size()));
+
+  for (size_t size : {snapshot.size() / 4, snapshot.size() / 2,
+                      snapshot.size() - 1}) {
+    std::shared_ptr<std::string> truncated(
+        new std::string(snapshot.substr(0, size)));
+    EXPECT_THROW(ConverterSnapshot::NewFromSharedBuffer(
+                     truncated->data(), truncated->size(), truncated),
+                 InvalidFormat);
+  }
+  EXPECT_FALSE(ConverterSnapshot::IsSnapshot("{}", 2));
+}
+
+} // namespace opencc
@@ -0,0 +1,274 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+#include "ConverterStats.hpp"
+#include "PerThreadShards.hpp"
+
+using namespace opencc;
+
+namespace {
+
+// Upper bounds of the latency buckets in nanoseconds.
+constexpr uint64_t kLatencyBoundNanos[] = {
+    1000,      2500,      5000,      10000,      25000,      50000,     100000,
+    250000,    500000,    1000000,   2500000,    5000000,    10000000,  25000000,
+    50000000,  100000000, 250000000, 500000000, 1000000000, 2500000000};
+
+constexpr size_t kLatencyBuckets =
+    sizeof(kLatencyBoundNanos) / sizeof(kLatencyBoundNanos[0]) + 1;
+
+size_t CountChars(std::string_view text) {
+  size_t chars = 0;
+  for (char c : text) {
+    chars += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+  }
+  return chars;
+}
+
+using Counter = std::atomic<uint64_t>;
+
+void Add(Counter* counter, uint64_t value) {
+  if (value != 0) {
+    counter->fetch_add(value, std::memory_order_relaxed);
+  }
+}
+
+uint64_t Get(const Counter& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+// Counters written by one thread. They are atomic only so that Snapshot()
+// and Reset() may run concurrently; the writing thread never contends.
+struct Shard {
+  Counter calls{0};
+  Counter inputBytes{0};
+  Counter inputChars{0};
+  Counter outputBytes{0};
+  Counter outputChars{0};
+  Counter totalNanos{0};
+  Counter normalizationNanos{0};
+  Counter segmentationNanos{0};
+  std::array<Counter, ConversionProfile::kMaxStages> stageNanos{};
+  std::atomic<size_t> stageCount{0};
+  Counter matches{0};
+  Counter matchedBytes{0};
+  Counter unmatchedBytes{0};
+  Counter skipScanBytes{0};
+  std::array<Counter, kLatencyBuckets> latencyCounts{};
+};
+
+} // namespace
+
+class ConverterStats::StatsInternal {
+public:
+  internal::PerThreadShards<Shard> shards;
+};
+
+ConverterStats::ConverterStats() : internal(new StatsInternal) {}
+
+ConverterStats::~ConverterStats() {}
+
+void ConverterStats::Record(std::string_view input, std::string_view output,
+                            uint64_t nanos, const ConversionProfile& profile) {
+  Shard& shard = internal->shards.Local();
+  Add(&shard.calls, 1);
+  Add(&shard.inputBytes, input.size());
+  Add(&shard.inputChars, CountChars(input));
+  Add(&shard.outputBytes, output.size());
+  Add(&shard.outputChars, CountChars(output));
+  Add(&shard.totalNanos, nanos);
+  Add(&shard.normalizationNanos, profile.normalizationNanos);
+  Add(&shard.segmentationNanos, profile.segmentationNanos);
+  const size_t stages =
+      std::min(profile.stageCount, ConversionProfile::kMaxStages);
+  for (size_t i = 0; i < stages; i++) {
+    Add(&shard.stageNanos[i], profile.stageNanos[i]);
+  }
+  if (stages > shard.stageCount.load(std::memory_order_relaxed)) {
+    shard.stageCount.store(stages, std::memory_order_relaxed);
+  }
+  Add(&shard.matches, profile.matches.matches);
+  Add(&shard.matchedBytes, profile.matches.matchedBytes);
+  Add(&shard.unmatchedBytes, profile.matches.unmatchedBytes);
+  Add(&shard.skipScanBytes, profile.matches.skipScanBytes);
+  const size_t bucket =
+      std::lower_bound(std::begin(kLatencyBoundNanos),
+                       std::end(kLatencyBoundNanos), nanos) -
+      std::begin(kLatencyBoundNanos);
+  Add(&shard.latencyCounts[bucket], 1);
+}
+
+ConverterStatsSnapshot ConverterStats::Snapshot() const {
+  ConverterStatsSnapshot snapshot;
+  snapshot.latencyCounts.assign(kLatencyBuckets, 0);
+  size_t stages = 0;
+  internal->shards.ForEach([&stages](const Shard& shard) {
+    stages = std::max(stages, shard.stageCount.load(std::memory_order_relaxed));
+  });
+  snapshot.stageNanos.assign(stages, 0);
+  internal->shards.ForEach([&snapshot, stages](const Shard& shard) {
+    snapshot.calls += Get(shard.calls);
+    snapshot.inputBytes += Get(shard.inputBytes);
+    snapshot.inputChars += Get(shard.inputChars);
+    snapshot.outputBytes += Get(shard.outputBytes);
+    snapshot.outputChars += Get(shard.outputChars);
+    snapshot.totalNanos += Get(shard.totalNanos);
+    snapshot.normalizationNanos += Get(shard.normalizationNanos);
+    snapshot.segmentationNanos += Get(shard.segmentationNanos);
+    for (size_t i = 0; i < stages; i++) {
+      snapshot.stageNanos[i] += Get(shard.stageNanos[i]);
+    }
+    snapshot.matches.matches += Get(shard.matches);
+    snapshot.matches.matchedBytes += Get(shard.matchedBytes);
+    snapshot.matches.unmatchedBytes += Get(shard.unmatchedBytes);
+    snapshot.matches.skipScanBytes += Get(shard.skipScanBytes);
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+      snapshot.latencyCounts[i] += Get(shard.latencyCounts[i]);
+    }
+  });
+  return snapshot;
+}
+
+void ConverterStats::Reset() {
+  internal->shards.ForEach([](Shard& shard) {
+    for (Counter* counter :
+         {&shard.calls, &shard.inputBytes, &shard.inputChars,
+          &shard.outputBytes, &shard.outputChars, &shard.totalNanos,
+          &shard.normalizationNanos, &shard.segmentationNanos,
+          &shard.matches, &shard.matchedBytes, &shard.unmatchedBytes,
+          &shard.skipScanBytes}) {
+      counter->store(0, std::memory_order_relaxed);
+    }
+    for (Counter& counter : shard.stageNanos) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    for (Counter& counter : shard.latencyCounts) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    shard.stageCount.store(0, std::memory_order_relaxed);
+  });
+}
+
+std::string ConverterStats::ToPrometheusText(const std::string& prefix) const {
+  return Snapshot().ToPrometheusText(prefix);
+}
+
+const std::vector<double>& ConverterStatsSnapshot::LatencyBucketBounds() {
+  static const std::vector<double> bounds = []() {
+    std::vector<double> seconds;
+    for (uint64_t nanos : kLatencyBoundNanos) {
+      seconds.push_back(static_cast<double>(nanos) / 1e9);
+    }
+    return seconds;
+  }();
+  return bounds;
+}
+
+namespace {
+
+std::string FormatNumber(double value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.9g", value);
+  return buffer;
+}
+
+std::string Seconds(uint64_t nanos) {
+  return FormatNumber(static_cast<double>(nanos) / 1e9);
+}
+
+void AppendMetric(std::string* text, const std::string& name,
+                  const char* type, const char* help) {
+  text->append("# HELP ").append(name).append(" ").append(help).append("\n");
+  text->append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+void AppendSample(std::string* text, const std::string& name,
+                  const std::string& labels, const std::string& value) {
+  text->append(name);
+  if (!labels.empty()) {
+    text->append("{").append(labels).append("}");
+  }
+  text->append(" ").append(value).append("\n");
+}
+
+void AppendCounter(std::string* text, const std::string& name,
+                   const char* help, uint64_t value) {
+  AppendMetric(text, name, "counter", help);
+  AppendSample(text, name, "", std::to_string(value));
+}
+
+} // namespace
+
+std::string
+ConverterStatsSnapshot::ToPrometheusText(const std::string& prefix) const {
+  std::string text;
+  const std::string p = prefix + "_";
+  AppendCounter(&text, p + "conversions_total", "Number of conversions.",
+                calls);
+  AppendCounter(&text, p + "input_bytes_total", "UTF-8 bytes converted.",
+                inputBytes);
+  AppendCounter(&text, p + "input_chars_total", "Code points converted.",
+                inputChars);
+  AppendCounter(&text, p + "output_bytes_total", "UTF-8 bytes produced.",
+                outputBytes);
+  AppendCounter(&text, p + "output_chars_total", "Code points produced.",
+                outputChars);
+
+  const std::string stageName = p + "stage_seconds_total";
+  AppendMetric(&text, stageName, "counter",
+               "Time spent in each conversion step.");
+  AppendSample(&text, stageName, "stage=\"normalization\"",
+               Seconds(normalizationNanos));
+  AppendSample(&text, stageName, "stage=\"segmentation\"",
+               Seconds(segmentationNanos));
+  for (size_t i = 0; i < stageNanos.size(); i++) {
+    AppendSample(&text, stageName,
+                 "stage=\"conversion_" + std::to_string(i + 1) + "\"",
+                 Seconds(stageNanos[i]));
+  }
+
+  AppendCounter(&text, p + "dict_matches_total", "Dictionary matches.",
+                matches.matches);
+  AppendCounter(&text, p + "matched_bytes_total",
+                "Bytes replaced by dictionary matches.", matches.matchedBytes);
+  AppendCounter(&text, p + "unmatched_bytes_total",
+                "Bytes passed through without a match.",
+                matches.unmatchedBytes);
+  AppendCounter(&text, p + "skip_scan_bytes_total",
+                "Unmatched bytes consumed by the skip scan.",
+                matches.skipScanBytes);
+
+  const std::string latencyName = p + "conversion_duration_seconds";
+  AppendMetric(&text, latencyName, "histogram", "Conversion latency.");
+  const std::vector<double>& bounds = LatencyBucketBounds();
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < latencyCounts.size(); i++) {
+    cumulative += latencyCounts[i];
+    const std::string le =
+        i < bounds.size() ? FormatNumber(bounds[i]) : std::string("+Inf");
+    AppendSample(&text, latencyName + "_bucket", "le=\"" + le + "\"",
+                 std::to_string(cumulative));
+  }
+  AppendSample(&text, latencyName + "_sum", "", Seconds(totalNanos));
+  AppendSample(&text, latencyName + "_count", "", std::to_string(calls));
+  return text;
+}
@@ -0,0 +1,171 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Common.hpp"
+
+namespace opencc {
+/**
+ * Dictionary lookup counters of a conversion.
+ *
+ * @ingroup opencc_cpp_api
+ */
+struct OPENCC_EXPORT MatchCounts {
+  /** Number of dictionary matches. */
+  uint64_t matches = 0;
+  /** Input bytes replaced by dictionary matches. */
+  uint64_t matchedBytes = 0;
+  /** Input bytes passed through without a match. */
+  uint64_t unmatchedBytes = 0;
+  /**
+   * The part of unmatchedBytes consumed by the bulk scan over characters that
+   * cannot begin any key, without a dictionary lookup.
+   */
+  uint64_t skipScanBytes = 0;
+
+  void Add(const MatchCounts& other) {
+    matches += other.matches;
+    matchedBytes += other.matchedBytes;
+    unmatchedBytes += other.unmatchedBytes;
+    skipScanBytes += other.skipScanBytes;
+  }
+};
+
+/**
+ * Time spent in each step of one conversion, filled in by
+ * Converter::AppendConvertedProfiled().
+ *
+ * Stages are the passes of the conversion chains in the order they run; a
+ * PipelineConverter numbers the passes of all its stages consecutively.
+ * Passes past the last slot are added to the last slot.
+ *
+ * @ingroup opencc_cpp_api
+ */
+struct OPENCC_EXPORT ConversionProfile {
+  static constexpr size_t kMaxStages = 16;
+
+  uint64_t normalizationNanos = 0;
+  uint64_t segmentationNanos = 0;
+  std::array<uint64_t, kMaxStages> stageNanos{};
+  /** Number of stages that have run so far, i.e. the next stage's index. */
+  size_t stageCount = 0;
+  MatchCounts matches;
+
+  void AddStageNanos(size_t stage, uint64_t nanos) {
+    stageNanos[stage < kMaxStages ? stage : kMaxStages - 1] += nanos;
+  }
+};
+
+/**
+ * Point-in-time totals of a ConverterStats collector.
+ *
+ * @ingroup opencc_cpp_api
+ */
+struct OPENCC_EXPORT ConverterStatsSnapshot {
+  /** Number of conversions recorded. */
+  uint64_t calls = 0;
+  uint64_t inputBytes = 0;
+  /** Input Unicode code points. */
+  uint64_t inputChars = 0;
+  uint64_t outputBytes = 0;
+  /** Output Unicode code points. */
+  uint64_t outputChars = 0;
+  /** Wall time of all conversions. */
+  uint64_t totalNanos = 0;
+  uint64_t normalizationNanos = 0;
+  uint64_t segmentationNanos = 0;
+  /** Time spent in each conversion stage; see ConversionProfile. */
+  std::vector<uint64_t> stageNanos;
+  MatchCounts matches;
+  /**
+   * Number of conversions per latency bucket, not cumulative. Entry i counts
+   * conversions taking at most LatencyBucketBounds()[i] seconds and more
+   * than the bound before; the last entry counts the rest.
+   */
+  std::vector<uint64_t> latencyCounts;
+
+  /** Upper bounds of the latency buckets in seconds, ascending. */
+  static const std::vector<double>& LatencyBucketBounds();
+
+  /**
+   * Formats the snapshot in the Prometheus text exposition format, with
+   * metric names starting with @p prefix followed by an underscore.
+   */
+  std::string ToPrometheusText(const std::string& prefix = "opencc") const;
+};
+
+/**
+ * Throughput and latency counters of conversions through a Converter,
+ * enabled with Converter::EnableStats().
+ *
+ * Each thread records into its own counters, so converting from many
+ * threads does not contend on shared cache lines; Snapshot() sums them.
+ * Counters of threads that have exited are kept. All methods are
+ * thread-safe.
+ *
+ * @ingroup opencc_cpp_api
+ */
+class OPENCC_EXPORT ConverterStats {
+public:
+  ConverterStats();
+
+  ~ConverterStats();
+
+  ConverterStats(const ConverterStats&) = delete;
+  ConverterStats& operator=(const ConverterStats&) = delete;
+
+  /**
+   * Records one conversion of @p input to @p output that took @p nanos
+   * nanoseconds, with the breakdown in @p profile.
+   */
+  void Record(std::string_view input, std::string_view output, uint64_t nanos,
+              const ConversionProfile& profile);
+
+  /** Returns the totals recorded since construction or the last Reset(). */
+  ConverterStatsSnapshot Snapshot() const;
+
+  /** Sets all counters to zero. */
+  void Reset();
+
+  /** Equivalent to Snapshot().ToPrometheusText(@p prefix). */
+  std::string ToPrometheusText(const std::string& prefix = "opencc") const;
+
+private:
+  class StatsInternal;
+  std::unique_ptr<StatsInternal> internal;
+};
+
+namespace internal {
+
+inline uint64_t NanosSince(std::chrono::steady_clock::time_point start) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+} // namespace internal
+} // namespace opencc
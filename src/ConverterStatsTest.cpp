@@ -0,0 +1,223 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <numeric>
+#include <thread>
+
+#include "Config.hpp"
+#include "ConfigTestBase.hpp"
+#include "ConversionChain.hpp"
+#include "Converter.hpp"
+#include "ConverterStats.hpp"
+#include "PipelineConverter.hpp"
+#include "SimpleConverter.hpp"
+#include "TestUtilsUTF8.hpp"
+
+namespace opencc {
+
+class ConverterStatsTest : public ConfigTestBase {
+protected:
+  ConverterStatsTest()
+      : inputs({utf8("太后的头发很干燥"), utf8("燕燕于飞，差池其羽。"),
+                "ASCII only", "", utf8("之子于归，远送于野。\n")}) {}
+
+  // Normalization pre-pass, then a two-dictionary chain that compiles into
+  // one pass.
+  ConverterPtr NormalizingConverter() {
+    const std::string first =
+        R"({"type": "inline", "entries": {"头发": "頭髮", "里": "裏",
+            "干": "乾", "太后": "太后"}})";
+    ConfigLoadOptions options;
+    options.compileConversionChains = true;
+    return Config().NewFromString(
+        R"({"name": "Normalizing",
+            "normalization": [{"dict": {"type": "inline",
+                                        "entries": {"x": "里"}}}],
+            "segmentation": {"type": "mmseg", "dict": )" +
+            first + R"(},
+            "conversion_chain": [{"dict": )" +
+            first + R"(}, {"dict": {"type": "inline", "entries":
+                {"裏": "裡", "頭髮": "HAIR"}}}]})",
+        std::vector<std::string>{CONFIG_TEST_DIR_PATH}, options);
+  }
+
+  // Checks that converting with stats enabled produces the same output as
+  // without, and returns the stats of converting every input once.
+  ConverterStatsSnapshot ConvertAll(const ConverterPtr& converter) {
+    std::vector<std::string> expected;
+    for (const std::string& input : inputs) {
+      expected.push_back(converter->Convert(input));
+    }
+    const std::shared_ptr<ConverterStats> stats = converter->EnableStats();
+    stats->Reset();
+    for (size_t i = 0; i < inputs.size(); i++) {
+      EXPECT_EQ(expected[i], converter->Convert(inputs[i])) << inputs[i];
+      std::string appended = "prefix";
+      converter->AppendConverted(inputs[i], &appended);
+      EXPECT_EQ("prefix" + expected[i], appended) << inputs[i];
+    }
+    return stats->Snapshot();
+  }
+
+  const std::vector<std::string> inputs;
+};
+
+TEST_F(ConverterStatsTest, RecordsConversions) {
+  const ConverterPtr converter = Config().NewFromFile(CONFIG_TEST_JSON_PATH);
+  EXPECT_EQ(nullptr, converter->GetStats());
+  const ConverterStatsSnapshot snapshot = ConvertAll(converter);
+
+  size_t inputBytes = 0;
+  size_t outputBytes = 0;
+  for (const std::string& input : inputs) {
+    inputBytes += input.size();
+    outputBytes += converter->Convert(input).size();
+  }
+  EXPECT_EQ(2 * inputs.size(), snapshot.calls);
+  EXPECT_EQ(2 * inputBytes, snapshot.inputBytes);
+  EXPECT_EQ(2 * outputBytes, snapshot.outputBytes);
+  EXPECT_EQ(2 * (8 + 10 + 10 + 0 + 11), snapshot.inputChars);
+  EXPECT_EQ(snapshot.inputChars, snapshot.outputChars);
+  EXPECT_EQ(snapshot.calls,
+            std::accumulate(snapshot.latencyCounts.begin(),
+                            snapshot.latencyCounts.end(), uint64_t(0)));
+  EXPECT_EQ(ConverterStatsSnapshot::LatencyBucketBounds().size() + 1,
+            snapshot.latencyCounts.size());
+  EXPECT_EQ(1, snapshot.stageNanos.size());
+  EXPECT_EQ(0, snapshot.normalizationNanos);
+  EXPECT_GT(snapshot.matches.matches, 0);
+  // A single pass looks at every input byte once.
+  EXPECT_EQ(snapshot.inputBytes,
+            snapshot.matches.matchedBytes + snapshot.matches.unmatchedBytes);
+  EXPECT_LE(snapshot.matches.skipScanBytes, snapshot.matches.unmatchedBytes);
+}
+
+TEST_F(ConverterStatsTest, ProfilesNormalizationAndCompiledChain) {
+  const ConverterPtr converter = NormalizingConverter();
+  EXPECT_EQ(utf8("太后的HAIR很乾燥"),
+            converter->Convert(utf8("太后的头发很干燥")));
+  const ConverterStatsSnapshot snapshot = ConvertAll(converter);
+  EXPECT_EQ(2 * inputs.size(), snapshot.calls);
+  EXPECT_EQ(converter->GetConversionChain()->GetPassCount(),
+            snapshot.stageNanos.size());
+  EXPECT_GT(snapshot.normalizationNanos, 0);
+  EXPECT_GT(snapshot.matches.matches, 0);
+}
+
+TEST_F(ConverterStatsTest, NumbersPipelineStagesConsecutively) {
+  const ConverterPtr first = Config().NewFromFile(CONFIG_TEST_JSON_PATH);
+  const ConverterPtr second = NormalizingConverter();
+  const ConverterPtr pipeline(
+      new PipelineConverter(std::vector<ConverterPtr>{first, second}));
+  const ConverterStatsSnapshot snapshot = ConvertAll(pipeline);
+  EXPECT_EQ(2 * inputs.size(), snapshot.calls);
+  EXPECT_EQ(1 + second->GetConversionChain()->GetPassCount(),
+            snapshot.stageNanos.size());
+  // Only the pipeline records; its stages were not enabled.
+  EXPECT_EQ(nullptr, first->GetStats());
+}
+
+TEST_F(ConverterStatsTest, DisableStopsRecording) {
+  const ConverterPtr converter = Config().NewFromFile(CONFIG_TEST_JSON_PATH);
+  const std::shared_ptr<ConverterStats> stats = converter->EnableStats();
+  EXPECT_EQ(stats, converter->GetStats());
+  converter->Convert(inputs[0]);
+  converter->DisableStats();
+  EXPECT_EQ(nullptr, converter->GetStats());
+  converter->Convert(inputs[0]);
+  EXPECT_EQ(1, stats->Snapshot().calls);
+
+  // Enabling again resumes counting into the same collector.
+  EXPECT_EQ(stats, converter->EnableStats());
+  converter->Convert(inputs[0]);
+  EXPECT_EQ(2, stats->Snapshot().calls);
+  stats->Reset();
+  const ConverterStatsSnapshot snapshot = stats->Snapshot();
+  EXPECT_EQ(0, snapshot.calls);
+  EXPECT_EQ(0, snapshot.inputBytes);
+  EXPECT_EQ(0, snapshot.totalNanos);
+  EXPECT_TRUE(snapshot.stageNanos.empty());
+}
+
+TEST_F(ConverterStatsTest, SumsCountersOfAllThreads) {
+  const ConverterPtr converter = Config().NewFromFile(CONFIG_TEST_JSON_PATH);
+  const std::shared_ptr<ConverterStats> stats = converter->EnableStats();
+  const size_t threadCount = 4;
+  const size_t callsPerThread = 200;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threadCount; t++) {
+    threads.emplace_back([&]() {
+      for (size_t i = 0; i < callsPerThread; i++) {
+        converter->Convert(inputs[0]);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const ConverterStatsSnapshot snapshot = stats->Snapshot();
+  EXPECT_EQ(threadCount * callsPerThread, snapshot.calls);
+  EXPECT_EQ(threadCount * callsPerThread * inputs[0].size(),
+            snapshot.inputBytes);
+}
+
+TEST_F(ConverterStatsTest, CountsBatchItems) {
+  const ConverterPtr converter = Config().NewFromFile(CONFIG_TEST_JSON_PATH);
+  const std::shared_ptr<ConverterStats> stats = converter->EnableStats();
+  const std::vector<std::string_view> views(inputs.begin(), inputs.end());
+  std::string output;
+  std::vector<size_t> offsets;
+  converter->ConvertBatch(views, &output, &offsets);
+  EXPECT_EQ(inputs.size(), stats->Snapshot().calls);
+  EXPECT_EQ(output.size(), stats->Snapshot().outputBytes);
+}
+
+TEST_F(ConverterStatsTest, SimpleConverterForwardsToConverter) {
+  SimpleConverter converter(CONFIG_TEST_JSON_PATH);
+  EXPECT_EQ(nullptr, converter.GetStats());
+  const std::shared_ptr<ConverterStats> stats = converter.EnableStats();
+  EXPECT_EQ(stats, converter.GetConverter()->GetStats());
+  converter.Convert(inputs[1]);
+  EXPECT_EQ(1, stats->Snapshot().calls);
+  converter.DisableStats();
+  EXPECT_EQ(nullptr, converter.GetStats());
+}
+
+TEST_F(ConverterStatsTest, PrometheusText) {
+  const ConverterPtr converter = Config().NewFromFile(CONFIG_TEST_JSON_PATH);
+  const std::shared_ptr<ConverterStats> stats = converter->EnableStats();
+  converter->Convert(inputs[0]);
+  converter->Convert(inputs[2]);
+  const std::string text = stats->ToPrometheusText("test");
+  for (const char* line :
+       {"# TYPE test_conversions_total counter\n",
+        "test_conversions_total 2\n",
+        "test_input_chars_total 18\n",
+        "# TYPE test_stage_seconds_total counter\n",
+        "test_stage_seconds_total{stage=\"segmentation\"} ",
+        "test_stage_seconds_total{stage=\"conversion_1\"} ",
+        "# TYPE test_conversion_duration_seconds histogram\n",
+        "test_conversion_duration_seconds_bucket{le=\"1e-06\"} ",
+        "test_conversion_duration_seconds_bucket{le=\"+Inf\"} 2\n",
+        "test_conversion_duration_seconds_count 2\n"}) {
+    EXPECT_NE(std::string::npos, text.find(line)) << line << "\n" << text;
+  }
+  EXPECT_EQ(std::string::npos, text.find("conversion_2"));
+}
+
+} // namespace opencc
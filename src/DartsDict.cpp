@@ -17,14 +17,19 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
 
 #include "BinaryDict.hpp"
 #include "DartsDict.hpp"
 #include "Dict.hpp"
 #include "Lexicon.hpp"
+#include "MappedFile.hpp"
 #include "darts.h"
 
 using namespace opencc;
@@ -36,18 +41,25 @@ static const char* OCDHEADER = "OPENCCDARTS1";
 // same as the 32-bit case; old files simply zero-extend every unit to 64 bits.
 namespace {
 
-struct LegacyUnit64 {
-  uint64_t unit;
+// A unit of a darts-clone double array of either width, with the bit
+// layout of Darts::Details::DoubleArrayUnit.
+template <typename UnitType> struct DartsUnit {
+  UnitType unit;
   bool has_leaf() const { return ((unit >> 8) & 1) == 1; }
   int value() const {
     return static_cast<int>(unit & ((1U << 31) - 1));
   }
-  uint64_t label() const { return unit & ((1U << 31) | 0xFF); }
-  uint64_t offset() const {
+  UnitType label() const { return unit & ((1U << 31) | 0xFF); }
+  UnitType offset() const {
     return (unit >> 10) << ((unit & (1U << 9)) >> 6);
   }
 };
 
+typedef DartsUnit<uint64_t> LegacyUnit64;
+typedef DartsUnit<uint32_t> Unit32;
+
+static_assert(sizeof(Unit32) == sizeof(uint32_t), "unexpected padding");
+
 int Legacy64ExactMatch(const LegacyUnit64* arr, const char* key, size_t len) {
   size_t pos = 0;
   for (size_t i = 0; i < len; ++i) {
@@ -59,24 +71,27 @@ int Legacy64ExactMatch(const LegacyUnit64* arr, const char* key, size_t len) {
   return arr[pos ^ static_cast<size_t>(arr[pos].offset())].value();
 }
 
-// Returns number of matches found; fills results[] with values (shortest to
-// longest).  Mirror of Darts::DoubleArray::commonPrefixSearch value-only form.
-size_t Legacy64PrefixSearch(const LegacyUnit64* arr, const char* key,
-                             size_t maxLen, int* results, size_t maxResults) {
-  size_t count = 0;
+// Walks arr once along [key, key + len) and returns the value of the
+// longest key that prefixes it, or -1, storing that key's length in
+// matchedLength. Same transitions as Darts::DoubleArray::commonPrefixSearch,
+// without collecting the shorter matches.
+template <typename Unit>
+int LongestPrefix(const Unit* arr, const char* key, size_t len,
+                  size_t* matchedLength) {
+  int value = -1;
   size_t pos = 0;
-  for (size_t i = 0; i < maxLen; ++i) {
-    uint64_t c = static_cast<unsigned char>(key[i]);
-    pos ^= static_cast<size_t>(arr[pos].offset() ^ c);
-    if (arr[pos].label() != c) break;
-    if (arr[pos].has_leaf()) {
-      if (count < maxResults) {
-        results[count] = arr[pos ^ static_cast<size_t>(arr[pos].offset())].value();
-      }
-      ++count;
+  Unit unit = arr[0];
+  for (size_t i = 0; i < len; ++i) {
+    const auto c = static_cast<unsigned char>(key[i]);
+    pos ^= static_cast<size_t>(unit.offset() ^ c);
+    unit = arr[pos];
+    if (unit.label() != c) break;
+    if (unit.has_leaf()) {
+      value = arr[pos ^ static_cast<size_t>(unit.offset())].value();
+      *matchedLength = i + 1;
     }
   }
-  return count;
+  return value;
 }
 
 // Mirror of Darts::DoubleArray::validate(); checks root sanity, offset bounds,
@@ -100,321 +115,262 @@ bool ValidateLegacy64(const LegacyUnit64* arr, size_t numUnits, int maxValueLimi
 
 class DartsDict::DartsInternal {
 public:
-  BinaryDictPtr binary;
-  void* buffer;
-  Darts::DoubleArray* doubleArray;     // 32-bit files (new, or old 32-bit platform)
-  const LegacyUnit64* legacyArray64;  // old 64-bit files; points into buffer
-
-  DartsInternal()
-      : binary(nullptr), buffer(nullptr), doubleArray(nullptr),
-        legacyArray64(nullptr) {}
-
-  ~DartsInternal() {
-    if (buffer != nullptr) {
-      free(buffer);
+  // Keeps the bytes of a loaded dictionary alive: a file mapping, a shared
+  // buffer or ownedBuffer.
+  std::shared_ptr<const void> bufferOwner;
+  std::string ownedBuffer;
+  // 32-bit files (new, or old 32-bit platform). Maps the units in place, or
+  // units when they are not suitably aligned.
+  std::unique_ptr<Darts::DoubleArray> doubleArray;
+  std::vector<uint32_t> units;
+  // Old 64-bit files; points into legacyUnits, a copy of the units, since
+  // they lie at an offset that is not 8-byte aligned.
+  const LegacyUnit64* legacyArray64 = nullptr;
+  std::vector<LegacyUnit64> legacyUnits;
+  // The serialized BinaryDict section of a loaded file, from which the
+  // lexicon is built on first use.
+  const char* binaryData = nullptr;
+  size_t binarySize = 0;
+  // Default value of every entry, indexed by the values of the double array.
+  std::vector<std::string_view> defaultValues;
+  size_t maxLength = 0;
+
+  LexiconPtr lexicon;
+  std::mutex lexiconMutex;
+  std::atomic<bool> lexiconConstructed{false};
+
+  int ExactMatch(const char* word, size_t len) const {
+    if (legacyArray64 != nullptr) {
+      return Legacy64ExactMatch(legacyArray64, word, len);
     }
-    delete doubleArray;
-    // legacyArray64 aliases buffer — no separate free
+    Darts::DoubleArray::result_pair_type result;
+    doubleArray->exactMatchSearch(word, result, len);
+    return result.value;
+  }
+
+  int LongestPrefix(const char* word, size_t len,
+                    size_t* matchedLength) const {
+    if (legacyArray64 != nullptr) {
+      return ::LongestPrefix(legacyArray64, word, len, matchedLength);
+    }
+    return ::LongestPrefix(static_cast<const Unit32*>(doubleArray->array()),
+                           word, len, matchedLength);
   }
 };
 
-DartsDict::DartsDict() { internal = new DartsInternal; }
+DartsDict::DartsDict() : internal(new DartsInternal) {}
 
-DartsDict::~DartsDict() { delete internal; }
+DartsDict::~DartsDict() {}
 
-size_t DartsDict::KeyMaxLength() const { return maxLength; }
+size_t DartsDict::KeyMaxLength() const { return internal->maxLength; }
 
 Optional<const DictEntry*> DartsDict::Match(const char* word,
                                             size_t len) const {
-  if (len > maxLength) {
+  if (len > internal->maxLength) {
     return Optional<const DictEntry*>::Null();
   }
-  if (internal->legacyArray64 != nullptr) {
-    int val = Legacy64ExactMatch(internal->legacyArray64, word, len);
-    if (val != -1) {
-      return Optional<const DictEntry*>(lexicon->At(static_cast<size_t>(val)));
-    }
+  const int value = internal->ExactMatch(word, len);
+  if (value < 0) {
     return Optional<const DictEntry*>::Null();
   }
-  Darts::DoubleArray& dict = *internal->doubleArray;
-  Darts::DoubleArray::result_pair_type result;
-  dict.exactMatchSearch(word, result, len);
-  if (result.value != -1) {
-    return Optional<const DictEntry*>(
-        lexicon->At(static_cast<size_t>(result.value)));
-  }
-  return Optional<const DictEntry*>::Null();
+  return Optional<const DictEntry*>(
+      GetLexicon()->At(static_cast<size_t>(value)));
 }
 
 Optional<const DictEntry*> DartsDict::MatchPrefix(const char* word,
                                                   size_t len) const {
-  const size_t DEFAULT_NUM_ENTRIES = 64;
-  size_t searchLen = (std::min)(maxLength, len);
-
-  if (internal->legacyArray64 != nullptr) {
-    int results[DEFAULT_NUM_ENTRIES];
-    size_t numMatched = Legacy64PrefixSearch(
-        internal->legacyArray64, word, searchLen, results, DEFAULT_NUM_ENTRIES);
-    if (numMatched == 0) {
-      return Optional<const DictEntry*>::Null();
-    }
-    int maxVal;
-    if (numMatched < DEFAULT_NUM_ENTRIES) {
-      maxVal = results[numMatched - 1];
-    } else {
-      std::vector<int> rematchedResults(numMatched);
-      numMatched = Legacy64PrefixSearch(internal->legacyArray64, word,
-                                        searchLen, rematchedResults.data(),
-                                        rematchedResults.size());
-      maxVal = rematchedResults[numMatched - 1];
-    }
-    if (maxVal >= 0) {
-      return Optional<const DictEntry*>(
-          lexicon->At(static_cast<size_t>(maxVal)));
-    }
+  size_t matchedLength = 0;
+  const int value = internal->LongestPrefix(word, len, &matchedLength);
+  if (value < 0) {
     return Optional<const DictEntry*>::Null();
   }
+  return Optional<const DictEntry*>(
+      GetLexicon()->At(static_cast<size_t>(value)));
+}
 
-  Darts::DoubleArray& dict = *internal->doubleArray;
-  Darts::DoubleArray::value_type results[DEFAULT_NUM_ENTRIES];
-  Darts::DoubleArray::value_type maxMatchedResult;
-  size_t numMatched =
-      dict.commonPrefixSearch(word, results, DEFAULT_NUM_ENTRIES, searchLen);
-  if (numMatched == 0) {
-    return Optional<const DictEntry*>::Null();
-  } else if (numMatched < DEFAULT_NUM_ENTRIES) {
-    maxMatchedResult = results[numMatched - 1];
-  } else {
-    Darts::DoubleArray::value_type* rematchedResults =
-        new Darts::DoubleArray::value_type[numMatched];
-    numMatched = dict.commonPrefixSearch(word, rematchedResults, numMatched,
-                                         searchLen);
-    maxMatchedResult = rematchedResults[numMatched - 1];
-    delete[] rematchedResults;
-  }
-  if (maxMatchedResult >= 0) {
-    return Optional<const DictEntry*>(
-        lexicon->At(static_cast<size_t>(maxMatchedResult)));
+LexiconPtr DartsDict::GetLexicon() const {
+  if (!internal->lexiconConstructed.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(internal->lexiconMutex);
+    if (!internal->lexiconConstructed.load(std::memory_order_relaxed)) {
+      internal->lexicon =
+          BinaryDict::NewFromBuffer(internal->binaryData, internal->binarySize)
+              ->GetLexicon();
+      internal->lexiconConstructed.store(true, std::memory_order_release);
+    }
   }
-  return Optional<const DictEntry*>::Null();
+  return internal->lexicon;
 }
 
-LexiconPtr DartsDict::GetLexicon() const { return lexicon; }
+bool DartsDict::IsLexiconConstructed() const {
+  return internal->lexiconConstructed.load(std::memory_order_acquire);
+}
 
 PrefixMatchView DartsDict::MatchPrefixValue(const char* word,
                                             size_t len) const {
-  Optional<const DictEntry*> matched = MatchPrefix(word, len);
-  if (matched.IsNull()) {
+  size_t matchedLength = 0;
+  const int value = internal->LongestPrefix(word, len, &matchedLength);
+  if (value < 0) {
     return PrefixMatchView{};
   }
-  const DictEntry* entry = matched.Get();
-  const size_t keyLen = entry->KeyLength();
-  return PrefixMatchView{true, keyLen, std::string_view(word, keyLen),
-                         entry->GetDefaultView()};
+  return PrefixMatchView{true, matchedLength,
+                         std::string_view(word, matchedLength),
+                         internal->defaultValues[static_cast<size_t>(value)]};
 }
 
-DartsDictPtr DartsDict::NewFromFile(FILE* fp) {
-  DartsDictPtr dict(new DartsDict());
-  auto internal = dict->internal;
-
-  size_t headerLen = strlen(OCDHEADER);
-  std::vector<char> headerBuffer(headerLen);
-  size_t bytesRead = fread(headerBuffer.data(), sizeof(char), headerLen, fp);
-  if (bytesRead != headerLen || memcmp(headerBuffer.data(), OCDHEADER, headerLen) != 0) {
-    throw InvalidFormat("Invalid OpenCC dictionary header");
-  }
-
-  // Measure remaining bytes for bounds checking
-  long currentOffset = ftell(fp);
-  fseek(fp, 0L, SEEK_END);
-  long fileEnd = ftell(fp);
-  fseek(fp, currentOffset, SEEK_SET);
-  size_t remainingSize =
-      (fileEnd > currentOffset)
-          ? static_cast<size_t>(fileEnd - currentOffset)
-          : 0;
-
-  // Detect the dartsSize field width by reading 8 bytes.
-  //   - Old 64-bit build: dartsSize field is uint64_t (8 bytes); high 32 bits
-  //     are zero for any realistic file size.
-  //   - Current build (any word size) or old 32-bit build: dartsSize field is
-  //     uint32_t (4 bytes); the other half of the probe is either the first
-  //     4 bytes of the darts array (non-zero for any valid array whose root
-  //     unit has a non-zero offset) or dartsSize itself, so the native
-  //     uint64_t load has non-zero high bits.
-  uint8_t probe[8];
-  if (fread(probe, 1, 8, fp) != 8) {
-    throw InvalidFormat("Invalid OpenCC dictionary header (dartsSize)");
-  }
-  bool is64bit = LooksLikeLegacy64Field(probe);
-
-  if (is64bit) {
-    uint64_t dartsSize64;
-    memcpy(&dartsSize64, probe, 8);
-    size_t dartsSize = static_cast<size_t>(dartsSize64);
-    if (dartsSize > remainingSize) {
-      throw InvalidFormat(
-          "Invalid OpenCC dictionary (dartsSize exceeds file size)");
-    }
-    if (dartsSize % sizeof(LegacyUnit64) != 0) {
-      throw InvalidFormat("Invalid legacy OCD dictionary unit alignment");
-    }
-    std::unique_ptr<void, decltype(&free)> buffer(malloc(dartsSize), free);
-    if (!buffer) {
-      throw std::bad_alloc();
+bool DartsDict::EnumerateKeys(
+    const std::function<void(const char*, size_t)>& cb) const {
+  if (internal->binaryData == nullptr) {
+    for (const std::unique_ptr<DictEntry>& entry : *internal->lexicon) {
+      const std::string_view key = entry->KeyView();
+      cb(key.data(), key.size());
     }
-    bytesRead = fread(buffer.get(), 1, dartsSize, fp);
-    if (bytesRead != dartsSize) {
-      throw InvalidFormat("Invalid legacy OCD dictionary size mismatch");
-    }
-
-    BinaryDictPtr binary = BinaryDict::NewFromFile(fp);
-
-    internal->buffer = buffer.release();
-    internal->binary = std::move(binary);
-    internal->legacyArray64 = static_cast<const LegacyUnit64*>(internal->buffer);
+    return true;
+  }
+  BinaryDict::VisitEntries(internal->binaryData, internal->binarySize,
+                           [&cb](std::string_view key, std::string_view) {
+                             cb(key.data(), key.size());
+                           });
+  return true;
+}
 
-    dict->lexicon = internal->binary->GetLexicon();
-    dict->maxLength = internal->binary->KeyMaxLength();
-    size_t numUnits = dartsSize / sizeof(LegacyUnit64);
-    if (!ValidateLegacy64(internal->legacyArray64, numUnits,
-                          static_cast<int>(dict->lexicon->Length()))) {
-      throw InvalidFormat("Invalid legacy OCD dictionary darts data");
+bool DartsDict::EnumerateEntries(
+    const std::function<bool(std::string_view key, std::string_view value)>&
+        cb) const {
+  if (internal->binaryData == nullptr) {
+    for (const std::unique_ptr<DictEntry>& entry : *internal->lexicon) {
+      if (!cb(entry->KeyView(), entry->GetDefaultView())) {
+        break;
+      }
     }
-    return dict;
+    return true;
   }
+  // The entries were validated on load; parsing the rest after a stop only
+  // skips over them.
+  bool walking = true;
+  BinaryDict::VisitEntries(
+      internal->binaryData, internal->binarySize,
+      [&cb, &walking](std::string_view key, std::string_view value) {
+        walking = walking && cb(key, value);
+      });
+  return true;
+}
 
-  // Fixed-width layout: dartsSize is the first 4 bytes of probe; remaining 4
-  // bytes belong to the array, so seek back.
-  fseek(fp, -4, SEEK_CUR);
-  uint32_t dartsSize32;
-  memcpy(&dartsSize32, probe, 4);
-  size_t dartsSize = dartsSize32;
-  if (dartsSize > remainingSize) {
-    throw InvalidFormat(
-        "Invalid OpenCC dictionary (dartsSize exceeds file size)");
-  }
-  std::unique_ptr<Darts::DoubleArray> doubleArray(new Darts::DoubleArray());
-  if (dartsSize % doubleArray->unit_size() != 0) {
-    throw InvalidFormat("Invalid OpenCC dictionary size of darts alignment");
-  }
-  std::unique_ptr<void, decltype(&free)> buffer(malloc(dartsSize), free);
-  if (!buffer) {
-    throw std::bad_alloc();
-  }
-  bytesRead = fread(buffer.get(), 1, dartsSize, fp);
-  if (bytesRead != dartsSize) {
-    throw InvalidFormat("Invalid OpenCC dictionary size of darts mismatch");
+DartsDictPtr DartsDict::NewFromFile(FILE* fp) {
+  const long start = ftell(fp);
+  std::shared_ptr<const internal::MappedFile> file =
+      internal::MappedFile::Open(fp);
+  if (start < 0 || static_cast<size_t>(start) > file->Size()) {
+    throw InvalidFormat("Invalid OpenCC dictionary header");
   }
-  doubleArray->set_array(buffer.get(), dartsSize / doubleArray->unit_size());
-
-  BinaryDictPtr binary = BinaryDict::NewFromFile(fp);
-
-  internal->buffer = buffer.release();
-  internal->doubleArray = doubleArray.release();
-  internal->binary = std::move(binary);
+  const char* data = file->Data() + start;
+  const size_t size = file->Size() - static_cast<size_t>(start);
+  return NewFromSharedBuffer(data, size, std::move(file));
+}
 
-  dict->lexicon = internal->binary->GetLexicon();
-  dict->maxLength = internal->binary->KeyMaxLength();
-  if (!internal->doubleArray->validate(static_cast<Darts::DoubleArray::value_type>(
-          dict->lexicon->Length()))) {
-    throw InvalidFormat("Invalid OpenCC dictionary darts data");
-  }
+DartsDictPtr DartsDict::NewFromBuffer(const char* data, size_t size) {
+  DartsDictPtr dict(new DartsDict());
+  dict->internal->ownedBuffer.assign(data, size);
+  dict->LoadFromBuffer(dict->internal->ownedBuffer.data(),
+                       dict->internal->ownedBuffer.size());
   return dict;
 }
 
-DartsDictPtr DartsDict::NewFromBuffer(const char* data, size_t size) {
+DartsDictPtr DartsDict::NewFromSharedBuffer(const char* data, size_t size,
+                                            std::shared_ptr<const void> owner) {
   DartsDictPtr dict(new DartsDict());
-  auto internal = dict->internal;
+  dict->internal->bufferOwner = std::move(owner);
+  dict->LoadFromBuffer(data, size);
+  return dict;
+}
 
+void DartsDict::LoadFromBuffer(const char* data, size_t size) {
   size_t headerLen = strlen(OCDHEADER);
   if (size < headerLen || memcmp(data, OCDHEADER, headerLen) != 0) {
     throw InvalidFormat("Invalid OpenCC dictionary header");
   }
   size_t offset = headerLen;
 
+  // Detect the dartsSize field width from 8 bytes.
+  //   - Old 64-bit build: dartsSize field is uint64_t (8 bytes); high 32 bits
+  //     are zero for any realistic file size.
+  //   - Current build (any word size) or old 32-bit build: dartsSize field is
+  //     uint32_t (4 bytes); the other half of the probe is either the first
+  //     4 bytes of the darts array (non-zero for any valid array whose root
+  //     unit has a non-zero offset) or dartsSize itself, so the native
+  //     uint64_t load has non-zero high bits.
   if (size - offset < 8) {
     throw InvalidFormat("Invalid OpenCC dictionary header (dartsSize)");
   }
   uint8_t probe[8];
   memcpy(probe, data + offset, 8);
-  offset += 8;
-  bool is64bit = LooksLikeLegacy64Field(probe);
+  const bool is64bit = LooksLikeLegacy64Field(probe);
 
+  size_t dartsSize;
   if (is64bit) {
     uint64_t dartsSize64;
     memcpy(&dartsSize64, probe, 8);
-    size_t dartsSize = static_cast<size_t>(dartsSize64);
-    if (dartsSize > size - offset) {
+    offset += 8;
+    if (dartsSize64 > size - offset) {
       throw InvalidFormat(
           "Invalid OpenCC dictionary (dartsSize exceeds file size)");
     }
+    dartsSize = static_cast<size_t>(dartsSize64);
     if (dartsSize % sizeof(LegacyUnit64) != 0) {
       throw InvalidFormat("Invalid legacy OCD dictionary unit alignment");
     }
-    std::unique_ptr<void, decltype(&free)> buffer(malloc(dartsSize), free);
-    if (!buffer) {
-      throw std::bad_alloc();
+    internal->legacyUnits.resize(dartsSize / sizeof(LegacyUnit64));
+    memcpy(internal->legacyUnits.data(), data + offset, dartsSize);
+    internal->legacyArray64 = internal->legacyUnits.data();
+  } else {
+    // Fixed-width layout: dartsSize is the first 4 bytes of probe; the
+    // remaining 4 bytes belong to the array.
+    uint32_t dartsSize32;
+    memcpy(&dartsSize32, probe, 4);
+    offset += 4;
+    dartsSize = dartsSize32;
+    if (dartsSize > size - offset) {
+      throw InvalidFormat(
+          "Invalid OpenCC dictionary (dartsSize exceeds file size)");
     }
-    memcpy(buffer.get(), data + offset, dartsSize);
-    offset += dartsSize;
-
-    BinaryDictPtr binary = BinaryDict::NewFromBuffer(data + offset, size - offset);
-
-    internal->buffer = buffer.release();
-    internal->binary = std::move(binary);
-    internal->legacyArray64 = static_cast<const LegacyUnit64*>(internal->buffer);
-
-    dict->lexicon = internal->binary->GetLexicon();
-    dict->maxLength = internal->binary->KeyMaxLength();
-    size_t numUnits = dartsSize / sizeof(LegacyUnit64);
-    if (!ValidateLegacy64(internal->legacyArray64, numUnits,
-                          static_cast<int>(dict->lexicon->Length()))) {
-      throw InvalidFormat("Invalid legacy OCD dictionary darts data");
+    std::unique_ptr<Darts::DoubleArray> doubleArray(new Darts::DoubleArray());
+    if (dartsSize % doubleArray->unit_size() != 0) {
+      throw InvalidFormat("Invalid OpenCC dictionary size of darts alignment");
     }
-    return dict;
-  }
-
-  // Fixed-width layout: dartsSize is the first 4 bytes of probe; probe[4..7]
-  // belong to the darts array, so rewind 4 bytes before reading the array.
-  uint32_t dartsSize32;
-  memcpy(&dartsSize32, probe, 4);
-  size_t dartsSize = dartsSize32;
-  offset -= 4;
-  if (dartsSize > size - offset) {
-    throw InvalidFormat(
-        "Invalid OpenCC dictionary (dartsSize exceeds file size)");
-  }
-  std::unique_ptr<Darts::DoubleArray> doubleArray(new Darts::DoubleArray());
-  if (dartsSize % doubleArray->unit_size() != 0) {
-    throw InvalidFormat("Invalid OpenCC dictionary size of darts alignment");
-  }
-  std::unique_ptr<void, decltype(&free)> buffer(malloc(dartsSize), free);
-  if (!buffer) {
-    throw std::bad_alloc();
+    const char* units = data + offset;
+    if (reinterpret_cast<uintptr_t>(units) % sizeof(uint32_t) != 0) {
+      internal->units.resize(dartsSize / sizeof(uint32_t));
+      memcpy(internal->units.data(), units, dartsSize);
+      units = reinterpret_cast<const char*>(internal->units.data());
+    }
+    doubleArray->set_array(units, dartsSize / doubleArray->unit_size());
+    internal->doubleArray = std::move(doubleArray);
   }
-  memcpy(buffer.get(), data + offset, dartsSize);
   offset += dartsSize;
-  doubleArray->set_array(buffer.get(), dartsSize / doubleArray->unit_size());
-
-  BinaryDictPtr binary = BinaryDict::NewFromBuffer(data + offset, size - offset);
 
-  internal->buffer = buffer.release();
-  internal->doubleArray = doubleArray.release();
-  internal->binary = std::move(binary);
+  internal->binaryData = data + offset;
+  internal->binarySize = size - offset;
+  const size_t numItems = BinaryDict::VisitEntries(
+      internal->binaryData, internal->binarySize,
+      [this](std::string_view key, std::string_view defaultValue) {
+        internal->defaultValues.push_back(defaultValue);
+        internal->maxLength = (std::max)(internal->maxLength, key.size());
+      });
 
-  dict->lexicon = internal->binary->GetLexicon();
-  dict->maxLength = internal->binary->KeyMaxLength();
-  if (!internal->doubleArray->validate(static_cast<Darts::DoubleArray::value_type>(
-          dict->lexicon->Length()))) {
+  if (internal->legacyArray64 != nullptr) {
+    if (!ValidateLegacy64(internal->legacyArray64,
+                          internal->legacyUnits.size(),
+                          static_cast<int>(numItems))) {
+      throw InvalidFormat("Invalid legacy OCD dictionary darts data");
+    }
+  } else if (!internal->doubleArray->validate(
+                 static_cast<Darts::DoubleArray::value_type>(numItems))) {
     throw InvalidFormat("Invalid OpenCC dictionary darts data");
   }
-  return dict;
 }
 
 DartsDictPtr DartsDict::NewFromDict(const Dict& thatDict) {
   DartsDictPtr dict(new DartsDict());
-  auto internal = dict->internal;
+  auto& internal = dict->internal;
 
   std::unique_ptr<Darts::DoubleArray> doubleArray(new Darts::DoubleArray());
   std::vector<std::string> keys;
@@ -424,16 +380,19 @@ DartsDictPtr DartsDict::NewFromDict(const Dict& thatDict) {
   size_t lexiconCount = lexicon->Length();
   keys.resize(lexiconCount);
   keys_cstr.resize(lexiconCount);
+  internal->defaultValues.resize(lexiconCount);
   for (size_t i = 0; i < lexiconCount; i++) {
     const DictEntry* entry = lexicon->At(i);
     keys[i] = entry->Key();
     keys_cstr[i] = keys[i].c_str();
+    internal->defaultValues[i] = entry->GetDefaultView();
     maxLength = (std::max)(entry->KeyLength(), maxLength);
   }
   doubleArray->build(lexicon->Length(), &keys_cstr[0]);
-  dict->lexicon = lexicon;
-  dict->maxLength = maxLength;
-  internal->doubleArray = doubleArray.release();
+  internal->lexicon = lexicon;
+  internal->lexiconConstructed.store(true, std::memory_order_release);
+  internal->maxLength = maxLength;
+  internal->doubleArray = std::move(doubleArray);
   return dict;
 }
 
@@ -453,6 +412,5 @@ void DartsDict::SerializeToFile(FILE* fp) const {
   fwrite(&dartsSize, sizeof(uint32_t), 1, fp);
   fwrite(dict.array(), sizeof(char), dartsSize, fp);
 
-  internal->binary.reset(new BinaryDict(lexicon));
-  internal->binary->SerializeToFile(fp);
+  BinaryDict(GetLexicon()).SerializeToFile(fp);
 }
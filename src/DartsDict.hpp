@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <functional>
+#include <string_view>
+
 #include "Common.hpp"
 #include "SerializableDict.hpp"
 
@@ -42,9 +45,30 @@ public:
 
   virtual bool SupportsFastPrefixMatch() const override { return true; }
 
+  /**
+   * Walks the double array once to the longest key that prefixes @p word
+   * and returns views of it and its default value, without touching the
+   * lexicon or allocating.
+   */
   virtual PrefixMatchView MatchPrefixValue(const char* word,
                                            size_t len) const override;
 
+  /**
+   * Enumerates keys from the serialized entries without triggering lexicon
+   * construction. Like MarisaDict::EnumerateKeys() it is not part of the
+   * Dict interface; returns false when no keys are available.
+   */
+  bool EnumerateKeys(const std::function<void(const char*, size_t)>& cb) const;
+
+  /**
+   * Like EnumerateKeys(), but also passes the default value of each key (the
+   * key for an entry without values). Both views are valid only during the
+   * callback, which returns false to stop the walk.
+   */
+  bool EnumerateEntries(const std::function<bool(std::string_view key,
+                                                 std::string_view value)>& cb)
+      const;
+
   virtual void SerializeToFile(FILE* fp) const override;
 
   /**
@@ -52,16 +76,35 @@ public:
    */
   static DartsDictPtr NewFromDict(const Dict& thatDict);
 
+  /**
+   * Loads the dictionary from @p fp. Where the platform allows, the file is
+   * memory-mapped instead of read: the double array is used in place and
+   * values are read from the mapping, so loading constructs no entries.
+   * The lexicon is built on first use of an interface that returns entries.
+   */
   static DartsDictPtr NewFromFile(FILE* fp);
+
+  /**
+   * Loads the dictionary from a private copy of @p data.
+   */
   static DartsDictPtr NewFromBuffer(const char* data, size_t size);
 
+  /**
+   * Loads the dictionary from @p data without copying it. @p owner keeps
+   * the buffer alive for the lifetime of the dictionary.
+   */
+  static DartsDictPtr NewFromSharedBuffer(const char* data, size_t size,
+                                          std::shared_ptr<const void> owner);
+
+  // Exposed for testing only.
+  bool IsLexiconConstructed() const;
+
 private:
   DartsDict();
 
-  size_t maxLength;
-  LexiconPtr lexicon;
+  void LoadFromBuffer(const char* data, size_t size);
 
   class DartsInternal;
-  DartsInternal* internal;
+  std::unique_ptr<DartsInternal> internal;
 };
 } // namespace opencc
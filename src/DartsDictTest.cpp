@@ -18,6 +18,8 @@
 
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "DartsDict.hpp"
@@ -181,6 +183,69 @@ TEST_F(DartsDictTest, ExactMatch) {
   EXPECT_TRUE(nowhere.IsNull());
 }
 
+TEST_F(DartsDictTest, LoadedDictMatchesWithoutConstructingLexicon) {
+  dartsDict->opencc::SerializableDict::SerializeToFile(fileName);
+  const DartsDictPtr loaded = SerializableDict::NewFromFile<DartsDict>(fileName);
+  size_t numKeys = 0;
+  EXPECT_TRUE(loaded->EnumerateKeys([&numKeys](const char*, size_t) {
+    numKeys++;
+  }));
+  EXPECT_EQ(textDict->GetLexicon()->Length(), numKeys);
+
+  for (const std::string& word :
+       {utf8("太后的美好時光"), utf8("清華大學"), utf8("積羽沉舟"),
+        std::string("BYVoid"), utf8("已"), std::string("xyz")}) {
+    const PrefixMatchView view = loaded->MatchPrefixValue(word.c_str(),
+                                                          word.length());
+    const Optional<const DictEntry*> expected =
+        textDict->MatchPrefix(word.c_str(), word.length());
+    ASSERT_EQ(!expected.IsNull(), view.matched) << word;
+    if (view.matched) {
+      EXPECT_EQ(expected.Get()->Key(), std::string(view.key)) << word;
+      EXPECT_EQ(expected.Get()->GetDefault(), std::string(view.value)) << word;
+      EXPECT_EQ(word.c_str(), view.key.data());
+    }
+  }
+  EXPECT_FALSE(loaded->IsLexiconConstructed());
+
+  TestDict(loaded);
+  EXPECT_TRUE(loaded->IsLexiconConstructed());
+}
+
+TEST_F(DartsDictTest, LoadsFromMisalignedBuffer) {
+  dartsDict->opencc::SerializableDict::SerializeToFile(fileName);
+  FILE* fp = fopen(fileName.c_str(), "rb");
+  ASSERT_NE(nullptr, fp);
+  fseek(fp, 0, SEEK_END);
+  std::string buffer(static_cast<size_t>(ftell(fp)) + 1, '\0');
+  rewind(fp);
+  ASSERT_EQ(buffer.size() - 1, fread(&buffer[1], 1, buffer.size() - 1, fp));
+  fclose(fp);
+  const std::shared_ptr<std::string> owner(new std::string(buffer));
+  const DartsDictPtr loaded = DartsDict::NewFromSharedBuffer(
+      owner->data() + 1, owner->size() - 1, owner);
+  TestDict(loaded);
+}
+
+TEST_F(DartsDictTest, MatchPrefixValueBeyond64Matches) {
+  const size_t kEntries = 65;
+  LexiconPtr lex(new Lexicon);
+  for (size_t i = 1; i <= kEntries; ++i) {
+    lex->Add(DictEntryFactory::New(std::string(i, 'a'), "v" + std::to_string(i)));
+  }
+  lex->Sort();
+  const DartsDictPtr deepDict = DartsDict::NewFromDict(TextDict(lex));
+  const std::string word(kEntries + 1, 'a');
+  const PrefixMatchView view = deepDict->MatchPrefixValue(word.c_str(),
+                                                          word.length());
+  ASSERT_TRUE(view.matched);
+  EXPECT_EQ(kEntries, view.keyLength);
+  EXPECT_EQ("v65", std::string(view.value));
+  const PrefixMatchView shorter = deepDict->MatchPrefixValue(word.c_str(), 3);
+  ASSERT_TRUE(shorter.matched);
+  EXPECT_EQ("v3", std::string(shorter.value));
+}
+
 // dartsSize exceeding remaining file size must throw (#816).
 TEST_F(DartsDictTest, RejectsHugeDartsSize) {
   std::string path = WriteMalformedDartsFile(0x13000000U);
@@ -270,6 +335,10 @@ TEST_F(DartsDictTest, Legacy64PrefixSearchBeyond64Matches) {
   auto result = loaded->MatchPrefix(std::string(kEntries, 'a').c_str(), kEntries);
   ASSERT_FALSE(result.IsNull());
   EXPECT_EQ("v65", result.Get()->GetDefault());
+  const PrefixMatchView view =
+      loaded->MatchPrefixValue(std::string(kEntries, 'a').c_str(), kEntries);
+  ASSERT_TRUE(view.matched);
+  EXPECT_EQ("v65", std::string(view.value));
 
   std::remove(path.c_str());
 }
@@ -145,7 +145,7 @@ DictPtr LoadDictionary(const std::string& format,
     return dict;
   } else if (format == "ocd") {
     return SerializableDict::NewFromFile<DartsDict>(inputFileName);
-  } else if (format == "ocd2") {
+  } else if (format == "ocd2" || format == "ocd3") {
     return SerializableDict::NewFromFile<MarisaDict>(inputFileName);
   }
   fprintf(stderr, "Unknown dictionary format: %s\n", format.c_str());
@@ -160,6 +160,8 @@ SerializableDictPtr ConvertDict(const std::string& format, const DictPtr dict) {
     return DartsDict::NewFromDict(*dict.get());
   } else if (format == "ocd2") {
     return MarisaDict::NewFromDict(*dict.get());
+  } else if (format == "ocd3") {
+    return MarisaDict::NewFromDict(*dict.get(), MarisaDict::Format::Ocd3);
   }
   fprintf(stderr, "Unknown dictionary format: %s\n", format.c_str());
   exit(2);
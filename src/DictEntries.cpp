@@ -0,0 +1,81 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DictEntries.hpp"
+#include "DartsDict.hpp"
+#include "Dict.hpp"
+#include "FlatLexicon.hpp"
+#include "Lexicon.hpp"
+#include "MarisaDict.hpp"
+#include "TextDict.hpp"
+
+namespace opencc {
+namespace internal {
+
+namespace {
+
+enum class StoredEntries { kNotStored, kEnumerated, kUnavailable };
+
+// Walks the entries of a dict from its storage (the trie and values of a
+// MarisaDict, the entries of a DartsDict, or the flat storage of a TextDict
+// loaded from text). Returns kNotStored for other dicts.
+StoredEntries EnumerateStoredEntries(const Dict& dict,
+                                     const DictEntryCallback& cb) {
+  const MarisaDict* marisaDict = dynamic_cast<const MarisaDict*>(&dict);
+  if (marisaDict != nullptr) {
+    return marisaDict->EnumerateEntries(cb) ? StoredEntries::kEnumerated
+                                            : StoredEntries::kUnavailable;
+  }
+  const DartsDict* dartsDict = dynamic_cast<const DartsDict*>(&dict);
+  if (dartsDict != nullptr) {
+    return dartsDict->EnumerateEntries(cb) ? StoredEntries::kEnumerated
+                                           : StoredEntries::kUnavailable;
+  }
+  const TextDict* textDict = dynamic_cast<const TextDict*>(&dict);
+  if (textDict != nullptr && textDict->GetFlatLexicon() != nullptr) {
+    for (const FlatLexicon::EntryView entry : *textDict->GetFlatLexicon()) {
+      if (!cb(entry.KeyView(), entry.GetDefaultView())) {
+        break;
+      }
+    }
+    return StoredEntries::kEnumerated;
+  }
+  return StoredEntries::kNotStored;
+}
+
+} // namespace
+
+bool EnumerateDictEntries(const Dict& dict, const DictEntryCallback& cb) {
+  const StoredEntries stored = EnumerateStoredEntries(dict, cb);
+  if (stored != StoredEntries::kNotStored) {
+    return stored == StoredEntries::kEnumerated;
+  }
+  const LexiconPtr lexicon = dict.GetLexicon();
+  if (lexicon == nullptr) {
+    return false;
+  }
+  for (const std::unique_ptr<DictEntry>& entry : *lexicon) {
+    if (!cb(entry->KeyView(), entry->GetDefaultView())) {
+      break;
+    }
+  }
+  return true;
+}
+
+} // namespace internal
+} // namespace opencc
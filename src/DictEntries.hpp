@@ -0,0 +1,47 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string_view>
+
+#include "Common.hpp"
+
+namespace opencc {
+namespace internal {
+
+/**
+ * Receives the key and default value of a dictionary entry. Returns false to
+ * stop the walk.
+ */
+typedef std::function<bool(std::string_view key, std::string_view value)>
+    DictEntryCallback;
+
+/**
+ * Calls @p cb with the key and default value of every entry of the leaf
+ * dictionary @p dict until it returns false. Entries are read straight from
+ * the storage of a MarisaDict, a DartsDict or a TextDict loaded from text,
+ * so that walking them does not construct the dictionary's lexicon; other
+ * dictionaries are walked through GetLexicon(). Returns false if the entries
+ * are unavailable. Private (non-installed) header.
+ */
+bool EnumerateDictEntries(const Dict& dict, const DictEntryCallback& cb);
+
+} // namespace internal
+} // namespace opencc
@@ -0,0 +1,259 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "FlatLexicon.hpp"
+#include "Lexicon.hpp"
+#include "ParallelPieces.hpp"
+#include "TextDictParser.hpp"
+
+using namespace opencc;
+
+namespace {
+
+// Offsets into the arena are 32-bit.
+constexpr size_t kMaxArenaSize = UINT32_MAX;
+
+// DictEntry interface over one entry of a FlatLexicon.
+class FlatDictEntry : public DictEntry {
+public:
+  FlatDictEntry(const FlatLexicon* lexicon, size_t index)
+      : lexicon(lexicon), index(index) {}
+
+  std::string_view KeyView() const override { return View().KeyView(); }
+
+  std::string_view GetDefaultView() const override {
+    return View().GetDefaultView();
+  }
+
+  std::vector<std::string> Values() const override {
+    const FlatLexicon::EntryView entry = View();
+    std::vector<std::string> values;
+    values.reserve(entry.NumValues());
+    for (size_t i = 0; i < entry.NumValues(); i++) {
+      values.emplace_back(entry.ValueView(i));
+    }
+    return values;
+  }
+
+  size_t NumValues() const override { return View().NumValues(); }
+
+  std::string ToString() const override { return View().ToString(); }
+
+private:
+  FlatLexicon::EntryView View() const { return lexicon->At(index); }
+
+  const FlatLexicon* lexicon;
+  size_t index;
+};
+
+} // namespace
+
+class FlatLexicon::DictEntryViews {
+public:
+  std::vector<FlatDictEntry> entries;
+};
+
+std::string FlatLexicon::EntryView::ToString() const {
+  std::string str(KeyView());
+  for (size_t i = 0; i < NumValues(); i++) {
+    str += i == 0 ? '\t' : ' ';
+    str.append(ValueView(i));
+  }
+  return str;
+}
+
+FlatLexicon::FlatLexicon() : maxKeyLength(0), dictEntries(nullptr) {}
+
+FlatLexicon::~FlatLexicon() {}
+
+uint32_t FlatLexicon::Append(std::string_view str) {
+  if (str.size() > kMaxArenaSize - arena.size()) {
+    throw InvalidFormat("Lexicon exceeds the 4 GiB limit of FlatLexicon");
+  }
+  const uint32_t offset = static_cast<uint32_t>(arena.size());
+  arena.append(str.data(), str.size());
+  return offset;
+}
+
+void FlatLexicon::Add(std::string_view key, const std::string_view* entryValues,
+                      size_t numValues) {
+  ResetDictEntries();
+  const Entry entry{Append(key), static_cast<uint32_t>(key.size()),
+                    static_cast<uint32_t>(values.size()),
+                    static_cast<uint32_t>(numValues)};
+  for (size_t i = 0; i < numValues; i++) {
+    const uint32_t offset = Append(entryValues[i]);
+    values.push_back(
+        Span{offset, static_cast<uint32_t>(entryValues[i].size())});
+  }
+  entries.push_back(entry);
+  maxKeyLength = (std::max)(maxKeyLength, key.size());
+}
+
+void FlatLexicon::Add(const DictEntry& entry) {
+  const std::vector<std::string> entryValues = entry.Values();
+  const std::vector<std::string_view> views(entryValues.begin(),
+                                            entryValues.end());
+  Add(entry.KeyView(), views.data(), views.size());
+}
+
+void FlatLexicon::Sort() {
+  ResetDictEntries();
+  std::sort(entries.begin(), entries.end(),
+            [this](const Entry& a, const Entry& b) {
+              return View(a.keyOffset, a.keyLength) <
+                     View(b.keyOffset, b.keyLength);
+            });
+}
+
+bool FlatLexicon::IsSorted() const {
+  for (size_t i = 1; i < entries.size(); ++i) {
+    if (At(i).KeyView() < At(i - 1).KeyView()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool FlatLexicon::IsUnique(std::string* dupkey) const {
+  for (size_t i = 1; i < entries.size(); ++i) {
+    if (At(i - 1).KeyView() == At(i).KeyView()) {
+      if (dupkey) {
+        *dupkey = std::string(At(i).KeyView());
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t FlatLexicon::Find(std::string_view key) const {
+  const auto found = std::lower_bound(
+      entries.begin(), entries.end(), key,
+      [this](const Entry& entry, std::string_view key) {
+        return View(entry.keyOffset, entry.keyLength) < key;
+      });
+  if (found != entries.end() &&
+      View(found->keyOffset, found->keyLength) == key) {
+    return static_cast<size_t>(found - entries.begin());
+  }
+  return entries.size();
+}
+
+const DictEntry* FlatLexicon::GetDictEntry(size_t index) const {
+  const DictEntryViews* views = dictEntries.load(std::memory_order_acquire);
+  if (views == nullptr) {
+    std::lock_guard<std::mutex> lock(dictEntriesMutex);
+    views = dictEntries.load(std::memory_order_relaxed);
+    if (views == nullptr) {
+      std::unique_ptr<DictEntryViews> created(new DictEntryViews);
+      created->entries.reserve(entries.size());
+      for (size_t i = 0; i < entries.size(); i++) {
+        created->entries.emplace_back(this, i);
+      }
+      views = created.get();
+      dictEntriesOwner = std::move(created);
+      dictEntries.store(views, std::memory_order_release);
+    }
+  }
+  return &views->entries.at(index);
+}
+
+void FlatLexicon::ResetDictEntries() {
+  dictEntries.store(nullptr, std::memory_order_relaxed);
+  dictEntriesOwner.reset();
+}
+
+LexiconPtr FlatLexicon::ToLexicon() const {
+  std::vector<std::unique_ptr<DictEntry>> copies;
+  copies.reserve(entries.size());
+  std::vector<std::string> entryValues;
+  for (const EntryView entry : *this) {
+    entryValues.clear();
+    for (size_t i = 0; i < entry.NumValues(); i++) {
+      entryValues.emplace_back(entry.ValueView(i));
+    }
+    copies.emplace_back(
+        DictEntryFactory::New(std::string(entry.KeyView()), entryValues));
+  }
+  return LexiconPtr(new Lexicon(std::move(copies)));
+}
+
+FlatLexiconPtr FlatLexicon::NewFromLexicon(const Lexicon& lexicon) {
+  FlatLexiconPtr flat(new FlatLexicon);
+  flat->entries.reserve(lexicon.Length());
+  for (const auto& entry : lexicon) {
+    flat->Add(*entry);
+  }
+  return flat;
+}
+
+FlatLexiconPtr FlatLexicon::ParseSortedFromBuffer(const char* data,
+                                                  size_t size,
+                                                  char keyValueDelimiter,
+                                                  size_t threads) {
+  return ParseSorted(std::string(data, size), keyValueDelimiter, threads);
+}
+
+FlatLexiconPtr FlatLexicon::ParseSortedFromFile(FILE* fp,
+                                                char keyValueDelimiter,
+                                                size_t threads) {
+  return ParseSorted(internal::ReadToEnd(fp), keyValueDelimiter, threads);
+}
+
+FlatLexiconPtr FlatLexicon::ParseSorted(std::string text,
+                                        char keyValueDelimiter,
+                                        size_t threads) {
+  if (text.size() > kMaxArenaSize) {
+    throw InvalidFormat("Lexicon exceeds the 4 GiB limit of FlatLexicon");
+  }
+  const internal::ParsedTextDictionary parsed = internal::ParseTextDictionary(
+      text.data(), text.size(), keyValueDelimiter,
+      internal::ResolveThreadCount(threads), true);
+
+  // Keys and values are already in the text, which becomes the arena; only
+  // their offsets are recorded, in sorted order.
+  FlatLexiconPtr lexicon(new FlatLexicon);
+  size_t numValues = 0;
+  for (const internal::ParsedTextEntry& parsedEntry : parsed.entries) {
+    numValues += parsedEntry.numValues;
+  }
+  lexicon->entries.reserve(parsed.entries.size());
+  lexicon->values.reserve(numValues);
+  const char* base = text.data();
+  for (const internal::ParsedTextEntry& parsedEntry : parsed.entries) {
+    lexicon->entries.push_back(
+        Entry{static_cast<uint32_t>(parsedEntry.keyData - base),
+              parsedEntry.keyLength,
+              static_cast<uint32_t>(lexicon->values.size()),
+              parsedEntry.numValues});
+    const std::string_view* entryValues = parsed.Values(parsedEntry);
+    for (size_t i = 0; i < parsedEntry.numValues; i++) {
+      lexicon->values.push_back(
+          Span{static_cast<uint32_t>(entryValues[i].data() - base),
+               static_cast<uint32_t>(entryValues[i].size())});
+    }
+    lexicon->maxKeyLength =
+        (std::max<size_t>)(lexicon->maxKeyLength, parsedEntry.keyLength);
+  }
+  // Offsets are relative, so they stay valid however the string moves.
+  lexicon->arena = std::move(text);
+  return lexicon;
+}
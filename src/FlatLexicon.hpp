@@ -0,0 +1,214 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+
+#include "Common.hpp"
+#include "DictEntry.hpp"
+
+namespace opencc {
+/**
+ * Compact storage of dictionary entries: every key and value lives in one
+ * string arena, and each entry is a plain record of offsets into it.
+ * Loading a lexicon this way costs a few allocations in total instead of
+ * several per entry, and walking it touches contiguous memory. Entries are
+ * read through the non-virtual EntryView; GetDictEntry() offers the
+ * DictEntry interface as views into the same storage.
+ * @ingroup opencc_cpp_api
+ */
+class OPENCC_EXPORT FlatLexicon {
+public:
+  /** An entry: its key and a range of Span records for its values. */
+  struct Entry {
+    uint32_t keyOffset;
+    uint32_t keyLength;
+    uint32_t firstValue;
+    uint32_t numValues;
+  };
+
+  /** A value as a range of the arena. */
+  struct Span {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  /** Non-owning view of one entry, valid while the lexicon is unchanged. */
+  class EntryView {
+  public:
+    EntryView(const FlatLexicon* lexicon, const Entry* entry)
+        : lexicon(lexicon), entry(entry) {}
+
+    std::string_view KeyView() const {
+      return lexicon->View(entry->keyOffset, entry->keyLength);
+    }
+
+    size_t NumValues() const { return entry->numValues; }
+
+    std::string_view ValueView(size_t i) const {
+      const Span& value = lexicon->values[entry->firstValue + i];
+      return lexicon->View(value.offset, value.length);
+    }
+
+    /** The first value, or the key of an entry without values. */
+    std::string_view GetDefaultView() const {
+      return entry->numValues == 0 ? KeyView() : ValueView(0);
+    }
+
+    /** Same format as DictEntry::ToString(). */
+    std::string ToString() const;
+
+  private:
+    const FlatLexicon* lexicon;
+    const Entry* entry;
+  };
+
+  class const_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef EntryView value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const EntryView* pointer;
+    typedef EntryView reference;
+
+    const_iterator(const FlatLexicon* lexicon, const Entry* entry)
+        : lexicon(lexicon), entry(entry) {}
+
+    EntryView operator*() const { return EntryView(lexicon, entry); }
+
+    const_iterator& operator++() {
+      ++entry;
+      return *this;
+    }
+
+    bool operator==(const const_iterator& that) const {
+      return entry == that.entry;
+    }
+
+    bool operator!=(const const_iterator& that) const {
+      return entry != that.entry;
+    }
+
+  private:
+    const FlatLexicon* lexicon;
+    const Entry* entry;
+  };
+
+  FlatLexicon();
+  ~FlatLexicon();
+  FlatLexicon(const FlatLexicon&) = delete;
+  FlatLexicon& operator=(const FlatLexicon&) = delete;
+
+  /**
+   * Appends an entry, copying @p key and @p values into the arena.
+   * @throws InvalidFormat if the arena would exceed 4 GiB.
+   */
+  void Add(std::string_view key, const std::string_view* values,
+           size_t numValues);
+
+  void Add(const DictEntry& entry);
+
+  void Sort();
+
+  // Returns true if the lexicon is sorted by key.
+  bool IsSorted() const;
+
+  // Returns true if every key unique (after sorted).
+  // When dupkey is set, it is set to the duplicate key.
+  bool IsUnique(std::string* dupkey = nullptr) const;
+
+  /**
+   * Returns the index of the entry with key @p key, or Length() if there is
+   * none. The lexicon must be sorted.
+   */
+  size_t Find(std::string_view key) const;
+
+  EntryView At(size_t index) const {
+    return EntryView(this, &entries.at(index));
+  }
+
+  size_t Length() const { return entries.size(); }
+
+  /** Returns the length in bytes of the longest key. */
+  size_t KeyMaxLength() const { return maxKeyLength; }
+
+  const_iterator begin() const {
+    return const_iterator(this, entries.data());
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, entries.data() + entries.size());
+  }
+
+  /**
+   * Returns entry @p index as a DictEntry. The DictEntry objects of all
+   * entries are created together on the first call, in one array, and refer
+   * to the arena instead of copying it. They stay valid until the lexicon is
+   * modified or destroyed.
+   */
+  const DictEntry* GetDictEntry(size_t index) const;
+
+  /** Copies the entries into a Lexicon of owned DictEntry objects. */
+  LexiconPtr ToLexicon() const;
+
+  static FlatLexiconPtr NewFromLexicon(const Lexicon& lexicon);
+
+  /**
+   * Parses a text dictionary like Lexicon::ParseSortedLexiconFromBuffer(),
+   * storing entries in place: a copy of @p data becomes the arena.
+   */
+  static FlatLexiconPtr ParseSortedFromBuffer(const char* data, size_t size,
+                                              char keyValueDelimiter = '\t',
+                                              size_t threads = 0);
+
+  /**
+   * Reads @p fp from its current position to the end and parses it like
+   * ParseSortedFromBuffer(), using the contents read as the arena.
+   */
+  static FlatLexiconPtr ParseSortedFromFile(FILE* fp,
+                                            char keyValueDelimiter = '\t',
+                                            size_t threads = 0);
+
+private:
+  class DictEntryViews;
+
+  static FlatLexiconPtr ParseSorted(std::string text, char keyValueDelimiter,
+                                    size_t threads);
+
+  std::string_view View(uint32_t offset, uint32_t length) const {
+    return std::string_view(arena.data() + offset, length);
+  }
+
+  uint32_t Append(std::string_view str);
+  void ResetDictEntries();
+
+  std::string arena;
+  std::vector<Entry> entries;
+  std::vector<Span> values;
+  size_t maxKeyLength;
+
+  mutable std::mutex dictEntriesMutex;
+  mutable std::atomic<const DictEntryViews*> dictEntries;
+  mutable std::unique_ptr<const DictEntryViews> dictEntriesOwner;
+};
+} // namespace opencc
@@ -0,0 +1,114 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FlatLexicon.hpp"
+#include "Lexicon.hpp"
+#include "TestUtils.hpp"
+#include "TestUtilsUTF8.hpp"
+
+namespace opencc {
+
+class FlatLexiconTest : public ::testing::Test {
+protected:
+  FlatLexiconTest()
+      : text("# comment\n" + utf8("清華") + "\tTsinghua\n" + utf8("清") +
+             "\tTsing Qing\n" + "BYVoid\tbyv\n"){};
+
+  const std::string text;
+};
+
+TEST_F(FlatLexiconTest, ParseSortedFromBuffer) {
+  const FlatLexiconPtr lexicon =
+      FlatLexicon::ParseSortedFromBuffer(text.data(), text.size());
+  ASSERT_EQ(3, lexicon->Length());
+  EXPECT_TRUE(lexicon->IsSorted());
+  EXPECT_TRUE(lexicon->IsUnique());
+  EXPECT_EQ(utf8("清華").size(), lexicon->KeyMaxLength());
+
+  const FlatLexicon::EntryView first = lexicon->At(0);
+  EXPECT_EQ("BYVoid", first.KeyView());
+  EXPECT_EQ("byv", first.GetDefaultView());
+
+  const FlatLexicon::EntryView second = lexicon->At(1);
+  EXPECT_EQ(utf8("清"), second.KeyView());
+  ASSERT_EQ(2, second.NumValues());
+  EXPECT_EQ("Tsing", second.ValueView(0));
+  EXPECT_EQ("Qing", second.ValueView(1));
+  EXPECT_EQ(utf8("清") + "\tTsing Qing", second.ToString());
+
+  size_t count = 0;
+  for (const FlatLexicon::EntryView entry : *lexicon) {
+    EXPECT_EQ(lexicon->At(count).KeyView(), entry.KeyView());
+    count++;
+  }
+  EXPECT_EQ(3, count);
+}
+
+TEST_F(FlatLexiconTest, Find) {
+  const FlatLexiconPtr lexicon =
+      FlatLexicon::ParseSortedFromBuffer(text.data(), text.size());
+  EXPECT_EQ(2, lexicon->Find(utf8("清華")));
+  EXPECT_EQ(0, lexicon->Find("BYVoid"));
+  EXPECT_EQ(lexicon->Length(), lexicon->Find("BYV"));
+  EXPECT_EQ(lexicon->Length(), lexicon->Find(utf8("清華大學")));
+}
+
+TEST_F(FlatLexiconTest, DictEntriesAreViews) {
+  const FlatLexiconPtr lexicon =
+      FlatLexicon::ParseSortedFromBuffer(text.data(), text.size());
+  const DictEntry* entry = lexicon->GetDictEntry(1);
+  EXPECT_EQ(entry, lexicon->GetDictEntry(1));
+  EXPECT_EQ(utf8("清"), entry->Key());
+  EXPECT_EQ("Tsing", entry->GetDefault());
+  EXPECT_EQ((std::vector<std::string>{"Tsing", "Qing"}), entry->Values());
+  EXPECT_EQ(lexicon->At(1).KeyView().data(), entry->KeyView().data());
+  EXPECT_EQ(utf8("清") + "\tTsing Qing", entry->ToString());
+}
+
+TEST_F(FlatLexiconTest, RoundTripThroughLexicon) {
+  LexiconPtr lexicon(new Lexicon);
+  lexicon->Add(DictEntryFactory::New("b", "B"));
+  lexicon->Add(DictEntryFactory::New("a"));
+  lexicon->Add(
+      DictEntryFactory::New("c", std::vector<std::string>{"C1", "C2", "C3"}));
+  const FlatLexiconPtr flat = FlatLexicon::NewFromLexicon(*lexicon);
+  EXPECT_FALSE(flat->IsSorted());
+  flat->Sort();
+  ASSERT_TRUE(flat->IsSorted());
+  EXPECT_EQ("a", flat->At(0).GetDefaultView());
+  EXPECT_EQ(0, flat->At(0).NumValues());
+
+  lexicon->Sort();
+  const LexiconPtr copy = flat->ToLexicon();
+  ASSERT_EQ(lexicon->Length(), copy->Length());
+  for (size_t i = 0; i < copy->Length(); i++) {
+    EXPECT_EQ(lexicon->At(i)->ToString(), copy->At(i)->ToString());
+    EXPECT_EQ(lexicon->At(i)->ToString(), flat->GetDictEntry(i)->ToString());
+  }
+}
+
+TEST_F(FlatLexiconTest, DetectsDuplicates) {
+  const std::string duplicated = "a\tA\nb\tB\na\tC\n";
+  const FlatLexiconPtr lexicon =
+      FlatLexicon::ParseSortedFromBuffer(duplicated.data(), duplicated.size());
+  std::string dupkey;
+  EXPECT_FALSE(lexicon->IsUnique(&dupkey));
+  EXPECT_EQ("a", dupkey);
+}
+
+} // namespace opencc
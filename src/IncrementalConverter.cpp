@@ -0,0 +1,322 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ConfigBasedConverter.hpp"
+#include "Conversion.hpp"
+#include "ConversionChain.hpp"
+#include "Dict.hpp"
+#include "IncrementalConverter.hpp"
+#include "MaxMatchSegmentation.hpp"
+#include "PrefixMatch.hpp"
+#include "Segments.hpp"
+#include "SingleStageConverter.hpp"
+#include "UTF8Util.hpp"
+
+using namespace opencc;
+
+namespace {
+
+// Maximum-match segmentation groups an ideographic description sequence of
+// up to 64 code points (see UTF8Util) into one segment, so it may look that
+// far ahead even past the longest dictionary key.
+constexpr size_t kMaxIDSBytes = 64 * 4;
+
+// Bytes after an edit reconverted at first while looking for the point where
+// the new conversion lines up with the old one. Doubled until it is found.
+constexpr size_t kInitialLookahead = 256;
+
+// An unmatched step of a stage split at its matching steps ends a piece when
+// its last byte is a line feed or has these bits clear, which keeps pieces of
+// unmatched text at about 16 characters.
+constexpr unsigned char kStepCutMask = 0x0F;
+
+} // namespace
+
+class IncrementalConverter::IncrementalInternal {
+public:
+  explicit IncrementalInternal(const ConverterPtr& converter_)
+      : lookbehind(0), inputBounds(1, 0), outputBounds(1, 0) {
+    const auto* configBased =
+        dynamic_cast<const ConfigBasedConverter*>(converter_.get());
+    if (configBased != nullptr) {
+      // The normalization pre-pass is a stage of its own: its patches are
+      // the edits to the text the main converter sees.
+      normalization.reset(
+          new IncrementalInternal(configBased->GetNormalizationConverter()));
+      converter = configBased->GetMainConverter();
+    } else {
+      converter = converter_;
+    }
+    const auto* singleStage =
+        dynamic_cast<const SingleStageConverter*>(converter.get());
+    if (singleStage == nullptr) {
+      return;
+    }
+    const SegmentationPtr stageSegmentation = singleStage->GetSegmentation();
+    const ConversionChainPtr stageChain = singleStage->GetConversionChain();
+    const auto maxMatch =
+        std::dynamic_pointer_cast<MaxMatchSegmentation>(stageSegmentation);
+    if (maxMatch != nullptr) {
+      segmentation = maxMatch;
+      chain = stageChain;
+      lookbehind = std::max(maxMatch->GetDict()->KeyMaxLength(), kMaxIDSBytes);
+    } else if (stageSegmentation == nullptr &&
+               stageChain->GetConversions().size() == 1) {
+      // The whole text is one segment, converted by forward maximum matching
+      // over a single dictionary, so it can be split between any two steps
+      // of that matching (as for a normalization pre-pass).
+      const ConversionPtr conversion = stageChain->GetConversions().front();
+      stepMatch = conversion->GetPrefixMatch();
+      chain = stageChain;
+      lookbehind =
+          std::max(conversion->GetDict()->KeyMaxLength(), kMaxIDSBytes);
+    }
+  }
+
+  void SetText(std::string_view newText) {
+    if (normalization != nullptr) {
+      normalization->SetText(newText);
+      Reset(normalization->output);
+    } else {
+      Reset(newText);
+    }
+  }
+
+  ConversionPatch Edit(size_t offset, size_t length,
+                       std::string_view replacement) {
+    if (normalization != nullptr) {
+      const ConversionPatch normalized =
+          normalization->Edit(offset, length, replacement);
+      return Reconvert(normalized.offset, normalized.length, normalized.text);
+    }
+    return Reconvert(offset, length, replacement);
+  }
+
+  // Returns the text before normalization.
+  const std::string& GetText() const {
+    return normalization != nullptr ? normalization->GetText() : text;
+  }
+
+  std::string output;
+
+private:
+  void Reset(std::string_view newText) {
+    text = newText;
+    output.clear();
+    inputBounds.assign(1, 0);
+    outputBounds.assign(1, 0);
+    std::vector<size_t> cuts;
+    Split(0, text.size(), &cuts);
+    AppendPieces(0, cuts, &output, &outputBounds);
+    inputBounds.insert(inputBounds.end(), cuts.begin(), cuts.end());
+  }
+
+  ConversionPatch Reconvert(size_t offset, size_t length,
+                            std::string_view replacement) {
+    if (offset > text.size() || length > text.size() - offset) {
+      throw std::out_of_range("Edit range is outside the text");
+    }
+    const size_t oldEditEnd = offset + length;
+    const size_t editEnd = offset + replacement.size();
+    text.replace(offset, length, replacement.data(), replacement.size());
+
+    // Pieces ending at least lookbehind bytes before the edit were decided
+    // without looking at it. Reconversion starts at the last such boundary.
+    const size_t unaffected = offset > lookbehind ? offset - lookbehind : 0;
+    const size_t first =
+        std::upper_bound(inputBounds.begin(), inputBounds.end(), unaffected) -
+        inputBounds.begin() - 1;
+    const size_t begin = inputBounds[first];
+
+    // Find the first boundary at or after the edit that the old conversion
+    // had too; from there on both split and convert the same text the same
+    // way. Unless the window reaches the end of the text, its boundaries are
+    // only trusted up to lookbehind bytes before its end, where the window
+    // cannot have cut a match short.
+    std::vector<size_t> cuts;
+    size_t last = inputBounds.size() - 1;
+    for (size_t lookahead = std::max(kInitialLookahead, lookbehind);;
+         lookahead *= 2) {
+      const size_t windowEnd =
+          text.size() - editEnd > lookahead ? editEnd + lookahead : text.size();
+      cuts.clear();
+      Split(begin, windowEnd, &cuts);
+      bool found = windowEnd == text.size();
+      for (size_t i = 0; i < cuts.size(); i++) {
+        if (cuts[i] < editEnd) {
+          continue;
+        }
+        if (windowEnd != text.size() && cuts[i] + lookbehind >= windowEnd) {
+          break;
+        }
+        const size_t oldCut = cuts[i] - editEnd + oldEditEnd;
+        const auto it = std::lower_bound(inputBounds.begin() + first,
+                                         inputBounds.end(), oldCut);
+        if (it != inputBounds.end() && *it == oldCut) {
+          last = it - inputBounds.begin();
+          cuts.resize(i + 1);
+          found = true;
+          break;
+        }
+      }
+      if (found) {
+        break;
+      }
+    }
+
+    ConversionPatch patch;
+    patch.offset = outputBounds[first];
+    patch.length = outputBounds[last] - patch.offset;
+    std::vector<size_t> cutOutputs(1, patch.offset);
+    AppendPieces(begin, cuts, &patch.text, &cutOutputs);
+    output.replace(patch.offset, patch.length, patch.text);
+
+    const size_t outputEnd = outputBounds[last];
+    for (size_t i = last + 1; i < inputBounds.size(); i++) {
+      inputBounds[i] = inputBounds[i] - oldEditEnd + editEnd;
+      outputBounds[i] = outputBounds[i] - outputEnd + patch.offset +
+                        patch.text.size();
+    }
+    inputBounds.erase(inputBounds.begin() + first + 1,
+                      inputBounds.begin() + last + 1);
+    inputBounds.insert(inputBounds.begin() + first + 1, cuts.begin(),
+                       cuts.end());
+    outputBounds.erase(outputBounds.begin() + first + 1,
+                       outputBounds.begin() + last + 1);
+    outputBounds.insert(outputBounds.begin() + first + 1,
+                        cutOutputs.begin() + 1, cutOutputs.end());
+    return patch;
+  }
+
+  // Appends to cuts the end of each piece that text[begin, end) is split
+  // into, as offsets into text.
+  void Split(size_t begin, size_t end, std::vector<size_t>* cuts) {
+    const std::string_view window(text.data() + begin, end - begin);
+    if (segmentation != nullptr) {
+      segmentation->SegmentSpans(window, &spans);
+      for (const SegmentSpan& span : spans) {
+        cuts->push_back(begin + span.offset + span.length);
+      }
+      return;
+    }
+    if (stepMatch != nullptr) {
+      SplitAtSteps(begin, window, cuts);
+      return;
+    }
+    for (size_t position = 0; position < window.size();) {
+      const size_t lineFeed = window.find('\n', position);
+      position = lineFeed == std::string_view::npos ? window.size()
+                                                    : lineFeed + 1;
+      cuts->push_back(begin + position);
+    }
+  }
+
+  // Cuts window, which starts at begin, after every dictionary match of
+  // stepMatch and after some unmatched steps (see kStepCutMask), and at its
+  // end. Whether a step ends a piece depends only on the step, so the cuts
+  // after an edit line up with the old ones again once the steps do.
+  void SplitAtSteps(size_t begin, std::string_view window,
+                    std::vector<size_t>* cuts) const {
+    const char* start = window.data();
+    const char* end = start + window.size();
+    for (const char* pstr = start; pstr < end;) {
+      const size_t remainingLength = end - pstr;
+      const PrefixMatchView matched =
+          stepMatch->MatchPrefixView(pstr, remainingLength);
+      size_t stepLength;
+      if (matched.matched) {
+        stepLength = matched.keyLength;
+      } else {
+        stepLength = UTF8Util::NextIdeographicDescriptionSequenceLength(
+            pstr, remainingLength);
+        if (stepLength == 0) {
+          stepLength = UTF8Util::NextCharLength(pstr);
+        }
+      }
+      stepLength = std::min(stepLength, remainingLength);
+      const unsigned char last =
+          static_cast<unsigned char>(pstr[stepLength - 1]);
+      pstr += stepLength;
+      if (matched.matched || last == '\n' || (last & kStepCutMask) == 0 ||
+          pstr == end) {
+        cuts->push_back(begin + (pstr - start));
+      }
+    }
+  }
+
+  // Converts the pieces from begin to each of cuts in turn, appending the
+  // results to out and the end of each result to outputEnds. outputEnds
+  // must end with the output offset of begin.
+  void AppendPieces(size_t begin, const std::vector<size_t>& cuts,
+                    std::string* out, std::vector<size_t>* outputEnds) const {
+    const size_t base = outputEnds->back() - out->size();
+    for (size_t cut : cuts) {
+      const std::string_view piece(text.data() + begin, cut - begin);
+      if (chain != nullptr) {
+        chain->AppendConvertedSegment(piece, out);
+      } else {
+        converter->AppendConverted(piece, out);
+      }
+      outputEnds->push_back(base + out->size());
+      begin = cut;
+    }
+  }
+
+  // The converter this stage runs when it is not split by segmentation or
+  // stepMatch, which then split after line feeds.
+  ConverterPtr converter;
+  std::unique_ptr<IncrementalInternal> normalization;
+  std::shared_ptr<MaxMatchSegmentation> segmentation;
+  std::shared_ptr<PrefixMatch> stepMatch;
+  ConversionChainPtr chain;
+  std::string text;
+  size_t lookbehind;
+  // Offsets of the split points in text and output, starting with 0 and
+  // ending with the sizes of both.
+  std::vector<size_t> inputBounds;
+  std::vector<size_t> outputBounds;
+  std::vector<SegmentSpan> spans;
+};
+
+IncrementalConverter::IncrementalConverter(ConverterPtr converter)
+    : internal(new IncrementalInternal(converter)) {}
+
+IncrementalConverter::~IncrementalConverter() {}
+
+const std::string& IncrementalConverter::SetText(std::string_view text) {
+  internal->SetText(text);
+  return internal->output;
+}
+
+ConversionPatch IncrementalConverter::Edit(size_t offset, size_t length,
+                                           std::string_view replacement) {
+  return internal->Edit(offset, length, replacement);
+}
+
+const std::string& IncrementalConverter::GetText() const {
+  return internal->GetText();
+}
+
+const std::string& IncrementalConverter::GetOutput() const {
+  return internal->output;
+}
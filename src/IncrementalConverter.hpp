@@ -0,0 +1,101 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "Common.hpp"
+
+namespace opencc {
+/**
+ * A change to a converted text: bytes [offset, offset + length) of the
+ * previous output are replaced by @c text.
+ *
+ * @ingroup opencc_cpp_api
+ */
+struct ConversionPatch {
+  size_t offset = 0;
+  size_t length = 0;
+  std::string text;
+};
+
+/**
+ * Keeps a text and its conversion in sync under edits, for editors and input
+ * methods that would otherwise reconvert a whole document per keystroke.
+ *
+ * The converter remembers where the previous conversion can be split without
+ * changing its result, with the output offset of each such point. An edit
+ * reconverts only from the last split point that the edit cannot influence to
+ * the first split point after it where the new conversion lines up with the
+ * old one again, and returns the difference as a ConversionPatch, so the work
+ * per edit follows the size of the edit rather than the document.
+ *
+ * For a SingleStageConverter with maximum-match segmentation the split points
+ * are segment boundaries: forward maximum matching looks at most
+ * Dict::KeyMaxLength() bytes (or one ideographic description sequence) ahead,
+ * so segments ending that far before an edit are unaffected, and once the new
+ * segmentation reaches a boundary of the old one past the edit, the rest is
+ * identical. A stage without segmentation that converts with a single
+ * dictionary, such as the normalization pre-pass of a config, is split the
+ * same way between the steps of its matching. A config's normalization and
+ * main converter are kept in sync as two such stages, the first one's
+ * patches being the edits of the second. Any other converter is split after
+ * line feeds, which no dictionary match crosses (see
+ * Converter::ConvertParallel()).
+ *
+ * The output always equals the converter's Convert() of the current text. An
+ * IncrementalConverter is not thread-safe; the converter it uses may be
+ * shared.
+ *
+ * @ingroup opencc_cpp_api
+ */
+class OPENCC_EXPORT IncrementalConverter {
+public:
+  explicit IncrementalConverter(ConverterPtr converter);
+
+  ~IncrementalConverter();
+
+  IncrementalConverter(const IncrementalConverter&) = delete;
+  IncrementalConverter& operator=(const IncrementalConverter&) = delete;
+
+  /**
+   * Replaces the whole text, converts it and returns the output.
+   */
+  const std::string& SetText(std::string_view text);
+
+  /**
+   * Replaces bytes [@p offset, @p offset + @p length) of the text with
+   * @p replacement and returns the resulting change to the output.
+   * @throws std::out_of_range if the range is not within the text.
+   */
+  ConversionPatch Edit(size_t offset, size_t length,
+                       std::string_view replacement);
+
+  /** Returns the current text. */
+  const std::string& GetText() const;
+
+  /** Returns the conversion of the current text. */
+  const std::string& GetOutput() const;
+
+private:
+  class IncrementalInternal;
+  std::unique_ptr<IncrementalInternal> internal;
+};
+} // namespace opencc
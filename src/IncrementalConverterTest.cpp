@@ -0,0 +1,222 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <stdexcept>
+
+#include "Config.hpp"
+#include "ConfigBasedConverter.hpp"
+#include "ConfigTestBase.hpp"
+#include "Conversion.hpp"
+#include "ConversionChain.hpp"
+#include "Converter.hpp"
+#include "IncrementalConverter.hpp"
+#include "KeyHitProfile.hpp"
+#include "PipelineConverter.hpp"
+#include "TestUtilsUTF8.hpp"
+
+namespace opencc {
+
+namespace {
+
+// Overlapping keys, so that an edit can change how text on both sides of it
+// is segmented.
+const char* const kOverlappingEntries = R"({
+  "ab": "[ab]", "abc": "[abc]", "bcd": "[bcd]", "ca": "[ca]",
+  "dab": "[dab]", "a": "A", "d": "D", "一二": "壹貳", "二三四": "貳參肆"
+})";
+
+} // namespace
+
+class IncrementalConverterTest : public ConfigTestBase {
+protected:
+  ConverterPtr NewConverter(const std::string& config) {
+    return Config().NewFromString(config, CONFIG_TEST_DIR_PATH);
+  }
+
+  // Converter whose segmentation and conversion use the same overlapping
+  // dictionary, optionally behind a normalization pre-pass.
+  ConverterPtr OverlappingConverter(bool normalize) {
+    const std::string dict =
+        std::string(R"({"type": "inline", "entries": )") +
+        kOverlappingEntries + "}";
+    std::string config = R"({"name": "Overlapping",)";
+    if (normalize) {
+      config += R"("normalization": [{"dict": {"type": "inline",
+                    "entries": {"x": "a"}}}],)";
+    }
+    config += R"("segmentation": {"type": "mmseg", "dict": )" + dict +
+              R"(}, "conversion_chain": [{"dict": )" + dict + "}]}";
+    return NewConverter(config);
+  }
+
+  std::string RandomText(std::mt19937* random, size_t length,
+                         bool lineFeeds = true) {
+    static const char* const pieces[] = {"a", "b", "c", "d", "x",
+                                         "一", "二", "三", "四", "\n"};
+    std::uniform_int_distribution<size_t> pick(0, lineFeeds ? 9 : 8);
+    std::string text;
+    while (text.size() < length) {
+      text += pieces[pick(*random)];
+    }
+    return text;
+  }
+
+  // Total number of keys matched by the conversions of chain since their
+  // profiles were enabled.
+  static size_t MatchedKeys(const ConversionChainPtr& chain) {
+    size_t matched = 0;
+    for (const ConversionPtr& conversion : chain->GetConversions()) {
+      for (const KeyHitCount& count :
+           conversion->GetKeyHitProfile()->Counts()) {
+        matched += count.hits;
+      }
+    }
+    return matched;
+  }
+
+  // Offset of a character boundary in text at or before offset.
+  size_t CharBoundary(const std::string& text, size_t offset) {
+    while (offset > 0 && offset < text.size() &&
+           (static_cast<unsigned char>(text[offset]) & 0xC0) == 0x80) {
+      offset--;
+    }
+    return offset;
+  }
+
+  // Applies random edits and checks that every patch turns the previous
+  // output into a full conversion of the edited text.
+  void CheckRandomEdits(const ConverterPtr& converter) {
+    std::mt19937 random(42);
+    IncrementalConverter incremental(converter);
+    const std::string text = RandomText(&random, 2000);
+    EXPECT_EQ(converter->Convert(text), incremental.SetText(text));
+    for (size_t i = 0; i < 300; i++) {
+      const std::string& current = incremental.GetText();
+      const size_t offset = CharBoundary(
+          current,
+          std::uniform_int_distribution<size_t>(0, current.size())(random));
+      const size_t end = CharBoundary(
+          current, std::min(current.size(),
+                            offset + std::uniform_int_distribution<size_t>(
+                                         0, 8)(random)));
+      const std::string replacement = RandomText(
+          &random, std::uniform_int_distribution<size_t>(0, 6)(random));
+      std::string expected = incremental.GetOutput();
+      const ConversionPatch patch =
+          incremental.Edit(offset, end - offset, replacement);
+      expected.replace(patch.offset, patch.length, patch.text);
+      ASSERT_EQ(converter->Convert(incremental.GetText()),
+                incremental.GetOutput());
+      ASSERT_EQ(expected, incremental.GetOutput());
+    }
+  }
+};
+
+TEST_F(IncrementalConverterTest, EditsMatchFullConversion) {
+  CheckRandomEdits(OverlappingConverter(false));
+}
+
+TEST_F(IncrementalConverterTest, EditsMatchFullConversionWithNormalization) {
+  CheckRandomEdits(OverlappingConverter(true));
+}
+
+TEST_F(IncrementalConverterTest, EditsMatchFullConversionByLine) {
+  // A pipeline has no single segmentation, so it is split after line feeds.
+  CheckRandomEdits(ConverterPtr(
+      new PipelineConverter({OverlappingConverter(false)})));
+}
+
+TEST_F(IncrementalConverterTest, EditsStartingFromEmptyText) {
+  const ConverterPtr converter = Config().NewFromFile(CONFIG_TEST_JSON_PATH);
+  IncrementalConverter incremental(converter);
+  EXPECT_EQ("", incremental.SetText(""));
+  incremental.Edit(0, 0, utf8("之子于"));
+  const ConversionPatch patch = incremental.Edit(9, 0, utf8("归"));
+  EXPECT_EQ(utf8("之子于歸"), incremental.GetOutput());
+  EXPECT_EQ(0, patch.offset);
+  EXPECT_EQ(9, patch.length);
+  EXPECT_EQ(utf8("之子于歸"), patch.text);
+
+  incremental.Edit(0, incremental.GetText().size(), "");
+  EXPECT_EQ("", incremental.GetText());
+  EXPECT_EQ("", incremental.GetOutput());
+}
+
+TEST_F(IncrementalConverterTest, SmallEditYieldsSmallPatch) {
+  const ConverterPtr converter = OverlappingConverter(false);
+  std::mt19937 random(7);
+  IncrementalConverter incremental(converter);
+  const std::string text = RandomText(&random, 100000);
+  incremental.SetText(text);
+  const size_t offset = CharBoundary(text, 50000);
+  const ConversionPatch patch = incremental.Edit(
+      offset, CharBoundary(text, offset + 4) - offset, "a");
+  EXPECT_EQ(converter->Convert(incremental.GetText()),
+            incremental.GetOutput());
+  EXPECT_LT(patch.length, 4096);
+  EXPECT_LT(patch.text.size(), 4096);
+}
+
+TEST_F(IncrementalConverterTest, NormalizedEditWithoutLineFeedsStaysLocal) {
+  const ConverterPtr converter = OverlappingConverter(true);
+  const auto* configBased =
+      dynamic_cast<const ConfigBasedConverter*>(converter.get());
+  ASSERT_NE(nullptr, configBased);
+  const ConversionChainPtr normChain =
+      configBased->GetNormalizationConverter()->GetConversionChain();
+  const ConversionChainPtr mainChain =
+      configBased->GetMainConverter()->GetConversionChain();
+
+  std::mt19937 random(7);
+  IncrementalConverter incremental(converter);
+  const std::string text = RandomText(&random, 100000, false);
+  incremental.SetText(text);
+  for (const ConversionPtr& conversion : normChain->GetConversions()) {
+    conversion->EnableKeyHitProfile();
+  }
+  for (const ConversionPtr& conversion : mainChain->GetConversions()) {
+    conversion->EnableKeyHitProfile();
+  }
+  const size_t offset = CharBoundary(text, 50000);
+  const ConversionPatch patch = incremental.Edit(
+      offset, CharBoundary(text, offset + 4) - offset, "x");
+  // Both stages reconverted only a window around the edit.
+  EXPECT_LT(MatchedKeys(normChain), 1000);
+  EXPECT_LT(MatchedKeys(mainChain), 1000);
+  for (const ConversionPtr& conversion : normChain->GetConversions()) {
+    conversion->DisableKeyHitProfile();
+  }
+  for (const ConversionPtr& conversion : mainChain->GetConversions()) {
+    conversion->DisableKeyHitProfile();
+  }
+  EXPECT_EQ(converter->Convert(incremental.GetText()),
+            incremental.GetOutput());
+  EXPECT_LT(patch.length, 4096);
+  EXPECT_LT(patch.text.size(), 4096);
+}
+
+TEST_F(IncrementalConverterTest, RejectsEditOutsideText) {
+  IncrementalConverter incremental(OverlappingConverter(false));
+  incremental.SetText("abc");
+  EXPECT_THROW(incremental.Edit(4, 0, "a"), std::out_of_range);
+  EXPECT_THROW(incremental.Edit(2, 2, "a"), std::out_of_range);
+  EXPECT_EQ("[abc]", incremental.GetOutput());
+}
+
+} // namespace opencc
@@ -0,0 +1,81 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+#include "KeyHitProfile.hpp"
+#include "PerThreadShards.hpp"
+
+using namespace opencc;
+
+namespace {
+
+struct HitShard {
+  std::mutex mutex;
+  std::unordered_map<std::string, uint64_t> counts;
+  // Reused for lookups, so counting a known key does not allocate.
+  std::string key;
+};
+
+bool MoreHits(const KeyHitCount& a, const KeyHitCount& b) {
+  return a.hits != b.hits ? a.hits > b.hits : a.key < b.key;
+}
+
+} // namespace
+
+class KeyHitProfile::ProfileInternal {
+public:
+  internal::PerThreadShards<HitShard> shards;
+};
+
+KeyHitProfile::KeyHitProfile() : internal(new ProfileInternal) {}
+
+KeyHitProfile::~KeyHitProfile() {}
+
+void KeyHitProfile::Record(std::string_view key) {
+  HitShard& shard = internal->shards.Local();
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.key.assign(key.data(), key.size());
+  shard.counts[shard.key]++;
+}
+
+std::vector<KeyHitCount> KeyHitProfile::Counts() const {
+  std::unordered_map<std::string, uint64_t> merged;
+  internal->shards.ForEach([&merged](HitShard& shard) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const auto& count : shard.counts) {
+      merged[count.first] += count.second;
+    }
+  });
+  std::vector<KeyHitCount> counts;
+  counts.reserve(merged.size());
+  for (auto& count : merged) {
+    counts.push_back(KeyHitCount{count.first, count.second});
+  }
+  std::sort(counts.begin(), counts.end(), MoreHits);
+  return counts;
+}
+
+void KeyHitProfile::Reset() {
+  internal->shards.ForEach([](HitShard& shard) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.counts.clear();
+  });
+}
@@ -0,0 +1,71 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Common.hpp"
+
+namespace opencc {
+/**
+ * Number of times a dictionary key was matched.
+ *
+ * @ingroup opencc_cpp_api
+ */
+struct OPENCC_EXPORT KeyHitCount {
+  std::string key;
+  uint64_t hits = 0;
+};
+
+/**
+ * Counts how often each key of a Conversion's dictionary matched, enabled
+ * with Conversion::EnableKeyHitProfile(); KeyHitProfiler attributes the
+ * counts to dictionaries.
+ *
+ * Each thread counts into its own table, so profiling a multi-threaded
+ * workload does not contend. All methods are thread-safe.
+ *
+ * @ingroup opencc_cpp_api
+ */
+class OPENCC_EXPORT KeyHitProfile {
+public:
+  KeyHitProfile();
+
+  ~KeyHitProfile();
+
+  KeyHitProfile(const KeyHitProfile&) = delete;
+  KeyHitProfile& operator=(const KeyHitProfile&) = delete;
+
+  /** Counts one match of @p key. */
+  void Record(std::string_view key);
+
+  /** Returns every key matched so far, most hits first, then by key. */
+  std::vector<KeyHitCount> Counts() const;
+
+  /** Forgets all counts. */
+  void Reset();
+
+private:
+  class ProfileInternal;
+  std::unique_ptr<ProfileInternal> internal;
+};
+} // namespace opencc
@@ -0,0 +1,213 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "ConfigBasedConverter.hpp"
+#include "Conversion.hpp"
+#include "ConversionChain.hpp"
+#include "Dict.hpp"
+#include "Exception.hpp"
+#include "KeyHitProfiler.hpp"
+#include "Lexicon.hpp"
+#include "PipelineConverter.hpp"
+#include "SingleStageConverter.hpp"
+
+using namespace opencc;
+
+uint64_t DictKeyHits::TotalHits() const {
+  uint64_t total = 0;
+  for (const KeyHitCount& count : hits) {
+    total += count.hits;
+  }
+  return total;
+}
+
+class KeyHitProfiler::ProfilerInternal {
+public:
+  struct ProfiledConversion {
+    std::string label;
+    ConversionPtr conversion;
+    std::shared_ptr<KeyHitProfile> profile;
+  };
+
+  void Collect(const ConverterPtr& converter, const std::string& prefix) {
+    if (const ConfigBasedConverter* configBased =
+            dynamic_cast<const ConfigBasedConverter*>(converter.get())) {
+      Collect(configBased->GetNormalizationConverter(),
+              prefix + "normalization.");
+      Collect(configBased->GetMainConverter(), prefix);
+    } else if (const PipelineConverter* pipeline =
+                   dynamic_cast<const PipelineConverter*>(converter.get())) {
+      const std::vector<ConverterPtr>& stages = pipeline->GetStages();
+      for (size_t i = 0; i < stages.size(); i++) {
+        Collect(stages[i], prefix + "stage[" + std::to_string(i) + "].");
+      }
+    } else if (dynamic_cast<const SingleStageConverter*>(converter.get()) !=
+               nullptr) {
+      const ConversionChainPtr chain = converter->GetConversionChain();
+      const std::list<ConversionPtr> chainConversions =
+          chain->GetConversions();
+      if (chain->GetPassCount() != chainConversions.size()) {
+        throw InvalidFormat("Key hits of a compiled conversion chain cannot "
+                            "be attributed to its dictionaries.");
+      }
+      size_t index = 0;
+      for (const ConversionPtr& conversion : chainConversions) {
+        const bool seen = std::any_of(
+            conversions.begin(), conversions.end(),
+            [&conversion](const ProfiledConversion& profiled) {
+              return profiled.conversion == conversion;
+            });
+        if (!seen) {
+          conversions.push_back(ProfiledConversion{
+              prefix + "conversion_chain[" + std::to_string(index) + "]",
+              conversion, nullptr});
+        }
+        index++;
+      }
+    } else {
+      throw InvalidFormat("Converter type cannot be profiled.");
+    }
+  }
+
+  std::vector<ProfiledConversion> conversions;
+};
+
+namespace {
+
+void AddLeafDicts(const DictPtr& dict, const std::string& label,
+                  std::vector<DictKeyHits>* report) {
+  const std::list<DictPtr>* items = dict->GetDictGroupItems();
+  if (items == nullptr) {
+    DictKeyHits leaf;
+    leaf.label = label;
+    leaf.dict = dict;
+    report->push_back(std::move(leaf));
+    return;
+  }
+  size_t index = 0;
+  for (const DictPtr& child : *items) {
+    AddLeafDicts(child, label + ".dict[" + std::to_string(index) + "]",
+                 report);
+    index++;
+  }
+}
+
+void FindDeadKeys(DictKeyHits* leaf) {
+  const LexiconPtr lexicon = leaf->dict->GetLexicon();
+  if (lexicon == nullptr) {
+    return;
+  }
+  leaf->keysEnumerated = true;
+  std::unordered_set<std::string_view> hitKeys;
+  for (const KeyHitCount& count : leaf->hits) {
+    hitKeys.insert(count.key);
+  }
+  for (const std::unique_ptr<DictEntry>& entry : *lexicon) {
+    const std::string_view key = entry->KeyView();
+    if (hitKeys.count(key) == 0) {
+      leaf->deadKeys.emplace_back(key);
+    }
+  }
+  std::sort(leaf->deadKeys.begin(), leaf->deadKeys.end());
+}
+
+} // namespace
+
+KeyHitProfiler::KeyHitProfiler(const ConverterPtr& converter)
+    : internal(new ProfilerInternal) {
+  // Collect everything first, so that a converter that cannot be profiled
+  // leaves no profile enabled.
+  internal->Collect(converter, "");
+  for (ProfilerInternal::ProfiledConversion& profiled :
+       internal->conversions) {
+    profiled.profile = profiled.conversion->EnableKeyHitProfile();
+  }
+}
+
+KeyHitProfiler::~KeyHitProfiler() {
+  for (const ProfilerInternal::ProfiledConversion& profiled :
+       internal->conversions) {
+    profiled.conversion->DisableKeyHitProfile();
+  }
+}
+
+std::vector<DictKeyHits> KeyHitProfiler::Report() const {
+  std::vector<DictKeyHits> report;
+  for (const ProfilerInternal::ProfiledConversion& profiled :
+       internal->conversions) {
+    const size_t first = report.size();
+    AddLeafDicts(profiled.conversion->GetDict(), profiled.label, &report);
+    // Counts are sorted, and attribution keeps their order per dictionary.
+    for (KeyHitCount& count : profiled.profile->Counts()) {
+      size_t owner = first;
+      for (size_t i = first; i < report.size(); i++) {
+        if (!report[i].dict->Match(count.key.data(), count.key.size())
+                 .IsNull()) {
+          owner = i;
+          break;
+        }
+      }
+      report[owner].hits.push_back(std::move(count));
+    }
+    for (size_t i = first; i < report.size(); i++) {
+      FindDeadKeys(&report[i]);
+    }
+  }
+  return report;
+}
+
+std::string KeyHitProfiler::ToReportText(size_t topKeys) const {
+  std::string text;
+  for (const DictKeyHits& leaf : Report()) {
+    text += leaf.label + ": " + std::to_string(leaf.TotalHits()) + " hits, " +
+            std::to_string(leaf.hits.size()) + " keys hit";
+    if (leaf.keysEnumerated) {
+      text += ", " + std::to_string(leaf.deadKeys.size()) + " never hit";
+    }
+    text += "\n";
+    for (size_t i = 0; i < leaf.hits.size() && i < topKeys; i++) {
+      text += "  " + std::to_string(leaf.hits[i].hits) + "\t" +
+              leaf.hits[i].key + "\n";
+    }
+  }
+  return text;
+}
+
+std::string KeyHitProfiler::ToHotnessText() const {
+  std::string text;
+  for (const DictKeyHits& leaf : Report()) {
+    text += "# " + leaf.label + "\n";
+    for (const KeyHitCount& count : leaf.hits) {
+      text += count.key + "\t" + std::to_string(count.hits) + "\n";
+    }
+    for (const std::string& key : leaf.deadKeys) {
+      text += key + "\t0\n";
+    }
+  }
+  return text;
+}
+
+void KeyHitProfiler::Reset() {
+  for (const ProfilerInternal::ProfiledConversion& profiled :
+       internal->conversions) {
+    profiled.profile->Reset();
+  }
+}
@@ -0,0 +1,110 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common.hpp"
+#include "KeyHitProfile.hpp"
+
+namespace opencc {
+/**
+ * Key hits of one leaf dictionary of a converter.
+ *
+ * @ingroup opencc_cpp_api
+ */
+struct OPENCC_EXPORT DictKeyHits {
+  /**
+   * Position of the dictionary in the converter, e.g.
+   * "conversion_chain[1].dict[0]" for the first dictionary of the group
+   * used by the second conversion. Pipeline stages are prefixed with
+   * "stage[i]." and normalization converters with "normalization.".
+   */
+  std::string label;
+  DictPtr dict;
+  /** Keys of the dictionary that matched, most hits first. */
+  std::vector<KeyHitCount> hits;
+  /**
+   * Keys of the dictionary that never matched, sorted. Empty when the
+   * dictionary cannot enumerate its keys; see keysEnumerated.
+   */
+  std::vector<std::string> deadKeys;
+  bool keysEnumerated = false;
+
+  uint64_t TotalHits() const;
+};
+
+/**
+ * Profiles which dictionary keys of a converter match over a workload.
+ *
+ * The profiler enables the key hit profile of every Conversion of the
+ * converter for its lifetime, then attributes each matched key to the
+ * first dictionary of the conversion's group that contains it, which is
+ * the dictionary whose entry a ShortCircuit group returns. Keys of later
+ * dictionaries shadowed that way therefore show up as dead.
+ *
+ * The results can be read as a report for people (ToReportText()) and as a
+ * hotness file for dictionary tooling (ToHotnessText()): one section per
+ * dictionary starting with a "# label" line, followed by one
+ * "key<TAB>hits" line per key, most hits first and never matched keys
+ * last.
+ *
+ * Profiling costs a table update per match. With no profiler attached, a
+ * conversion pays one atomic load per segment.
+ *
+ * @ingroup opencc_cpp_api
+ */
+class OPENCC_EXPORT KeyHitProfiler {
+public:
+  /**
+   * Starts profiling @p converter. Conversions shared with other converters
+   * are profiled for all of them.
+   * @throws InvalidFormat if @p converter is of an unknown type or has a
+   *   conversion chain compiled with fused stages, whose matches cannot be
+   *   attributed to the original dictionaries.
+   */
+  explicit KeyHitProfiler(const ConverterPtr& converter);
+
+  /** Stops profiling. */
+  ~KeyHitProfiler();
+
+  KeyHitProfiler(const KeyHitProfiler&) = delete;
+  KeyHitProfiler& operator=(const KeyHitProfiler&) = delete;
+
+  /** Returns the hits of every leaf dictionary in conversion order. */
+  std::vector<DictKeyHits> Report() const;
+
+  /**
+   * Formats Report() for reading: per dictionary, the total hits, the
+   * number of keys hit and never hit, and the @p topKeys most hit keys.
+   */
+  std::string ToReportText(size_t topKeys = 20) const;
+
+  /** Formats Report() as a hotness file; see the class description. */
+  std::string ToHotnessText() const;
+
+  /** Forgets all counts. */
+  void Reset();
+
+private:
+  class ProfilerInternal;
+  std::unique_ptr<ProfilerInternal> internal;
+};
+} // namespace opencc
@@ -0,0 +1,157 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+
+#include "Config.hpp"
+#include "ConfigTestBase.hpp"
+#include "Conversion.hpp"
+#include "ConversionChain.hpp"
+#include "Converter.hpp"
+#include "Exception.hpp"
+#include "KeyHitProfiler.hpp"
+#include "TestUtilsUTF8.hpp"
+
+namespace opencc {
+
+class KeyHitProfilerTest : public ConfigTestBase {
+protected:
+  // One conversion over a short-circuit group in which "b" of the second
+  // dictionary is shadowed by the first, behind a normalization pre-pass.
+  ConverterPtr GroupConverter(bool compile = false) {
+    ConfigLoadOptions options;
+    options.compileConversionChains = compile;
+    return Config().NewFromString(
+        R"({"name": "Group",
+            "normalization": [{"dict": {"type": "inline",
+                                        "entries": {"x": "a"}}}],
+            "conversion_chain": [{"dict": {
+              "type": "group", "match_policy": "short_circuit",
+              "dicts": [
+                {"type": "inline", "entries": {"a": "1", "b": "2"}},
+                {"type": "inline", "entries": {"b": "3", "c": "4", "d": "5"}}
+              ]}},
+              {"dict": {"type": "inline", "entries": {"1": "one"}}}]})",
+        std::vector<std::string>{CONFIG_TEST_DIR_PATH}, options);
+  }
+
+  ConversionPtr FirstConversion(const ConverterPtr& converter) {
+    return converter->GetConversionChain()->GetConversions().front();
+  }
+};
+
+TEST_F(KeyHitProfilerTest, CountsHitsPerDictionary) {
+  const ConverterPtr converter = Config().NewFromFile(CONFIG_TEST_JSON_PATH);
+  KeyHitProfiler profiler(converter);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(utf8("燕燕于飛，遠送於野。"),
+              converter->Convert(utf8("燕燕于飞，远送于野。")));
+  }
+
+  const std::vector<DictKeyHits> report = profiler.Report();
+  ASSERT_EQ(2, report.size());
+  EXPECT_EQ("conversion_chain[0].dict[0]", report[0].label);
+  ASSERT_EQ(1, report[0].hits.size());
+  EXPECT_EQ(utf8("燕燕于飞"), report[0].hits[0].key);
+  EXPECT_EQ(3, report[0].hits[0].hits);
+  EXPECT_TRUE(report[0].keysEnumerated);
+  EXPECT_EQ(std::vector<std::string>{utf8("之子于归")}, report[0].deadKeys);
+
+  EXPECT_EQ("conversion_chain[0].dict[1]", report[1].label);
+  ASSERT_EQ(2, report[1].hits.size());
+  EXPECT_EQ(6, report[1].TotalHits());
+  EXPECT_TRUE(report[1].deadKeys.empty());
+}
+
+TEST_F(KeyHitProfilerTest, AttributesShadowedKeysToFirstDictionary) {
+  const ConverterPtr converter = GroupConverter();
+  KeyHitProfiler profiler(converter);
+  EXPECT_EQ("one24one", converter->Convert("abcx"));
+  EXPECT_EQ("# normalization.conversion_chain[0]\n"
+            "x\t1\n"
+            "# conversion_chain[0].dict[0]\n"
+            "a\t2\n"
+            "b\t1\n"
+            "# conversion_chain[0].dict[1]\n"
+            "c\t1\n"
+            "b\t0\n"
+            "d\t0\n"
+            "# conversion_chain[1]\n"
+            "1\t2\n",
+            profiler.ToHotnessText());
+  EXPECT_EQ("normalization.conversion_chain[0]: 1 hits, 1 keys hit, "
+            "0 never hit\n"
+            "  1\tx\n"
+            "conversion_chain[0].dict[0]: 3 hits, 2 keys hit, 0 never hit\n"
+            "  2\ta\n"
+            "conversion_chain[0].dict[1]: 1 hits, 1 keys hit, 2 never hit\n"
+            "  1\tc\n"
+            "conversion_chain[1]: 2 hits, 1 keys hit, 0 never hit\n"
+            "  2\t1\n",
+            profiler.ToReportText(1));
+
+  profiler.Reset();
+  EXPECT_EQ(0, profiler.Report()[1].TotalHits());
+}
+
+TEST_F(KeyHitProfilerTest, StopsCountingWhenDestroyed) {
+  const ConverterPtr converter = GroupConverter();
+  const ConversionPtr conversion = FirstConversion(converter);
+  EXPECT_EQ(nullptr, conversion->GetKeyHitProfile());
+  {
+    KeyHitProfiler outer(converter);
+    {
+      KeyHitProfiler inner(converter);
+      converter->Convert("a");
+    }
+    // The outer profiler still counts, into the same profile.
+    converter->Convert("a");
+    EXPECT_EQ(2, outer.Report()[1].TotalHits());
+  }
+  EXPECT_EQ(nullptr, conversion->GetKeyHitProfile());
+}
+
+TEST_F(KeyHitProfilerTest, SumsCountsOfAllThreads) {
+  const ConverterPtr converter = GroupConverter();
+  KeyHitProfiler profiler(converter);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&converter]() {
+      for (int i = 0; i < 100; i++) {
+        converter->Convert("ab");
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const std::vector<DictKeyHits> report = profiler.Report();
+  ASSERT_EQ(2, report[1].hits.size());
+  EXPECT_EQ(400, report[1].hits[0].hits);
+  EXPECT_EQ(400, report[1].hits[1].hits);
+}
+
+TEST_F(KeyHitProfilerTest, RejectsCompiledChain) {
+  const ConverterPtr converter = GroupConverter(true);
+  ASSERT_EQ(1, converter->GetConversionChain()->GetPassCount());
+  EXPECT_THROW(KeyHitProfiler profiler(converter), InvalidFormat);
+  // Nothing was left enabled.
+  EXPECT_EQ(nullptr, FirstConversion(converter)->GetKeyHitProfile());
+}
+
+} // namespace opencc
@@ -19,39 +19,47 @@
 #include <algorithm>
 
 #include "Lexicon.hpp"
+#include "ParallelPieces.hpp"
+#include "TextDictParser.hpp"
 
 namespace opencc {
 
 namespace {
 
-DictEntry* ParseKeyValues(const char* buff, size_t lineNum,
-                          char keyValueDelimiter) {
-  size_t length;
-  if (buff == nullptr || UTF8Util::IsLineEndingOrFileEnding(*buff)) {
-    return nullptr;
-  }
-  const char* pbuff = UTF8Util::FindNextInline(buff, keyValueDelimiter);
-  if (UTF8Util::IsLineEndingOrFileEnding(*pbuff)) {
-    throw InvalidTextDictionary("Tabular not found " + std::string(buff),
-                                lineNum);
-  }
-  length = static_cast<size_t>(pbuff - buff);
-  std::string key = UTF8Util::FromSubstr(buff, length);
-  std::vector<std::string> values;
-  while (!UTF8Util::IsLineEndingOrFileEnding(*pbuff)) {
-    buff = pbuff = UTF8Util::NextChar(pbuff);
-    pbuff = UTF8Util::FindNextInline(buff, ' ');
-    length = static_cast<size_t>(pbuff - buff);
-    const std::string& value = UTF8Util::FromSubstr(buff, length);
-    values.push_back(value);
-  }
-  if (values.size() == 0) {
-    throw InvalidTextDictionary("No value in an item", lineNum);
-  } else if (values.size() == 1) {
-    return DictEntryFactory::New(key, values.at(0));
-  } else {
-    return DictEntryFactory::New(key, values);
-  }
+// Entries created per task when building the lexicon from parsed entries.
+constexpr size_t kEntriesPerPiece = 64 * 1024;
+
+LexiconPtr NewLexicon(const internal::ParsedTextDictionary& parsed,
+                      size_t threads) {
+  const std::vector<internal::ParsedTextEntry>& entries = parsed.entries;
+  std::vector<std::unique_ptr<DictEntry>> dictEntries(entries.size());
+  const size_t numPieces =
+      (entries.size() + kEntriesPerPiece - 1) / kEntriesPerPiece;
+  internal::RunPieces(numPieces, threads, [&](size_t piece) {
+    const size_t end =
+        (std::min)(entries.size(), (piece + 1) * kEntriesPerPiece);
+    for (size_t i = piece * kEntriesPerPiece; i < end; i++) {
+      const internal::ParsedTextEntry& entry = entries[i];
+      const std::string_view* values = parsed.Values(entry);
+      const std::string key(entry.Key());
+      if (entry.numValues == 1) {
+        dictEntries[i].reset(
+            DictEntryFactory::New(key, std::string(values[0])));
+      } else {
+        dictEntries[i].reset(DictEntryFactory::New(
+            key, std::vector<std::string>(values, values + entry.numValues)));
+      }
+    }
+  });
+  return LexiconPtr(new Lexicon(std::move(dictEntries)));
+}
+
+LexiconPtr ParseLexicon(const char* data, size_t size, char keyValueDelimiter,
+                        size_t threads, bool sorted) {
+  threads = internal::ResolveThreadCount(threads);
+  return NewLexicon(internal::ParseTextDictionary(data, size, keyValueDelimiter,
+                                                  threads, sorted),
+                    threads);
 }
 
 } // namespace
@@ -82,58 +90,27 @@ LexiconPtr Lexicon::ParseLexiconFromFile(FILE* fp) {
 }
 
 LexiconPtr Lexicon::ParseLexiconFromFile(FILE* fp, char keyValueDelimiter) {
-  const int ENTRY_BUFF_SIZE = 4096;
-  char buff[ENTRY_BUFF_SIZE];
-  LexiconPtr lexicon(new Lexicon);
-  UTF8Util::SkipUtf8Bom(fp);
-
-  size_t lineNum = 1;
-  while (fgets(buff, ENTRY_BUFF_SIZE, fp)) {
-    if (*buff == '#') {
-      lineNum++;
-      continue;
-    }
-    DictEntry* entry = ParseKeyValues(buff, lineNum, keyValueDelimiter);
-    if (entry != nullptr) {
-      lexicon->Add(entry);
-    }
-    lineNum++;
-  }
-  return lexicon;
+  const std::string buffer = internal::ReadToEnd(fp);
+  return ParseLexicon(buffer.data(), buffer.size(), keyValueDelimiter, 0,
+                      false);
 }
 
 LexiconPtr Lexicon::ParseLexiconFromBuffer(const char* data, size_t size) {
-  LexiconPtr lexicon(new Lexicon);
-  size_t offset = 0;
-  if (size >= 3 && static_cast<unsigned char>(data[0]) == 0xef &&
-      static_cast<unsigned char>(data[1]) == 0xbb &&
-      static_cast<unsigned char>(data[2]) == 0xbf) {
-    offset = 3;
-  }
-
-  size_t lineNum = 1;
-  while (offset < size) {
-    size_t lineEnd = offset;
-    while (lineEnd < size && data[lineEnd] != '\n') {
-      lineEnd++;
-    }
+  return ParseLexicon(data, size, '\t', 0, false);
+}
 
-    std::string line(data + offset, lineEnd - offset);
-    if (!line.empty() && line.back() == '\r') {
-      line.pop_back();
-    }
-    if (!line.empty() && line.front() != '#') {
-      line.push_back('\n');
-      DictEntry* entry = ParseKeyValues(line.c_str(), lineNum, '\t');
-      if (entry != nullptr) {
-        lexicon->Add(entry);
-      }
-    }
+LexiconPtr Lexicon::ParseSortedLexiconFromBuffer(const char* data, size_t size,
+                                                 char keyValueDelimiter,
+                                                 size_t threads) {
+  return ParseLexicon(data, size, keyValueDelimiter, threads, true);
+}
 
-    offset = lineEnd < size ? lineEnd + 1 : lineEnd;
-    lineNum++;
-  }
-  return lexicon;
+LexiconPtr Lexicon::ParseSortedLexiconFromFile(FILE* fp,
+                                               char keyValueDelimiter,
+                                               size_t threads) {
+  const std::string buffer = internal::ReadToEnd(fp);
+  return ParseLexicon(buffer.data(), buffer.size(), keyValueDelimiter, threads,
+                      true);
 }
 
 } // namespace opencc
@@ -62,10 +62,35 @@ public:
     return entries.end();
   }
 
+  /**
+   * Parses a text dictionary and keeps its entries in file order. Large
+   * inputs are parsed in line-aligned chunks on several threads.
+   */
   static LexiconPtr ParseLexiconFromFile(FILE* fp);
   static LexiconPtr ParseLexiconFromFile(FILE* fp, char keyValueDelimiter);
   static LexiconPtr ParseLexiconFromBuffer(const char* data, size_t size);
 
+  /**
+   * Parses a text dictionary and returns its entries sorted by key, as if
+   * by ParseLexiconFromBuffer() and Sort(). The input is split into
+   * line-aligned chunks that are parsed and sorted on up to @p threads
+   * threads (0 for the hardware concurrency) and then merged. Entries are
+   * parsed as views into @p data, and a DictEntry is only allocated for
+   * each entry once the order is known.
+   * @throws InvalidTextDictionary for the first malformed line.
+   */
+  static LexiconPtr ParseSortedLexiconFromBuffer(const char* data, size_t size,
+                                                 char keyValueDelimiter = '\t',
+                                                 size_t threads = 0);
+
+  /**
+   * Reads @p fp from its current position to the end and parses it with
+   * ParseSortedLexiconFromBuffer().
+   */
+  static LexiconPtr ParseSortedLexiconFromFile(FILE* fp,
+                                               char keyValueDelimiter = '\t',
+                                               size_t threads = 0);
+
 private:
   std::vector<std::unique_ptr<DictEntry>> entries;
 };
@@ -0,0 +1,108 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MappedFile.hpp"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include "WinUtil.hpp"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Exception.hpp"
+
+namespace opencc {
+namespace internal {
+
+namespace {
+
+// Reads everything behind fp from the start into buffer.
+bool ReadWholeFile(FILE* fp, std::string* buffer) {
+  if (fseek(fp, 0L, SEEK_END) != 0) {
+    return false;
+  }
+  const long fileSize = ftell(fp);
+  if (fileSize < 0 || fseek(fp, 0L, SEEK_SET) != 0) {
+    return false;
+  }
+  buffer->resize(static_cast<size_t>(fileSize));
+  return buffer->empty() ||
+         fread(&(*buffer)[0], sizeof(char), buffer->size(), fp) ==
+             buffer->size();
+}
+
+} // namespace
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::string& path) {
+#if defined(_WIN32) || defined(_WIN64)
+  FILE* fp = _wfopen(WideFromUtf8(path).c_str(), L"rb");
+#else
+  FILE* fp = fopen(path.c_str(), "rb");
+#endif
+  if (fp == nullptr) {
+    throw FileNotFound(path);
+  }
+  try {
+    std::shared_ptr<const MappedFile> file = Open(fp);
+    fclose(fp);
+    return file;
+  } catch (const InvalidFormat&) {
+    fclose(fp);
+    throw FileNotFound(path);
+  }
+}
+
+std::shared_ptr<const MappedFile> MappedFile::Open(FILE* fp) {
+  std::shared_ptr<MappedFile> file(new MappedFile);
+#if !defined(_WIN32) && !defined(_WIN64)
+  const int fd = fileno(fp);
+  struct stat info;
+  if (fd >= 0 && fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+    file->size = static_cast<size_t>(info.st_size);
+    if (file->size == 0) {
+      return file;
+    }
+    void* mapped = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped != MAP_FAILED) {
+      file->data = static_cast<const char*>(mapped);
+      file->mapped = true;
+      return file;
+    }
+  }
+#endif
+  if (!ReadWholeFile(fp, &file->buffer)) {
+    throw InvalidFormat("Cannot read file.");
+  }
+  file->data = file->buffer.data();
+  file->size = file->buffer.size();
+  return file;
+}
+
+MappedFile::~MappedFile() {
+#if !defined(_WIN32) && !defined(_WIN64)
+  if (mapped) {
+    munmap(const_cast<char*>(data), size);
+  }
+#endif
+}
+
+} // namespace internal
+} // namespace opencc
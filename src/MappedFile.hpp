@@ -0,0 +1,70 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace opencc {
+namespace internal {
+
+/**
+ * Read-only view of a whole file's contents.
+ *
+ * On POSIX systems the file is memory-mapped, so every process that opens the
+ * same file shares one page-cache copy and opening it allocates nothing
+ * proportional to the file size.  Where mapping is unavailable (Windows, or a
+ * descriptor that cannot be mapped such as a pipe) the contents are read into
+ * a private buffer instead.  Private (non-installed) header.
+ */
+class MappedFile {
+public:
+  /**
+   * Maps the file at @p path.  Throws FileNotFound if it cannot be opened.
+   */
+  static std::shared_ptr<const MappedFile> Open(const std::string& path);
+
+  /**
+   * Maps the whole file behind @p fp, independent of its current position.
+   * The mapping stays valid after @p fp is closed.  Throws InvalidFormat if
+   * the file cannot be read.
+   */
+  static std::shared_ptr<const MappedFile> Open(FILE* fp);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile();
+
+  const char* Data() const { return data; }
+
+  size_t Size() const { return size; }
+
+private:
+  MappedFile() = default;
+
+  const char* data = nullptr;
+  size_t size = 0;
+  bool mapped = false;
+  std::string buffer;
+};
+
+} // namespace internal
+} // namespace opencc
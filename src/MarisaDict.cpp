@@ -17,13 +17,20 @@
  */
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <istream>
 #include <stdexcept>
+#include <streambuf>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 
 #include "marisa.h"
+#include "marisa/iostream.h"
 
 #include "Lexicon.hpp"
+#include "MappedFile.hpp"
 #include "MarisaDict.hpp"
 #include "SerializedValues.hpp"
 
@@ -31,37 +38,194 @@ using namespace opencc;
 
 namespace {
 static const char* OCD2_HEADER = "OPENCC_MARISA_0.2.5";
+static const char* OCD3_HEADER = "OPENCC_MARISA_0.3.0";
+// The OCD3 header is NUL-padded so that the trie and the value tables after
+// it start 8-byte aligned in the file, and can be used in place when the
+// file is mapped.
+constexpr size_t kOcd3HeaderSize = 24;
+constexpr size_t kOcd3SectionAlignment = 8;
+
+// Returns the length of the OCD2 or OCD3 header at the start of data.
+size_t ParseHeader(const char* data, size_t size, MarisaDict::Format* format) {
+  const size_t ocd2HeaderLen = strlen(OCD2_HEADER);
+  if (size >= ocd2HeaderLen && memcmp(data, OCD2_HEADER, ocd2HeaderLen) == 0) {
+    *format = MarisaDict::Format::Ocd2;
+    return ocd2HeaderLen;
+  }
+  const size_t ocd3HeaderLen = strlen(OCD3_HEADER);
+  if (size >= kOcd3HeaderSize &&
+      memcmp(data, OCD3_HEADER, ocd3HeaderLen) == 0) {
+    *format = MarisaDict::Format::Ocd3;
+    return kOcd3HeaderSize;
+  }
+  throw InvalidFormat("Invalid OpenCC dictionary header");
 }
 
+// Read-only stream over a memory range, used to load a trie whose bytes are
+// not aligned well enough to be mapped in place.
+class MemoryStreamBuf : public std::streambuf {
+public:
+  MemoryStreamBuf(const char* data, size_t size) {
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+  }
+
+  size_t Consumed() const { return static_cast<size_t>(gptr() - eback()); }
+};
+
+// marisa reads its mapped structures as 64-bit words.
+constexpr size_t kTrieAlignment = alignof(uint64_t);
+
+// DictEntry interface over a key of the trie and its values, which are read
+// in place.
+class MarisaDictEntry : public DictEntry {
+public:
+  MarisaDictEntry(const SerializedValues::ValuesView* values,
+                  std::string_view key, size_t id)
+      : values(values), key(key), id(id) {}
+
+  std::string_view KeyView() const override { return key; }
+
+  std::string_view GetDefaultView() const override {
+    return values->NumValues(id) == 0 ? key : values->Value(id, 0);
+  }
+
+  std::vector<std::string> Values() const override {
+    std::vector<std::string> result;
+    result.reserve(NumValues());
+    for (size_t i = 0; i < NumValues(); i++) {
+      result.emplace_back(values->Value(id, i));
+    }
+    return result;
+  }
+
+  size_t NumValues() const override { return values->NumValues(id); }
+
+  std::string ToString() const override {
+    std::string str(key);
+    for (size_t i = 0; i < NumValues(); i++) {
+      str += i == 0 ? '\t' : ' ';
+      str.append(values->Value(id, i));
+    }
+    return str;
+  }
+
+private:
+  const SerializedValues::ValuesView* values;
+  std::string_view key;
+  size_t id;
+};
+
+} // namespace
+
 class MarisaDict::MarisaInternal {
 public:
+  static constexpr size_t kUnknownLength = SIZE_MAX;
+
+  // A copy of every key, indexed by key id, and a MarisaDictEntry for each.
+  struct EntryViews {
+    std::string keys;
+    std::vector<MarisaDictEntry> entries;
+  };
+
   std::unique_ptr<marisa::Trie> marisa;
-  std::string mappedBuffer;
+  // Storage behind the mapped trie and the values: a private copy made by
+  // NewFromBuffer(), or memory kept alive by bufferOwner (e.g. a file
+  // mapping).
+  std::string ownedBuffer;
+  std::shared_ptr<const void> bufferOwner;
+  SerializedValues::ValuesView values;
+  bool hasValues = false;
+  Format format = Format::Ocd2;
+  // Length of the longest key; derived from the trie on first use unless
+  // NewFromDict() knew it.
+  std::atomic<size_t> keyMaxLength{kUnknownLength};
+  // Entries returned by Match() and friends, built on first use.
+  std::atomic<const EntryViews*> entryViews{nullptr};
+  std::unique_ptr<const EntryViews> entryViewsOwner;
+  std::mutex entryViewsMutex;
 
   MarisaInternal() : marisa(new marisa::Trie()) {}
+
+  size_t KeyMaxLength() {
+    size_t length = keyMaxLength.load(std::memory_order_relaxed);
+    if (length != kUnknownLength) {
+      return length;
+    }
+    // A walk over all keys, which neither copies nor allocates per key.
+    // Racing callers compute the same value.
+    length = 0;
+    marisa::Agent agent;
+    agent.set_query("");
+    while (marisa->predictive_search(agent)) {
+      length = (std::max)(length, agent.key().length());
+    }
+    keyMaxLength.store(length, std::memory_order_relaxed);
+    return length;
+  }
+
+  const EntryViews& GetEntryViews() {
+    const EntryViews* views = entryViews.load(std::memory_order_acquire);
+    if (views != nullptr) {
+      return *views;
+    }
+    std::lock_guard<std::mutex> lock(entryViewsMutex);
+    if (entryViewsOwner != nullptr) {
+      return *entryViewsOwner;
+    }
+    std::unique_ptr<EntryViews> built(new EntryViews);
+    std::vector<std::pair<size_t, size_t>> keyRanges(
+        values.Length(), std::make_pair(size_t(0), size_t(0)));
+    marisa::Agent agent;
+    agent.set_query("");
+    while (marisa->predictive_search(agent)) {
+      const size_t id = agent.key().id();
+      if (id >= keyRanges.size()) {
+        throw InvalidFormat(
+            "Invalid OpenCC Marisa dictionary (key id out of bounds)");
+      }
+      keyRanges[id] = std::make_pair(built->keys.size(), agent.key().length());
+      built->keys.append(agent.key().ptr(), agent.key().length());
+    }
+    built->entries.reserve(keyRanges.size());
+    for (size_t id = 0; id < keyRanges.size(); id++) {
+      built->entries.emplace_back(
+          &values,
+          std::string_view(built->keys.data() + keyRanges[id].first,
+                           keyRanges[id].second),
+          id);
+    }
+    entryViewsOwner = std::move(built);
+    entryViews.store(entryViewsOwner.get(), std::memory_order_release);
+    return *entryViewsOwner;
+  }
 };
 
 MarisaDict::MarisaDict()
-    : maxLength(128), lexiconReconstructed(false), internal(new MarisaInternal()) {}
+    : lexiconReconstructed(false), internal(new MarisaInternal()) {}
 
 MarisaDict::~MarisaDict() {}
 
-size_t MarisaDict::KeyMaxLength() const {
-  ReconstructLexicon();
-  return maxLength;
+size_t MarisaDict::KeyMaxLength() const { return internal->KeyMaxLength(); }
+
+const DictEntry* MarisaDict::EntryAt(size_t id) const {
+  if (internal->hasValues) {
+    return &internal->GetEntryViews().entries[id];
+  }
+  // Built by NewFromDict(), which keeps its entries in the lexicon.
+  return lexicon->At(id);
 }
 
 Optional<const DictEntry*> MarisaDict::Match(const char* word,
                                              size_t len) const {
-  ReconstructLexicon();
-  if (len > maxLength) {
+  if (len > KeyMaxLength()) {
     return Optional<const DictEntry*>::Null();
   }
   const marisa::Trie& trie = *internal->marisa;
   marisa::Agent agent;
   agent.set_query(word, len);
   if (trie.lookup(agent)) {
-    return Optional<const DictEntry*>(lexicon->At(agent.key().id()));
+    return Optional<const DictEntry*>(EntryAt(agent.key().id()));
   } else {
     return Optional<const DictEntry*>::Null();
   }
@@ -69,13 +233,12 @@ Optional<const DictEntry*> MarisaDict::Match(const char* word,
 
 Optional<const DictEntry*> MarisaDict::MatchPrefix(const char* word,
                                                    size_t len) const {
-  ReconstructLexicon();
   const marisa::Trie& trie = *internal->marisa;
   marisa::Agent agent;
-  agent.set_query(word, (std::min)(maxLength, len));
+  agent.set_query(word, (std::min)(KeyMaxLength(), len));
   const DictEntry* match = nullptr;
   while (trie.common_prefix_search(agent)) {
-    match = lexicon->At(agent.key().id());
+    match = EntryAt(agent.key().id());
   }
   if (match == nullptr) {
     return Optional<const DictEntry*>::Null();
@@ -86,13 +249,12 @@ Optional<const DictEntry*> MarisaDict::MatchPrefix(const char* word,
 
 std::vector<const DictEntry*> MarisaDict::MatchAllPrefixes(const char* word,
                                                            size_t len) const {
-  ReconstructLexicon();
   const marisa::Trie& trie = *internal->marisa;
   marisa::Agent agent;
-  agent.set_query(word, (std::min)(maxLength, len));
+  agent.set_query(word, (std::min)(KeyMaxLength(), len));
   std::vector<const DictEntry*> matches;
   while (trie.common_prefix_search(agent)) {
-    matches.push_back(lexicon->At(agent.key().id()));
+    matches.push_back(EntryAt(agent.key().id()));
   }
   std::reverse(matches.begin(), matches.end());
   return matches;
@@ -111,14 +273,15 @@ void MarisaDict::ReconstructLexicon() const {
   if (lexiconReconstructed.load(std::memory_order_relaxed)) {
     return;
   }
-  if (!valuesLexicon) {
+  const SerializedValues::ValuesView& values = internal->values;
+  if (!internal->hasValues) {
     lexiconReconstructed.store(true, std::memory_order_release);
     return;
   }
   marisa::Agent agent;
   agent.set_query("");
   std::vector<std::unique_ptr<DictEntry>> entries;
-  entries.resize(valuesLexicon->Length());
+  entries.resize(values.Length());
   size_t maxLen = 0;
   try {
     while (internal->marisa->predictive_search(agent)) {
@@ -129,8 +292,12 @@ void MarisaDict::ReconstructLexicon() const {
             "Invalid OpenCC Marisa dictionary (key id out of bounds)");
       }
       maxLen = (std::max)(key.length(), maxLen);
-      std::unique_ptr<DictEntry> entry(
-          DictEntryFactory::New(key, valuesLexicon->At(id)->Values()));
+      std::vector<std::string> entryValues;
+      entryValues.reserve(values.NumValues(id));
+      for (size_t i = 0; i < values.NumValues(id); i++) {
+        entryValues.emplace_back(values.Value(id, i));
+      }
+      std::unique_ptr<DictEntry> entry(DictEntryFactory::New(key, entryValues));
       entries[id] = std::move(entry);
     }
   } catch (const std::exception& e) {
@@ -138,87 +305,101 @@ void MarisaDict::ReconstructLexicon() const {
                         e.what());
   }
   lexicon.reset(new Lexicon(std::move(entries)));
-  maxLength = maxLen;
+  internal->keyMaxLength.store(maxLen, std::memory_order_relaxed);
   lexiconReconstructed.store(true, std::memory_order_release);
 }
 
 MarisaDictPtr MarisaDict::NewFromFile(FILE* fp) {
-  // Verify file header
-  size_t headerLen = strlen(OCD2_HEADER);
-  void* buffer = malloc(sizeof(char) * headerLen);
-  size_t bytesRead = fread(buffer, sizeof(char), headerLen, fp);
-  if (bytesRead != headerLen || memcmp(buffer, OCD2_HEADER, headerLen) != 0) {
+  const long start = ftell(fp);
+  std::shared_ptr<const internal::MappedFile> file =
+      internal::MappedFile::Open(fp);
+  if (start < 0 || static_cast<size_t>(start) > file->Size()) {
     throw InvalidFormat("Invalid OpenCC dictionary header");
   }
-  free(buffer);
-  long trieOffset = ftell(fp);
-  fseek(fp, 0L, SEEK_END);
-  long fileEnd = ftell(fp);
-  fseek(fp, trieOffset, SEEK_SET);
-  size_t remainingSize =
-      (fileEnd > trieOffset) ? static_cast<size_t>(fileEnd - trieOffset) : 0;
+  const char* data = file->Data() + start;
+  const size_t size = file->Size() - static_cast<size_t>(start);
+  return NewFromSharedBuffer(data, size, std::move(file));
+}
 
+MarisaDictPtr MarisaDict::NewFromBuffer(const char* data, size_t size) {
   MarisaDictPtr dict(new MarisaDict());
-  if (remainingSize > 0) {
-    dict->internal->mappedBuffer.resize(remainingSize);
-    bytesRead = fread(&dict->internal->mappedBuffer[0],
-                      sizeof(char), remainingSize, fp);
-    if (bytesRead != remainingSize) {
-      throw InvalidFormat("Invalid OpenCC Marisa dictionary.");
-    }
-  }
+  const size_t headerLen = ParseHeader(data, size, &dict->internal->format);
+  size_t remainingSize = size - headerLen;
+  dict->internal->ownedBuffer.assign(data + headerLen, remainingSize);
 
-  dict->LoadFromMappedBuffer();
+  dict->LoadFromBuffer(dict->internal->ownedBuffer.data(),
+                       dict->internal->ownedBuffer.size());
   return dict;
 }
 
-MarisaDictPtr MarisaDict::NewFromBuffer(const char* data, size_t size) {
-  // Verify file header
-  size_t headerLen = strlen(OCD2_HEADER);
-  if (size < headerLen || memcmp(data, OCD2_HEADER, headerLen) != 0) {
-    throw InvalidFormat("Invalid OpenCC dictionary header");
-  }
-
-  size_t remainingSize = size - headerLen;
+MarisaDictPtr
+MarisaDict::NewFromSharedBuffer(const char* data, size_t size,
+                                std::shared_ptr<const void> owner) {
   MarisaDictPtr dict(new MarisaDict());
-  dict->internal->mappedBuffer.assign(data + headerLen, remainingSize);
-
-  dict->LoadFromMappedBuffer();
+  const size_t headerLen = ParseHeader(data, size, &dict->internal->format);
+  dict->internal->bufferOwner = std::move(owner);
+  dict->LoadFromBuffer(data + headerLen, size - headerLen);
   return dict;
 }
 
-void MarisaDict::LoadFromMappedBuffer() {
+void MarisaDict::LoadFromBuffer(const char* data, size_t size) {
+  size_t trieSize = 0;
   try {
-    internal->marisa->map(internal->mappedBuffer.data(),
-                          internal->mappedBuffer.size());
+    if (reinterpret_cast<uintptr_t>(data) % kTrieAlignment == 0) {
+      internal->marisa->map(data, size);
+      trieSize = internal->marisa->io_size();
+    } else {
+      // The 19-byte OCD2 header leaves the trie of a mapped file misaligned,
+      // so it is read into trie-owned storage instead. Values stay in place.
+      MemoryStreamBuf streamBuf(data, size);
+      std::istream stream(&streamBuf);
+      marisa::read(stream, internal->marisa.get());
+      trieSize = streamBuf.Consumed();
+    }
   } catch (const std::exception& e) {
     throw InvalidFormat(std::string("Invalid OpenCC Marisa dictionary: ") +
                         e.what());
   }
 
-  const size_t trieSize = internal->marisa->io_size();
-  if (trieSize > internal->mappedBuffer.size()) {
+  if (trieSize > size) {
     throw InvalidFormat(
         "Invalid OpenCC Marisa dictionary (trie exceeds file size)");
   }
 
   size_t valuesBytesRead = 0;
-  std::shared_ptr<SerializedValues> serialized_values =
-      SerializedValues::NewFromBuffer(
-          internal->mappedBuffer.data() + trieSize,
-          internal->mappedBuffer.size() - trieSize, &valuesBytesRead);
-  valuesLexicon = serialized_values->GetLexicon();
+  if (internal->format == Format::Ocd3) {
+    const size_t valuesOffset = trieSize + (kOcd3SectionAlignment -
+                                            trieSize % kOcd3SectionAlignment) %
+                                               kOcd3SectionAlignment;
+    if (valuesOffset > size) {
+      throw InvalidFormat(
+          "Invalid OpenCC Marisa dictionary (trie exceeds file size)");
+    }
+    internal->values = SerializedValues::NewViewFromFlatBuffer(
+        data + valuesOffset, size - valuesOffset, &valuesBytesRead);
+  } else {
+    internal->values = SerializedValues::NewViewFromBuffer(
+        data + trieSize, size - trieSize, &valuesBytesRead);
+  }
+  internal->hasValues = true;
   // Validate key count consistency
   size_t numKeys = internal->marisa->num_keys();
-  if (numKeys != valuesLexicon->Length()) {
+  if (numKeys != internal->values.Length()) {
     throw InvalidFormat(
         "Invalid OpenCC Marisa dictionary (key count mismatch)");
   }
-  maxLength = 128;
   lexiconReconstructed.store(false, std::memory_order_release);
 }
 
 
+MarisaDictPtr MarisaDict::NewFromDict(const Dict& thatDict, Format format) {
+  MarisaDictPtr dict = NewFromDict(thatDict);
+  dict->internal->format = format;
+  return dict;
+}
+
+MarisaDict::Format MarisaDict::GetFormat() const { return internal->format; }
+
 MarisaDictPtr MarisaDict::NewFromDict(const Dict& thatDict) {
   // Extract lexicon into marisa::Keyset and a map.
   const LexiconPtr& thatLexicon = thatDict.GetLexicon();
@@ -246,16 +427,30 @@ MarisaDictPtr MarisaDict::NewFromDict(const Dict& thatDict) {
   }
   // Set lexicon with entries ordered by Marisa Trie key id.
   dict->lexicon.reset(new Lexicon(std::move(entries)));
-  dict->maxLength = maxLength;
+  dict->internal->keyMaxLength.store(maxLength, std::memory_order_relaxed);
   dict->lexiconReconstructed.store(true, std::memory_order_release);
   return dict;
 }
 
 void MarisaDict::SerializeToFile(FILE* fp) const {
-  fwrite(OCD2_HEADER, sizeof(char), strlen(OCD2_HEADER), fp);
-  marisa::fwrite(fp, *internal->marisa);
   std::unique_ptr<SerializedValues> serialized_values(
       new SerializedValues(GetLexicon()));
+  if (internal->format == Format::Ocd3) {
+    char header[kOcd3HeaderSize] = {};
+    memcpy(header, OCD3_HEADER, strlen(OCD3_HEADER));
+    fwrite(header, sizeof(char), kOcd3HeaderSize, fp);
+    marisa::fwrite(fp, *internal->marisa);
+    const size_t trieSize = internal->marisa->io_size();
+    const char padding[kOcd3SectionAlignment] = {};
+    fwrite(padding, sizeof(char),
+           (kOcd3SectionAlignment - trieSize % kOcd3SectionAlignment) %
+               kOcd3SectionAlignment,
+           fp);
+    serialized_values->SerializeFlatToFile(fp);
+    return;
+  }
+  fwrite(OCD2_HEADER, sizeof(char), strlen(OCD2_HEADER), fp);
+  marisa::fwrite(fp, *internal->marisa);
   serialized_values->SerializeToFile(fp);
 }
 
@@ -291,6 +486,42 @@ bool MarisaDict::EnumerateKeys(
   return true;
 }
 
+bool MarisaDict::EnumerateEntries(
+    const std::function<bool(std::string_view key, std::string_view value)>&
+        cb) const {
+  if (!internal->hasValues) {
+    // Built by NewFromDict(), which keeps its entries in the lexicon.
+    if (lexicon == nullptr) {
+      return false;
+    }
+    for (const std::unique_ptr<DictEntry>& entry : *lexicon) {
+      if (!cb(entry->KeyView(), entry->GetDefaultView())) {
+        break;
+      }
+    }
+    return true;
+  }
+  const SerializedValues::ValuesView& values = internal->values;
+  try {
+    marisa::Agent agent;
+    agent.set_query("");
+    while (internal->marisa->predictive_search(agent)) {
+      const std::string_view key(agent.key().ptr(), agent.key().length());
+      const size_t id = agent.key().id();
+      if (id >= values.Length()) {
+        throw InvalidFormat(
+            "Invalid OpenCC Marisa dictionary (key id out of bounds)");
+      }
+      if (!cb(key, values.NumValues(id) == 0 ? key : values.Value(id, 0))) {
+        break;
+      }
+    }
+  } catch (const marisa::Exception&) {
+    return false;
+  }
+  return true;
+}
+
 PrefixMatchView MarisaDict::MatchPrefixValue(const char* word,
                                              size_t len) const {
   const marisa::Trie* trie = internal->marisa.get();
@@ -313,21 +544,26 @@ PrefixMatchView MarisaDict::MatchPrefixValue(const char* word,
   if (!matched) {
     return PrefixMatchView{};
   }
-  // value view points directly into the DictEntry's owned string storage,
-  // valid for the lifetime of this dictionary.
-  if (valuesLexicon != nullptr) {
-    if (matchedId < valuesLexicon->Length()) {
-      return PrefixMatchView{true, matchedLength,
-                             std::string_view(word, matchedLength),
-                             valuesLexicon->At(matchedId)->GetDefaultView()};
+  return MatchedValue(word, matchedId, matchedLength);
+}
+
+PrefixMatchView MarisaDict::MatchedValue(const char* word, size_t id,
+                                         size_t length) const {
+  // value view points directly into the loaded buffer, valid for the
+  // lifetime of this dictionary.
+  const SerializedValues::ValuesView& values = internal->values;
+  if (internal->hasValues) {
+    if (id < values.Length()) {
+      return PrefixMatchView{true, length, std::string_view(word, length),
+                             values.NumValues(id) > 0 ? values.Value(id, 0)
+                                                      : std::string_view()};
     }
     return PrefixMatchView{};
   }
   LexiconPtr lex = GetLexicon();
-  if (lex != nullptr && matchedId < lex->Length()) {
-    return PrefixMatchView{true, matchedLength,
-                           std::string_view(word, matchedLength),
-                           lex->At(matchedId)->GetDefaultView()};
+  if (lex != nullptr && id < lex->Length()) {
+    return PrefixMatchView{true, length, std::string_view(word, length),
+                           lex->At(id)->GetDefaultView()};
   }
   return PrefixMatchView{};
 }
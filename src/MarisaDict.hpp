@@ -21,6 +21,7 @@
 #include <atomic>
 #include <functional>
 #include <mutex>
+#include <string_view>
 
 #include "Common.hpp"
 #include "SerializableDict.hpp"
@@ -36,6 +37,21 @@ namespace opencc {
  */
 class OPENCC_EXPORT MarisaDict : public Dict, public SerializableDict {
 public:
+  /**
+   * On-disk layouts. Loading detects the layout from the file header;
+   * SerializeToFile() writes the layout the dictionary was loaded from or
+   * created with.
+   */
+  enum class Format {
+    /** OCD2: values are stored as a length table that is decoded at load. */
+    Ocd2,
+    /**
+     * OCD3: an aligned header, the trie, and values as flat offset tables
+     * plus a string pool that are read in place without decoding.
+     */
+    Ocd3,
+  };
+
   virtual ~MarisaDict() override;
 
   virtual size_t KeyMaxLength() const override;
@@ -49,6 +65,10 @@ public:
   virtual std::vector<const DictEntry*> MatchAllPrefixes(
       const char* word, size_t len) const override;
 
+  /**
+   * Copies every entry of a loaded dictionary into a Lexicon on the first
+   * call. Lookups never need it: they read keys and values in place.
+   */
   virtual LexiconPtr GetLexicon() const override;
 
   virtual bool SupportsFastPrefixMatch() const override { return true; }
@@ -65,6 +85,17 @@ public:
    */
   bool EnumerateKeys(const std::function<void(const char*, size_t)>& cb) const;
 
+  /**
+   * Enumerates every key with its default value (the key for an entry
+   * without values) by walking the trie and reading the values of each key
+   * id in place, so it does not trigger lexicon reconstruction either. Both
+   * views are valid only during the callback, which returns false to stop
+   * the walk. Returns false when the trie is unavailable.
+   */
+  bool EnumerateEntries(const std::function<bool(std::string_view key,
+                                                 std::string_view value)>& cb)
+      const;
+
   virtual void SerializeToFile(FILE* fp) const override;
 
   /**
@@ -72,10 +103,36 @@ public:
    */
   static MarisaDictPtr NewFromDict(const Dict& thatDict);
 
+  /**
+   * Constructs a MarisaDict from another dictionary, to be serialized in
+   * @p format.
+   */
+  static MarisaDictPtr NewFromDict(const Dict& thatDict, Format format);
+
+  /** Returns the on-disk layout of this dictionary. */
+  Format GetFormat() const;
+
+  /**
+   * Loads the dictionary from @p fp. Where the platform allows, the file is
+   * memory-mapped instead of read, so processes loading the same file share
+   * its pages and values are not copied.
+   */
   static MarisaDictPtr NewFromFile(FILE* fp);
 
+  /**
+   * Loads the dictionary from a private copy of @p data.
+   */
   static MarisaDictPtr NewFromBuffer(const char* data, size_t size);
 
+  /**
+   * Loads the dictionary from @p data without copying it. Values are read
+   * straight from the buffer, and the trie is mapped in place when the
+   * buffer is suitably aligned. @p owner keeps the buffer alive for the
+   * lifetime of the dictionary.
+   */
+  static MarisaDictPtr NewFromSharedBuffer(const char* data, size_t size,
+                                           std::shared_ptr<const void> owner);
+
   // Exposed for testing only.
   bool IsLexiconReconstructed() const {
     return lexiconReconstructed.load(std::memory_order_acquire);
@@ -84,14 +141,15 @@ public:
 private:
   MarisaDict();
 
-  void LoadFromMappedBuffer();
+  void LoadFromBuffer(const char* data, size_t size);
   void ReconstructLexicon() const;
+  const DictEntry* EntryAt(size_t id) const;
+  PrefixMatchView MatchedValue(const char* word, size_t id,
+                               size_t length) const;
 
-  mutable size_t maxLength;
   mutable LexiconPtr lexicon;
   mutable std::mutex lexiconMutex;
   mutable std::atomic<bool> lexiconReconstructed;
-  LexiconPtr valuesLexicon;
 
   class MarisaInternal;
   std::unique_ptr<MarisaInternal> internal;
@@ -16,7 +16,12 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "MarisaDict.hpp"
 #include "TestUtilsUTF8.hpp"
@@ -27,11 +32,20 @@ namespace opencc {
 class MarisaDictTest : public TextDictTestBase {
 protected:
   MarisaDictTest()
-      : dict(MarisaDict::NewFromDict(*textDict)), fileName("dict.ocd2"){};
+      : dict(MarisaDict::NewFromDict(*textDict)),
+        fileName(TempFileName("dict.ocd2")){};
+
+  // Files go to the temporary directory, not the working directory, which
+  // may be the source tree.
+  static std::string TempFileName(const std::string& name) {
+    return (std::filesystem::temp_directory_path() /
+            ("opencc_marisa_dict_test_" + name))
+        .string();
+  }
 
   // Write a crafted OCD2 file with a valid header but corrupt trie data.
   static std::string WriteMalformedMarisaFile() {
-    const std::string path = "malformed_marisa.ocd2";
+    const std::string path = TempFileName("malformed_marisa.ocd2");
     FILE* fp = fopen(path.c_str(), "wb");
     const char* header = "OPENCC_MARISA_0.2.5";
     fwrite(header, sizeof(char), strlen(header), fp);
@@ -107,6 +121,98 @@ TEST_F(MarisaDictTest, MatchPrefix) {
   }
 }
 
+TEST_F(MarisaDictTest, SharedBufferReferencesCallerMemory) {
+  dict->opencc::SerializableDict::SerializeToFile(fileName);
+  FILE* fp = fopen(fileName.c_str(), "rb");
+  ASSERT_NE(nullptr, fp);
+  std::string content;
+  char chunk[4096];
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+    content.append(chunk, length);
+  }
+  fclose(fp);
+
+  // Offsets 0 and 5 put the trie at an aligned and a misaligned address
+  // (the header is 19 bytes), covering both the in-place mapping and the
+  // copying fallback.
+  for (size_t shift : {static_cast<size_t>(5), static_cast<size_t>(0)}) {
+    std::shared_ptr<std::string> buffer =
+        std::make_shared<std::string>(shift, '\0');
+    buffer->append(content);
+    const char* data = buffer->data() + shift;
+    const MarisaDictPtr shared =
+        MarisaDict::NewFromSharedBuffer(data, content.size(), buffer);
+    buffer.reset();
+
+    const PrefixMatchView matched = shared->MatchPrefixValue("清華", 6);
+    ASSERT_TRUE(matched.matched);
+    EXPECT_EQ(utf8("Tsinghua"), std::string(matched.value));
+    EXPECT_FALSE(shared->IsLexiconReconstructed());
+    TestDict(shared);
+  }
+}
+
+TEST_F(MarisaDictTest, Ocd3RoundTrip) {
+  const std::string ocd3FileName = TempFileName("dict.ocd3");
+  const MarisaDictPtr ocd3Dict =
+      MarisaDict::NewFromDict(*textDict, MarisaDict::Format::Ocd3);
+  ocd3Dict->opencc::SerializableDict::SerializeToFile(ocd3FileName);
+
+  const MarisaDictPtr& deserialized =
+      SerializableDict::NewFromFile<MarisaDict>(ocd3FileName);
+  EXPECT_EQ(MarisaDict::Format::Ocd3, deserialized->GetFormat());
+  const PrefixMatchView matched = deserialized->MatchPrefixValue("清華", 6);
+  ASSERT_TRUE(matched.matched);
+  EXPECT_EQ(utf8("Tsinghua"), std::string(matched.value));
+  EXPECT_FALSE(deserialized->IsLexiconReconstructed());
+  TestDict(deserialized);
+
+  const LexiconPtr& lex1 = dict->GetLexicon();
+  const LexiconPtr& lex2 = deserialized->GetLexicon();
+  ASSERT_EQ(lex1->Length(), lex2->Length());
+  for (size_t i = 0; i < lex1->Length(); i++) {
+    EXPECT_EQ(lex1->At(i)->Key(), lex2->At(i)->Key());
+    EXPECT_EQ(lex1->At(i)->Values(), lex2->At(i)->Values());
+  }
+  std::remove(ocd3FileName.c_str());
+}
+
+TEST_F(MarisaDictTest, LookupsDoNotReconstructLexicon) {
+  dict->opencc::SerializableDict::SerializeToFile(fileName);
+  const MarisaDictPtr& deserialized =
+      SerializableDict::NewFromFile<MarisaDict>(fileName);
+  EXPECT_EQ(dict->KeyMaxLength(), deserialized->KeyMaxLength());
+  TestDict(deserialized);
+  const Optional<const DictEntry*> entry =
+      DictPtr(deserialized)->Match(utf8("清華"));
+  ASSERT_FALSE(entry.IsNull());
+  EXPECT_EQ(utf8("清華\tTsinghua"), entry.Get()->ToString());
+
+  std::vector<std::pair<std::string, std::string>> entries;
+  EXPECT_TRUE(deserialized->EnumerateEntries(
+      [&entries](std::string_view key, std::string_view value) {
+        entries.emplace_back(key, value);
+        return true;
+      }));
+  EXPECT_FALSE(deserialized->IsLexiconReconstructed());
+
+  std::vector<std::pair<std::string, std::string>> expected;
+  for (const std::unique_ptr<DictEntry>& item : *textDict->GetLexicon()) {
+    expected.emplace_back(item->Key(), item->GetDefault());
+  }
+  std::sort(entries.begin(), entries.end());
+  EXPECT_EQ(expected, entries);
+
+  size_t visited = 0;
+  EXPECT_TRUE(deserialized->EnumerateEntries(
+      [&visited](std::string_view, std::string_view) {
+        visited++;
+        return false;
+      }));
+  EXPECT_EQ(1u, visited);
+}
+
 // Test that corrupt marisa trie data triggers InvalidFormat (#814, #817).
 TEST_F(MarisaDictTest, RejectsCorruptTrieData) {
   std::string path = WriteMalformedMarisaFile();
@@ -25,18 +25,20 @@ using namespace opencc;
 
 namespace {
 
-SegmentsPtr SegmentText(const std::shared_ptr<PrefixMatch>& prefixMatch,
-                        std::string_view text) {
-  SegmentsPtr segments(new Segments);
+void SegmentText(const PrefixMatch& prefixMatch, std::string_view text,
+                 std::vector<SegmentSpan>* spans) {
+  spans->clear();
   if (text.empty()) {
-    return segments;
+    return;
   }
 
-  const char* segStart = text.data();
+  const char* textStart = text.data();
+  const char* segStart = textStart;
   size_t segLength = 0;
-  auto clearBuffer = [&segments, &segStart, &segLength]() {
+  auto clearBuffer = [spans, textStart, &segStart, &segLength]() {
     if (segLength > 0) {
-      segments->AddSegment(std::string_view(segStart, segLength));
+      spans->push_back(
+          SegmentSpan{static_cast<size_t>(segStart - textStart), segLength});
       segLength = 0;
     }
   };
@@ -44,7 +46,7 @@ SegmentsPtr SegmentText(const std::shared_ptr<PrefixMatch>& prefixMatch,
   for (const char* pstr = text.data(); pstr < textEnd;) {
     size_t remainingLength = textEnd - pstr;
     const PrefixMatchView matched =
-        prefixMatch->MatchPrefixView(pstr, remainingLength);
+        prefixMatch.MatchPrefixView(pstr, remainingLength);
     size_t matchedLength;
     if (!matched.matched) {
       matchedLength =
@@ -60,19 +62,22 @@ SegmentsPtr SegmentText(const std::shared_ptr<PrefixMatch>& prefixMatch,
       // Extend the unmatched run over characters that cannot begin any
       // dictionary key; each of them would fail the prefix lookup, so they
       // are consumed with a single bulk scan.
-      matchedLength += prefixMatch->SkipUnmatchable(
+      matchedLength += prefixMatch.SkipUnmatchable(
           pstr + matchedLength, remainingLength - matchedLength);
       segLength += matchedLength;
     } else {
       clearBuffer();
       matchedLength = matched.keyLength;
-      segments->AddSegment(matched.key);
+      if (matchedLength > remainingLength) {
+        matchedLength = remainingLength;
+      }
+      spans->push_back(SegmentSpan{static_cast<size_t>(pstr - textStart),
+                                   matchedLength});
       segStart = pstr + matchedLength;
     }
     pstr += matchedLength;
   }
   clearBuffer();
-  return segments;
 }
 
 } // namespace
@@ -80,6 +85,22 @@ SegmentsPtr SegmentText(const std::shared_ptr<PrefixMatch>& prefixMatch,
 MaxMatchSegmentation::MaxMatchSegmentation(const DictPtr _dict)
     : dict(_dict), prefixMatch(new PrefixMatch(_dict)) {}
 
+MaxMatchSegmentation::MaxMatchSegmentation(
+    const DictPtr _dict, std::shared_ptr<PrefixMatch> _prefixMatch)
+    : dict(_dict), prefixMatch(_prefixMatch) {}
+
 SegmentsPtr MaxMatchSegmentation::Segment(std::string_view text) const {
-  return SegmentText(prefixMatch, text);
+  std::vector<SegmentSpan> spans;
+  SegmentText(*prefixMatch, text, &spans);
+  SegmentsPtr segments(new Segments);
+  for (const SegmentSpan& span : spans) {
+    segments->AddSegment(text.substr(span.offset, span.length));
+  }
+  return segments;
+}
+
+bool MaxMatchSegmentation::SegmentSpans(
+    std::string_view text, std::vector<SegmentSpan>* spans) const {
+  SegmentText(*prefixMatch, text, spans);
+  return true;
 }
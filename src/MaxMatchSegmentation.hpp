@@ -33,10 +33,21 @@ public:
 
   MaxMatchSegmentation(const DictPtr _dict);
 
+  /**
+   * Constructs a segmentation over @p dict that looks keys up through
+   * @p prefixMatch, which must have been built for @p dict (e.g. restored
+   * from a converter snapshot).
+   */
+  MaxMatchSegmentation(const DictPtr _dict,
+                       std::shared_ptr<PrefixMatch> _prefixMatch);
+
   virtual ~MaxMatchSegmentation() {}
 
   SegmentsPtr Segment(std::string_view text) const override;
 
+  bool SegmentSpans(std::string_view text,
+                    std::vector<SegmentSpan>* spans) const override;
+
   const DictPtr GetDict() const { return dict; }
 
 private:
@@ -120,4 +120,23 @@ TEST_F(MaxMatchSegmentationTest, TruncatedUtf8Sequence) {
   });
 }
 
+TEST_F(MaxMatchSegmentationTest, SegmentSpansMatchSegment) {
+  const std::string text = utf8("Hello, 太后的头发干燥。") + "\xE4\xB8";
+  std::vector<SegmentSpan> spans = {SegmentSpan{7, 7}};
+  ASSERT_TRUE(segmenter->SegmentSpans(text, &spans));
+  const auto& segments = segmenter->Segment(text);
+  ASSERT_EQ(segments->Length(), spans.size());
+  size_t offset = 0;
+  for (size_t i = 0; i < spans.size(); i++) {
+    EXPECT_EQ(offset, spans[i].offset);
+    EXPECT_EQ(std::string(segments->At(i)),
+              text.substr(spans[i].offset, spans[i].length));
+    offset += spans[i].length;
+  }
+  EXPECT_EQ(text.size(), offset);
+
+  ASSERT_TRUE(segmenter->SegmentSpans("", &spans));
+  EXPECT_TRUE(spans.empty());
+}
+
 } // namespace opencc
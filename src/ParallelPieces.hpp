@@ -0,0 +1,94 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace opencc {
+namespace internal {
+
+/**
+ * Returns @p threads, or the hardware concurrency if it is 0, and at least 1.
+ */
+inline size_t ResolveThreadCount(size_t threads) {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  return (std::max<size_t>)(1, threads);
+}
+
+/**
+ * Calls runPiece(i) for every i < pieceCount on up to @p threads threads,
+ * including the calling thread, and rethrows the first exception on the
+ * calling thread. Threads take the next unclaimed piece as they finish.
+ * Private (non-installed) header.
+ */
+inline void RunPieces(size_t pieceCount, size_t threads,
+                      const std::function<void(size_t)>& runPiece) {
+  if (pieceCount == 0) {
+    return;
+  }
+  std::atomic<size_t> nextPiece(0);
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto worker = [&]() {
+    for (size_t i = nextPiece++; i < pieceCount; i = nextPiece++) {
+      try {
+        runPiece(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        nextPiece = pieceCount;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  const size_t workerCount = std::min(threads, pieceCount) - 1;
+  workers.reserve(workerCount);
+  for (size_t i = 0; i < workerCount; i++) {
+    try {
+      workers.emplace_back(worker);
+    } catch (const std::system_error&) {
+      // Out of threads: the calling thread and any started workers finish
+      // the remaining pieces.
+      break;
+    }
+  }
+  worker();
+  for (std::thread& thread : workers) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace internal
+} // namespace opencc
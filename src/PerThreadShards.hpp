@@ -0,0 +1,114 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace opencc {
+namespace internal {
+
+/**
+ * One @p Shard per thread that has called Local(), owned by a collector such
+ * as ConverterStats, so that threads recording into the same collector never
+ * write to shared cache lines. ForEach() visits the shards of all threads,
+ * including threads that have exited.
+ *
+ * Each thread caches its shards by collector id; ids are never reused, so a
+ * cached shard of a destroyed collector is never mistaken for a live one.
+ * Private (non-installed) header.
+ */
+template <typename Shard> class PerThreadShards {
+public:
+  PerThreadShards() : id(NextId()) {}
+
+  PerThreadShards(const PerThreadShards&) = delete;
+  PerThreadShards& operator=(const PerThreadShards&) = delete;
+
+  /** Returns the calling thread's shard, creating it on first use. */
+  Shard& Local() {
+    ThreadCache& cache = CurrentThreadCache();
+    if (cache.lastId == id) {
+      return *cache.last;
+    }
+    for (const auto& entry : cache.shards) {
+      if (entry.first == id) {
+        // The collector is alive, so is its shard.
+        cache.lastId = id;
+        cache.last = entry.second.lock().get();
+        return *cache.last;
+      }
+    }
+    std::shared_ptr<Shard> shard(new Shard);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      shards.push_back(shard);
+    }
+    // Forget shards of destroyed collectors.
+    cache.shards.erase(
+        std::remove_if(cache.shards.begin(), cache.shards.end(),
+                       [](const std::pair<uint64_t, std::weak_ptr<Shard>>&
+                              entry) { return entry.second.expired(); }),
+        cache.shards.end());
+    cache.shards.emplace_back(id, shard);
+    cache.lastId = id;
+    cache.last = shard.get();
+    return *shard;
+  }
+
+  /**
+   * Calls @p visit on every shard. Shards may be written concurrently, so
+   * @p visit must only touch fields that are atomic or guarded by the shard.
+   */
+  template <typename Visit> void ForEach(Visit visit) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const std::shared_ptr<Shard>& shard : shards) {
+      visit(*shard);
+    }
+  }
+
+private:
+  struct ThreadCache {
+    uint64_t lastId = 0;
+    Shard* last = nullptr;
+    std::vector<std::pair<uint64_t, std::weak_ptr<Shard>>> shards;
+  };
+
+  static ThreadCache& CurrentThreadCache() {
+    static thread_local ThreadCache cache;
+    return cache;
+  }
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> nextId(1);
+    return nextId++;
+  }
+
+  const uint64_t id;
+  mutable std::mutex mutex;
+  std::vector<std::shared_ptr<Shard>> shards;
+};
+
+} // namespace internal
+} // namespace opencc
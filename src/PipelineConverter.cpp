@@ -17,10 +17,15 @@
  */
 
 #include "PipelineConverter.hpp"
+#include "ScratchString.hpp"
 
 using namespace opencc;
 
 std::string PipelineConverter::Convert(std::string_view text) const {
+  std::string converted;
+  if (AppendConvertedIfRecording(text, &converted)) {
+    return converted;
+  }
   if (stages.empty()) {
     return std::string(text);
   }
@@ -32,6 +37,46 @@ std::string PipelineConverter::Convert(std::string_view text) const {
   return result;
 }
 
+void PipelineConverter::AppendConverted(std::string_view text,
+                                        std::string* output) const {
+  if (AppendConvertedIfRecording(text, output)) {
+    return;
+  }
+  if (stages.empty()) {
+    output->append(text);
+    return;
+  }
+  // Intermediate stages alternate between two scratch buffers; only the last
+  // stage writes to output.
+  internal::ScratchString buffers[2];
+  std::string_view current = text;
+  for (size_t i = 0; i + 1 < stages.size(); i++) {
+    std::string& next = buffers[i % 2].value;
+    next.clear();
+    stages[i]->AppendConverted(current, &next);
+    current = next;
+  }
+  stages.back()->AppendConverted(current, output);
+}
+
+void PipelineConverter::AppendConvertedProfiled(
+    std::string_view text, std::string* output,
+    ConversionProfile* profile) const {
+  if (stages.empty()) {
+    output->append(text);
+    return;
+  }
+  internal::ScratchString buffers[2];
+  std::string_view current = text;
+  for (size_t i = 0; i + 1 < stages.size(); i++) {
+    std::string& next = buffers[i % 2].value;
+    next.clear();
+    stages[i]->AppendConvertedProfiled(current, &next, profile);
+    current = next;
+  }
+  stages.back()->AppendConvertedProfiled(current, output, profile);
+}
+
 ConversionInspectionResult
 PipelineConverter::Inspect(std::string_view text) const {
   ConversionInspectionResult result;
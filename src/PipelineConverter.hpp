@@ -47,6 +47,17 @@ public:
 
   std::string Convert(std::string_view text) const override;
 
+  void AppendConverted(std::string_view text,
+                       std::string* output) const override;
+
+  /**
+   * Runs every stage through its own AppendConvertedProfiled(), so the
+   * stages of all conversion chains are numbered consecutively in
+   * @p profile.
+   */
+  void AppendConvertedProfiled(std::string_view text, std::string* output,
+                               ConversionProfile* profile) const override;
+
   /**
    * Returns an inspection result with @c input and @c output populated.
    * Per-stage segment detail is not available at the pipeline level.
@@ -59,6 +70,9 @@ public:
   /** Always returns @c nullptr; a pipeline has no single conversion chain. */
   ConversionChainPtr GetConversionChain() const override { return nullptr; }
 
+  /** Returns the stages in the order they are applied. */
+  const std::vector<ConverterPtr>& GetStages() const { return stages; }
+
 private:
   const std::vector<ConverterPtr> stages;
 };
@@ -17,15 +17,21 @@
  */
 
 #include "PrefixMatch.hpp"
+#include "CharacterMap.hpp"
 #include "Dict.hpp"
+#include "DictEntries.hpp"
 #include "DictGroup.hpp"
+#include "Exception.hpp"
 #include "Lexicon.hpp"
-#include "MarisaDict.hpp"
 #include "UTF8Util.hpp"
 #include "Utf8SkipScan.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <mutex>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -50,6 +56,66 @@ uint32_t Utf8CharKey(const char* str, size_t charLen) {
   return key;
 }
 
+// Serialized tables layout (native byte order, every field 4-byte aligned
+// relative to the start of the tables):
+//   uint32_t flags (kHasMatcher | kAsciiHasCandidates | kCharLevel |
+//                   kAstralLevel)
+//   uint8_t  candidate[256]
+//   uint64_t bmpCandidates[1024]                  (only with kCharLevel)
+//   uint32_t numAstralBlocks                      (only with kAstralLevel)
+//   uint16_t astralBlocks[256]                    (only with kAstralLevel)
+//   uint64_t astralCandidates[numAstralBlocks * 64]
+//                                                (only with kAstralLevel)
+//   matcher                                      (only with kHasMatcher)
+// matcher:
+//   uint32_t kind (kLeafMatcher, kGroupMatcher or kCharacterMapMatcher)
+//   leaf:  uint32_t numNodes, numCandidates, arenaLength
+//          Node nodes[numNodes], uint32_t childKeys[numNodes],
+//          StoredCandidate candidates[numCandidates],
+//          char arena[arenaLength], zero padding to a multiple of 4
+//   group: uint32_t matchPolicy, numChildren, matcher children[numChildren]
+//   character map: uint32_t numValues, arenaLength,
+//          CharacterMap::Value values[numValues],
+//          char arena[arenaLength], zero padding to a multiple of 4
+const uint32_t kHasMatcher = 1;
+const uint32_t kAsciiHasCandidates = 2;
+const uint32_t kCharLevel = 4;
+// Tables written without it keep lead-byte filtering for 4-byte characters.
+const uint32_t kAstralLevel = 8;
+const uint32_t kLeafMatcher = 0;
+const uint32_t kGroupMatcher = 1;
+const uint32_t kCharacterMapMatcher = 2;
+// Bounds recursion on corrupt input; real configs nest groups a few levels.
+const int kMaxSerializedGroupDepth = 32;
+
+template <typename INT_TYPE> void WriteInteger(FILE* fp, INT_TYPE num) {
+  if (fwrite(&num, sizeof(INT_TYPE), 1, fp) != 1) {
+    throw InvalidFormat("Cannot write prefix match tables.");
+  }
+}
+
+void WriteBytes(FILE* fp, const void* data, size_t size) {
+  if (size > 0 && fwrite(data, 1, size, fp) != size) {
+    throw InvalidFormat("Cannot write prefix match tables.");
+  }
+}
+
+const char* ReadBytes(const char* data, size_t size, size_t* offset,
+                      uint64_t length) {
+  if (length > size - *offset) {
+    throw InvalidFormat("Invalid prefix match tables (truncated)");
+  }
+  const char* bytes = data + *offset;
+  *offset += static_cast<size_t>(length);
+  return bytes;
+}
+
+uint32_t ReadUInt32(const char* data, size_t size, size_t* offset) {
+  uint32_t num;
+  memcpy(&num, ReadBytes(data, size, offset, sizeof(num)), sizeof(num));
+  return num;
+}
+
 } // namespace
 
 class PrefixMatch::Tables {
@@ -57,6 +123,8 @@ public:
   class Matcher;
   std::unique_ptr<Matcher> matcher;
   internal::Utf8SkipTable skip;
+  // Keeps the buffer that restored matchers point into alive.
+  std::shared_ptr<const void> owner;
 };
 
 namespace {
@@ -64,9 +132,6 @@ namespace {
 struct CacheEntry {
   std::vector<std::weak_ptr<const Dict>> dicts;
   std::weak_ptr<const PrefixMatch::Tables> tables;
-  // Fast-path Tables carry no matcher; never hand one to the table path
-  // (and vice versa), independently of the cache-key encoding.
-  bool fastPath = false;
 };
 
 bool SameOwner(const std::weak_ptr<const Dict>& cached,
@@ -129,63 +194,10 @@ void Unreachable() {
 #endif
 }
 
-// Marks a single key's first character in the skip table: the lead byte
-// always, plus the exact first code point for 2- and 3-byte characters so
-// scanning can filter at character granularity. Uses the same decoder as the
-// scanner (internal::DecodeCodePoint23) so a key's first character always
-// maps to the bit the scanner will test. A key whose first character is
-// truncated or invalid cannot be represented as a code point; character
-// filtering is then disabled for the whole table and lead-byte filtering
-// (which stops at the marked lead) remains in effect.
-void MarkKeyFirstChar(internal::Utf8SkipTable* table, const char* key,
-                      size_t len) {
-  if (len == 0) {
-    return;
-  }
-  // key may come straight from a trie enumeration buffer (e.g. marisa's
-  // Agent) and is NOT NUL-terminated. NextCharLengthNoException() reads only
-  // the lead byte, and DecodeCodePoint23() reads at most charLength bytes,
-  // which is checked against len first — no read may pass key + len.
-  const unsigned char lead = static_cast<unsigned char>(key[0]);
-  table->candidate[lead] = true;
-  if (lead < 0x80) {
-    return;
-  }
-  const size_t charLength = UTF8Util::NextCharLengthNoException(key);
-  if (charLength == 0) {
-    // Invalid lead byte: the scanner stops at charLength == 0 before any
-    // candidate check, so the lead-byte mark alone is sufficient and
-    // character-level filtering can stay enabled.
-    return;
-  }
-  if (charLength > len) {
-    // Truncated first character: the key can still match its raw byte
-    // prefix, but the scanner would decode the code point using the text's
-    // following bytes and could skip such a position. This cannot be
-    // represented at character granularity, so fall back to lead-byte
-    // filtering (the marked lead stops the scan).
-    table->DisableCharLevel();
-    return;
-  }
-  if (charLength == 2 || charLength == 3) {
-    table->MarkCharCandidate(internal::DecodeCodePoint23(key, charLength));
-  }
-  // 4-byte (and longer legacy) first characters rely on lead-byte filtering.
-}
-
 // Recursively marks every key's first character into table: groups recurse
 // into children via GetDictGroupItems() (part of the Dict interface, so no
-// dynamic_cast needed); MarisaDict is special-cased with a dynamic_cast so
-// its keys can be walked directly from the trie without forcing lexicon
-// reconstruction; any other leaf dict enumerates through GetLexicon(), whose
-// contract (like LeafMatcher::AddDict's) assumes a non-null result. The
-// nullptr branch below is an untested defensive guard, kept for symmetry
-// with MarisaDict::EnumerateKeys() returning false when its trie is
-// unavailable; it cannot currently be exercised through PrefixMatch's public
-// API without a Dict subclass that violates the GetLexicon() contract
-// elsewhere too (BuildMatcher's LeafMatcher::AddDict dereferences it
-// unconditionally, so a real nullptr would already crash matcher
-// construction).
+// dynamic_cast needed) and leaf dicts are walked by EnumerateDictEntries(). A
+// leaf whose keys are unavailable marks every byte as a candidate.
 void CollectSkipTable(const DictPtr& dict, internal::Utf8SkipTable* table) {
   const std::list<DictPtr>* items = dict->GetDictGroupItems();
   if (items != nullptr) {
@@ -194,31 +206,20 @@ void CollectSkipTable(const DictPtr& dict, internal::Utf8SkipTable* table) {
     }
     return;
   }
-  const MarisaDict* marisaDict = dynamic_cast<const MarisaDict*>(dict.get());
-  if (marisaDict != nullptr) {
-    const bool enumerated =
-        marisaDict->EnumerateKeys([table](const char* key, size_t len) {
-          MarkKeyFirstChar(table, key, len);
-        });
-    if (!enumerated) {
-      table->MarkAllCandidates();
-    }
-    return;
-  }
-  const LexiconPtr lexicon = dict->GetLexicon();
-  if (lexicon == nullptr) {
+  const bool enumerated = internal::EnumerateDictEntries(
+      *dict, [table](std::string_view key, std::string_view) {
+        internal::MarkKeyFirstChar(table, key.data(), key.size());
+        return true;
+      });
+  if (!enumerated) {
     table->MarkAllCandidates();
-    return;
-  }
-  for (const std::unique_ptr<DictEntry>& entry : *lexicon) {
-    const std::string& key = entry->Key();
-    MarkKeyFirstChar(table, key.data(), key.length());
   }
 }
 
 // Builds the skip table for dict by enumerating every key at character
 // granularity; falls back to treating every byte as a candidate when any
-// leaf's keys are unavailable.
+// leaf's keys are unavailable. Only the fast path, which builds no matcher,
+// needs this walk; BuildMatcher() marks the table itself.
 void BuildSkipTable(const DictPtr& dict, internal::Utf8SkipTable* table) {
   table->EnableCharLevel();
   CollectSkipTable(dict, table);
@@ -232,94 +233,317 @@ public:
   struct Candidate {
     bool hasValue = false;
     size_t keyLength = 0;
-    const std::string* key = nullptr;
-    const std::string* value = nullptr;
+    std::string_view key;
+    std::string_view value;
   };
 
   virtual ~Matcher() {}
 
   virtual Candidate MatchPrefixCandidate(const char* word,
                                          size_t len) const = 0;
+
+  virtual void Serialize(FILE* fp) const = 0;
+
+  // Returns the map when every key is a single character, nullptr otherwise.
+  virtual const internal::CharacterMap* GetCharacterMap() const {
+    return nullptr;
+  }
+
+  // Restores a matcher written by Serialize(), advancing offset past it.
+  static std::unique_ptr<Matcher> NewFromBuffer(const char* data, size_t size,
+                                                size_t* offset, int depth);
 };
 
+// Character trie compiled into flat arrays. Entries are first inserted into a
+// temporary pointer-based builder trie, then Compile() lays the nodes out in
+// breadth-first order so that the children of every node occupy a contiguous
+// index range, sorted by character key. A lookup step is then a search over a
+// short run of uint32_t keys instead of a hash-map probe and a pointer chase,
+// and all keys and values live in a single string arena. Lookups go through
+// raw table pointers, which point either at the owned vectors or, for a
+// matcher restored by NewFromBuffer(), straight into the serialized buffer.
 class LeafMatcher : public PrefixMatch::Tables::Matcher {
 private:
+  static const uint32_t kNoCandidate = static_cast<uint32_t>(-1);
+  // Child runs up to this size are scanned linearly; longer runs (typically
+  // the root and a few common first characters) use binary search.
+  static const uint32_t kLinearScanLimit = 8;
+
+  struct Node {
+    uint32_t firstChild = 0;
+    uint32_t numChildren = 0;
+    uint32_t candidate = kNoCandidate;
+  };
+
   struct StoredCandidate {
-    bool hasValue = false;
-    size_t keyLength = 0;
-    std::string key;
-    std::string value;
+    uint32_t keyOffset;
+    uint32_t keyLength;
+    uint32_t valueOffset;
+    uint32_t valueLength;
   };
 
-  struct Node {
-    StoredCandidate candidate;
-    std::unordered_map<uint32_t, std::unique_ptr<Node>> children;
+  // Both are written to and read from serialized tables as-is.
+  static_assert(sizeof(Node) == 3 * sizeof(uint32_t), "unexpected padding");
+  static_assert(sizeof(StoredCandidate) == 4 * sizeof(uint32_t),
+                "unexpected padding");
+
+  struct BuilderNode {
+    uint32_t candidate = kNoCandidate;
+    std::unordered_map<uint32_t, std::unique_ptr<BuilderNode>> children;
   };
 
 public:
-  LeafMatcher() {}
+  LeafMatcher() : builderRoot(new BuilderNode) {}
+
+  // Streams the entries of dict from its storage, so a serialized dict
+  // never constructs its lexicon, marking the first character of each key
+  // into skip on the same walk.
+  void AddDict(const DictPtr& dict, internal::Utf8SkipTable* skip) {
+    const bool enumerated = internal::EnumerateDictEntries(
+        *dict, [this, skip](std::string_view key, std::string_view value) {
+          internal::MarkKeyFirstChar(skip, key.data(), key.size());
+          AddEntry(key, value);
+          return true;
+        });
+    if (!enumerated) {
+      skip->MarkAllCandidates();
+    }
+  }
 
-  void AddDict(const DictPtr& dict) {
-    const LexiconPtr lexicon = dict->GetLexicon();
-    for (const std::unique_ptr<DictEntry>& item : *lexicon) {
-      AddEntry(item->Key(), item->GetDefault());
+  // Freezes the trie into its flat representation. Must be called once after
+  // the last AddDict() and before any lookup.
+  void Compile() {
+    nodes.clear();
+    childKeys.clear();
+    nodes.emplace_back();
+    childKeys.push_back(0);
+    std::vector<const BuilderNode*> queue(1, builderRoot.get());
+    std::vector<std::pair<uint32_t, const BuilderNode*>> sortedChildren;
+    for (size_t i = 0; i < queue.size(); i++) {
+      const BuilderNode* builderNode = queue[i];
+      sortedChildren.clear();
+      for (const auto& child : builderNode->children) {
+        sortedChildren.emplace_back(child.first, child.second.get());
+      }
+      std::sort(sortedChildren.begin(), sortedChildren.end(),
+                [](const std::pair<uint32_t, const BuilderNode*>& a,
+                   const std::pair<uint32_t, const BuilderNode*>& b) {
+                  return a.first < b.first;
+                });
+      nodes[i].candidate = builderNode->candidate;
+      nodes[i].firstChild = static_cast<uint32_t>(nodes.size());
+      nodes[i].numChildren = static_cast<uint32_t>(sortedChildren.size());
+      for (const auto& child : sortedChildren) {
+        nodes.emplace_back();
+        childKeys.push_back(child.first);
+        queue.push_back(child.second);
+      }
     }
+    nodes.shrink_to_fit();
+    childKeys.shrink_to_fit();
+    candidates.shrink_to_fit();
+    arena.shrink_to_fit();
+    builderRoot.reset();
+    SetTables(nodes.data(), childKeys.data(), candidates.data(), arena.data(),
+              static_cast<uint32_t>(nodes.size()),
+              static_cast<uint32_t>(candidates.size()),
+              static_cast<uint32_t>(arena.size()));
+  }
+
+  void Serialize(FILE* fp) const override {
+    WriteInteger(fp, kLeafMatcher);
+    WriteInteger(fp, numNodes);
+    WriteInteger(fp, numCandidates);
+    WriteInteger(fp, arenaLength);
+    WriteBytes(fp, nodeTable, numNodes * sizeof(Node));
+    WriteBytes(fp, childKeyTable, numNodes * sizeof(uint32_t));
+    WriteBytes(fp, candidateTable, numCandidates * sizeof(StoredCandidate));
+    WriteBytes(fp, arenaData, arenaLength);
+    const uint32_t zero = 0;
+    WriteBytes(fp, &zero, (4 - arenaLength % 4) % 4);
+  }
+
+  // Restores a matcher written by Serialize() after its kind field. The
+  // tables are used in place when data is 4-byte aligned and copied
+  // otherwise; either way they are validated once so that lookups need no
+  // bounds checks.
+  static std::unique_ptr<LeafMatcher> NewFromBuffer(const char* data,
+                                                    size_t size,
+                                                    size_t* offset) {
+    const uint32_t numNodes = ReadUInt32(data, size, offset);
+    const uint32_t numCandidates = ReadUInt32(data, size, offset);
+    const uint32_t arenaLength = ReadUInt32(data, size, offset);
+    if (numNodes == 0) {
+      throw InvalidFormat("Invalid prefix match tables (no root node)");
+    }
+    const char* nodeBytes = ReadBytes(data, size, offset,
+                                      uint64_t(numNodes) * sizeof(Node));
+    const char* keyBytes = ReadBytes(data, size, offset,
+                                     uint64_t(numNodes) * sizeof(uint32_t));
+    const char* candidateBytes = ReadBytes(
+        data, size, offset, uint64_t(numCandidates) * sizeof(StoredCandidate));
+    const char* arenaBytes = ReadBytes(data, size, offset, arenaLength);
+    ReadBytes(data, size, offset, (4 - arenaLength % 4) % 4);
+
+    std::unique_ptr<LeafMatcher> leaf(new LeafMatcher);
+    leaf->builderRoot.reset();
+    if (reinterpret_cast<uintptr_t>(data) % alignof(uint32_t) == 0) {
+      leaf->SetTables(reinterpret_cast<const Node*>(nodeBytes),
+                      reinterpret_cast<const uint32_t*>(keyBytes),
+                      reinterpret_cast<const StoredCandidate*>(candidateBytes),
+                      arenaBytes, numNodes, numCandidates, arenaLength);
+    } else {
+      leaf->nodes.resize(numNodes);
+      memcpy(leaf->nodes.data(), nodeBytes, numNodes * sizeof(Node));
+      leaf->childKeys.resize(numNodes);
+      memcpy(leaf->childKeys.data(), keyBytes, numNodes * sizeof(uint32_t));
+      leaf->candidates.resize(numCandidates);
+      memcpy(leaf->candidates.data(), candidateBytes,
+             numCandidates * sizeof(StoredCandidate));
+      leaf->arena.assign(arenaBytes, arenaLength);
+      leaf->SetTables(leaf->nodes.data(), leaf->childKeys.data(),
+                      leaf->candidates.data(), leaf->arena.data(), numNodes,
+                      numCandidates, arenaLength);
+    }
+
+    for (uint32_t i = 0; i < numNodes; i++) {
+      const Node& node = leaf->nodeTable[i];
+      if (node.numChildren > numNodes ||
+          (node.numChildren > 0 &&
+           (node.firstChild == 0 ||
+            node.firstChild > numNodes - node.numChildren)) ||
+          (node.candidate != kNoCandidate && node.candidate >= numCandidates)) {
+        throw InvalidFormat("Invalid prefix match tables (node out of bounds)");
+      }
+    }
+    for (uint32_t i = 0; i < numCandidates; i++) {
+      const StoredCandidate& candidate = leaf->candidateTable[i];
+      if (candidate.keyOffset > arenaLength ||
+          candidate.keyLength > arenaLength - candidate.keyOffset ||
+          candidate.valueOffset > arenaLength ||
+          candidate.valueLength > arenaLength - candidate.valueOffset) {
+        throw InvalidFormat(
+            "Invalid prefix match tables (candidate out of bounds)");
+      }
+    }
+    return leaf;
   }
 
   Candidate MatchPrefixCandidate(const char* word, size_t len) const override {
-    const Node* node = &root;
-    const StoredCandidate* matchedCandidate = nullptr;
+    const Node* node = &nodeTable[0];
+    uint32_t matched = kNoCandidate;
     for (const char* pstr = word; pstr < word + len;) {
       const size_t remainingLength = word + len - pstr;
       const size_t charLength = Utf8CharLength(pstr, remainingLength);
       if (charLength == 0) {
         break;
       }
-      const auto child = node->children.find(Utf8CharKey(pstr, charLength));
-      if (child == node->children.end()) {
+      const uint32_t child =
+          FindChild(*node, Utf8CharKey(pstr, charLength));
+      if (child == 0) {
         break;
       }
       pstr += charLength;
-      node = child->second.get();
-      if (node->candidate.hasValue &&
-          (matchedCandidate == nullptr ||
-           node->candidate.keyLength > matchedCandidate->keyLength)) {
-        matchedCandidate = &node->candidate;
+      node = &nodeTable[child];
+      if (node->candidate != kNoCandidate &&
+          (matched == kNoCandidate ||
+           candidateTable[node->candidate].keyLength >
+               candidateTable[matched].keyLength)) {
+        matched = node->candidate;
       }
     }
-    if (matchedCandidate == nullptr) {
+    if (matched == kNoCandidate) {
       return Candidate{};
     }
-    return Candidate{true, matchedCandidate->keyLength,
-                     &matchedCandidate->key, &matchedCandidate->value};
+    const StoredCandidate& candidate = candidateTable[matched];
+    return Candidate{
+        true, candidate.keyLength,
+        std::string_view(arenaData + candidate.keyOffset, candidate.keyLength),
+        std::string_view(arenaData + candidate.valueOffset,
+                         candidate.valueLength)};
   }
 
 private:
-  void AddEntry(const std::string& key, const std::string& value) {
-    Node* node = &root;
-    for (const char* pstr = key.c_str(); *pstr != '\0';) {
-      const size_t remainingLength = key.c_str() + key.length() - pstr;
+  void SetTables(const Node* _nodes, const uint32_t* _childKeys,
+                 const StoredCandidate* _candidates, const char* _arena,
+                 uint32_t _numNodes, uint32_t _numCandidates,
+                 uint32_t _arenaLength) {
+    nodeTable = _nodes;
+    childKeyTable = _childKeys;
+    candidateTable = _candidates;
+    arenaData = _arena;
+    numNodes = _numNodes;
+    numCandidates = _numCandidates;
+    arenaLength = _arenaLength;
+  }
+
+  // Returns the index of node's child labelled key, or 0 (the root, which is
+  // never a child) if there is none.
+  uint32_t FindChild(const Node& node, uint32_t key) const {
+    const uint32_t* first = childKeyTable + node.firstChild;
+    const uint32_t* last = first + node.numChildren;
+    if (node.numChildren <= kLinearScanLimit) {
+      for (const uint32_t* it = first; it != last; ++it) {
+        if (*it == key) {
+          return static_cast<uint32_t>(it - childKeyTable);
+        }
+      }
+      return 0;
+    }
+    const uint32_t* it = std::lower_bound(first, last, key);
+    if (it != last && *it == key) {
+      return static_cast<uint32_t>(it - childKeyTable);
+    }
+    return 0;
+  }
+
+  void AddEntry(std::string_view key, std::string_view value) {
+    BuilderNode* node = builderRoot.get();
+    const char* end = key.data() + key.length();
+    for (const char* pstr = key.data(); pstr < end && *pstr != '\0';) {
+      const size_t remainingLength = end - pstr;
       const size_t charLength = Utf8CharLength(pstr, remainingLength);
       if (charLength == 0) {
         break;
       }
-      std::unique_ptr<Node>& child =
+      std::unique_ptr<BuilderNode>& child =
           node->children[Utf8CharKey(pstr, charLength)];
       if (child == nullptr) {
-        child.reset(new Node);
+        child.reset(new BuilderNode);
       }
       node = child.get();
       pstr += charLength;
     }
-    if (!node->candidate.hasValue) {
-      node->candidate.hasValue = true;
-      node->candidate.keyLength = key.length();
-      node->candidate.key = key;
-      node->candidate.value = value;
+    if (node->candidate == kNoCandidate) {
+      node->candidate = static_cast<uint32_t>(candidates.size());
+      StoredCandidate candidate;
+      candidate.keyOffset = static_cast<uint32_t>(arena.size());
+      candidate.keyLength = static_cast<uint32_t>(key.length());
+      arena.append(key);
+      candidate.valueOffset = static_cast<uint32_t>(arena.size());
+      candidate.valueLength = static_cast<uint32_t>(value.length());
+      arena.append(value);
+      candidates.push_back(candidate);
     }
   }
 
-  Node root;
+  // Only used while building; released by Compile().
+  std::unique_ptr<BuilderNode> builderRoot;
+  // Breadth-first node array; nodes[0] is the root. Empty when the tables
+  // are used in place from a serialized buffer.
+  std::vector<Node> nodes;
+  // childKeys[i] is the character key on the edge leading to nodes[i].
+  std::vector<uint32_t> childKeys;
+  std::vector<StoredCandidate> candidates;
+  std::string arena;
+  // The tables lookups read; set by Compile() or NewFromBuffer().
+  const Node* nodeTable = nullptr;
+  const uint32_t* childKeyTable = nullptr;
+  const StoredCandidate* candidateTable = nullptr;
+  const char* arenaData = nullptr;
+  uint32_t numNodes = 0;
+  uint32_t numCandidates = 0;
+  uint32_t arenaLength = 0;
 };
 
 class GroupMatcher : public PrefixMatch::Tables::Matcher {
@@ -331,6 +555,15 @@ public:
     children.push_back(std::move(child));
   }
 
+  void Serialize(FILE* fp) const override {
+    WriteInteger(fp, kGroupMatcher);
+    WriteInteger(fp, static_cast<uint32_t>(matchPolicy));
+    WriteInteger(fp, static_cast<uint32_t>(children.size()));
+    for (const std::unique_ptr<Matcher>& child : children) {
+      child->Serialize(fp);
+    }
+  }
+
   Candidate MatchPrefixCandidate(const char* word, size_t len) const override {
     switch (matchPolicy) {
     case DictGroupMatchPolicy::ShortCircuit:
@@ -369,67 +602,297 @@ private:
   const DictGroupMatchPolicy matchPolicy;
 };
 
-// Returns true if dict is a leaf dict, or if the entire subtree rooted at dict
-// consists only of union groups and leaf dicts (no short_circuit anywhere).
-// Union is associative, so such a tree is semantically equivalent to a single
-// flat union of all its leaf dicts: the longest match across all leaves wins,
-// which is exactly what a single LeafMatcher trie computes.
-bool CanFlattenAsUnion(const DictPtr& dict) {
+// Matcher of a dictionary (or group) whose keys are all single characters:
+// one CharacterMap lookup instead of a trie walk.
+class CharacterMapMatcher : public PrefixMatch::Tables::Matcher {
+public:
+  static_assert(sizeof(internal::CharacterMap::Value) == 3 * sizeof(uint32_t),
+                "unexpected padding");
+
+  explicit CharacterMapMatcher(internal::CharacterMap _map)
+      : map(std::move(_map)) {}
+
+  Candidate MatchPrefixCandidate(const char* word, size_t len) const override {
+    const PrefixMatchView matched = map.MatchPrefixView(word, len);
+    Candidate candidate;
+    candidate.hasValue = matched.matched;
+    candidate.keyLength = matched.keyLength;
+    candidate.key = matched.key;
+    candidate.value = matched.value;
+    return candidate;
+  }
+
+  const internal::CharacterMap* GetCharacterMap() const override {
+    return &map;
+  }
+
+  void Serialize(FILE* fp) const override {
+    const std::vector<internal::CharacterMap::Value>& values = map.GetValues();
+    const std::string& arena = map.GetArena();
+    WriteInteger(fp, kCharacterMapMatcher);
+    WriteInteger(fp, static_cast<uint32_t>(values.size()));
+    WriteInteger(fp, static_cast<uint32_t>(arena.size()));
+    WriteBytes(fp, values.data(),
+               values.size() * sizeof(internal::CharacterMap::Value));
+    WriteBytes(fp, arena.data(), arena.size());
+    const uint32_t zero = 0;
+    WriteBytes(fp, &zero, (4 - arena.size() % 4) % 4);
+  }
+
+  // Restores a matcher written by Serialize() after its kind field. The
+  // code point table is not serialized; it is rebuilt from the values.
+  static std::unique_ptr<CharacterMapMatcher>
+  NewFromBuffer(const char* data, size_t size, size_t* offset) {
+    const uint32_t numValues = ReadUInt32(data, size, offset);
+    const uint32_t arenaLength = ReadUInt32(data, size, offset);
+    const char* valueBytes = ReadBytes(
+        data, size, offset,
+        uint64_t(numValues) * sizeof(internal::CharacterMap::Value));
+    const char* arenaBytes = ReadBytes(data, size, offset, arenaLength);
+    ReadBytes(data, size, offset, (4 - arenaLength % 4) % 4);
+
+    internal::CharacterMap map;
+    map.MutableArena().assign(arenaBytes, arenaLength);
+    internal::CodePointTable seen;
+    for (uint32_t i = 0; i < numValues; i++) {
+      internal::CharacterMap::Value value;
+      memcpy(&value, valueBytes + i * sizeof(value), sizeof(value));
+      if (value.codePoint > 0x10FFFF ||
+          seen.Get(value.codePoint) != internal::CodePointTable::kNone ||
+          value.offset > arenaLength ||
+          value.length > arenaLength - value.offset) {
+        throw InvalidFormat(
+            "Invalid prefix match tables (character out of bounds)");
+      }
+      seen.Set(value.codePoint, i);
+      map.AddValue(value);
+    }
+    return std::unique_ptr<CharacterMapMatcher>(
+        new CharacterMapMatcher(std::move(map)));
+  }
+
+private:
+  const internal::CharacterMap map;
+};
+
+std::unique_ptr<PrefixMatch::Tables::Matcher>
+PrefixMatch::Tables::Matcher::NewFromBuffer(const char* data, size_t size,
+                                            size_t* offset, int depth) {
+  const uint32_t kind = ReadUInt32(data, size, offset);
+  if (kind == kLeafMatcher) {
+    return LeafMatcher::NewFromBuffer(data, size, offset);
+  }
+  if (kind == kCharacterMapMatcher) {
+    return CharacterMapMatcher::NewFromBuffer(data, size, offset);
+  }
+  if (kind != kGroupMatcher || depth >= kMaxSerializedGroupDepth) {
+    throw InvalidFormat("Invalid prefix match tables (unknown matcher)");
+  }
+  const uint32_t matchPolicy = ReadUInt32(data, size, offset);
+  if (matchPolicy != static_cast<uint32_t>(DictGroupMatchPolicy::ShortCircuit) &&
+      matchPolicy != static_cast<uint32_t>(DictGroupMatchPolicy::Union)) {
+    throw InvalidFormat("Invalid prefix match tables (unknown match policy)");
+  }
+  const uint32_t numChildren = ReadUInt32(data, size, offset);
+  std::unique_ptr<GroupMatcher> group(
+      new GroupMatcher(static_cast<DictGroupMatchPolicy>(matchPolicy)));
+  for (uint32_t i = 0; i < numChildren; i++) {
+    group->AddChild(NewFromBuffer(data, size, offset, depth + 1));
+  }
+  return std::move(group);
+}
+
+bool IsSingleCharKey(const char* key, size_t len) {
+  return len > 0 && UTF8Util::NextCharLengthNoException(key) == len;
+}
+
+// Returns true if a CharacterMap can hold key: exactly one valid character.
+bool IsCodePointKey(const char* key, size_t len) {
+  size_t charLength = 0;
+  return internal::DecodeUtf8(key, len, &charLength) !=
+             internal::kInvalidCodePoint &&
+         charLength == len;
+}
+
+namespace {
+
+// Classifies the keys of each leaf dict at most once per table build, however
+// many of the checks below ask about it. The walk over a leaf stops at its
+// first key that is not a single character, which for a phrase dict is one of
+// the first few, so only character dicts are walked in full.
+class KeyClassifier {
+public:
+  // Returns true if every key of dict, or of every leaf dict under it, is
+  // exactly one UTF-8 character.
+  bool HasOnlySingleCharKeys(const DictPtr& dict) {
+    return AllLeaves(dict, &LeafKeys::singleChars);
+  }
+
+  // Returns true if dict compiles to a CharacterMap: every key is exactly one
+  // valid code point. As all its keys have the same length, the first leaf
+  // holding a key answers it under either match policy, so groups of any
+  // shape qualify.
+  bool IsCharacterMapDict(const DictPtr& dict) {
+    return AllLeaves(dict, &LeafKeys::codePoints);
+  }
+
+private:
+  // Both are false if the keys of the leaf are unavailable.
+  struct LeafKeys {
+    bool singleChars = true;
+    bool codePoints = true;
+  };
+
+  bool AllLeaves(const DictPtr& dict, bool LeafKeys::*holds) {
+    const std::list<DictPtr>* items = dict->GetDictGroupItems();
+    if (items == nullptr) {
+      return Classify(dict).*holds;
+    }
+    for (const DictPtr& child : *items) {
+      if (!AllLeaves(child, holds)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const LeafKeys& Classify(const DictPtr& leaf) {
+    const auto inserted = leaves.emplace(leaf.get(), LeafKeys());
+    LeafKeys& keys = inserted.first->second;
+    if (!inserted.second) {
+      return keys;
+    }
+    const bool enumerated = internal::EnumerateDictEntries(
+        *leaf, [&keys](std::string_view key, std::string_view) {
+          if (!IsSingleCharKey(key.data(), key.size())) {
+            keys.singleChars = false;
+            keys.codePoints = false;
+            return false;
+          }
+          keys.codePoints =
+              keys.codePoints && IsCodePointKey(key.data(), key.size());
+          return true;
+        });
+    if (!enumerated) {
+      keys.singleChars = false;
+      keys.codePoints = false;
+    }
+    return keys;
+  }
+
+  std::unordered_map<const Dict*, LeafKeys> leaves;
+};
+
+} // namespace
+
+// Adds every entry under dict to map, earlier leaves first, and marks every
+// key into skip. Only called once every leaf is known to be enumerable.
+void AddToCharacterMap(const DictPtr& dict, internal::CharacterMap* map,
+                       internal::Utf8SkipTable* skip) {
+  const std::list<DictPtr>* items = dict->GetDictGroupItems();
+  if (items != nullptr) {
+    for (const DictPtr& child : *items) {
+      AddToCharacterMap(child, map, skip);
+    }
+    return;
+  }
+  internal::EnumerateDictEntries(
+      *dict, [map, skip](std::string_view key, std::string_view value) {
+        internal::MarkKeyFirstChar(skip, key.data(), key.size());
+        map->Add(key, value);
+        return true;
+      });
+}
+
+// Returns true if the subtree rooted at dict is semantically equivalent to a
+// single flat union of all its leaf dicts, in order: the longest match
+// across all leaves wins and ties go to the earlier leaf, which is exactly
+// what a single LeafMatcher trie computes. This holds for
+//  - leaf dicts;
+//  - union groups of such subtrees, since union is associative;
+//  - short_circuit groups of such subtrees in which every child after the
+//    first has only single-character keys (e.g. a phrase dict followed by a
+//    character dict): a match of an earlier child covers at least the one
+//    character a later child could match, so it is never shorter, and an
+//    equal-length tie goes to the earlier child either way.
+bool CanFlattenAsUnion(const DictPtr& dict, KeyClassifier* classifier) {
   const std::list<DictPtr>* items = dict->GetDictGroupItems();
   if (items == nullptr) {
     return true;
   }
-  if (dict->GetMatchPolicy() != DictGroupMatchPolicy::Union) {
-    return false;
-  }
+  const bool shortCircuit =
+      dict->GetMatchPolicy() == DictGroupMatchPolicy::ShortCircuit;
+  bool first = true;
   for (const DictPtr& child : *items) {
-    if (!CanFlattenAsUnion(child)) {
+    if (!CanFlattenAsUnion(child, classifier)) {
+      return false;
+    }
+    if (shortCircuit && !first && !classifier->HasOnlySingleCharKeys(child)) {
       return false;
     }
+    first = false;
   }
   return true;
 }
 
-void CollectAllLeafDicts(const DictPtr& dict, LeafMatcher* out) {
+void CollectAllLeafDicts(const DictPtr& dict, LeafMatcher* out,
+                         internal::Utf8SkipTable* skip) {
   const std::list<DictPtr>* items = dict->GetDictGroupItems();
   if (items == nullptr) {
-    out->AddDict(dict);
+    out->AddDict(dict, skip);
     return;
   }
   for (const DictPtr& child : *items) {
-    CollectAllLeafDicts(child, out);
+    CollectAllLeafDicts(child, out, skip);
   }
 }
 
-std::unique_ptr<PrefixMatch::Tables::Matcher> BuildMatcher(
-    const DictPtr& dict) {
+// Builds the matcher for dict, marking the skip table on the same walk over
+// the entries of each leaf, so that a table build reads every leaf once
+// besides the classification.
+std::unique_ptr<PrefixMatch::Tables::Matcher>
+BuildMatcher(const DictPtr& dict, KeyClassifier* classifier,
+             internal::Utf8SkipTable* skip) {
+  if (classifier->IsCharacterMapDict(dict)) {
+    internal::CharacterMap map;
+    AddToCharacterMap(dict, &map, skip);
+    return std::unique_ptr<CharacterMapMatcher>(
+        new CharacterMapMatcher(std::move(map)));
+  }
   const std::list<DictPtr>* dictGroupItems = dict->GetDictGroupItems();
   if (dictGroupItems != nullptr) {
-    // If the entire subtree is a pure union of leaf dicts, merge all entries
-    // into a single LeafMatcher. One trie traversal finds the longest match
-    // across all dicts, which equals union semantics, and eliminates the
-    // overhead of GroupMatcher dispatch and multiple traversals.
-    if (CanFlattenAsUnion(dict)) {
+    // If the entire subtree is equivalent to a union of its leaf dicts, merge
+    // all entries into a single LeafMatcher. One trie traversal finds the
+    // longest match across all dicts, which equals union semantics, and
+    // eliminates the overhead of GroupMatcher dispatch and multiple
+    // traversals.
+    if (CanFlattenAsUnion(dict, classifier)) {
       std::unique_ptr<LeafMatcher> leaf(new LeafMatcher);
-      CollectAllLeafDicts(dict, leaf.get());
+      CollectAllLeafDicts(dict, leaf.get(), skip);
+      leaf->Compile();
       return std::move(leaf);
     }
 
     std::unique_ptr<GroupMatcher> group(
         new GroupMatcher(dict->GetMatchPolicy()));
     for (const DictPtr& child : *dictGroupItems) {
-      group->AddChild(BuildMatcher(child));
+      group->AddChild(BuildMatcher(child, classifier, skip));
     }
     return std::move(group);
   }
 
   std::unique_ptr<LeafMatcher> leaf(new LeafMatcher);
-  leaf->AddDict(dict);
+  leaf->AddDict(dict, skip);
+  leaf->Compile();
   return std::move(leaf);
 }
 
-PrefixMatch::PrefixMatch(const DictPtr& dict) {
-  // Try to unwrap single dict group
+namespace {
+
+// Returns the dictionary that can answer prefix queries itself when dict,
+// after unwrapping single-item groups, supports the fast path; nullptr
+// otherwise.
+DictPtr FastPathCapableDict(const DictPtr& dict) {
   DictPtr actualDict = dict;
   while (actualDict) {
     const std::list<DictPtr>* items = actualDict->GetDictGroupItems();
@@ -439,26 +902,38 @@ PrefixMatch::PrefixMatch(const DictPtr& dict) {
       break;
     }
   }
+  if (actualDict && actualDict->SupportsFastPrefixMatch()) {
+    return actualDict;
+  }
+  return DictPtr();
+}
 
-  const bool fastPath = actualDict && actualDict->SupportsFastPrefixMatch();
-  if (fastPath) {
-    singleDict = actualDict;
+// Like FastPathCapableDict(), but a dictionary of single characters takes
+// the table path, where a CharacterMap beats the dictionary's own lookup.
+DictPtr FastPathDict(const DictPtr& dict, KeyClassifier* classifier) {
+  DictPtr actualDict = FastPathCapableDict(dict);
+  if (actualDict != nullptr && classifier->IsCharacterMapDict(actualDict)) {
+    return DictPtr();
   }
-  // On the fast path the Tables only carry the skip table (the dictionary
-  // answers prefix queries itself); the cache is shared with the table path,
-  // with a distinct key prefix because fast-path Tables hold no matcher.
-  const DictPtr& tableDict = fastPath ? actualDict : dict;
+  return actualDict;
+}
 
+} // namespace
+
+PrefixMatch::PrefixMatch() {}
+
+PrefixMatch::PrefixMatch(const DictPtr& dict) {
   static std::mutex cacheMutex;
   static std::unordered_map<std::string, std::vector<CacheEntry>> cache;
 
+  // The cache is looked up before the dictionary is classified, so a hit
+  // does not walk any keys. Fast-path Tables only carry the skip table (the
+  // dictionary answers prefix queries itself) and are told apart from
+  // table-path ones by their missing matcher, as in NewFromSerializedTables().
   std::string cacheKey;
-  if (fastPath) {
-    cacheKey.push_back('F');
-  }
-  AppendCacheKey(tableDict, &cacheKey);
+  AppendCacheKey(dict, &cacheKey);
   std::vector<std::weak_ptr<const Dict>> leafDicts;
-  CollectLeafDicts(tableDict, &leafDicts);
+  CollectLeafDicts(dict, &leafDicts);
 
   {
     std::lock_guard<std::mutex> lock(cacheMutex);
@@ -466,9 +941,12 @@ PrefixMatch::PrefixMatch(const DictPtr& dict) {
     const auto cached = cache.find(cacheKey);
     if (cached != cache.end()) {
       for (const CacheEntry& entry : cached->second) {
-        if (entry.fastPath == fastPath && SameDicts(entry, leafDicts)) {
+        if (SameDicts(entry, leafDicts)) {
           tables = entry.tables.lock();
           if (tables != nullptr) {
+            if (tables->matcher == nullptr) {
+              singleDict = FastPathCapableDict(dict);
+            }
             return;
           }
         }
@@ -476,11 +954,18 @@ PrefixMatch::PrefixMatch(const DictPtr& dict) {
     }
   }
 
+  KeyClassifier classifier;
+  const DictPtr actualDict = FastPathDict(dict, &classifier);
+  const bool fastPath = actualDict != nullptr;
   std::shared_ptr<Tables> built(new Tables);
-  if (!fastPath) {
-    built->matcher = BuildMatcher(tableDict);
+  if (fastPath) {
+    singleDict = actualDict;
+    BuildSkipTable(actualDict, &built->skip);
+  } else {
+    built->skip.EnableCharLevel();
+    built->matcher = BuildMatcher(dict, &classifier, &built->skip);
+    built->skip.Finalize();
   }
-  BuildSkipTable(tableDict, &built->skip);
 
   std::lock_guard<std::mutex> lock(cacheMutex);
   PruneExpiredPrefixMatchCache(&cache);
@@ -489,7 +974,8 @@ PrefixMatch::PrefixMatch(const DictPtr& dict) {
        it != entries.end();) {
     if (HasExpiredDict(*it)) {
       it = entries.erase(it);
-    } else if (it->fastPath == fastPath && SameDicts(*it, leafDicts)) {
+    } else if (SameDicts(*it, leafDicts)) {
+      // Built concurrently from the same dicts, so on the same path.
       tables = it->tables.lock();
       if (tables != nullptr) {
         return;
@@ -503,39 +989,146 @@ PrefixMatch::PrefixMatch(const DictPtr& dict) {
   CacheEntry entry;
   entry.dicts = std::move(leafDicts);
   entry.tables = tables;
-  entry.fastPath = fastPath;
   entries.push_back(std::move(entry));
 }
 
 PrefixMatch::~PrefixMatch() {}
 
-PrefixMatch::Match PrefixMatch::MatchPrefix(const char* word,
-                                            size_t len) const {
-  if (singleDict != nullptr) {
-    struct MatchCache {
-      std::string key;
-      std::string value;
-    };
-    // key/value pointers are valid until the next MatchPrefix() call on this
-    // thread.
-    static thread_local MatchCache matchCache;
-    const PrefixMatchView pv = singleDict->MatchPrefixValue(word, len);
-    if (pv.matched) {
-      matchCache.key = std::string(pv.key);
-      matchCache.value = std::string(pv.value);
-      return Match{true, pv.keyLength, &matchCache.key, &matchCache.value};
-    }
-    return Match{false, 0, nullptr, nullptr};
+void PrefixMatch::SerializeTables(FILE* fp) const {
+  const internal::Utf8SkipTable& skip = tables->skip;
+  uint32_t flags = 0;
+  if (tables->matcher != nullptr) {
+    flags |= kHasMatcher;
+  }
+  if (skip.asciiHasCandidates) {
+    flags |= kAsciiHasCandidates;
+  }
+  if (skip.CharLevel()) {
+    flags |= kCharLevel;
+  }
+  if (skip.AstralLevel()) {
+    flags |= kAstralLevel;
+  }
+  WriteInteger(fp, flags);
+  for (size_t b = 0; b < 256; b++) {
+    WriteInteger(fp, static_cast<uint8_t>(skip.candidate[b] ? 1 : 0));
+  }
+  if (skip.CharLevel()) {
+    WriteBytes(fp, skip.bmpCandidates.data(),
+               skip.bmpCandidates.size() * sizeof(uint64_t));
+  }
+  if (skip.AstralLevel()) {
+    const size_t numAstralBlocks = skip.astralCandidates.size() /
+                                   internal::Utf8SkipTable::kAstralBlockWords;
+    WriteInteger(fp, static_cast<uint32_t>(numAstralBlocks));
+    WriteBytes(fp, skip.astralBlocks.data(),
+               skip.astralBlocks.size() * sizeof(uint16_t));
+    WriteBytes(fp, skip.astralCandidates.data(),
+               skip.astralCandidates.size() * sizeof(uint64_t));
+  }
+  if (tables->matcher != nullptr) {
+    tables->matcher->Serialize(fp);
+  }
+}
+
+std::shared_ptr<PrefixMatch> PrefixMatch::NewFromSerializedTables(
+    const DictPtr& dict, const char* data, size_t size, size_t* bytesRead,
+    std::shared_ptr<const void> owner) {
+  std::shared_ptr<PrefixMatch> prefixMatch(new PrefixMatch);
+  // Tables written before character maps existed hold no matcher for a
+  // fast-path dictionary of single characters, so which path such a
+  // dictionary takes is read from the tables rather than recomputed, which
+  // would also enumerate its keys.
+  const DictPtr fastPathDict = FastPathCapableDict(dict);
+  std::shared_ptr<Tables> restored(new Tables);
+  restored->owner = std::move(owner);
+
+  size_t offset = 0;
+  const uint32_t flags = ReadUInt32(data, size, &offset);
+  const bool hasMatcher = (flags & kHasMatcher) != 0;
+  if (!hasMatcher) {
+    if (fastPathDict == nullptr) {
+      throw InvalidFormat(
+          "Invalid prefix match tables (do not match the dictionary)");
+    }
+    prefixMatch->singleDict = fastPathDict;
+  }
+  internal::Utf8SkipTable& skip = restored->skip;
+  const char* candidates = ReadBytes(data, size, &offset, 256);
+  for (size_t b = 0; b < 256; b++) {
+    skip.candidate[b] = candidates[b] != 0;
+  }
+  skip.asciiHasCandidates = (flags & kAsciiHasCandidates) != 0;
+  if ((flags & kCharLevel) != 0) {
+    skip.EnableCharLevel();
+    const size_t bitmapBytes = skip.bmpCandidates.size() * sizeof(uint64_t);
+    memcpy(skip.bmpCandidates.data(),
+           ReadBytes(data, size, &offset, bitmapBytes), bitmapBytes);
+    if ((flags & kAstralLevel) == 0) {
+      skip.DisableAstralLevel();
+    }
+  } else if ((flags & kAstralLevel) != 0) {
+    throw InvalidFormat("Invalid prefix match tables (astral without BMP)");
+  }
+  if ((flags & kAstralLevel) != 0) {
+    const uint32_t numAstralBlocks = ReadUInt32(data, size, &offset);
+    if (numAstralBlocks == 0 ||
+        numAstralBlocks > internal::Utf8SkipTable::kNumAstralBlocks + 1) {
+      throw InvalidFormat("Invalid prefix match tables (astral blocks)");
+    }
+    const size_t indexBytes = skip.astralBlocks.size() * sizeof(uint16_t);
+    memcpy(skip.astralBlocks.data(),
+           ReadBytes(data, size, &offset, indexBytes), indexBytes);
+    for (const uint16_t block : skip.astralBlocks) {
+      if (block >= numAstralBlocks) {
+        throw InvalidFormat("Invalid prefix match tables (astral blocks)");
+      }
+    }
+    skip.astralCandidates.resize(numAstralBlocks *
+                                 internal::Utf8SkipTable::kAstralBlockWords);
+    const size_t bitmapBytes = skip.astralCandidates.size() * sizeof(uint64_t);
+    memcpy(skip.astralCandidates.data(),
+           ReadBytes(data, size, &offset, bitmapBytes), bitmapBytes);
+  }
+  if (hasMatcher) {
+    restored->matcher =
+        Tables::Matcher::NewFromBuffer(data, size, &offset, 0);
+    if (fastPathDict != nullptr &&
+        restored->matcher->GetCharacterMap() == nullptr) {
+      throw InvalidFormat(
+          "Invalid prefix match tables (do not match the dictionary)");
+    }
   }
+  prefixMatch->tables = std::move(restored);
+  if (bytesRead != nullptr) {
+    *bytesRead = offset;
+  }
+  return prefixMatch;
+}
 
-  const Tables::Matcher::Candidate candidate =
-      tables->matcher->MatchPrefixCandidate(word, len);
-  if (candidate.hasValue) {
-    return Match{true, candidate.keyLength, candidate.key, candidate.value};
+PrefixMatch::Match PrefixMatch::MatchPrefix(const char* word,
+                                            size_t len) const {
+  struct MatchCache {
+    std::string key;
+    std::string value;
+  };
+  // key/value pointers are valid until the next MatchPrefix() call on this
+  // thread.
+  static thread_local MatchCache matchCache;
+  const PrefixMatchView pv = MatchPrefixView(word, len);
+  if (pv.matched) {
+    matchCache.key.assign(pv.key.data(), pv.key.size());
+    matchCache.value.assign(pv.value.data(), pv.value.size());
+    return Match{true, pv.keyLength, &matchCache.key, &matchCache.value};
   }
   return Match{false, 0, nullptr, nullptr};
 }
 
+const internal::CharacterMap* PrefixMatch::GetCharacterMap() const {
+  return tables->matcher != nullptr ? tables->matcher->GetCharacterMap()
+                                    : nullptr;
+}
+
 size_t PrefixMatch::SkipUnmatchable(const char* word, size_t len) const {
   return internal::SkipNonCandidateBytes(tables->skip, word, len);
 }
@@ -548,9 +1141,7 @@ PrefixMatchView PrefixMatch::MatchPrefixView(const char* word,
   const Tables::Matcher::Candidate candidate =
       tables->matcher->MatchPrefixCandidate(word, len);
   if (candidate.hasValue) {
-    return {true, candidate.keyLength,
-            std::string_view(*candidate.key),
-            std::string_view(*candidate.value)};
+    return {true, candidate.keyLength, candidate.key, candidate.value};
   }
   return {false, 0, std::string_view(), std::string_view()};
 }
@@ -23,6 +23,10 @@
 
 namespace opencc {
 
+namespace internal {
+class CharacterMap;
+}
+
 class OPENCC_EXPORT PrefixMatch {
 public:
   class Tables;
@@ -37,6 +41,12 @@ public:
   explicit PrefixMatch(const DictPtr& dict);
   ~PrefixMatch();
 
+  /**
+   * Returns the longest dictionary key that is a prefix of @p word. The key
+   * and value pointers refer to thread-local copies and are valid until the
+   * next MatchPrefix() call on the same thread; prefer MatchPrefixView() on
+   * hot paths.
+   */
   Match MatchPrefix(const char* word, size_t len) const;
 
   /**
@@ -46,9 +56,9 @@ public:
    * Lifetime of the returned views:
    *  - @b key: points into the caller's input buffer (fast-path singleDict,
    *    where both MarisaDict and DartsDict return a slice of @p word) or into
-   *    PrefixMatch-owned table storage (table-path LeafMatcher).  Callers
-   *    must not assume one or the other; copy if the key needs to outlive the
-   *    current input position.
+   *    PrefixMatch-owned table storage (the table-path LeafMatcher's string
+   *    arena).  Callers must not assume one or the other; copy if the key
+   *    needs to outlive the current input position.
    *  - @b value: valid for the lifetime of the underlying dictionary
    *    (fast-path) or the lifetime of this PrefixMatch's tables (table-path).
    */
@@ -65,7 +75,35 @@ public:
    */
   size_t SkipUnmatchable(const char* word, size_t len) const;
 
+  /**
+   * Returns the compiled map when every key is a single character, so that
+   * callers can look characters up inline instead of through
+   * MatchPrefixView(); nullptr otherwise. Valid for the lifetime of this
+   * PrefixMatch.
+   */
+  const internal::CharacterMap* GetCharacterMap() const;
+
+  /**
+   * Writes the compiled lookup tables (matcher and skip table) to @p fp, so
+   * that NewFromSerializedTables() can restore them without rebuilding.
+   */
+  void SerializeTables(FILE* fp) const;
+
+  /**
+   * Restores a PrefixMatch for @p dict from tables that SerializeTables()
+   * wrote for a dictionary of the same structure. Matcher tables are used in
+   * place when @p data is 4-byte aligned; @p owner keeps @p data alive.
+   * Stores the number of bytes consumed in @p bytesRead if it is not null.
+   * @throws InvalidFormat if the tables are malformed or were written for a
+   *   dictionary that takes a different lookup path.
+   */
+  static std::shared_ptr<PrefixMatch>
+  NewFromSerializedTables(const DictPtr& dict, const char* data, size_t size,
+                          size_t* bytesRead, std::shared_ptr<const void> owner);
+
 private:
+  PrefixMatch();
+
   static void AppendCacheKey(const DictPtr& dict, std::string* output);
   static void CollectLeafDicts(const DictPtr& dict,
                                std::vector<std::weak_ptr<const Dict>>* output);
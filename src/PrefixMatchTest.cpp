@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "PrefixMatch.hpp"
+#include "DartsDict.hpp"
 #include "DictGroup.hpp"
 #include "MarisaDict.hpp"
 #include "TestUtilsUTF8.hpp"
@@ -100,6 +101,48 @@ TEST_F(PrefixMatchTest, MarisaLazyLoadFastPathDoesNotReconstruct) {
   EXPECT_FALSE(lazyDict->IsLexiconReconstructed());
 }
 
+TEST_F(PrefixMatchTest, MarisaGroupTablePathDoesNotReconstruct) {
+  const MarisaDictPtr lazyDict =
+      SerializableDict::NewFromFile<MarisaDict>(fileName);
+  const DictPtr group(new DictGroup(
+      std::list<DictPtr>{lazyDict, CreateDictForCharacters()}));
+  const PrefixMatch pm(group);
+  EXPECT_EQ(nullptr, pm.GetCharacterMap());
+
+  const std::vector<std::string> testQueries = {
+      "清華", "清華大學", "清", "積羽沉舟", "干燥", "nowhere"};
+  for (const std::string& query : testQueries) {
+    const PrefixMatchView v = pm.MatchPrefixView(query.c_str(), query.length());
+    const Optional<const DictEntry*> expected =
+        group->MatchPrefix(query.c_str(), query.length());
+    ASSERT_EQ(!expected.IsNull(), v.matched) << query;
+    if (v.matched) {
+      EXPECT_EQ(expected.Get()->Key(), std::string(v.key)) << query;
+      EXPECT_EQ(expected.Get()->GetDefault(), std::string(v.value)) << query;
+    }
+  }
+  EXPECT_FALSE(lazyDict->IsLexiconReconstructed());
+}
+
+TEST_F(PrefixMatchTest, DartsLoadFastPathDoesNotConstructLexicon) {
+  const std::string dartsFileName = "prefix_match_dict.ocd";
+  DartsDict::NewFromDict(*textDict)
+      ->opencc::SerializableDict::SerializeToFile(dartsFileName);
+  const DartsDictPtr dartsDict =
+      SerializableDict::NewFromFile<DartsDict>(dartsFileName);
+
+  // Building the skip table enumerates keys from the serialized entries.
+  const PrefixMatch pm(dartsDict);
+  const std::string query = utf8("清華大學");
+  const PrefixMatchView v = pm.MatchPrefixView(query.c_str(), query.length());
+  ASSERT_TRUE(v.matched);
+  EXPECT_EQ(utf8("清華大學"), std::string(v.key));
+  EXPECT_EQ(utf8("TsinghuaUniversity"), std::string(v.value));
+  EXPECT_EQ(0u, pm.SkipUnmatchable(query.c_str(), query.length()));
+  EXPECT_FALSE(dartsDict->IsLexiconConstructed());
+  std::remove(dartsFileName.c_str());
+}
+
 TEST_F(PrefixMatchTest, FastPathSelectsLongestMatch) {
   // Dictionary has "清"→Tsing, "清華"→Tsinghua, "清華大學"→TsinghuaUniversity.
   // A query with a longer input must match the longest key, not the first
@@ -146,6 +189,44 @@ TEST_F(PrefixMatchTest, MatchPrefixViewTablePathReturnsViews) {
   EXPECT_EQ(v.key.size(), v.keyLength);
 }
 
+TEST_F(PrefixMatchTest, TablePathWideFanoutMatchesDictGroup) {
+  // Enough distinct first characters (and second characters under one of
+  // them) that the flat trie's child runs exceed the linear-scan limit and
+  // are binary searched.
+  LexiconPtr firstLexicon(new Lexicon);
+  LexiconPtr secondLexicon(new Lexicon);
+  for (char c = 'a'; c <= 'z'; c++) {
+    firstLexicon->Add(DictEntryFactory::New(std::string(1, c),
+                                            std::string(1, c - 'a' + 'A')));
+    secondLexicon->Add(DictEntryFactory::New(std::string("q") + c,
+                                             std::string("Q") + c));
+  }
+  secondLexicon->Add(DictEntryFactory::New(utf8("清華"), "second"));
+  firstLexicon->Sort();
+  secondLexicon->Sort();
+  DictPtr firstDict(new TextDict(firstLexicon));
+  DictPtr secondDict(new TextDict(secondLexicon));
+  DictPtr dictGroup(
+      new UnionDictGroup(std::list<DictPtr>{textDict, firstDict, secondDict}));
+  PrefixMatch pm(dictGroup);
+
+  const std::vector<std::string> testQueries = {
+      "a",         "m",           "z",           "qa",     "qz",
+      "q",         "qq!",         "BYVoid",      "BYVoid1", "0",
+      utf8("清"), utf8("清華"), utf8("清華大學校園"), "",       "~"};
+  for (const std::string& query : testQueries) {
+    const PrefixMatchView v = pm.MatchPrefixView(query.c_str(), query.length());
+    const Optional<const DictEntry*> expected =
+        dictGroup->MatchPrefix(query.c_str(), query.length());
+    ASSERT_EQ(!expected.IsNull(), v.matched) << query;
+    if (v.matched) {
+      EXPECT_EQ(expected.Get()->Key(), std::string(v.key)) << query;
+      EXPECT_EQ(expected.Get()->GetDefault(), std::string(v.value)) << query;
+      EXPECT_EQ(v.key.size(), v.keyLength);
+    }
+  }
+}
+
 TEST_F(PrefixMatchTest, ShortCircuitGroupPrefersEarlierShorterMatch) {
   LexiconPtr firstLexicon(new Lexicon);
   firstLexicon->Add(DictEntryFactory::New(utf8("意大利"), utf8("義大利")));
@@ -170,6 +251,43 @@ TEST_F(PrefixMatchTest, ShortCircuitGroupPrefersEarlierShorterMatch) {
   EXPECT_EQ(utf8("義大利"), *m.value);
 }
 
+TEST_F(PrefixMatchTest, ShortCircuitGroupWithCharacterTailMatchesDictGroup) {
+  // A short_circuit group whose later children only hold single characters
+  // is matched by one flattened trie; results must not change.
+  LexiconPtr phraseLexicon(new Lexicon);
+  phraseLexicon->Add(DictEntryFactory::New(utf8("意大利"), utf8("義大利")));
+  phraseLexicon->Add(DictEntryFactory::New(utf8("面"), utf8("麵")));
+  phraseLexicon->Sort();
+  LexiconPtr firstCharLexicon(new Lexicon);
+  firstCharLexicon->Add(DictEntryFactory::New(utf8("意"), "first-yi"));
+  firstCharLexicon->Add(DictEntryFactory::New(utf8("面"), "first-mian"));
+  firstCharLexicon->Sort();
+  LexiconPtr secondCharLexicon(new Lexicon);
+  secondCharLexicon->Add(DictEntryFactory::New(utf8("意"), "second-yi"));
+  secondCharLexicon->Add(DictEntryFactory::New(utf8("大"), "second-da"));
+  secondCharLexicon->Sort();
+  DictPtr dictGroup(new DictGroup(
+      std::list<DictPtr>{DictPtr(new TextDict(phraseLexicon)),
+                         DictPtr(new TextDict(firstCharLexicon)),
+                         DictPtr(new TextDict(secondCharLexicon))},
+      DictGroupMatchPolicy::ShortCircuit));
+  PrefixMatch pm(dictGroup);
+
+  const std::vector<std::string> testQueries = {
+      utf8("意大利面"), utf8("意大"), utf8("面"), utf8("大利"), utf8("利"),
+      "x"};
+  for (const std::string& query : testQueries) {
+    const PrefixMatchView v = pm.MatchPrefixView(query.c_str(), query.length());
+    const Optional<const DictEntry*> expected =
+        dictGroup->MatchPrefix(query.c_str(), query.length());
+    ASSERT_EQ(!expected.IsNull(), v.matched) << query;
+    if (v.matched) {
+      EXPECT_EQ(expected.Get()->Key(), std::string(v.key)) << query;
+      EXPECT_EQ(expected.Get()->GetDefault(), std::string(v.value)) << query;
+    }
+  }
+}
+
 TEST_F(PrefixMatchTest, UnionGroupPrefersLaterLongerMatch) {
   LexiconPtr firstLexicon(new Lexicon);
   firstLexicon->Add(DictEntryFactory::New(utf8("意大利"), utf8("義大利")));
@@ -223,6 +341,86 @@ TEST_F(PrefixMatchTest, UnionGroupPreservesNestedShortCircuitBoundary) {
   EXPECT_EQ("root-second", *m.value);
 }
 
+TEST_F(PrefixMatchTest, CharacterGroupsUseCharacterMap) {
+  LexiconPtr firstLexicon(new Lexicon);
+  firstLexicon->Add(DictEntryFactory::New(utf8("意"), "first-yi"));
+  firstLexicon->Add(DictEntryFactory::New("a", "first-a"));
+  firstLexicon->Add(DictEntryFactory::New(utf8("\U00020000"), "first-ext"));
+  firstLexicon->Sort();
+  LexiconPtr secondLexicon(new Lexicon);
+  secondLexicon->Add(DictEntryFactory::New(utf8("意"), "second-yi"));
+  secondLexicon->Add(DictEntryFactory::New(utf8("面"), "second-mian"));
+  secondLexicon->Sort();
+  const DictPtr first(new TextDict(firstLexicon));
+  const DictPtr second(new TextDict(secondLexicon));
+
+  const std::vector<std::string> testQueries = {
+      utf8("意大利"), utf8("面"), "ab", "b", utf8("\U00020000"), ""};
+  // Truncated, overlong ("a" as two bytes) and invalid sequences.
+  const std::vector<std::string> invalidQueries = {
+      std::string("\xE6\x84", 2), "\xC1\xA1", "\xFF"};
+  for (const DictPtr& group :
+       {DictPtr(new DictGroup(std::list<DictPtr>{first, second})),
+        DictPtr(new UnionDictGroup(std::list<DictPtr>{first, second}))}) {
+    const PrefixMatch pm(group);
+    EXPECT_NE(nullptr, pm.GetCharacterMap());
+    for (const std::string& query : testQueries) {
+      const PrefixMatchView v =
+          pm.MatchPrefixView(query.c_str(), query.length());
+      const Optional<const DictEntry*> expected =
+          group->MatchPrefix(query.c_str(), query.length());
+      ASSERT_EQ(!expected.IsNull(), v.matched) << query;
+      if (v.matched) {
+        EXPECT_EQ(expected.Get()->Key(), std::string(v.key)) << query;
+        EXPECT_EQ(expected.Get()->GetDefault(), std::string(v.value)) << query;
+        EXPECT_EQ(query.data(), v.key.data());
+      }
+    }
+    for (const std::string& query : invalidQueries) {
+      EXPECT_FALSE(pm.MatchPrefixView(query.c_str(), query.length()).matched);
+    }
+  }
+
+  // A phrase key anywhere in the group keeps the trie.
+  EXPECT_EQ(nullptr, PrefixMatch(DictPtr(new DictGroup(
+                                     std::list<DictPtr>{first, textDict})))
+                         .GetCharacterMap());
+}
+
+TEST_F(PrefixMatchTest, MarisaCharacterDictUsesCharacterMap) {
+  const std::string characterFileName = "prefix_match_characters.ocd2";
+  MarisaDict::NewFromDict(*CreateDictForCharacters())
+      ->opencc::SerializableDict::SerializeToFile(characterFileName);
+  const MarisaDictPtr lazyDict =
+      SerializableDict::NewFromFile<MarisaDict>(characterFileName);
+  const PrefixMatch pm(lazyDict);
+  ASSERT_NE(nullptr, pm.GetCharacterMap());
+  const std::string query = utf8("干燥");
+  const PrefixMatchView v = pm.MatchPrefixView(query.c_str(), query.length());
+  ASSERT_TRUE(v.matched);
+  EXPECT_EQ(utf8("干"), std::string(v.key));
+  EXPECT_EQ(utf8("幹"), std::string(v.value));
+  EXPECT_FALSE(lazyDict->IsLexiconReconstructed());
+
+  // The map survives serialization of the tables.
+  FILE* fp = tmpfile();
+  ASSERT_NE(nullptr, fp);
+  pm.SerializeTables(fp);
+  std::string tables(static_cast<size_t>(ftell(fp)), '\0');
+  rewind(fp);
+  ASSERT_EQ(tables.size(), fread(&tables[0], 1, tables.size(), fp));
+  fclose(fp);
+  const std::shared_ptr<PrefixMatch> restored =
+      PrefixMatch::NewFromSerializedTables(lazyDict, tables.data(),
+                                           tables.size(), nullptr, nullptr);
+  ASSERT_NE(nullptr, restored->GetCharacterMap());
+  const PrefixMatchView r =
+      restored->MatchPrefixView(query.c_str(), query.length());
+  ASSERT_TRUE(r.matched);
+  EXPECT_EQ(utf8("幹"), std::string(r.value));
+  std::remove(characterFileName.c_str());
+}
+
 TEST(Utf8SkipScanTest, AsciiRunLength) {
   const std::string cjk = utf8("一");
   // Cover all vector-width boundaries and unaligned starting offsets.
@@ -241,6 +439,87 @@ TEST(Utf8SkipScanTest, AsciiRunLength) {
   EXPECT_EQ(0u, internal::AsciiRunLength("", 0));
 }
 
+TEST(Utf8SkipScanTest, ThreeByteRunLength) {
+  internal::Utf8SkipTable table;
+  table.EnableCharLevel();
+  const std::string candidate = utf8("太");
+  internal::MarkKeyFirstChar(&table, candidate.data(), candidate.size());
+  const uint64_t* bits = table.bmpCandidates.data();
+  const std::string skippable = utf8("天");
+  // Cover every position of the stopping character within a group, and
+  // every stop reason: a candidate, a non-3-byte character and truncation.
+  for (size_t runLength = 0; runLength < 20; runLength++) {
+    std::string run;
+    for (size_t i = 0; i < runLength; i++) {
+      run += skippable;
+    }
+    for (const std::string& stop :
+         {candidate, std::string("a"), utf8("é"), utf8("🎉"),
+          candidate.substr(0, 2), std::string()}) {
+      const std::string text = run + stop + skippable;
+      EXPECT_EQ(run.size(),
+                internal::ThreeByteRunLength(bits, text.data(),
+                                             run.size() + stop.size()))
+          << runLength;
+    }
+  }
+  EXPECT_EQ(0u, internal::ThreeByteRunLength(bits, "", 0));
+}
+
+TEST(Utf8SkipScanTest, FourByteRunLength) {
+  internal::Utf8SkipTable table;
+  table.EnableCharLevel();
+  const std::string candidate = utf8("𠀀");
+  internal::MarkKeyFirstChar(&table, candidate.data(), candidate.size());
+  table.Finalize();
+  const std::string skippable = utf8("😀");
+  for (size_t runLength = 0; runLength < 6; runLength++) {
+    std::string run;
+    for (size_t i = 0; i < runLength; i++) {
+      run += skippable;
+    }
+    for (const std::string& stop :
+         {candidate, std::string("a"), utf8("天"), skippable.substr(0, 3),
+          std::string("\xF4\x90\x80\x80"), std::string()}) {
+      const std::string text = run + stop + skippable;
+      EXPECT_EQ(run.size(),
+                internal::FourByteRunLength(table, text.data(),
+                                            run.size() + stop.size()))
+          << runLength;
+    }
+  }
+
+  // Without the supplementary-plane bitmap, as in tables restored from
+  // before it existed, the shared lead byte stops the scan.
+  const std::string text = skippable + candidate;
+  EXPECT_EQ(skippable.size(), internal::SkipNonCandidateBytes(
+                                  table, text.data(), text.size()));
+  table.DisableAstralLevel();
+  EXPECT_EQ(0u, internal::SkipNonCandidateBytes(table, text.data(),
+                                                text.size()));
+}
+
+TEST(Utf8SkipScanTest, MergeCandidatesKeepsAstralBits) {
+  internal::Utf8SkipTable into;
+  into.EnableCharLevel();
+  internal::Utf8SkipTable from;
+  from.EnableCharLevel();
+  const std::string first = utf8("𠀀");
+  const std::string second = utf8("🎉");
+  internal::MarkKeyFirstChar(&into, first.data(), first.size());
+  internal::MarkKeyFirstChar(&from, second.data(), second.size());
+  into.MergeCandidates(from);
+  ASSERT_TRUE(into.AstralLevel());
+  EXPECT_TRUE(into.IsCharCandidate(0x20000));
+  EXPECT_TRUE(into.IsCharCandidate(0x1F389));
+  EXPECT_FALSE(into.IsCharCandidate(0x1F600));
+
+  from.DisableAstralLevel();
+  into.MergeCandidates(from);
+  EXPECT_TRUE(into.CharLevel());
+  EXPECT_FALSE(into.AstralLevel());
+}
+
 TEST_F(PrefixMatchTest, SkipUnmatchableStopsAtAsciiCandidates) {
   // textDict contains ASCII keys ("BYVoid", "zigzagzig"), so the scalar
   // ASCII path must stop at candidate bytes 'B' and 'z'.
@@ -302,25 +581,38 @@ TEST_F(PrefixMatchSkipTest, SkipsNonCandidateCjkCharacters) {
   EXPECT_EQ(0u, pm.SkipUnmatchable(candidate.data(), candidate.size()));
 }
 
-TEST_F(PrefixMatchSkipTest, FourByteCharactersUseLeadByteFiltering) {
-  // No 4-byte key exists in dict, so lead byte 0xF0 is not a candidate and
-  // 4-byte characters are skipped whole.
+TEST_F(PrefixMatchSkipTest, FourByteCharactersUseCharLevelFiltering) {
+  // No 4-byte key exists in dict, so 4-byte characters are skipped whole.
   PrefixMatch pm(dict);
   const std::string emoji = utf8("🎉🚀x太后");
   EXPECT_EQ(9u, pm.SkipUnmatchable(emoji.data(), emoji.size()));
 
-  // With a 4-byte key, its lead byte becomes a candidate; any 4-byte
-  // character sharing that lead byte conservatively stops the scan.
+  // With a 4-byte key, only that character stops the scan; other 4-byte
+  // characters sharing its lead byte 0xF0 are still skipped.
   LexiconPtr lexicon(new Lexicon);
   lexicon->Add(DictEntryFactory::New(utf8("𠀀"), "X"));
   lexicon->Sort();
   DictPtr extDict(new TextDict(lexicon));
   PrefixMatch pmExt(extDict);
   const std::string extB = utf8("𠀀");
-  const std::string otherFourByte = utf8("🎉");
   EXPECT_EQ(0u, pmExt.SkipUnmatchable(extB.data(), extB.size()));
-  EXPECT_EQ(0u, pmExt.SkipUnmatchable(otherFourByte.data(),
-                                      otherFourByte.size()));
+  const std::string mixed = utf8("🎉👨‍👩‍👧𠀁𠀀");
+  EXPECT_EQ(mixed.size() - extB.size(),
+            pmExt.SkipUnmatchable(mixed.data(), mixed.size()));
+
+  // The supplementary-plane bitmap survives serialization of the tables.
+  FILE* fp = tmpfile();
+  ASSERT_NE(nullptr, fp);
+  pmExt.SerializeTables(fp);
+  std::string tables(static_cast<size_t>(ftell(fp)), '\0');
+  rewind(fp);
+  ASSERT_EQ(tables.size(), fread(&tables[0], 1, tables.size(), fp));
+  fclose(fp);
+  const std::shared_ptr<PrefixMatch> restored =
+      PrefixMatch::NewFromSerializedTables(extDict, tables.data(),
+                                           tables.size(), nullptr, nullptr);
+  EXPECT_EQ(mixed.size() - extB.size(),
+            restored->SkipUnmatchable(mixed.data(), mixed.size()));
 }
 
 TEST_F(PrefixMatchSkipTest, CharLevelSkipsSameLeadByteNonCandidates) {
@@ -19,7 +19,6 @@
 #include "ResourceProvider.hpp"
 
 #include <cstdint>
-#include <fstream>
 #include <unordered_map>
 #include <sstream>
 #include <sys/stat.h>
@@ -27,13 +26,10 @@
 #if defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
 #include "WinUtil.hpp"
-#else
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <unistd.h>
 #endif
 
 #include "Exception.hpp"
+#include "MappedFile.hpp"
 
 namespace opencc {
 namespace {
@@ -180,36 +176,6 @@ bool GetFileFreshnessCacheKey(const std::string& path, std::string* cacheKey) {
   return true;
 }
 
-#if defined(_WIN32) || defined(_WIN64)
-std::vector<unsigned char> ReadBinaryFile(const std::string& path) {
-  FILE* file = _wfopen(internal::WideFromUtf8(path).c_str(), L"rb");
-  if (file == nullptr) {
-    throw FileNotFound(path);
-  }
-  if (fseek(file, 0, SEEK_END) != 0) {
-    fclose(file);
-    throw FileNotFound(path);
-  }
-  const long fileSize = ftell(file);
-  if (fileSize < 0) {
-    fclose(file);
-    throw FileNotFound(path);
-  }
-  if (fseek(file, 0, SEEK_SET) != 0) {
-    fclose(file);
-    throw FileNotFound(path);
-  }
-  std::vector<unsigned char> data(static_cast<size_t>(fileSize));
-  if (!data.empty() &&
-      fread(data.data(), 1, data.size(), file) != data.size()) {
-    fclose(file);
-    throw FileNotFound(path);
-  }
-  fclose(file);
-  return data;
-}
-#endif
-
 struct ZipEntry {
   uint16_t method;
   uint32_t compressedSize;
@@ -223,63 +189,21 @@ public:
     if (!GetFileFreshnessCacheKey(path, &cacheKey)) {
       throw FileNotFound(path);
     }
-#if defined(_WIN32) || defined(_WIN64)
-    buffer = ReadBinaryFile(path);
-    data = buffer.empty() ? nullptr : buffer.data();
-    size = buffer.size();
-#else
-    fd = open(path.c_str(), O_RDONLY);
-    if (fd < 0) {
-      throw FileNotFound(path);
-    }
-    struct stat info;
-    if (fstat(fd, &info) != 0 || info.st_size < 0) {
-      close(fd);
-      fd = -1;
-      throw FileNotFound(path);
-    }
-    size = static_cast<size_t>(info.st_size);
-    if (size == 0) {
-      close(fd);
-      fd = -1;
-      data = nullptr;
-      return;
-    }
-    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (mapped == MAP_FAILED) {
-      close(fd);
-      fd = -1;
-      throw FileNotFound(path);
-    }
-    data = static_cast<const unsigned char*>(mapped);
-#endif
+    file = internal::MappedFile::Open(path);
+    data = reinterpret_cast<const unsigned char*>(file->Data());
+    size = file->Size();
   }
 
   MappedZipArchive(const MappedZipArchive&) = delete;
   MappedZipArchive& operator=(const MappedZipArchive&) = delete;
 
-  ~MappedZipArchive() {
-#if !defined(_WIN32) && !defined(_WIN64)
-    if (data != nullptr) {
-      munmap(const_cast<unsigned char*>(data), size);
-    }
-    if (fd >= 0) {
-      close(fd);
-    }
-#endif
-  }
-
   const std::string fileName;
   std::string cacheKey;
   const unsigned char* data = nullptr;
   size_t size = 0;
 
 private:
-#if defined(_WIN32) || defined(_WIN64)
-  std::vector<unsigned char> buffer;
-#else
-  int fd = -1;
-#endif
+  std::shared_ptr<const internal::MappedFile> file;
 };
 
 } // namespace
@@ -379,27 +303,16 @@ ResourceProvider::Resource::Resource(std::string name_, const char* data_,
 std::shared_ptr<const ResourceProvider::Resource>
 ResourceProvider::GetResource(std::string_view resourceName) const {
   const std::string path = Resolve(resourceName);
-  std::shared_ptr<std::string> content(new std::string);
-#if defined(_WIN32) || defined(_WIN64)
-  const std::vector<unsigned char> data = ReadBinaryFile(path);
-  content->assign(reinterpret_cast<const char*>(data.data()), data.size());
-#else
-  std::ifstream input(path, std::ios::binary);
-  if (!input) {
-    throw FileNotFound(path);
-  }
-  content->assign(std::istreambuf_iterator<char>(input),
-                  std::istreambuf_iterator<char>());
-  if (input.bad()) {
-    throw FileNotFound(path);
-  }
-#endif
+  // Mapped rather than read, so that dictionaries loaded from the resource
+  // can reference its bytes without a private copy.
+  const std::shared_ptr<const internal::MappedFile> content =
+      internal::MappedFile::Open(path);
 
   std::string cacheKey;
   if (!GetFileFreshnessCacheKey(path, &cacheKey)) {
     throw FileNotFound(path);
   }
-  return std::make_shared<Resource>(path, content->data(), content->size(),
+  return std::make_shared<Resource>(path, content->Data(), content->Size(),
                                     content, cacheKey);
 }
 
@@ -0,0 +1,80 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2010-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace opencc {
+namespace internal {
+
+/**
+ * Borrows a per-thread scratch string for the intermediate result of a
+ * multi-stage conversion and returns it on destruction, so converting many
+ * short strings through a pipeline does not allocate one string per stage.
+ *
+ * Each thread keeps a small pool, so nested borrows (a pipeline stage that
+ * is itself a pipeline) and several borrows in one scope never share
+ * storage. Buffers grown by unusually large inputs are released rather than
+ * pooled. Private (non-installed) header.
+ */
+class ScratchString {
+public:
+  ScratchString() {
+    std::vector<std::string>& pool = Pool();
+    if (!pool.empty()) {
+      value.swap(pool.back());
+      pool.pop_back();
+    }
+  }
+
+  ~ScratchString() {
+    std::vector<std::string>& pool = Pool();
+    // The pool's capacity is reserved up front, so returning a buffer never
+    // allocates.
+    if (value.capacity() <= kMaxRetainedCapacity &&
+        pool.size() < pool.capacity()) {
+      value.clear();
+      pool.push_back(std::move(value));
+    }
+  }
+
+  ScratchString(const ScratchString&) = delete;
+  ScratchString& operator=(const ScratchString&) = delete;
+
+  std::string value;
+
+private:
+  static constexpr size_t kMaxRetainedCapacity = 1 << 20;
+  static constexpr size_t kMaxPooledStrings = 8;
+
+  static std::vector<std::string>& Pool() {
+    static thread_local std::vector<std::string> pool = []() {
+      std::vector<std::string> strings;
+      strings.reserve(kMaxPooledStrings);
+      return strings;
+    }();
+    return pool;
+  }
+};
+
+} // namespace internal
+} // namespace opencc
@@ -27,3 +27,8 @@ SegmentsPtr Segmentation::Segment(const char* text) const {
 SegmentsPtr Segmentation::Segment(const std::string& str) const {
   return Segment(std::string_view(str));
 }
+
+bool Segmentation::SegmentSpans(std::string_view,
+                                std::vector<SegmentSpan>*) const {
+  return false;
+}
@@ -50,5 +50,17 @@ public:
 
   /** Convenience overload for std::string. */
   SegmentsPtr Segment(const std::string& str) const;
+
+  /**
+   * Splits @p text into segments and stores them in @p spans as byte ranges
+   * of @p text, replacing its previous contents. Nothing is copied, so a
+   * caller that reuses @p spans segments without per-segment allocations.
+   *
+   * @return false if this segmentation does not support spans (the default),
+   *         in which case @p spans is left unspecified and callers should use
+   *         Segment() instead.
+   */
+  virtual bool SegmentSpans(std::string_view text,
+                            std::vector<SegmentSpan>* spans) const;
 };
 } // namespace opencc
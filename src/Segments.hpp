@@ -20,11 +20,21 @@
 
 #include <cstring>
 #include <iterator>
+#include <string>
 #include <string_view>
 
 #include "Common.hpp"
 
 namespace opencc {
+/**
+ * One segment of a text, as a byte range into that text.
+ * @ingroup opencc_cpp_api
+ */
+struct OPENCC_EXPORT SegmentSpan {
+  size_t offset;
+  size_t length;
+};
+
 /**
  * Segmented text
  * @ingroup opencc_cpp_api
@@ -51,13 +61,13 @@ public:
   }
 
   void AddSegment(const std::string& str) {
-    indexes.push_back(std::make_pair(managed.size(), true));
-    managed.push_back(str);
+    AddSegment(std::string_view(str));
   }
 
   void AddSegment(std::string_view sv) {
     indexes.push_back(std::make_pair(managed.size(), true));
-    managed.emplace_back(sv);
+    managed.append(sv.data(), sv.size());
+    managed.push_back('\0');
   }
 
   class iterator {
@@ -91,7 +101,7 @@ public:
   const char* At(size_t cursor) const {
     const auto& index = indexes[cursor];
     if (index.second) {
-      return managed[index.first].c_str();
+      return managed.c_str() + index.first;
     } else {
       return unmanaged[index.first];
     }
@@ -130,8 +140,10 @@ private:
   Segments(const Segments&) {}
 
   std::vector<const char*> unmanaged;
-  std::vector<std::string> managed;
-  // index, managed
+  // Copies of managed segments, each followed by a NUL terminator, stored
+  // back to back so that adding a segment does not allocate per segment.
+  std::string managed;
+  // index into unmanaged or byte offset into managed, managed
   std::vector<std::pair<size_t, bool>> indexes;
 };
 } // namespace opencc
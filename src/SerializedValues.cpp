@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
@@ -106,8 +107,24 @@ std::shared_ptr<SerializedValues> SerializedValues::NewFromFile(FILE* fp) {
 
 std::shared_ptr<SerializedValues> SerializedValues::NewFromBuffer(
     const char* data, size_t size, size_t* bytesRead) {
+  const ValuesView view = NewViewFromBuffer(data, size, bytesRead);
   std::shared_ptr<SerializedValues> dict(
       new SerializedValues(LexiconPtr(new Lexicon)));
+  for (size_t i = 0; i < view.Length(); i++) {
+    std::vector<std::string> values;
+    values.reserve(view.NumValues(i));
+    for (size_t j = 0; j < view.NumValues(i); j++) {
+      values.emplace_back(view.Value(i, j));
+    }
+    DictEntry* entry = DictEntryFactory::New("", values);
+    dict->lexicon->Add(entry);
+  }
+  return dict;
+}
+
+SerializedValues::ValuesView SerializedValues::NewViewFromBuffer(
+    const char* data, size_t size, size_t* bytesRead) {
+  ValuesView view;
   size_t offset = 0;
 
   // Number of items
@@ -120,42 +137,151 @@ std::shared_ptr<SerializedValues> SerializedValues::NewFromBuffer(
     throw InvalidFormat(
         "Invalid OpenCC binary dictionary (valueTotalLength exceeds file size)");
   }
-  std::string valueBuffer;
-  valueBuffer.resize(valueTotalLength);
-  memcpy(valueBuffer.data(), data + offset, valueTotalLength);
+  view.valueBuffer = data + offset;
   offset += valueTotalLength;
 
-  // Offsets
-  const char* pValueBuffer = valueBuffer.c_str();
-  const char* pValueBufferEnd = pValueBuffer + valueTotalLength;
+  // Offsets. Every item takes at least two bytes, which bounds the
+  // reservation for a corrupt item count.
+  view.numEntries = numItems;
+  view.ownedEntryBegins.reserve(
+      (std::min)(static_cast<size_t>(numItems), (size - offset) / 2) + 1);
+  view.ownedValueOffsets.reserve(
+      (std::min)(static_cast<size_t>(numItems), (size - offset) / 2) + 1);
+  uint32_t valueCursor = 0;
   for (uint32_t i = 0; i < numItems; i++) {
+    view.ownedEntryBegins.push_back(
+        static_cast<uint32_t>(view.ownedValueOffsets.size()));
     // Number of values
     uint16_t numValues = ReadIntegerFromBuffer<uint16_t>(data, size, &offset);
     // Value offset
-    std::vector<std::string> values;
     for (uint16_t j = 0; j < numValues; j++) {
       uint16_t numValueBytes =
           ReadIntegerFromBuffer<uint16_t>(data, size, &offset);
-      if (numValueBytes == 0 || pValueBuffer + numValueBytes > pValueBufferEnd) {
+      if (numValueBytes == 0 ||
+          numValueBytes > valueTotalLength - valueCursor) {
         throw InvalidFormat(
             "Invalid OpenCC binary dictionary (value offset out of bounds)");
       }
-      if (pValueBuffer[numValueBytes - 1] != '\0') {
+      if (view.valueBuffer[valueCursor + numValueBytes - 1] != '\0') {
         throw InvalidFormat(
             "Invalid OpenCC binary dictionary (value not null-terminated)");
       }
-      const char* value = pValueBuffer;
-      pValueBuffer += numValueBytes;
-      values.push_back(value);
+      view.ownedValueOffsets.push_back(valueCursor);
+      valueCursor += numValueBytes;
     }
-    DictEntry* entry = DictEntryFactory::New("", values);
-    dict->lexicon->Add(entry);
   }
+  view.ownedEntryBegins.push_back(
+      static_cast<uint32_t>(view.ownedValueOffsets.size()));
+  view.ownedValueOffsets.push_back(valueCursor);
 
   if (bytesRead != nullptr) {
     *bytesRead = offset;
   }
-  return dict;
+  return view;
+}
+
+void SerializedValues::SerializeFlatToFile(FILE* fp) const {
+  std::vector<uint32_t> entryBegins;
+  std::vector<uint32_t> valueOffsets;
+  entryBegins.reserve(lexicon->Length() + 1);
+  uint32_t poolLength = 0;
+  for (const std::unique_ptr<DictEntry>& entry : *lexicon) {
+    entryBegins.push_back(static_cast<uint32_t>(valueOffsets.size()));
+    for (const auto& value : entry->Values()) {
+      valueOffsets.push_back(poolLength);
+      poolLength += static_cast<uint32_t>(value.length()) + 1;
+    }
+  }
+  entryBegins.push_back(static_cast<uint32_t>(valueOffsets.size()));
+  const uint32_t numValues = static_cast<uint32_t>(valueOffsets.size());
+  valueOffsets.push_back(poolLength);
+
+  WriteInteger(fp, static_cast<uint32_t>(lexicon->Length()));
+  WriteInteger(fp, numValues);
+  WriteInteger(fp, poolLength);
+  WriteInteger(fp, static_cast<uint32_t>(0));
+  if (fwrite(entryBegins.data(), sizeof(uint32_t), entryBegins.size(), fp) !=
+          entryBegins.size() ||
+      fwrite(valueOffsets.data(), sizeof(uint32_t), valueOffsets.size(),
+             fp) != valueOffsets.size()) {
+    throw InvalidFormat("Cannot write binary dictionary.");
+  }
+  for (const std::unique_ptr<DictEntry>& entry : *lexicon) {
+    for (const auto& value : entry->Values()) {
+      if (fwrite(value.c_str(), sizeof(char), value.length() + 1, fp) !=
+          value.length() + 1) {
+        throw InvalidFormat("Cannot write binary dictionary.");
+      }
+    }
+  }
+}
+
+SerializedValues::ValuesView SerializedValues::NewViewFromFlatBuffer(
+    const char* data, size_t size, size_t* bytesRead) {
+  ValuesView view;
+  size_t offset = 0;
+  const uint32_t numEntries =
+      ReadIntegerFromBuffer<uint32_t>(data, size, &offset);
+  const uint32_t numValues =
+      ReadIntegerFromBuffer<uint32_t>(data, size, &offset);
+  const uint32_t poolLength =
+      ReadIntegerFromBuffer<uint32_t>(data, size, &offset);
+  ReadIntegerFromBuffer<uint32_t>(data, size, &offset);
+
+  const uint64_t entryTableBytes =
+      (static_cast<uint64_t>(numEntries) + 1) * sizeof(uint32_t);
+  const uint64_t valueTableBytes =
+      (static_cast<uint64_t>(numValues) + 1) * sizeof(uint32_t);
+  if (entryTableBytes + valueTableBytes + poolLength > size - offset) {
+    throw InvalidFormat(
+        "Invalid OpenCC binary dictionary (value tables exceed file size)");
+  }
+  const char* entryTable = data + offset;
+  const char* valueTable = entryTable + entryTableBytes;
+  view.valueBuffer = valueTable + valueTableBytes;
+  view.numEntries = numEntries;
+  if (reinterpret_cast<uintptr_t>(data) % alignof(uint32_t) == 0) {
+    view.entryBegins = reinterpret_cast<const uint32_t*>(entryTable);
+    view.valueOffsets = reinterpret_cast<const uint32_t*>(valueTable);
+  } else {
+    view.ownedEntryBegins.resize(static_cast<size_t>(numEntries) + 1);
+    memcpy(view.ownedEntryBegins.data(), entryTable, entryTableBytes);
+    view.ownedValueOffsets.resize(static_cast<size_t>(numValues) + 1);
+    memcpy(view.ownedValueOffsets.data(), valueTable, valueTableBytes);
+  }
+
+  // Validate once so that lookups can index without bounds checks.
+  const uint32_t* begins = view.EntryBegins();
+  if (begins[0] != 0 || begins[numEntries] != numValues) {
+    throw InvalidFormat(
+        "Invalid OpenCC binary dictionary (entry table out of bounds)");
+  }
+  for (uint32_t i = 0; i < numEntries; i++) {
+    if (begins[i + 1] < begins[i]) {
+      throw InvalidFormat(
+          "Invalid OpenCC binary dictionary (entry table out of order)");
+    }
+  }
+  const uint32_t* offsets = view.ValueOffsets();
+  if (offsets[0] != 0 || offsets[numValues] != poolLength) {
+    throw InvalidFormat(
+        "Invalid OpenCC binary dictionary (value offset out of bounds)");
+  }
+  for (uint32_t i = 0; i < numValues; i++) {
+    if (offsets[i + 1] <= offsets[i] || offsets[i + 1] > poolLength) {
+      throw InvalidFormat(
+          "Invalid OpenCC binary dictionary (value offset out of bounds)");
+    }
+    if (view.valueBuffer[offsets[i + 1] - 1] != '\0') {
+      throw InvalidFormat(
+          "Invalid OpenCC binary dictionary (value not null-terminated)");
+    }
+  }
+
+  if (bytesRead != nullptr) {
+    *bytesRead = offset + entryTableBytes + valueTableBytes + poolLength;
+  }
+  return view;
 }
 
 void SerializedValues::ConstructBuffer(std::string* valueBuffer,
@@ -19,6 +19,8 @@
 #pragma once
 
 #include <cstdint>
+#include <string_view>
+#include <vector>
 
 #include "Common.hpp"
 #include "SerializableDict.hpp"
@@ -36,11 +38,84 @@ public:
 
   virtual void SerializeToFile(FILE* fp) const;
 
+  /**
+   * Read-only index over serialized values that stay in the buffer they were
+   * parsed from. Values are returned as views into that buffer, so it must
+   * outlive the index; no DictEntry is created. For the flat layout the
+   * offset tables are read in place as well, otherwise they are built at
+   * parse time at one offset per value and one per entry.
+   */
+  class OPENCC_EXPORT ValuesView {
+  public:
+    /** Number of entries. */
+    size_t Length() const { return numEntries; }
+
+    size_t NumValues(size_t index) const {
+      const uint32_t* begins = EntryBegins();
+      return begins[index + 1] - begins[index];
+    }
+
+    std::string_view Value(size_t index, size_t valueIndex) const {
+      const uint32_t* offsets = ValueOffsets();
+      const size_t cursor = EntryBegins()[index] + valueIndex;
+      // Each value is followed by its NUL terminator.
+      return std::string_view(valueBuffer + offsets[cursor],
+                              offsets[cursor + 1] - offsets[cursor] - 1);
+    }
+
+  private:
+    friend class SerializedValues;
+
+    const uint32_t* EntryBegins() const {
+      return entryBegins != nullptr ? entryBegins : ownedEntryBegins.data();
+    }
+
+    const uint32_t* ValueOffsets() const {
+      return valueOffsets != nullptr ? valueOffsets : ownedValueOffsets.data();
+    }
+
+    const char* valueBuffer = nullptr;
+    size_t numEntries = 0;
+    // Index into the value offsets of each entry's first value, plus an end
+    // mark; points into the parsed buffer, or is null when the table is held
+    // in ownedEntryBegins.
+    const uint32_t* entryBegins = nullptr;
+    // Offset of each value in valueBuffer, plus the buffer length; likewise
+    // null when held in ownedValueOffsets.
+    const uint32_t* valueOffsets = nullptr;
+    std::vector<uint32_t> ownedEntryBegins;
+    std::vector<uint32_t> ownedValueOffsets;
+  };
+
   static std::shared_ptr<SerializedValues> NewFromFile(FILE* fp);
   static std::shared_ptr<SerializedValues> NewFromBuffer(const char* data,
                                                          size_t size,
                                                          size_t* bytesRead);
 
+  /**
+   * Parses serialized values in place. Validates the data like
+   * NewFromBuffer() and throws InvalidFormat on malformed input.
+   */
+  static ValuesView NewViewFromBuffer(const char* data, size_t size,
+                                      size_t* bytesRead);
+
+  /**
+   * Writes the values in the flat layout: a header of four uint32 (entry
+   * count, value count, string pool length, reserved), the entry table, the
+   * value offset table, then the string pool of NUL-terminated values. Both
+   * tables carry a trailing end mark, so looking up a value is two array
+   * reads with no decoding.
+   */
+  void SerializeFlatToFile(FILE* fp) const;
+
+  /**
+   * Parses values written by SerializeFlatToFile(). The tables are used in
+   * place when @p data is 4-byte aligned. Throws InvalidFormat on malformed
+   * input.
+   */
+  static ValuesView NewViewFromFlatBuffer(const char* data, size_t size,
+                                          size_t* bytesRead);
+
   const LexiconPtr& GetLexicon() const { return lexicon; }
 
   size_t KeyMaxLength() const;
@@ -134,6 +134,47 @@ TEST_F(SerializedValuesTest, AcceptsWellFormedFile) {
   std::remove(path.c_str());
 }
 
+TEST_F(SerializedValuesTest, FlatLayoutRoundTrip) {
+  const std::string path = "dict_flat.bin";
+  FILE* fp = fopen(path.c_str(), "wb");
+  binDict->SerializeFlatToFile(fp);
+  fclose(fp);
+  std::string content;
+  fp = fopen(path.c_str(), "rb");
+  char chunk[4096];
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+    content.append(chunk, length);
+  }
+  fclose(fp);
+  std::remove(path.c_str());
+
+  size_t bytesRead = 0;
+  const SerializedValues::ValuesView view =
+      SerializedValues::NewViewFromFlatBuffer(content.data(), content.size(),
+                                              &bytesRead);
+  EXPECT_EQ(content.size(), bytesRead);
+  const LexiconPtr& lexicon = binDict->GetLexicon();
+  ASSERT_EQ(lexicon->Length(), view.Length());
+  for (size_t i = 0; i < lexicon->Length(); i++) {
+    const std::vector<std::string> values = lexicon->At(i)->Values();
+    ASSERT_EQ(values.size(), view.NumValues(i));
+    for (size_t j = 0; j < values.size(); j++) {
+      EXPECT_EQ(values[j], view.Value(i, j));
+    }
+  }
+
+  // A value offset past the string pool must be rejected.
+  const size_t numEntries = lexicon->Length();
+  std::string corrupt = content;
+  const uint32_t badOffset = 0xFFFF;
+  memcpy(&corrupt[16 + (numEntries + 1) * sizeof(uint32_t) + 4], &badOffset,
+         sizeof(badOffset));
+  EXPECT_THROW(SerializedValues::NewViewFromFlatBuffer(
+                   corrupt.data(), corrupt.size(), &bytesRead),
+               InvalidFormat);
+}
+
 // Test that valueTotalLength exceeding file size triggers InvalidFormat (#812).
 TEST_F(SerializedValuesTest, RejectsHugeValueTotalLength) {
   // File only has a few bytes, but claims valueTotalLength = 0xFFFFFFFF.
@@ -20,6 +20,8 @@
 
 #include "Config.hpp"
 #include "Converter.hpp"
+#include "ScratchString.hpp"
+#include "StreamWindow.hpp"
 #include "UTF8Util.hpp"
 #include "opencc.h"
 
@@ -139,6 +141,28 @@ std::string SimpleConverter::Convert(std::string_view input) const {
   }
 }
 
+std::string SimpleConverter::ConvertParallel(std::string_view input,
+                                             size_t threads) const {
+  try {
+    const InternalData* data = (InternalData*)internalData;
+    return data->converter->ConvertParallel(input, threads);
+  } catch (Exception& ex) {
+    throw std::runtime_error(ex.what());
+  }
+}
+
+void SimpleConverter::ConvertBatch(const std::vector<std::string_view>& inputs,
+                                   std::string* output,
+                                   std::vector<size_t>* offsets,
+                                   size_t threads) const {
+  try {
+    const InternalData* data = (InternalData*)internalData;
+    data->converter->ConvertBatch(inputs, output, offsets, threads);
+  } catch (Exception& ex) {
+    throw std::runtime_error(ex.what());
+  }
+}
+
 std::string SimpleConverter::Convert(const char* input) const {
   return Convert(std::string_view(input));
 }
@@ -152,14 +176,7 @@ std::string SimpleConverter::Convert(const char* input, size_t length) const {
 }
 
 size_t SimpleConverter::Convert(const char* input, char* output) const {
-  try {
-    const InternalData* data = (InternalData*)internalData;
-    const std::string converted = data->converter->Convert(input);
-    strcpy(output, converted.c_str());
-    return converted.length();
-  } catch (Exception& ex) {
-    throw std::runtime_error(ex.what());
-  }
+  return ConvertToBuffer(input, output, static_cast<size_t>(-1));
 }
 
 size_t SimpleConverter::Convert(const char* input, size_t length,
@@ -167,8 +184,35 @@ size_t SimpleConverter::Convert(const char* input, size_t length,
   if (length == static_cast<size_t>(-1)) {
     return Convert(input, output);
   } else {
-    std::string trimmed = UTF8Util::FromSubstr(input, length);
-    return Convert(trimmed.c_str(), output);
+    return ConvertToBuffer(std::string_view(input, length), output,
+                           static_cast<size_t>(-1));
+  }
+}
+
+size_t SimpleConverter::ConvertToBuffer(std::string_view input, char* output,
+                                        size_t capacity) const {
+  try {
+    const InternalData* data = (InternalData*)internalData;
+    internal::ScratchString converted;
+    data->converter->AppendConverted(input, &converted.value);
+    const size_t length = converted.value.length();
+    if (capacity > 0) {
+      size_t copied = length;
+      if (copied >= capacity) {
+        // Do not end the truncated text in the middle of a character.
+        copied = capacity - 1;
+        while (copied > 0 &&
+               (static_cast<unsigned char>(converted.value[copied]) & 0xC0) ==
+                   0x80) {
+          copied--;
+        }
+      }
+      memcpy(output, converted.value.data(), copied);
+      output[copied] = '\0';
+    }
+    return length;
+  } catch (Exception& ex) {
+    throw std::runtime_error(ex.what());
   }
 }
 
@@ -182,6 +226,26 @@ SimpleConverter::Inspect(std::string_view input) const {
   }
 }
 
+std::shared_ptr<Converter> SimpleConverter::GetConverter() const {
+  const InternalData* data = (InternalData*)internalData;
+  return data->converter;
+}
+
+std::shared_ptr<ConverterStats> SimpleConverter::EnableStats() {
+  const InternalData* data = (InternalData*)internalData;
+  return data->converter->EnableStats();
+}
+
+void SimpleConverter::DisableStats() {
+  const InternalData* data = (InternalData*)internalData;
+  data->converter->DisableStats();
+}
+
+std::shared_ptr<ConverterStats> SimpleConverter::GetStats() const {
+  const InternalData* data = (InternalData*)internalData;
+  return data->converter->GetStats();
+}
+
 static std::string cError;
 
 opencc_t opencc_open_internal(const char* configFileName) {
@@ -245,6 +309,25 @@ size_t opencc_convert_utf8_to_buffer(opencc_t opencc, const char* input,
   }
 }
 
+size_t opencc_convert_utf8_to_sized_buffer(opencc_t opencc, const char* input,
+                                           size_t length, char* output,
+                                           size_t capacity) {
+  try {
+    SimpleConverter* instance = reinterpret_cast<SimpleConverter*>(opencc);
+    if (length == static_cast<size_t>(-1)) {
+      return instance->ConvertToBuffer(input, output, capacity);
+    }
+    return instance->ConvertToBuffer(std::string_view(input, length), output,
+                                     capacity);
+  } catch (Exception& ex) {
+    cError = ex.what();
+    return static_cast<size_t>(-1);
+  } catch (std::exception& ex) {
+    cError = ex.what();
+    return static_cast<size_t>(-1);
+  }
+}
+
 char* opencc_convert_utf8(opencc_t opencc, const char* input, size_t length) {
   try {
     SimpleConverter* instance = reinterpret_cast<SimpleConverter*>(opencc);
@@ -259,6 +342,94 @@ char* opencc_convert_utf8(opencc_t opencc, const char* input, size_t length) {
   }
 }
 
+char* opencc_convert_utf8_batch(opencc_t opencc, const char* const* inputs,
+                                const size_t* lengths, size_t count,
+                                size_t threads, size_t* offsets) {
+  try {
+    SimpleConverter* instance = reinterpret_cast<SimpleConverter*>(opencc);
+    std::vector<std::string_view> views(count);
+    for (size_t i = 0; i < count; i++) {
+      if (lengths == nullptr || lengths[i] == static_cast<size_t>(-1)) {
+        views[i] = std::string_view(inputs[i]);
+      } else {
+        views[i] = std::string_view(inputs[i], lengths[i]);
+      }
+    }
+    std::string converted;
+    std::vector<size_t> convertedOffsets;
+    instance->ConvertBatch(views, &converted, &convertedOffsets, threads);
+    char* output = new char[converted.length() + 1];
+    memcpy(output, converted.c_str(), converted.length());
+    output[converted.length()] = '\0';
+    memcpy(offsets, convertedOffsets.data(), (count + 1) * sizeof(size_t));
+    return output;
+  } catch (Exception& ex) {
+    cError = ex.what();
+    return nullptr;
+  } catch (std::exception& ex) {
+    cError = ex.what();
+    return nullptr;
+  }
+}
+
 void opencc_convert_utf8_free(char* str) { delete[] str; }
 
+opencc_stream_t opencc_stream_open(opencc_t opencc, size_t maxKeepChars) {
+  try {
+    SimpleConverter* instance = reinterpret_cast<SimpleConverter*>(opencc);
+    if (maxKeepChars == 0) {
+      maxKeepChars = internal::kDefaultStreamKeepChars;
+    }
+    return new ConverterStream(instance->GetConverter(), maxKeepChars);
+  } catch (std::exception& ex) {
+    cError = ex.what();
+    return nullptr;
+  }
+}
+
+int opencc_stream_feed(opencc_stream_t stream, const char* input,
+                       size_t length, opencc_stream_output_fn output,
+                       void* userData) {
+  try {
+    ConverterStream* instance = reinterpret_cast<ConverterStream*>(stream);
+    const std::string converted = instance->ConvertChunk(
+        length == static_cast<size_t>(-1) ? std::string_view(input)
+                                          : std::string_view(input, length));
+    if (!converted.empty()) {
+      output(converted.data(), converted.length(), userData);
+    }
+    return 0;
+  } catch (Exception& ex) {
+    cError = ex.what();
+    return -1;
+  } catch (std::exception& ex) {
+    cError = ex.what();
+    return -1;
+  }
+}
+
+int opencc_stream_finish(opencc_stream_t stream,
+                         opencc_stream_output_fn output, void* userData) {
+  try {
+    ConverterStream* instance = reinterpret_cast<ConverterStream*>(stream);
+    const std::string converted = instance->Finish();
+    if (!converted.empty()) {
+      output(converted.data(), converted.length(), userData);
+    }
+    return 0;
+  } catch (Exception& ex) {
+    cError = ex.what();
+    return -1;
+  } catch (std::exception& ex) {
+    cError = ex.what();
+    return -1;
+  }
+}
+
+int opencc_stream_close(opencc_stream_t stream) {
+  ConverterStream* instance = reinterpret_cast<ConverterStream*>(stream);
+  delete instance;
+  return 0;
+}
+
 const char* opencc_error(void) { return cError.c_str(); }
@@ -36,6 +36,8 @@
 
 namespace opencc {
 
+class Converter;
+class ConverterStats;
 struct ConfigLoadOptions;
 
 /**
@@ -134,6 +136,29 @@ public:
    */
   std::string Convert(std::string_view input) const;
 
+  /**
+   * Converts a large text on up to @p threads threads, splitting it after
+   * line feeds. The result is identical to Convert(@p input).
+   * @param input   Text to be converted.
+   * @param threads Maximum number of threads, or 0 to use one per hardware
+   *                thread.
+   */
+  std::string ConvertParallel(std::string_view input, size_t threads = 0) const;
+
+  /**
+   * Converts many texts in one call, storing the results back to back in
+   * @p output. Result @c i occupies [offsets[i], offsets[i + 1]) of
+   * @p output; see Converter::ConvertBatch().
+   * @param inputs  Texts to be converted.
+   * @param output  Receives the concatenated results.
+   * @param offsets Receives inputs.size() + 1 offsets into @p output.
+   * @param threads Maximum number of threads, or 0 to use one per hardware
+   *                thread.
+   */
+  void ConvertBatch(const std::vector<std::string_view>& inputs,
+                    std::string* output, std::vector<size_t>* offsets,
+                    size_t threads = 1) const;
+
   /**
    * Converts a text
    * @param input A C-Style std::string (terminated by '\0') to be converted.
@@ -150,7 +175,8 @@ public:
 
   /**
    * Converts a text and writes to an allocated buffer
-   * Please make sure the buffer has sufficient space.
+   * Please make sure the buffer has sufficient space, or use
+   * ConvertToBuffer() to bound the output.
    * @param input  A C-Style std::string (terminated by '\0') to be converted.
    * @param output Buffer to write the converted text.
    * @return       Length of converted text.
@@ -168,6 +194,26 @@ public:
    */
   size_t Convert(const char* input, size_t length, char* output) const;
 
+  /**
+   * Converts a text into a buffer of @p capacity bytes, snprintf-style.
+   *
+   * Writes the converted text and a terminating '\0' if they fit. Otherwise
+   * writes the longest prefix of complete UTF-8 characters that fits,
+   * followed by '\0'; nothing is written when @p capacity is 0, in which
+   * case @p output may be null. Converts into a per-thread scratch buffer
+   * that keeps its capacity between calls, so a caller reusing one output
+   * buffer does not allocate per call.
+   * @param input    Text to be converted.
+   * @param output   Buffer to write the converted text.
+   * @param capacity Size of @p output in bytes, including room for '\0'.
+   * @return         Length of the whole converted text, excluding '\0'. The
+   *                 text was written completely if and only if this is less
+   *                 than @p capacity; otherwise retry with a buffer of at
+   *                 least the returned length plus one.
+   */
+  size_t ConvertToBuffer(std::string_view input, char* output,
+                         size_t capacity) const;
+
   /**
    * Inspects the conversion process for a given text.
    * Returns the segmentation result, per-stage conversion outputs, and final
@@ -176,6 +222,27 @@ public:
    */
   ConversionInspectionResult Inspect(std::string_view input) const;
 
+  /**
+   * Returns the converter this instance wraps, for use with the
+   * comprehensive API, e.g. to build a ConverterStream.
+   */
+  std::shared_ptr<Converter> GetConverter() const;
+
+  /**
+   * Starts recording conversions and returns the collector; see
+   * Converter::EnableStats(). Instances wrapping the same converter share
+   * it.
+   */
+  std::shared_ptr<ConverterStats> EnableStats();
+
+  /** Stops recording conversions; see Converter::DisableStats(). */
+  void DisableStats();
+
+  /**
+   * Returns the collector while stats are enabled, or @c nullptr otherwise.
+   */
+  std::shared_ptr<ConverterStats> GetStats() const;
+
 private:
   const void* internalData;
 };
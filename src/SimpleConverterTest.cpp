@@ -16,8 +16,11 @@
  * limitations under the License.
  */
 
-#include <thread>
+#include <cstring>
+#include <iterator>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include "ConfigTestBase.hpp"
 #include "SimpleConverter.hpp"
@@ -51,6 +54,58 @@ TEST_F(SimpleConverterTest, Multithreading) {
   thread2.join();
 }
 
+TEST_F(SimpleConverterTest, ConvertParallelMatchesConvert) {
+  const SimpleConverter converter(CONFIG_TEST_JSON_PATH);
+  std::string text;
+  for (size_t i = 0; text.size() < 512 * 1024; i++) {
+    text += utf8("燕燕于飞差池其羽之子于归远送于野");
+    text += (i % 7 == 0) ? "\n" : " ";
+  }
+  const std::string expected = converter.Convert(std::string_view(text));
+  EXPECT_EQ(expected, converter.ConvertParallel(text, 4));
+  EXPECT_EQ(expected, converter.ConvertParallel(text, 1));
+  EXPECT_EQ(expected, converter.ConvertParallel(text));
+
+  const std::string singleLine(text.size(), 'x');
+  EXPECT_EQ(singleLine, converter.ConvertParallel(singleLine, 4));
+  EXPECT_EQ("", converter.ConvertParallel("", 4));
+}
+
+TEST_F(SimpleConverterTest, ConvertBatchMatchesConvert) {
+  const SimpleConverter converter(CONFIG_TEST_JSON_PATH);
+  // Large enough in total to be split into runs converted on several threads.
+  std::vector<std::string> texts;
+  size_t totalBytes = 0;
+  for (size_t i = 0; totalBytes < 512 * 1024; i++) {
+    std::string text = utf8("燕燕于飞差池其羽之子于归远送于野");
+    text.resize((i * 7) % text.size());
+    texts.push_back(text + std::to_string(i));
+    totalBytes += texts.back().size();
+  }
+  texts.push_back("");
+  const std::vector<std::string_view> inputs(texts.begin(), texts.end());
+
+  for (size_t threads : {1, 4, 0}) {
+    std::string output;
+    std::vector<size_t> offsets;
+    converter.ConvertBatch(inputs, &output, &offsets, threads);
+    ASSERT_EQ(inputs.size() + 1, offsets.size());
+    EXPECT_EQ(0, offsets.front());
+    EXPECT_EQ(output.size(), offsets.back());
+    for (size_t i = 0; i < inputs.size(); i++) {
+      ASSERT_EQ(converter.Convert(inputs[i]),
+                output.substr(offsets[i], offsets[i + 1] - offsets[i]))
+          << "threads " << threads << ", item " << i;
+    }
+  }
+
+  std::string output = "stale";
+  std::vector<size_t> offsets = {1, 2, 3};
+  converter.ConvertBatch({}, &output, &offsets, 4);
+  EXPECT_EQ("", output);
+  EXPECT_EQ(std::vector<size_t>{0}, offsets);
+}
+
 TEST_F(SimpleConverterTest, CInterface) {
   const std::string& text = utf8("燕燕于飞差池其羽之子于归远送于野");
   const std::string& expected = utf8("燕燕于飛差池其羽之子于歸遠送於野");
@@ -70,6 +125,78 @@ TEST_F(SimpleConverterTest, CInterface) {
     EXPECT_EQ(expected, output);
     EXPECT_EQ(0, opencc_close(od));
   }
+  {
+    opencc_t od = opencc_open(CONFIG_TEST_JSON_PATH.c_str());
+    const std::string first = utf8("远送于野");
+    const char* inputs[] = {text.c_str(), first.c_str(), ""};
+    const size_t lengths[] = {(size_t)-1, utf8("远送").size(), 0};
+    size_t offsets[4];
+    char* converted =
+        opencc_convert_utf8_batch(od, inputs, lengths, 3, 1, offsets);
+    EXPECT_EQ(expected + utf8("遠送"), converted);
+    EXPECT_EQ(0, offsets[0]);
+    EXPECT_EQ(expected.length(), offsets[1]);
+    EXPECT_EQ(offsets[3], offsets[2]);
+    EXPECT_EQ(strlen(converted), offsets[3]);
+    opencc_convert_utf8_free(converted);
+
+    converted = opencc_convert_utf8_batch(od, inputs, nullptr, 2, 0, offsets);
+    EXPECT_EQ(expected + utf8("遠送於野"), converted);
+    opencc_convert_utf8_free(converted);
+    EXPECT_EQ(0, opencc_close(od));
+  }
+  {
+    opencc_t od = opencc_open(CONFIG_TEST_JSON_PATH.c_str());
+    EXPECT_EQ(expected.length(), opencc_convert_utf8_to_sized_buffer(
+                                     od, text.c_str(), (size_t)-1, nullptr, 0));
+
+    std::vector<char> output(expected.length() + 1, 'x');
+    EXPECT_EQ(expected.length(),
+              opencc_convert_utf8_to_sized_buffer(od, text.c_str(), text.size(),
+                                                  output.data(),
+                                                  output.size()));
+    EXPECT_EQ(expected, output.data());
+
+    // One byte short: the last character is dropped rather than cut.
+    EXPECT_EQ(expected.length(),
+              opencc_convert_utf8_to_sized_buffer(od, text.c_str(), (size_t)-1,
+                                                  output.data(),
+                                                  output.size() - 1));
+    EXPECT_EQ(expected.substr(0, expected.length() - utf8("野").length()),
+              output.data());
+    EXPECT_EQ(0, opencc_close(od));
+  }
+  {
+    opencc_t od = opencc_open(CONFIG_TEST_JSON_PATH.c_str());
+    opencc_stream_t stream = opencc_stream_open(od, 0);
+    ASSERT_NE(nullptr, stream);
+    EXPECT_EQ(0, opencc_close(od));
+    const auto append = [](const char* data, size_t length, void* userData) {
+      static_cast<std::string*>(userData)->append(data, length);
+    };
+    // Pieces ending inside a character, fed twice to check that a finished
+    // stream starts over. The first piece is shorter than the kept tail.
+    const std::string longText = text + text + text;
+    const size_t cuts[] = {0, text.size() + 1, 2 * text.size() + 1,
+                           longText.size()};
+    std::string converted;
+    for (size_t round = 0; round < 2; round++) {
+      for (size_t i = 0; i + 1 < std::size(cuts); i++) {
+        EXPECT_EQ(0, opencc_stream_feed(stream, longText.c_str() + cuts[i],
+                                        cuts[i + 1] - cuts[i], append,
+                                        &converted));
+        EXPECT_EQ(i == 0, converted.empty());
+      }
+      EXPECT_EQ(0, opencc_stream_finish(stream, append, &converted));
+      EXPECT_EQ(expected + expected + expected, converted);
+      converted.clear();
+    }
+    EXPECT_EQ(0, opencc_stream_feed(stream, text.c_str(), (size_t)-1, append,
+                                    &converted));
+    EXPECT_EQ(0, opencc_stream_finish(stream, append, &converted));
+    EXPECT_EQ(expected, converted);
+    EXPECT_EQ(0, opencc_stream_close(stream));
+  }
   {
     std::string path = "/opencc/no/such/file/or/directory";
     opencc_t od = opencc_open(path.c_str());
@@ -16,26 +16,89 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <cstring>
+
 #include "SingleStageConverter.hpp"
 
 #include "ConversionChain.hpp"
 #include "ConversionInspection.hpp"
+#include "ConverterStats.hpp"
 #include "Segments.hpp"
 
 using namespace opencc;
 
+namespace {
+
+// Segment boundaries are collected into a per-thread vector that keeps its
+// capacity between calls, so converting a document does not allocate one
+// string per segment. The vector is trimmed after unusually large inputs.
+constexpr size_t kMaxRetainedSpanCapacity = 1 << 16;
+
+std::vector<SegmentSpan>& ThreadSpans() {
+  static thread_local std::vector<SegmentSpan> spans;
+  return spans;
+}
+
+} // namespace
+
 std::string SingleStageConverter::Convert(std::string_view text) const {
   std::string converted;
   converted.reserve(text.length() + text.length() / 5);
+  AppendConverted(text, &converted);
+  return converted;
+}
+
+void SingleStageConverter::AppendConverted(std::string_view text,
+                                           std::string* output) const {
+  if (AppendConvertedIfRecording(text, output)) {
+    return;
+  }
   if (segmentation == nullptr) {
-    conversionChain->AppendConvertedSegment(text, &converted);
-    return converted;
+    conversionChain->AppendConvertedSegment(text, output);
+    return;
+  }
+  std::vector<SegmentSpan>& spans = ThreadSpans();
+  if (segmentation->SegmentSpans(text, &spans)) {
+    conversionChain->AppendConvertedSegments(text, spans, output);
+    if (spans.capacity() > kMaxRetainedSpanCapacity) {
+      std::vector<SegmentSpan>().swap(spans);
+    }
+    return;
   }
   const SegmentsPtr& segments = segmentation->Segment(text);
   for (const char* segment : *segments) {
-    conversionChain->AppendConvertedSegment(segment, &converted);
+    conversionChain->AppendConvertedSegment(segment, output);
+  }
+}
+
+void SingleStageConverter::AppendConvertedProfiled(
+    std::string_view text, std::string* output,
+    ConversionProfile* profile) const {
+  std::vector<SegmentSpan>& spans = ThreadSpans();
+  // Segmentations without span support produce copies of the segments,
+  // which are joined so that the chain can run over spans of one buffer.
+  std::string joined;
+  std::string_view segmented = text;
+  const auto start = std::chrono::steady_clock::now();
+  if (segmentation == nullptr) {
+    spans.assign(1, SegmentSpan{0, text.size()});
+  } else if (!segmentation->SegmentSpans(text, &spans)) {
+    const SegmentsPtr& segments = segmentation->Segment(text);
+    spans.clear();
+    for (const char* segment : *segments) {
+      const size_t length = strlen(segment);
+      spans.push_back(SegmentSpan{joined.size(), length});
+      joined.append(segment, length);
+    }
+    segmented = joined;
+  }
+  profile->segmentationNanos += internal::NanosSince(start);
+  conversionChain->AppendConvertedSegmentsProfiled(segmented, spans, output,
+                                                   profile);
+  if (spans.capacity() > kMaxRetainedSpanCapacity) {
+    std::vector<SegmentSpan>().swap(spans);
   }
-  return converted;
 }
 
 ConversionInspectionResult
@@ -43,10 +106,21 @@ SingleStageConverter::Inspect(std::string_view text) const {
   ConversionInspectionResult result;
   result.input = text;
 
+  // Segmented through SegmentSpans() like AppendConverted(); the stages of
+  // the trace still take Segments, which hold the spans in one arena.
   SegmentsPtr initialSegments;
+  std::vector<SegmentSpan>& spans = ThreadSpans();
   if (segmentation == nullptr) {
     initialSegments.reset(new Segments);
     initialSegments->AddSegment(text);
+  } else if (segmentation->SegmentSpans(text, &spans)) {
+    initialSegments.reset(new Segments);
+    for (const SegmentSpan& span : spans) {
+      initialSegments->AddSegment(text.substr(span.offset, span.length));
+    }
+    if (spans.capacity() > kMaxRetainedSpanCapacity) {
+      std::vector<SegmentSpan>().swap(spans);
+    }
   } else {
     initialSegments = segmentation->Segment(text);
   }
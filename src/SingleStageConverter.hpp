@@ -47,6 +47,12 @@ public:
 
   std::string Convert(std::string_view text) const override;
 
+  void AppendConverted(std::string_view text,
+                       std::string* output) const override;
+
+  void AppendConvertedProfiled(std::string_view text, std::string* output,
+                               ConversionProfile* profile) const override;
+
   ConversionInspectionResult Inspect(std::string_view text) const override;
 
   SegmentationPtr GetSegmentation() const override { return segmentation; }
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 #include <string_view>
 
 #include "UTF8Util.hpp"
@@ -93,5 +94,31 @@ inline size_t FlushableByteCount(std::string_view pending,
   return static_cast<size_t>(keepStart - bufferBegin);
 }
 
+/**
+ * Returns the smallest offset not below @p target at which @p text may be
+ * split into two independently converted pieces, or text.size() if there is
+ * none.
+ *
+ * Only offsets directly after a line feed qualify.  Dictionary keys come from
+ * line-oriented sources and never contain '\n', and ideographic description
+ * sequences consist of ideographs only, so neither a segmentation match nor a
+ * conversion match can straddle such an offset.  Converting the two pieces
+ * separately therefore yields exactly the bytes of converting the whole.
+ * Unlike FlushableByteCount(), which trades exactness for a bounded window,
+ * this boundary is exact; ConvertParallel relies on that.
+ */
+inline size_t ParallelCutOffset(std::string_view text, size_t target) {
+  if (target == 0 || target >= text.size()) {
+    return target == 0 ? 0 : text.size();
+  }
+  const void* newline =
+      std::memchr(text.data() + target - 1, '\n', text.size() - target + 1);
+  if (newline == nullptr) {
+    return text.size();
+  }
+  return static_cast<size_t>(static_cast<const char*>(newline) - text.data()) +
+         1;
+}
+
 } // namespace internal
 } // namespace opencc
@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cassert>
 
+#include "FlatLexicon.hpp"
 #include "Lexicon.hpp"
 #include "TextDict.hpp"
 
@@ -34,11 +35,19 @@ static size_t GetKeyMaxLength(const LexiconPtr& lexicon) {
 }
 
 TextDict::TextDict(const LexiconPtr& _lexicon)
-    : maxLength(GetKeyMaxLength(_lexicon)), lexicon(_lexicon) {
+    : maxLength(GetKeyMaxLength(_lexicon)), lexicon(_lexicon),
+      lexiconConstructed(true) {
   assert(lexicon->IsSorted());
   assert(lexicon->IsUnique());
 }
 
+TextDict::TextDict(const FlatLexiconPtr& _lexicon)
+    : maxLength(_lexicon->KeyMaxLength()), flatLexicon(_lexicon),
+      lexiconConstructed(false) {
+  assert(flatLexicon->IsSorted());
+  assert(flatLexicon->IsUnique());
+}
+
 TextDict::~TextDict() {}
 
 TextDictPtr TextDict::NewFromSortedFile(FILE* fp) {
@@ -51,9 +60,8 @@ TextDictPtr TextDict::NewFromFile(FILE* fp) {
 }
 
 TextDictPtr TextDict::NewFromFile(FILE* fp, char keyValueDelimiter) {
-  const LexiconPtr& lexicon =
-      Lexicon::ParseLexiconFromFile(fp, keyValueDelimiter);
-  lexicon->Sort();
+  const FlatLexiconPtr& lexicon =
+      FlatLexicon::ParseSortedFromFile(fp, keyValueDelimiter);
   std::string dupkey;
   if (!lexicon->IsUnique(&dupkey)) {
     throw InvalidFormat(
@@ -63,8 +71,8 @@ TextDictPtr TextDict::NewFromFile(FILE* fp, char keyValueDelimiter) {
 }
 
 TextDictPtr TextDict::NewFromBuffer(const char* data, size_t size) {
-  const LexiconPtr& lexicon = Lexicon::ParseLexiconFromBuffer(data, size);
-  lexicon->Sort();
+  const FlatLexiconPtr& lexicon =
+      FlatLexicon::ParseSortedFromBuffer(data, size);
   std::string dupkey;
   if (!lexicon->IsUnique(&dupkey)) {
     throw InvalidFormat(
@@ -80,6 +88,13 @@ TextDictPtr TextDict::NewFromDict(const Dict& dict) {
 size_t TextDict::KeyMaxLength() const { return maxLength; }
 
 Optional<const DictEntry*> TextDict::Match(const char* word, size_t len) const {
+  if (flatLexicon != nullptr) {
+    const size_t index = flatLexicon->Find(std::string_view(word, len));
+    if (index == flatLexicon->Length()) {
+      return Optional<const DictEntry*>::Null();
+    }
+    return Optional<const DictEntry*>(flatLexicon->GetDictEntry(index));
+  }
   std::unique_ptr<DictEntry> entry(
       new NoValueDictEntry(std::string(word, len)));
   const auto& found = std::lower_bound(lexicon->begin(), lexicon->end(), entry,
@@ -91,9 +106,25 @@ Optional<const DictEntry*> TextDict::Match(const char* word, size_t len) const {
   }
 }
 
-LexiconPtr TextDict::GetLexicon() const { return lexicon; }
+LexiconPtr TextDict::GetLexicon() const {
+  if (lexiconConstructed.load(std::memory_order_acquire)) {
+    return lexicon;
+  }
+  std::lock_guard<std::mutex> lock(lexiconMutex);
+  if (!lexiconConstructed.load(std::memory_order_relaxed)) {
+    lexicon = flatLexicon->ToLexicon();
+    lexiconConstructed.store(true, std::memory_order_release);
+  }
+  return lexicon;
+}
 
 void TextDict::SerializeToFile(FILE* fp) const {
+  if (flatLexicon != nullptr) {
+    for (const FlatLexicon::EntryView entry : *flatLexicon) {
+      fprintf(fp, "%s\n", entry.ToString().c_str());
+    }
+    return;
+  }
   for (const auto& entry : *lexicon) {
     fprintf(fp, "%s\n", entry->ToString().c_str());
   }
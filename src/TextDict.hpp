@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include "Common.hpp"
 #include "SerializableDict.hpp"
 
@@ -34,6 +37,14 @@ public:
    */
   TextDict(const LexiconPtr& _lexicon);
 
+  /**
+   * Constructor of TextDict over flat storage, which is how text files are
+   * loaded. Lookups use @p _lexicon directly; GetLexicon() copies it into a
+   * Lexicon on first use.
+   * _lexicon must be sorted.
+   */
+  TextDict(const FlatLexiconPtr& _lexicon);
+
   virtual ~TextDict();
 
   virtual size_t KeyMaxLength() const;
@@ -56,8 +67,22 @@ public:
 
   static TextDictPtr NewFromSortedFile(FILE* fp);
 
+  /**
+   * Returns the flat storage of a dictionary loaded from text, or nullptr if
+   * it was constructed from a Lexicon.
+   */
+  const FlatLexiconPtr& GetFlatLexicon() const { return flatLexicon; }
+
+  // Exposed for testing only.
+  bool IsLexiconConstructed() const {
+    return lexiconConstructed.load(std::memory_order_acquire);
+  }
+
 private:
   const size_t maxLength;
-  const LexiconPtr lexicon;
+  const FlatLexiconPtr flatLexicon;
+  mutable LexiconPtr lexicon;
+  mutable std::mutex lexiconMutex;
+  mutable std::atomic<bool> lexiconConstructed;
 };
 } // namespace opencc
@@ -0,0 +1,285 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2020-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "Exception.hpp"
+#include "ParallelPieces.hpp"
+#include "TextDictParser.hpp"
+#include "UTF8Util.hpp"
+
+namespace opencc {
+namespace internal {
+
+namespace {
+
+// Chunks smaller than this are not worth a thread hand-off.
+constexpr size_t kMinChunkBytes = 256 * 1024;
+
+// A few chunks per thread let threads that finish early pick up the rest
+// when line lengths are uneven.
+constexpr size_t kChunksPerThread = 4;
+
+struct ParsedChunk {
+  std::string_view text;
+  std::vector<ParsedTextEntry> entries;
+  std::vector<std::string_view> values;
+  // Lines parsed so far, including the malformed one if parsing failed.
+  size_t numLines = 0;
+  bool failed = false;
+  bool invalidUtf8 = false;
+  std::string error;
+};
+
+uint64_t KeyPrefix(std::string_view key) {
+  uint64_t prefix = 0;
+  const size_t length = (std::min)(key.size(), sizeof(prefix));
+  for (size_t i = 0; i < sizeof(prefix); i++) {
+    prefix <<= 8;
+    if (i < length) {
+      prefix |= static_cast<unsigned char>(key[i]);
+    }
+  }
+  return prefix;
+}
+
+bool EntryLessThan(const ParsedTextEntry& a, const ParsedTextEntry& b) {
+  if (a.keyPrefix != b.keyPrefix) {
+    return a.keyPrefix < b.keyPrefix;
+  }
+  return a.Key() < b.Key();
+}
+
+// Advances *pos to the first @p ch or line ending in [*pos, end), stepping
+// over whole UTF-8 characters. Returns false, with *pos at the offending
+// byte, if a byte cannot start a UTF-8 character.
+bool FindInLine(const char** pos, const char* end, char ch) {
+  const char* str = *pos;
+  while (str < end && !UTF8Util::IsLineEndingOrFileEnding(*str) &&
+         *str != ch) {
+    const size_t length = UTF8Util::NextCharLengthNoException(str);
+    if (length == 0) {
+      *pos = str;
+      return false;
+    }
+    str += (std::min)(length, static_cast<size_t>(end - str));
+  }
+  *pos = str;
+  return true;
+}
+
+// Parses the line [line, end) into @p chunk. Returns false after recording
+// the error if the line is malformed.
+bool ParseLine(const char* line, const char* end, char keyValueDelimiter,
+               uint32_t chunkIndex, ParsedChunk* chunk) {
+  if (line == end || *line == '#' ||
+      UTF8Util::IsLineEndingOrFileEnding(*line)) {
+    return true;
+  }
+  const char* pos = line;
+  bool valid = FindInLine(&pos, end, keyValueDelimiter);
+  if (valid && (pos == end || UTF8Util::IsLineEndingOrFileEnding(*pos))) {
+    chunk->failed = true;
+    chunk->error = "Tabular not found " + std::string(line, end - line);
+    return false;
+  }
+  const std::string_view key(line, static_cast<size_t>(pos - line));
+  const uint32_t firstValue = static_cast<uint32_t>(chunk->values.size());
+  while (valid && pos < end && !UTF8Util::IsLineEndingOrFileEnding(*pos)) {
+    // Skip the delimiter or the space before the value.
+    const char* value = ++pos;
+    valid = FindInLine(&pos, end, ' ');
+    chunk->values.emplace_back(value, static_cast<size_t>(pos - value));
+  }
+  if (!valid) {
+    chunk->failed = true;
+    chunk->invalidUtf8 = true;
+    chunk->error.assign(pos, end);
+    return false;
+  }
+  chunk->entries.push_back(ParsedTextEntry{
+      KeyPrefix(key), key.data(), static_cast<uint32_t>(key.size()),
+      firstValue, chunkIndex,
+      static_cast<uint32_t>(chunk->values.size() - firstValue)});
+  return true;
+}
+
+void ParseChunk(char keyValueDelimiter, uint32_t chunkIndex,
+                ParsedChunk* chunk) {
+  const char* str = chunk->text.data();
+  const char* textEnd = str + chunk->text.size();
+  while (str < textEnd) {
+    const char* newline = static_cast<const char*>(
+        std::memchr(str, '\n', static_cast<size_t>(textEnd - str)));
+    const char* lineEnd = newline != nullptr ? newline : textEnd;
+    chunk->numLines++;
+    if (!ParseLine(str, lineEnd, keyValueDelimiter, chunkIndex, chunk)) {
+      return;
+    }
+    str = newline != nullptr ? newline + 1 : textEnd;
+  }
+}
+
+// Splits [data, data + size), without a leading UTF-8 BOM, into line-aligned
+// chunks and parses them on up to @p threads threads. Each chunk is stably
+// sorted by key after parsing if @p sortChunks is set. Throws for the first malformed
+// line in the input.
+std::vector<ParsedChunk> ParseChunks(const char* data, size_t size,
+                                     char keyValueDelimiter, size_t threads,
+                                     bool sortChunks) {
+  if (size >= 3 && static_cast<unsigned char>(data[0]) == 0xef &&
+      static_cast<unsigned char>(data[1]) == 0xbb &&
+      static_cast<unsigned char>(data[2]) == 0xbf) {
+    data += 3;
+    size -= 3;
+  }
+  // A single thread parses the input in one chunk, which saves merging.
+  size_t maxChunks = 1;
+  if (threads > 1) {
+    maxChunks = (std::max<size_t>)(
+        1, (std::min)(threads * kChunksPerThread, size / kMinChunkBytes));
+  }
+  const size_t chunkBytes = size / maxChunks;
+  std::vector<ParsedChunk> chunks;
+  chunks.reserve(maxChunks + 1);
+  size_t begin = 0;
+  while (begin < size) {
+    size_t end = size;
+    if (begin + chunkBytes < size) {
+      const void* newline = std::memchr(data + begin + chunkBytes, '\n',
+                                        size - begin - chunkBytes);
+      if (newline != nullptr) {
+        end = static_cast<size_t>(static_cast<const char*>(newline) - data) +
+              1;
+      }
+    }
+    chunks.emplace_back();
+    chunks.back().text = std::string_view(data + begin, end - begin);
+    begin = end;
+  }
+
+  RunPieces(chunks.size(), threads, [&](size_t i) {
+    ParsedChunk& chunk = chunks[i];
+    ParseChunk(keyValueDelimiter, static_cast<uint32_t>(i), &chunk);
+    if (sortChunks && !chunk.failed) {
+      std::stable_sort(chunk.entries.begin(), chunk.entries.end(),
+                       EntryLessThan);
+    }
+  });
+
+  size_t lineNum = 0;
+  for (const ParsedChunk& chunk : chunks) {
+    if (chunk.failed) {
+      if (chunk.invalidUtf8) {
+        throw InvalidUTF8(chunk.error);
+      }
+      throw InvalidTextDictionary(chunk.error, lineNum + chunk.numLines);
+    }
+    lineNum += chunk.numLines;
+  }
+  return chunks;
+}
+
+// Concatenates the entries of @p chunks, leaving those of the chunks empty,
+// and records where each chunk's run starts in @p runStarts, followed by the
+// total.
+std::vector<ParsedTextEntry> JoinChunks(std::vector<ParsedChunk>* chunks,
+                                    std::vector<size_t>* runStarts) {
+  if (chunks->size() == 1) {
+    std::vector<ParsedTextEntry> entries = std::move(chunks->front().entries);
+    runStarts->assign({0, entries.size()});
+    return entries;
+  }
+  size_t numEntries = 0;
+  for (const ParsedChunk& chunk : *chunks) {
+    numEntries += chunk.entries.size();
+  }
+  std::vector<ParsedTextEntry> entries;
+  entries.reserve(numEntries);
+  for (ParsedChunk& chunk : *chunks) {
+    runStarts->push_back(entries.size());
+    entries.insert(entries.end(), chunk.entries.begin(), chunk.entries.end());
+    std::vector<ParsedTextEntry>().swap(chunk.entries);
+  }
+  runStarts->push_back(entries.size());
+  return entries;
+}
+
+// Merges the sorted runs of @p entries pairwise, one round at a time with the
+// merges of a round running in parallel, until a single run is left. The
+// merge is stable, so equal keys keep their input order.
+void MergeRuns(std::vector<size_t> runStarts, size_t threads,
+               std::vector<ParsedTextEntry>* entries) {
+  if (runStarts.size() <= 2) {
+    return;
+  }
+  std::vector<ParsedTextEntry> merged(entries->size());
+  while (runStarts.size() > 2) {
+    const size_t numRuns = runStarts.size() - 1;
+    const size_t numMerges = (numRuns + 1) / 2;
+    RunPieces(numMerges, threads, [&](size_t i) {
+      const size_t begin = runStarts[2 * i];
+      const size_t middle = runStarts[(std::min)(2 * i + 1, numRuns)];
+      const size_t end = runStarts[(std::min)(2 * i + 2, numRuns)];
+      std::merge(entries->begin() + begin, entries->begin() + middle,
+                 entries->begin() + middle, entries->begin() + end,
+                 merged.begin() + begin, EntryLessThan);
+    });
+    std::vector<size_t> nextStarts;
+    for (size_t i = 0; i < numRuns; i += 2) {
+      nextStarts.push_back(runStarts[i]);
+    }
+    nextStarts.push_back(runStarts.back());
+    runStarts.swap(nextStarts);
+    entries->swap(merged);
+  }
+}
+
+} // namespace
+
+ParsedTextDictionary ParseTextDictionary(const char* data, size_t size,
+                                         char keyValueDelimiter,
+                                         size_t threads, bool sorted) {
+  std::vector<ParsedChunk> chunks =
+      ParseChunks(data, size, keyValueDelimiter, threads, sorted);
+  ParsedTextDictionary parsed;
+  std::vector<size_t> runStarts;
+  parsed.entries = JoinChunks(&chunks, &runStarts);
+  if (sorted) {
+    MergeRuns(std::move(runStarts), threads, &parsed.entries);
+  }
+  parsed.values.reserve(chunks.size());
+  for (ParsedChunk& chunk : chunks) {
+    parsed.values.push_back(std::move(chunk.values));
+  }
+  return parsed;
+}
+
+std::string ReadToEnd(FILE* fp) {
+  std::string buffer;
+  char block[64 * 1024];
+  size_t length;
+  while ((length = fread(block, 1, sizeof(block), fp)) > 0) {
+    buffer.append(block, length);
+  }
+  return buffer;
+}
+
+} // namespace internal
+} // namespace opencc
@@ -0,0 +1,79 @@
+/*
+ * Open Chinese Convert
+ *
+ * Copyright 2020-2026 Carbo Kuo and contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace opencc {
+namespace internal {
+
+/**
+ * An entry of a text dictionary parsed by ParseTextDictionary(), as views
+ * into the parsed text.
+ */
+struct ParsedTextEntry {
+  // The first 8 bytes of the key, zero-padded, in big-endian order, so that
+  // most comparisons while sorting do not dereference the key.
+  uint64_t keyPrefix;
+  const char* keyData;
+  uint32_t keyLength;
+  // The values are ParsedTextDictionary::values[chunk][firstValue,
+  // firstValue + numValues).
+  uint32_t firstValue;
+  uint32_t chunk;
+  uint32_t numValues;
+
+  std::string_view Key() const { return std::string_view(keyData, keyLength); }
+};
+
+/**
+ * Entries of a text dictionary parsed by ParseTextDictionary(). Private
+ * (non-installed) header.
+ */
+struct ParsedTextDictionary {
+  std::vector<ParsedTextEntry> entries;
+  // Values of the entries of each chunk.
+  std::vector<std::vector<std::string_view>> values;
+
+  const std::string_view* Values(const ParsedTextEntry& entry) const {
+    return values[entry.chunk].data() + entry.firstValue;
+  }
+};
+
+/**
+ * Parses the text dictionary in [data, data + size), after a leading UTF-8
+ * BOM if any. The input is split into line-aligned chunks that are parsed on
+ * up to @p threads threads. Entries keep the input order, or are sorted by
+ * key if @p sorted is set; sorting merges the chunks stably, so entries with
+ * equal keys keep their input order.
+ * @throws InvalidTextDictionary or InvalidUTF8 for the first malformed line.
+ */
+ParsedTextDictionary ParseTextDictionary(const char* data, size_t size,
+                                         char keyValueDelimiter,
+                                         size_t threads, bool sorted);
+
+/** Reads @p fp from its current position to the end. */
+std::string ReadToEnd(FILE* fp);
+
+} // namespace internal
+} // namespace opencc
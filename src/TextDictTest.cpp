@@ -16,11 +16,38 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <random>
+
+#include "FlatLexicon.hpp"
 #include "TestUtilsUTF8.hpp"
 #include "TextDictTestBase.hpp"
 
 namespace opencc {
 
+namespace {
+
+// Text dictionary of about 1.5 MB in shuffled key order, large enough to be
+// parsed in several chunks.
+std::string ShuffledTextDict(size_t numEntries) {
+  std::vector<std::string> lines;
+  lines.reserve(numEntries);
+  for (size_t i = 0; i < numEntries; i++) {
+    const std::string key = utf8("詞") + std::to_string(i * 7919 % numEntries);
+    lines.push_back(key + "\t" + std::to_string(i) +
+                    (i % 3 == 0 ? " alt" + std::to_string(i) : ""));
+  }
+  std::mt19937 random(42);
+  std::shuffle(lines.begin(), lines.end(), random);
+  std::string text;
+  for (const std::string& line : lines) {
+    text += line + "\n";
+  }
+  return text;
+}
+
+} // namespace
+
 class TextDictTest : public TextDictTestBase {
 protected:
   TextDictTest() : fileName("dict.txt"){};
@@ -52,6 +79,24 @@ TEST_F(TextDictTest, DeserializationEmptyLine) {
   EXPECT_EQ(utf8("A"), entry.Get()->Key());
 }
 
+TEST_F(TextDictTest, LoadsTextIntoFlatLexicon) {
+  const std::string text = "b\tB\na\tA1 A2\n";
+  const TextDictPtr dict = TextDict::NewFromBuffer(text.data(), text.size());
+  ASSERT_NE(nullptr, dict->GetFlatLexicon());
+  const FlatLexicon::EntryView flatEntry = dict->GetFlatLexicon()->At(0);
+
+  Optional<const DictEntry*> entry = dict->Match("a", 1);
+  ASSERT_FALSE(entry.IsNull());
+  EXPECT_EQ(flatEntry.KeyView().data(), entry.Get()->KeyView().data());
+  EXPECT_EQ((std::vector<std::string>{"A1", "A2"}), entry.Get()->Values());
+  EXPECT_TRUE(dict->Match("c", 1).IsNull());
+
+  const LexiconPtr lexicon = dict->GetLexicon();
+  ASSERT_EQ(2, lexicon->Length());
+  EXPECT_EQ("a\tA1 A2", lexicon->At(0)->ToString());
+  EXPECT_EQ(lexicon, dict->GetLexicon());
+}
+
 TEST_F(TextDictTest, ExactMatch) {
   auto there = textDict->Match("積羽沉舟", 12);
   EXPECT_FALSE(there.IsNull());
@@ -90,4 +135,87 @@ TEST_F(TextDictTest, MatchPrefix) {
   }
 }
 
+TEST_F(TextDictTest, ParallelParseMatchesSequentialSort) {
+  const std::string text = ShuffledTextDict(100000);
+  const LexiconPtr expected =
+      Lexicon::ParseLexiconFromBuffer(text.data(), text.size());
+  expected->Sort();
+  const LexiconPtr parsed =
+      Lexicon::ParseSortedLexiconFromBuffer(text.data(), text.size(), '\t', 4);
+  ASSERT_EQ(expected->Length(), parsed->Length());
+  EXPECT_TRUE(parsed->IsSorted());
+  for (size_t i = 0; i < expected->Length(); i++) {
+    ASSERT_EQ(expected->At(i)->ToString(), parsed->At(i)->ToString());
+  }
+}
+
+TEST_F(TextDictTest, ParallelParseKeepsFileOrder) {
+  const std::string text = ShuffledTextDict(100000);
+  const LexiconPtr parsed =
+      Lexicon::ParseLexiconFromBuffer(text.data(), text.size());
+  ASSERT_EQ(100000, parsed->Length());
+  size_t lineStart = 0;
+  for (size_t i = 0; i < parsed->Length(); i++) {
+    const size_t lineEnd = text.find('\n', lineStart);
+    ASSERT_EQ(text.substr(lineStart, lineEnd - lineStart),
+              parsed->At(i)->ToString());
+    lineStart = lineEnd + 1;
+  }
+}
+
+TEST_F(TextDictTest, ParallelParseKeepsFileOrderOfEqualKeys) {
+  std::string text = ShuffledTextDict(100000);
+  for (int i = 0; i < 8; i++) {
+    text += utf8("詞") + "dup\t" + std::to_string(i) + "\n";
+  }
+  text += ShuffledTextDict(1000);
+  for (size_t threads : {1, 4}) {
+    const LexiconPtr parsed = Lexicon::ParseSortedLexiconFromBuffer(
+        text.data(), text.size(), '\t', threads);
+    std::vector<std::string> values;
+    for (size_t i = 0; i < parsed->Length(); i++) {
+      if (parsed->At(i)->Key() == utf8("詞") + "dup") {
+        values.push_back(parsed->At(i)->GetDefault());
+      }
+    }
+    EXPECT_EQ((std::vector<std::string>{"0", "1", "2", "3", "4", "5", "6",
+                                        "7"}),
+              values)
+        << threads;
+  }
+}
+
+TEST_F(TextDictTest, ParallelParseReportsAbsoluteLine) {
+  std::string text = ShuffledTextDict(100000);
+  text += "no delimiter\n";
+  text += ShuffledTextDict(10);
+  try {
+    Lexicon::ParseSortedLexiconFromBuffer(text.data(), text.size(), '\t', 4);
+    FAIL() << "Expected InvalidTextDictionary";
+  } catch (const InvalidTextDictionary& e) {
+    EXPECT_NE(std::string(e.what()).find("at line 100001:"),
+              std::string::npos)
+        << e.what();
+  }
+}
+
+TEST_F(TextDictTest, ParallelParseDetectsDuplicatesAcrossChunks) {
+  std::string text = ShuffledTextDict(100000);
+  text += utf8("詞") + "5\tdup\n";
+  EXPECT_THROW(TextDict::NewFromBuffer(text.data(), text.size()),
+               InvalidFormat);
+}
+
+TEST_F(TextDictTest, ParseLongLinesAndByteOrderMark) {
+  const std::string longValue(10000, 'v');
+  const std::string text =
+      "\xEF\xBB\xBF# comment\r\nb\t" + longValue + "\r\na\tx y\n";
+  const TextDictPtr dict = TextDict::NewFromBuffer(text.data(), text.size());
+  const LexiconPtr lexicon = dict->GetLexicon();
+  ASSERT_EQ(2, lexicon->Length());
+  EXPECT_EQ("a", lexicon->At(0)->Key());
+  EXPECT_EQ((std::vector<std::string>{"x", "y"}), lexicon->At(0)->Values());
+  EXPECT_EQ(longValue, lexicon->At(1)->GetDefault());
+}
+
 } // namespace opencc
@@ -47,6 +47,19 @@ inline uint32_t DecodeCodePoint23(const char* str, size_t charLength) {
          (static_cast<unsigned char>(str[2]) & 0x3FU);
 }
 
+/**
+ * Decodes the code point of a 4-byte UTF-8 sequence from raw bytes, without
+ * validating continuation bytes. Like DecodeCodePoint23() it is shared by
+ * the skip-table builder and the scanner. Malformed leads F5..F7 decode to
+ * values above U+10FFFF, which the table does not refine.
+ */
+inline uint32_t DecodeCodePoint4(const char* str) {
+  return ((static_cast<unsigned char>(str[0]) & 0x07U) << 18) |
+         ((static_cast<unsigned char>(str[1]) & 0x3FU) << 12) |
+         ((static_cast<unsigned char>(str[2]) & 0x3FU) << 6) |
+         (static_cast<unsigned char>(str[3]) & 0x3FU);
+}
+
 /**
  * Per-byte lookup table describing which byte values may begin a dictionary
  * key. The conversion hot loop uses it to consume runs of characters that
@@ -70,32 +83,135 @@ struct Utf8SkipTable {
    * (U+0000..U+FFFF, 8 KiB). When non-empty, 2- and 3-byte UTF-8 characters
    * are filtered by their exact code point instead of their lead byte, so
    * e.g. a rare CJK character sharing its lead byte with common dictionary
-   * keys can still be skipped. 4-byte characters keep lead-byte filtering.
-   * Character-level mode is on exactly when this vector is non-empty; there
-   * is deliberately no separate flag to keep in sync.
+   * keys can still be skipped. Character-level mode is on exactly when this
+   * vector is non-empty; there is deliberately no separate flag to keep in
+   * sync.
    */
   std::vector<uint64_t> bmpCandidates;
+  /**
+   * Character-level refinement of the supplementary planes
+   * (U+10000..U+10FFFF), in two levels because dictionaries have very few
+   * keys there: astralBlocks maps each block of 4096 code points to a
+   * 64-word block of astralCandidates, and blocks without candidates share
+   * the all-clear block 0. When empty, 4-byte characters keep lead-byte
+   * filtering (tables restored from before this refinement existed).
+   */
+  std::vector<uint16_t> astralBlocks;
+  std::vector<uint64_t> astralCandidates;
+
+  static constexpr uint32_t kAstralBlockBits = 12;
+  static constexpr size_t kAstralBlockWords = (1U << kAstralBlockBits) / 64;
+  static constexpr size_t kNumAstralBlocks =
+      (0x110000 - 0x10000) >> kAstralBlockBits;
 
   bool CharLevel() const { return !bmpCandidates.empty(); }
 
-  void EnableCharLevel() { bmpCandidates.assign(0x10000 / 64, 0); }
+  bool AstralLevel() const { return !astralBlocks.empty(); }
+
+  void EnableCharLevel() {
+    bmpCandidates.assign(0x10000 / 64, 0);
+    astralBlocks.assign(kNumAstralBlocks, 0);
+    astralCandidates.assign(kAstralBlockWords, 0);
+  }
 
   /**
    * Permanently falls back to lead-byte filtering, e.g. when a key's first
    * character is truncated or invalid and cannot be represented as a code
    * point. Byte-level candidates accumulated so far remain valid.
    */
-  void DisableCharLevel() { bmpCandidates.clear(); }
+  void DisableCharLevel() {
+    bmpCandidates.clear();
+    DisableAstralLevel();
+  }
+
+  /** Falls back to lead-byte filtering for 4-byte characters only. */
+  void DisableAstralLevel() {
+    astralBlocks.clear();
+    astralCandidates.clear();
+  }
 
   void MarkCharCandidate(uint32_t codePoint) {
-    if (CharLevel() && codePoint < 0x10000) {
+    if (!CharLevel()) {
+      return;
+    }
+    if (codePoint < 0x10000) {
       bmpCandidates[codePoint >> 6] |= uint64_t(1) << (codePoint & 63);
+      return;
+    }
+    if (!AstralLevel() || codePoint > 0x10FFFF) {
+      return;
+    }
+    uint16_t& block =
+        astralBlocks[(codePoint - 0x10000) >> kAstralBlockBits];
+    if (block == 0) {
+      block = static_cast<uint16_t>(astralCandidates.size() /
+                                    kAstralBlockWords);
+      astralCandidates.resize(astralCandidates.size() + kAstralBlockWords, 0);
     }
+    astralCandidates[block * kAstralBlockWords +
+                     ((codePoint >> 6) & (kAstralBlockWords - 1))] |=
+        uint64_t(1) << (codePoint & 63);
   }
 
+  /**
+   * @p codePoint must be a BMP code point, or at most U+10FFFF when
+   * AstralLevel() holds.
+   */
   bool IsCharCandidate(uint32_t codePoint) const {
     assert(CharLevel());
-    return (bmpCandidates[codePoint >> 6] >> (codePoint & 63)) & 1;
+    if (codePoint < 0x10000) {
+      return (bmpCandidates[codePoint >> 6] >> (codePoint & 63)) & 1;
+    }
+    assert(AstralLevel() && codePoint <= 0x10FFFF);
+    const size_t block =
+        astralBlocks[(codePoint - 0x10000) >> kAstralBlockBits];
+    return (astralCandidates[block * kAstralBlockWords +
+                             ((codePoint >> 6) & (kAstralBlockWords - 1))] >>
+            (codePoint & 63)) &
+           1;
+  }
+
+  /**
+   * Adds the candidates of @p from to this table. Character-level
+   * refinement is kept only as far as both tables have it.
+   */
+  void MergeCandidates(const Utf8SkipTable& from) {
+    for (size_t b = 0; b < 256; b++) {
+      candidate[b] = candidate[b] || from.candidate[b];
+    }
+    if (!from.CharLevel()) {
+      DisableCharLevel();
+      return;
+    }
+    if (!CharLevel()) {
+      return;
+    }
+    for (size_t i = 0; i < bmpCandidates.size(); i++) {
+      bmpCandidates[i] |= from.bmpCandidates[i];
+    }
+    if (!from.AstralLevel()) {
+      DisableAstralLevel();
+      return;
+    }
+    if (!AstralLevel()) {
+      return;
+    }
+    for (size_t i = 0; i < kNumAstralBlocks; i++) {
+      const size_t fromBlock = from.astralBlocks[i];
+      if (fromBlock == 0) {
+        continue;
+      }
+      const uint32_t first = 0x10000 + (uint32_t(i) << kAstralBlockBits);
+      for (size_t word = 0; word < kAstralBlockWords; word++) {
+        const uint64_t bits =
+            from.astralCandidates[fromBlock * kAstralBlockWords + word];
+        for (uint32_t bit = 0; bit < 64; bit++) {
+          if ((bits >> bit) & 1) {
+            MarkCharCandidate(first + uint32_t(word) * 64 + bit);
+          }
+        }
+      }
+    }
   }
 
   void MarkAllCandidates() {
@@ -136,6 +252,55 @@ struct Utf8SkipTable {
   }
 };
 
+/**
+ * Marks a single key's first character in @p table: the lead byte always,
+ * plus the exact first code point for 2-, 3- and 4-byte characters so
+ * scanning can filter at character granularity. Uses the same decoders as
+ * the scanner (DecodeCodePoint23, DecodeCodePoint4) so a key's first
+ * character always maps to the bit the scanner will test. A key whose first
+ * character is truncated or invalid cannot be represented as a code point;
+ * character filtering is then disabled for the whole table and lead-byte
+ * filtering (which stops at the marked lead) remains in effect.
+ */
+inline void MarkKeyFirstChar(Utf8SkipTable* table, const char* key,
+                             size_t len) {
+  if (len == 0) {
+    return;
+  }
+  // key may come straight from a trie enumeration buffer (e.g. marisa's
+  // Agent) and is NOT NUL-terminated. NextCharLengthNoException() reads only
+  // the lead byte, and DecodeCodePoint23() reads at most charLength bytes,
+  // which is checked against len first — no read may pass key + len.
+  const unsigned char lead = static_cast<unsigned char>(key[0]);
+  table->candidate[lead] = true;
+  if (lead < 0x80) {
+    return;
+  }
+  const size_t charLength = UTF8Util::NextCharLengthNoException(key);
+  if (charLength == 0) {
+    // Invalid lead byte: the scanner stops at charLength == 0 before any
+    // candidate check, so the lead-byte mark alone is sufficient and
+    // character-level filtering can stay enabled.
+    return;
+  }
+  if (charLength > len) {
+    // Truncated first character: the key can still match its raw byte
+    // prefix, but the scanner would decode the code point using the text's
+    // following bytes and could skip such a position. This cannot be
+    // represented at character granularity, so fall back to lead-byte
+    // filtering (the marked lead stops the scan).
+    table->DisableCharLevel();
+    return;
+  }
+  if (charLength == 2 || charLength == 3) {
+    table->MarkCharCandidate(DecodeCodePoint23(key, charLength));
+  } else if (charLength == 4) {
+    table->MarkCharCandidate(DecodeCodePoint4(key));
+  }
+  // Longer legacy sequences, and 4-byte ones beyond U+10FFFF, rely on
+  // lead-byte filtering.
+}
+
 /**
  * Returns the number of leading bytes of [str, str + len) with the high bit
  * clear, i.e. the length of the leading ASCII run.
@@ -166,6 +331,87 @@ inline size_t AsciiRunLength(const char* str, size_t len) {
   return pos;
 }
 
+/**
+ * Returns the number of leading bytes of [str, str + len) made of whole
+ * 3-byte UTF-8 characters whose code points are clear in @p bmpCandidates
+ * (a Utf8SkipTable::bmpCandidates bitmap). Stops at the first character that
+ * is not a complete 3-byte sequence or is a candidate.
+ *
+ * CJK text is dominated by long runs of 3-byte characters, so this is the
+ * character-level counterpart of AsciiRunLength(): four characters are
+ * checked per step with one combined lead-byte test and one combined bitmap
+ * test, which removes the per-character length dispatch and most branches
+ * from the loop. Like AsciiRunLength() it is plain C++: an AVX2 kernel
+ * decoding eight characters and gathering their bitmap words per step
+ * scanned faster in isolation but converted no faster end to end, so it
+ * did not earn a runtime CPU dispatch.
+ */
+inline size_t ThreeByteRunLength(const uint64_t* bmpCandidates,
+                                 const char* str, size_t len) {
+  const auto leadBits = [str](size_t pos) {
+    return static_cast<unsigned char>(str[pos]) ^ 0xE0U;
+  };
+  const auto isCandidate = [bmpCandidates, str](size_t pos) {
+    const uint32_t cp = DecodeCodePoint23(str + pos, 3);
+    return (bmpCandidates[cp >> 6] >> (cp & 63)) & 1;
+  };
+  // Tests single characters from pos until limit; returns where it stopped.
+  const auto scanSingles = [&](size_t pos, size_t limit) {
+    for (; pos < limit && len - pos >= 3; pos += 3) {
+      if ((leadBits(pos) & 0xF0U) != 0 || isCandidate(pos)) {
+        break;
+      }
+    }
+    return pos;
+  };
+  // Where keys are dense most runs are only a few characters long, so the
+  // first group is tested one character at a time.
+  size_t pos = scanSingles(0, 12);
+  if (pos < 12) {
+    return pos;
+  }
+  for (; len - pos >= 12; pos += 12) {
+    if (((leadBits(pos) | leadBits(pos + 3) | leadBits(pos + 6) |
+          leadBits(pos + 9)) &
+         0xF0U) != 0) {
+      break;
+    }
+    if (isCandidate(pos) | isCandidate(pos + 3) | isCandidate(pos + 6) |
+        isCandidate(pos + 9)) {
+      break;
+    }
+  }
+  // Resolve the exact character within the group that stopped the loop, and
+  // handle the trailing partial group.
+  return scanSingles(pos, len);
+}
+
+/**
+ * Returns the number of leading bytes of [str, str + len) made of whole
+ * 4-byte UTF-8 characters whose code points are not candidates in
+ * @p table, which must have AstralLevel(). Stops at the first character that
+ * is not a complete 4-byte sequence, lies beyond U+10FFFF or is a candidate.
+ *
+ * Emoji, CJK extension B..H characters and other supplementary-plane text
+ * rarely begin dictionary keys, so runs of them are skipped a character at
+ * a time instead of stopping for a lookup at every character whose lead
+ * byte (F0 for most of them) some key shares.
+ */
+inline size_t FourByteRunLength(const Utf8SkipTable& table, const char* str,
+                                size_t len) {
+  size_t pos = 0;
+  for (; len - pos >= 4; pos += 4) {
+    if ((static_cast<unsigned char>(str[pos]) & 0xF8U) != 0xF0U) {
+      break;
+    }
+    const uint32_t cp = DecodeCodePoint4(str + pos);
+    if (cp > 0x10FFFF || table.IsCharCandidate(cp)) {
+      break;
+    }
+  }
+  return pos;
+}
+
 /**
  * Returns the number of leading bytes of [str, str + len) that the conversion
  * loop may consume without any dictionary lookup: whole UTF-8 characters
@@ -189,11 +435,31 @@ inline size_t SkipNonCandidateBytes(const Utf8SkipTable& table, const char* str,
       pos++;
       continue;
     }
+    if (table.CharLevel() && (lead & 0xF0) == 0xE0) {
+      pos += ThreeByteRunLength(table.bmpCandidates.data(), str + pos,
+                                len - pos);
+      // A run ending on a 3-byte lead ended on a truncated or candidate
+      // character, where the per-character path below would stop as well.
+      if (pos < len && (static_cast<unsigned char>(str[pos]) & 0xF0) == 0xE0) {
+        break;
+      }
+      continue;
+    }
+    if (table.AstralLevel() && (lead & 0xF8) == 0xF0) {
+      const size_t run = FourByteRunLength(table, str + pos, len - pos);
+      pos += run;
+      // Characters beyond U+10FFFF fall through to lead-byte filtering
+      // below; a run ending elsewhere on a 4-byte lead ended on a truncated
+      // or candidate character.
+      if (run > 0 || pos == len) {
+        continue;
+      }
+    }
     const size_t charLength = UTF8Util::NextCharLengthNoException(str + pos);
     if (charLength == 0 || charLength > len - pos) {
       break;
     }
-    if (table.CharLevel() && (charLength == 2 || charLength == 3)) {
+    if (table.CharLevel() && charLength == 2) {
       // DecodeCodePoint23 does not validate continuation bytes; the table
       // builder decodes key bytes with the same function, so a position is
       // skipped only when its exact bytes cannot begin any key. Either way
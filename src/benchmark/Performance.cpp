@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <benchmark/benchmark.h>
 #include <cstdlib>
 #include <cstdio>
@@ -43,6 +44,8 @@
 #include "Exception.hpp"
 #include "SimpleConverter.hpp"
 #include "TestUtilsUTF8.hpp"
+#include "UTF8Util.hpp"
+#include "Utf8SkipScan.hpp"
 
 namespace opencc {
 
@@ -762,6 +765,28 @@ std::string ReadText(const std::string& filename) {
                      std::istreambuf_iterator<char>());
 }
 
+// Builds an emoji-dense variant of text, as in chat and social media
+// content: an emoji after every third character, cycling through plain
+// emoji, a ZWJ family sequence and a heart with a variation selector.
+std::string InsertEmoji(const std::string& text) {
+  static const char* const kEmoji[] = {"😀", "👍", "🎉", "😂",
+                                       "👨‍👩‍👧", "🚀", "❤️", "🙏"};
+  std::string output;
+  output.reserve(text.size() * 2);
+  size_t characters = 0;
+  size_t emoji = 0;
+  for (size_t pos = 0; pos < text.size();) {
+    const size_t charLength = std::max<size_t>(
+        1, UTF8Util::NextCharLengthNoException(text.data() + pos));
+    output.append(text, pos, charLength);
+    pos += charLength;
+    if (++characters % 3 == 0) {
+      output += kEmoji[emoji++ % (sizeof(kEmoji) / sizeof(kEmoji[0]))];
+    }
+  }
+  return output;
+}
+
 static void BM_Initialization(benchmark::State& state,
                               const BenchmarkConfig& config) {
   for (auto _ : state) {
@@ -782,6 +807,16 @@ static void BM_ConvertLongText(benchmark::State& state,
   SetThroughputCounter(state, text.size());
 }
 
+static void BM_ConvertEmojiText(benchmark::State& state,
+                                const BenchmarkConfig& config) {
+  const std::string text = InsertEmoji(ReadText("zuozhuan.txt"));
+  const std::unique_ptr<SimpleConverter> converter(Initialize(config));
+  for (auto _ : state) {
+    Convert(converter.get(), text);
+  }
+  SetThroughputCounter(state, text.size());
+}
+
 static void BM_Convert(benchmark::State& state, const BenchmarkConfig& config,
                        int iteration) {
   std::ostringstream os;
@@ -796,6 +831,52 @@ static void BM_Convert(benchmark::State& state, const BenchmarkConfig& config,
   SetThroughputCounter(state, text.size());
 }
 
+internal::Utf8SkipTable BuildSkipTable(const std::string& dict_file_name) {
+  internal::Utf8SkipTable table;
+  table.EnableCharLevel();
+  std::ifstream stream(ResolveTextDictionaryPath(dict_file_name).c_str());
+  std::string line;
+  while (std::getline(stream, line)) {
+    const std::string::size_type tab = line.find('\t');
+    if (tab != std::string::npos) {
+      internal::MarkKeyFirstChar(&table, line.data(), tab);
+    }
+  }
+  table.Finalize();
+  return table;
+}
+
+// Runs the candidate skip scan alone over a long text, stepping over each
+// character it stops at the way the conversion loop would after a lookup.
+static void BM_SkipScan(benchmark::State& state,
+                        const std::string& dict_file_name, bool simplified,
+                        bool emoji) {
+  const internal::Utf8SkipTable table = BuildSkipTable(dict_file_name);
+  std::string text = ReadText("zuozhuan.txt");
+  if (simplified) {
+    const std::unique_ptr<SimpleConverter> converter(
+        Initialize(BenchmarkConfig{"t2s", ResolveConfigPath("t2s")}));
+    text = converter->Convert(text);
+  }
+  if (emoji) {
+    text = InsertEmoji(text);
+  }
+  for (auto _ : state) {
+    size_t stops = 0;
+    for (size_t pos = 0; pos < text.size();) {
+      pos += internal::SkipNonCandidateBytes(table, text.data() + pos,
+                                             text.size() - pos);
+      if (pos < text.size()) {
+        pos += std::max<size_t>(
+            1, UTF8Util::NextCharLengthNoException(text.data() + pos));
+        stops++;
+      }
+    }
+    benchmark::DoNotOptimize(stops);
+  }
+  SetThroughputCounter(state, text.size());
+}
+
 static void BM_CommandLineLongText(benchmark::State& state,
                                    const BenchmarkConfig& config) {
   const std::string input_path =
@@ -886,6 +967,35 @@ bool RegisterBenchmarks() {
         [config](benchmark::State& state) { BM_ConvertLongText(state, config); })
         ->Unit(benchmark::kMillisecond);
   }
+  for (const BenchmarkConfig& config : conversion_configs) {
+    benchmark::RegisterBenchmark(
+        ("BM_ConvertEmojiText/" + config.name).c_str(),
+        [config](benchmark::State& state) { BM_ConvertEmojiText(state, config); })
+        ->Unit(benchmark::kMillisecond);
+  }
+
+  // Traditional text against simplified-to-traditional keys stops often;
+  // its simplified conversion against traditional-to-simplified keys is
+  // dominated by long runs of skippable CJK characters. The emoji variant
+  // interleaves it with supplementary-plane characters that start no key.
+  benchmark::RegisterBenchmark("BM_SkipScan/STCharacters/zuozhuan",
+                               [](benchmark::State& state) {
+                                 BM_SkipScan(state, "STCharacters.txt", false,
+                                             false);
+                               })
+      ->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark("BM_SkipScan/TSCharacters/zuozhuan_simplified",
+                               [](benchmark::State& state) {
+                                 BM_SkipScan(state, "TSCharacters.txt", true,
+                                             false);
+                               })
+      ->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark(
+      "BM_SkipScan/TSCharacters/zuozhuan_simplified_emoji",
+      [](benchmark::State& state) {
+        BM_SkipScan(state, "TSCharacters.txt", true, true);
+      })
+      ->Unit(benchmark::kMillisecond);
 
   for (const BenchmarkConfig& config : conversion_configs) {
     for (const int iteration : {100, 1000, 10000, 100000}) {
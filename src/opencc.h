@@ -101,7 +101,8 @@ OPENCC_EXPORT int opencc_close(opencc_t opencc);
  * @param length The maximum length in byte to convert. If length is (size_t)-1,
  *               the whole std::string (terminated by '\0') will be converted.
  * @param output The buffer to store converted text. You MUST make sure this
- *               buffer has sufficient space.
+ *               buffer has sufficient space, or use
+ *               opencc_convert_utf8_to_sized_buffer() instead.
  *
  * @return       The length of converted std::string or (size_t)-1 on error.
  *
@@ -111,6 +112,37 @@ OPENCC_EXPORT size_t opencc_convert_utf8_to_buffer(opencc_t opencc,
                                                    const char* input,
                                                    size_t length, char* output);
 
+/**
+ * Converts UTF-8 std::string into a buffer of limited size
+ * Works like snprintf(): the converted text and a terminating '\0' are written
+ * if they fit. Otherwise the longest prefix of complete UTF-8 characters that
+ * fits is written, followed by '\0'. The return value is always the length of
+ * the whole converted text, so a caller can pass a capacity of 0 to query the
+ * required size, or retry with a larger buffer. Reusing one buffer across
+ * calls avoids the allocation made by opencc_convert_utf8().
+ *
+ * @param opencc   The opencc description pointer.
+ * @param input    The UTF-8 encoded std::string.
+ * @param length   The maximum length in byte to convert. If length is
+ *                 (size_t)-1, the whole std::string (terminated by '\0') will
+ *                 be converted.
+ * @param output   The buffer to store converted text. May be NULL if capacity
+ *                 is 0.
+ * @param capacity The size of output in byte, including the terminating '\0'.
+ *
+ * @return         The length of the whole converted std::string, excluding
+ *                 '\0', or (size_t)-1 on error. The text was written
+ *                 completely if and only if the return value is less than
+ *                 capacity.
+ *
+ * @ingroup opencc_c_api
+ */
+OPENCC_EXPORT size_t opencc_convert_utf8_to_sized_buffer(opencc_t opencc,
+                                                         const char* input,
+                                                         size_t length,
+                                                         char* output,
+                                                         size_t capacity);
+
 /**
  * Converts UTF-8 std::string
  * This function returns an allocated C-Style std::string, which stores
@@ -130,15 +162,131 @@ OPENCC_EXPORT char* opencc_convert_utf8(opencc_t opencc, const char* input,
                                         size_t length);
 
 /**
- * Releases allocated buffer by opencc_convert_utf8
+ * Converts several UTF-8 strings in one call
+ * The results are stored back to back in one allocated buffer, terminated by
+ * '\0'. Result i occupies bytes [offsets[i], offsets[i + 1]) of the buffer;
+ * results are not separated by '\0'.
+ * You MUST call opencc_convert_utf8_free() to release allocated memory.
+ *
+ * @param opencc  The opencc description pointer.
+ * @param inputs  Array of count UTF-8 encoded strings.
+ * @param lengths Array of count lengths in byte. An entry of (size_t)-1, or a
+ *                NULL array, means the input is terminated by '\0'.
+ * @param count   The number of strings to convert.
+ * @param threads The maximum number of threads to use, including the calling
+ *                thread. 0 uses one per hardware thread.
+ * @param offsets Array of count + 1 entries receiving the start of each
+ *                result and, last, the total length of the results.
+ *
+ * @return        The newly allocated buffer holding the converted strings, or
+ *                NULL on error.
+ * @ingroup opencc_c_api
+ */
+OPENCC_EXPORT char* opencc_convert_utf8_batch(opencc_t opencc,
+                                              const char* const* inputs,
+                                              const size_t* lengths,
+                                              size_t count, size_t threads,
+                                              size_t* offsets);
+
+/**
+ * Releases allocated buffer by opencc_convert_utf8 or opencc_convert_utf8_batch
  *
  * @param str    Pointer to the allocated std::string buffer by
- * opencc_convert_utf8.
+ * opencc_convert_utf8 or opencc_convert_utf8_batch.
  *
  * @ingroup opencc_c_api
  */
 OPENCC_EXPORT void opencc_convert_utf8_free(char* str);
 
+/**
+ * Conversion stream description pointer
+ * A stream converts text fed in pieces, e.g. read from a socket or a large
+ * file, without splitting phrases at piece boundaries. Its memory use stays
+ * bounded by the largest piece plus a short kept tail.
+ *
+ * @ingroup opencc_c_api
+ */
+typedef void* opencc_stream_t;
+
+/**
+ * Receives converted text from a stream
+ *
+ * @param data     Converted UTF-8 text, not terminated by '\0'. It is only
+ *                 valid during the call.
+ * @param length   The length of data in byte, never 0.
+ * @param userData The pointer passed along with the callback.
+ *
+ * @ingroup opencc_c_api
+ */
+typedef void (*opencc_stream_output_fn)(const char* data, size_t length,
+                                        void* userData);
+
+/**
+ * Makes a conversion stream
+ * The stream shares the converter of opencc and keeps it alive, so opencc may
+ * be closed before the stream.
+ * You MUST call opencc_stream_close() to release the stream.
+ *
+ * @param opencc       The opencc description pointer.
+ * @param maxKeepChars The number of characters held back after each piece so
+ *                     that phrases spanning two pieces are converted whole.
+ *                     0 selects the default of 16.
+ *
+ * @return             A description pointer of the newly allocated stream, or
+ *                     NULL on error.
+ * @ingroup opencc_c_api
+ */
+OPENCC_EXPORT opencc_stream_t opencc_stream_open(opencc_t opencc,
+                                                 size_t maxKeepChars);
+
+/**
+ * Feeds a piece of UTF-8 text to a stream
+ * Everything except the kept tail is converted and passed to output, which is
+ * called at most once. A piece may end in the middle of a UTF-8 character.
+ * A phrase that straddles the start of the kept tail is converted in two
+ * parts, so pieces much longer than maxKeepChars give the best results.
+ *
+ * @param stream   The stream description pointer.
+ * @param input    The UTF-8 encoded piece.
+ * @param length   The length of input in byte. If length is (size_t)-1, the
+ *                 whole std::string (terminated by '\0') is fed.
+ * @param output   The callback receiving converted text.
+ * @param userData Passed to output unchanged.
+ *
+ * @return         0 on success or -1 on error.
+ * @ingroup opencc_c_api
+ */
+OPENCC_EXPORT int opencc_stream_feed(opencc_stream_t stream, const char* input,
+                                     size_t length,
+                                     opencc_stream_output_fn output,
+                                     void* userData);
+
+/**
+ * Converts the rest of a stream
+ * The kept tail is converted and passed to output, which is called at most
+ * once. The stream may then be fed again to convert a new text.
+ *
+ * @param stream   The stream description pointer.
+ * @param output   The callback receiving converted text.
+ * @param userData Passed to output unchanged.
+ *
+ * @return         0 on success or -1 on error.
+ * @ingroup opencc_c_api
+ */
+OPENCC_EXPORT int opencc_stream_finish(opencc_stream_t stream,
+                                       opencc_stream_output_fn output,
+                                       void* userData);
+
+/**
+ * Destroys a stream
+ * Text fed but not finished is discarded.
+ *
+ * @param stream The stream description pointer.
+ * @return 0 on success or non-zero number on failure.
+ * @ingroup opencc_c_api
+ */
+OPENCC_EXPORT int opencc_stream_close(opencc_stream_t stream);
+
 /**
  * Returns the last error message
  *
@@ -17,14 +17,132 @@
  */
 
 #include "Config.hpp"
+#include "Converter.hpp"
 #include "ResourceProvider.hpp"
+#include "StreamWindow.hpp"
 #include "opencc.h"
 #include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
 #include <pybind11/pybind11.h>
 
 namespace py = pybind11;
 
+namespace {
+
+struct BufferRelease {
+  void operator()(Py_buffer* buffer) const {
+    PyBuffer_Release(buffer);
+    delete buffer;
+  }
+};
+
+// A text argument viewed as UTF-8 without copying it: a str exposes its
+// cached UTF-8 form and a bytes-like object its buffer. The view stays valid
+// while the GIL is released, as the object and its buffer are held until the
+// TextView is destroyed, which must happen with the GIL held.
+class TextView {
+public:
+  explicit TextView(const py::handle& text)
+      : owner(py::reinterpret_borrow<py::object>(text)) {
+    if (PyUnicode_Check(text.ptr())) {
+      Py_ssize_t size = 0;
+      const char* data = PyUnicode_AsUTF8AndSize(text.ptr(), &size);
+      if (data == nullptr) {
+        throw py::error_already_set();
+      }
+      view = std::string_view(data, static_cast<size_t>(size));
+      return;
+    }
+    if (!PyObject_CheckBuffer(text.ptr())) {
+      throw py::type_error("expected str or a bytes-like object, got " +
+                           std::string(py::str(py::type::of(text))));
+    }
+    std::unique_ptr<Py_buffer, BufferRelease> requested(new Py_buffer());
+    if (PyObject_GetBuffer(text.ptr(), requested.get(), PyBUF_SIMPLE) != 0) {
+      // Nothing to release: PyObject_GetBuffer failed.
+      delete requested.release();
+      throw py::error_already_set();
+    }
+    buffer = std::move(requested);
+    view = std::string_view(static_cast<const char*>(buffer->buf),
+                            static_cast<size_t>(buffer->len));
+  }
+
+  std::string_view Get() const { return view; }
+
+  bool IsBytes() const { return buffer != nullptr; }
+
+  // Wraps converted text in the type of the argument: str for str, bytes
+  // for bytes-like objects.
+  py::object Wrap(const std::string& converted) const {
+    return Wrap(converted.data(), converted.size(), IsBytes());
+  }
+
+  static py::object Wrap(const char* data, size_t length, bool bytes) {
+    if (bytes) {
+      return py::bytes(data, length);
+    }
+    return py::str(data, length);
+  }
+
+private:
+  py::object owner;
+  std::unique_ptr<Py_buffer, BufferRelease> buffer;
+  std::string_view view;
+};
+
+// ConverterStream keeps pending text between calls, so calls from several
+// Python threads, which may overlap once the GIL is released, are
+// serialized.
+class PyConverterStream {
+public:
+  PyConverterStream(opencc::ConverterPtr converter, size_t maxKeepChars)
+      : stream(std::move(converter), maxKeepChars) {}
+
+  py::object Convert(const py::handle& text) {
+    const TextView input(text);
+    std::string converted;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(mutex);
+      converted = stream.ConvertChunk(input.Get());
+    }
+    bytes = input.IsBytes();
+    return input.Wrap(converted);
+  }
+
+  // Without text, the rest is returned in the type of the last piece.
+  py::object Finish(const py::object& text) {
+    std::unique_ptr<TextView> input;
+    if (!text.is_none()) {
+      input.reset(new TextView(text));
+      bytes = input->IsBytes();
+    }
+    std::string converted;
+    {
+      py::gil_scoped_release release;
+      std::lock_guard<std::mutex> lock(mutex);
+      converted = input != nullptr ? stream.Finish(input->Get())
+                                   : stream.Finish();
+    }
+    return TextView::Wrap(converted.data(), converted.size(), bytes);
+  }
+
+private:
+  opencc::ConverterStream stream;
+  std::mutex mutex;
+  bool bytes = false;
+};
+
+} // namespace
+
 PYBIND11_MODULE(opencc_clib, m) {
+  py::class_<PyConverterStream>(m, "_Stream")
+      .def("convert", &PyConverterStream::Convert, py::arg("text"))
+      .def("finish", &PyConverterStream::Finish, py::arg("text") = py::none());
+
   py::class_<opencc::SimpleConverter>(m, "_OpenCC")
       .def(py::init([](const std::string& configFileName,
                        bool includeTofuRiskDictionaries,
@@ -43,8 +161,55 @@ PYBIND11_MODULE(opencc_clib, m) {
            py::arg("config"),
            py::arg("include_tofu_risk_dictionaries") = true,
            py::arg("resource_zip") = py::none())
-      .def("convert", py::overload_cast<const char*, size_t>(
-                          &opencc::SimpleConverter::Convert, py::const_));
+      .def(
+          "convert",
+          [](const opencc::SimpleConverter& converter, const py::handle& text) {
+            const TextView input(text);
+            std::string converted;
+            {
+              py::gil_scoped_release release;
+              converted = converter.Convert(input.Get());
+            }
+            return input.Wrap(converted);
+          },
+          py::arg("text"))
+      .def(
+          "convert_batch",
+          [](const opencc::SimpleConverter& converter, const py::list& texts,
+             size_t threads) {
+            std::vector<TextView> views;
+            views.reserve(texts.size());
+            for (const py::handle& text : texts) {
+              views.emplace_back(text);
+            }
+            std::vector<std::string_view> inputs;
+            inputs.reserve(views.size());
+            for (const TextView& view : views) {
+              inputs.push_back(view.Get());
+            }
+            std::string output;
+            std::vector<size_t> offsets;
+            {
+              py::gil_scoped_release release;
+              converter.ConvertBatch(inputs, &output, &offsets, threads);
+            }
+            py::list converted(views.size());
+            for (size_t i = 0; i < views.size(); i++) {
+              converted[i] = TextView::Wrap(output.data() + offsets[i],
+                                            offsets[i + 1] - offsets[i],
+                                            views[i].IsBytes());
+            }
+            return converted;
+          },
+          py::arg("texts"), py::arg("threads") = 1)
+      .def(
+          "stream",
+          [](const opencc::SimpleConverter& converter, size_t maxKeepChars) {
+            return new PyConverterStream(converter.GetConverter(),
+                                         maxKeepChars);
+          },
+          py::arg("max_keep_chars") =
+              opencc::internal::kDefaultStreamKeepChars);
 
 #ifdef OPENCC_VERSION
   m.attr("__version__") = OPENCC_VERSION;
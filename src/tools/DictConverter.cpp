@@ -18,6 +18,8 @@
 
 #include "src/DictConverter.hpp"
 #include "src/CmdLineOutput.hpp"
+#include "src/Config.hpp"
+#include "src/ConverterSnapshot.hpp"
 #include "src/Exception.hpp"
 
 using namespace opencc;
@@ -29,10 +31,13 @@ int main(int argc, const char* argv[]) {
     CmdLineOutput cmdLineOutput;
     cmd.setOutput(&cmdLineOutput);
 
-    std::vector<std::string> inputFormats{"text", "text_space", "ocd2", "ocd",
-                                          "cppjieba_utf8"};
+    // "config" and "snapshot" go together: a converter snapshot is compiled
+    // from a JSON config rather than converted from a dictionary.
+    std::vector<std::string> inputFormats{
+        "text", "text_space", "ocd3", "ocd2", "ocd", "cppjieba_utf8", "config"};
     TCLAP::ValuesConstraint<std::string> allowedInputVals(inputFormats);
-    std::vector<std::string> outputFormats{"text", "ocd2", "ocd"};
+    std::vector<std::string> outputFormats{"text", "ocd3", "ocd2", "ocd",
+                                           "snapshot"};
     TCLAP::ValuesConstraint<std::string> allowedOutputVals(outputFormats);
 
     TCLAP::ValueArg<std::string> toArg("t", "to", "Output format",
@@ -47,7 +52,40 @@ int main(int argc, const char* argv[]) {
     TCLAP::MultiArg<std::string> inputArg(
         "i", "input", "Path to input dictionary", true /* required */,
         "file" /* type */, cmd);
+    // The snapshot records these, and must be loaded with the same options.
+    // The defaults match the opencc command line tool.
+    TCLAP::SwitchArg includeTofuRiskDictionariesArg(
+        "", "include-tofu-risk-dictionaries",
+        "Snapshot only: include dictionaries marked as possibly outputting "
+        "tofu, as opencc --include-tofu-risk-dictionaries does.",
+        cmd, false);
+    TCLAP::SwitchArg compileConversionChainsArg(
+        "", "compile-conversion-chains",
+        "Snapshot only: compose adjacent conversion chain stages into "
+        "single-pass stages when the snapshot is loaded.",
+        cmd, false);
     cmd.parse(argc, argv);
+    if (fromArg.getValue() == "config" || toArg.getValue() == "snapshot" ||
+        includeTofuRiskDictionariesArg.getValue() ||
+        compileConversionChainsArg.getValue()) {
+      if (fromArg.getValue() != "config" || toArg.getValue() != "snapshot" ||
+          inputArg.getValue().size() != 1) {
+        std::cerr << "error: snapshots are compiled from a single config: "
+                     "-f config -t snapshot -i <config.json>"
+                  << std::endl;
+        return 1;
+      }
+      ConfigLoadOptions options;
+      options.includeTofuRiskDictionaries =
+          includeTofuRiskDictionariesArg.getValue();
+      options.compileConversionChains = compileConversionChainsArg.getValue();
+      Config config;
+      ConverterSnapshot::SerializeToFile(
+          config.NewFromFile(inputArg.getValue().front(),
+                             std::vector<std::string>{}, nullptr, options),
+          outputArg.getValue(), options);
+      return 0;
+    }
     ConvertDictionary(inputArg.getValue(), outputArg.getValue(),
                       fromArg.getValue(), toArg.getValue());
   } catch (TCLAP::ArgException& e) {
@@ -969,6 +969,76 @@ TEST_F(CommandLineConvertTest, WritesMeasuredResultJson) {
   EXPECT_TRUE(doc["output_bytes"].IsUint64());
 }
 
+TEST_F(CommandLineConvertTest, WritesKeyHits) {
+  const std::string config = "s2t";
+  const std::string inputFile = InputFile(config.c_str()) + ".key_hits";
+  const std::string outputFile = OutputFile(config.c_str()) + ".key_hits";
+  const std::string keyHitsFile = OutputDirectory() + config + ".key_hits.tsv";
+
+  {
+    std::ofstream ofs(inputFile, std::ios::binary);
+    ASSERT_TRUE(ofs.is_open()) << "Failed to open input file for writing: "
+                               << inputFile;
+    ofs << "开放中文转换" << std::endl;
+  }
+
+  ASSERT_EQ(0, system(TestCommand(config, inputFile, outputFile, "",
+                                  "--key-hits " + QuotePath(keyHitsFile))
+                          .c_str()));
+  EXPECT_EQ("開放中文轉換\n", GetFileContents(outputFile));
+
+  const std::string content = GetFileContents(keyHitsFile);
+  // s2t lists its normalization pass first, then the leaves of the
+  // STPhrases group, then STCharacters with all of its keys, hit keys first.
+  EXPECT_EQ(0, content.find("# normalization.conversion_chain[0]\n"));
+  const size_t characters = content.find("# conversion_chain[0].dict[1]\n");
+  ASSERT_NE(std::string::npos, characters);
+  EXPECT_NE(std::string::npos, content.find("转\t1\n", characters));
+  EXPECT_NE(std::string::npos, content.find("\t0\n", characters));
+}
+
+TEST_F(CommandLineConvertTest, ThreadsOutputMatchesSingleThreaded) {
+  const std::string config = "s2twp";
+  const std::string inputFile = InputFile(config.c_str()) + ".threads";
+  const std::string serialOutputFile = OutputFile(config.c_str()) + ".serial";
+  const std::string threadedOutputFile =
+      OutputFile(config.c_str()) + ".threads";
+  const std::string measuredResultFile =
+      OutputDirectory() + config + ".threads_measured_result.json";
+
+  {
+    // Several read buffers' worth of text, so that chunks are cut by the
+    // streaming window and converted out of order.
+    std::ofstream ofs(inputFile, std::ios::binary);
+    ASSERT_TRUE(ofs.is_open()) << "Failed to open input file for writing: "
+                               << inputFile;
+    for (int i = 0; i < 60000; i++) {
+      ofs << "鼠标里面的硅二极管坏了，导致光标分辨率降低。";
+      if (i % 5 == 0) {
+        ofs << "\n";
+      }
+    }
+  }
+
+  ASSERT_EQ(0, RunCommand(TestCommand(config, inputFile, serialOutputFile)));
+  ASSERT_EQ(0, RunCommand(TestCommand(config, inputFile, threadedOutputFile,
+                                      measuredResultFile, "--threads 4")));
+  EXPECT_EQ(GetFileContents(serialOutputFile),
+            GetFileContents(threadedOutputFile));
+
+  const std::string content = GetFileContents(measuredResultFile);
+  rapidjson::Document doc;
+  doc.Parse(content.c_str());
+  ASSERT_FALSE(doc.HasParseError());
+  ASSERT_TRUE(doc.HasMember("threads"));
+  EXPECT_EQ(4u, doc["threads"].GetUint64());
+  ASSERT_TRUE(doc.HasMember("read_ms"));
+  EXPECT_TRUE(doc["read_ms"].IsNumber());
+  ASSERT_TRUE(doc.HasMember("output_bytes"));
+  EXPECT_EQ(GetFileContents(serialOutputFile).size(),
+            doc["output_bytes"].GetUint64());
+}
+
 TEST_F(CommandLineConvertTest, SegmentationOutputIsJson) {
   const std::string config = "s2twp";
   const std::string inputFile = InputFile("segmentation_test");